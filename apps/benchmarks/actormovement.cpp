@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace
+{
+    const int sNumSteps = 3;
+    const int sSweepsPerStep = 4;
+    const float sStepTime = 1.f / 60.f;
+
+    /// Like the tracer of MWPhysics, which ignores the actor it moves
+    class ClosestNotMeCallback : public btCollisionWorld::ClosestConvexResultCallback
+    {
+    public:
+        ClosestNotMeCallback(const btCollisionObject* me)
+            : btCollisionWorld::ClosestConvexResultCallback(btVector3(0, 0, 0), btVector3(0, 0, 0))
+            , mMe(me)
+        {
+        }
+
+        virtual btScalar addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace)
+        {
+            if (convexResult.m_hitCollisionObject == mMe)
+                return btScalar(1);
+            return ClosestConvexResultCallback::addSingleResult(convexResult, normalInWorldSpace);
+        }
+
+    private:
+        const btCollisionObject* mMe;
+    };
+
+    struct TestActor
+    {
+        std::unique_ptr<btCollisionObject> mObject;
+        btVector3 mVelocity;
+        btVector3 mPosition;
+    };
+
+    /// A test cell: a floor with pillars on it and actors walking around between them.
+    /// Nothing here needs the game data or a World, the cost is in the Bullet sweep tests.
+    class TestCell
+    {
+    public:
+        TestCell(int numActors)
+            : mDispatcher(&mConfiguration)
+            , mWorld(&mDispatcher, &mBroadphase, &mConfiguration)
+            , mFloorShape(btVector3(4096, 4096, 16))
+            , mPillarShape(btVector3(64, 64, 256))
+            , mActorShape(btVector3(29, 29, 64))
+        {
+            mWorld.setForceUpdateAllAabbs(false);
+
+            addStatic(&mFloorShape, btVector3(0, 0, -16));
+            for (int x = -3000; x <= 3000; x += 500)
+                for (int y = -3000; y <= 3000; y += 500)
+                    addStatic(&mPillarShape, btVector3(x, y, 256));
+
+            // Crowded on purpose, so that actors keep running into each other
+            for (int i = 0; i < numActors; ++i)
+            {
+                TestActor actor;
+                actor.mObject.reset(new btCollisionObject);
+                actor.mObject->setCollisionShape(&mActorShape);
+                actor.mPosition = btVector3((i % 20) * 100.f - 1000.f, (i / 20) * 100.f - 1000.f, 65.f);
+                actor.mObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), actor.mPosition));
+                actor.mVelocity = btVector3(((i * 7) % 11) - 5.f, ((i * 13) % 11) - 5.f, 0.f).normalized() * 200.f;
+                mWorld.addCollisionObject(actor.mObject.get(), 2, 1|2);
+                mActors.push_back(std::move(actor));
+            }
+        }
+
+        ~TestCell()
+        {
+            for (TestActor& actor : mActors)
+                mWorld.removeCollisionObject(actor.mObject.get());
+            for (auto& object : mStatics)
+                mWorld.removeCollisionObject(object.get());
+        }
+
+        /// Sweep one actor forward, sliding along what it hits, then down onto the floor.
+        /// Only reads the world, so it may run for several actors at once.
+        void solve(TestActor& actor) const
+        {
+            btVector3 position = actor.mPosition;
+            for (int step = 0; step < sNumSteps; ++step)
+            {
+                btVector3 velocity = actor.mVelocity;
+                for (int i = 0; i < sSweepsPerStep && velocity.length2() > 0.01f; ++i)
+                {
+                    btVector3 target = position + velocity * sStepTime;
+                    ClosestNotMeCallback callback(actor.mObject.get());
+                    mWorld.convexSweepTest(&mActorShape, btTransform(btQuaternion::getIdentity(), position),
+                                           btTransform(btQuaternion::getIdentity(), target), callback);
+                    if (!callback.hasHit())
+                    {
+                        position = target;
+                        break;
+                    }
+                    position.setInterpolate3(position, target, callback.m_closestHitFraction);
+                    btVector3 normal = callback.m_hitNormalWorld;
+                    velocity -= normal * velocity.dot(normal);
+                }
+
+                ClosestNotMeCallback down(actor.mObject.get());
+                mWorld.convexSweepTest(&mActorShape, btTransform(btQuaternion::getIdentity(), position),
+                                       btTransform(btQuaternion::getIdentity(), position - btVector3(0, 0, 64)), down);
+                if (down.hasHit())
+                    position.setInterpolate3(position, position - btVector3(0, 0, 64), down.m_closestHitFraction);
+            }
+            actor.mPosition = position;
+        }
+
+        /// Move the collision objects to where the actors were solved to
+        void commit()
+        {
+            for (TestActor& actor : mActors)
+            {
+                actor.mObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), actor.mPosition));
+                mWorld.updateSingleAabb(actor.mObject.get());
+            }
+        }
+
+        std::vector<TestActor>& getActors() { return mActors; }
+
+    private:
+        void addStatic(btCollisionShape* shape, const btVector3& position)
+        {
+            mStatics.emplace_back(new btCollisionObject);
+            mStatics.back()->setCollisionShape(shape);
+            mStatics.back()->setWorldTransform(btTransform(btQuaternion::getIdentity(), position));
+            mWorld.addCollisionObject(mStatics.back().get(), 1, 2);
+        }
+
+        btDefaultCollisionConfiguration mConfiguration;
+        btCollisionDispatcher mDispatcher;
+        btDbvtBroadphase mBroadphase;
+        btCollisionWorld mWorld;
+
+        btBoxShape mFloorShape;
+        btBoxShape mPillarShape;
+        btBoxShape mActorShape;
+
+        std::vector<std::unique_ptr<btCollisionObject> > mStatics;
+        std::vector<TestActor> mActors;
+    };
+
+    bool isThreadSafeBullet()
+    {
+#if BT_BULLET_VERSION >= 286
+        btDbvtBroadphase broadphase;
+        return broadphase.m_rayTestStacks.size() > 1;
+#else
+        return false;
+#endif
+    }
+
+    /// One physics frame of PhysicsSystem::applyQueuedMovement.
+    /// @param state.range(0) Number of actors.
+    /// @param state.range(1) Number of worker threads, 0 solves all actors on the calling thread.
+    void moveActors(benchmark::State& state)
+    {
+        if (state.range(1) > 0 && !isThreadSafeBullet())
+        {
+            state.SkipWithError("Bullet was built without BT_THREADSAFE");
+            return;
+        }
+
+        TestCell cell(state.range(0));
+        std::vector<TestActor>& actors = cell.getActors();
+        osg::ref_ptr<SceneUtil::WorkQueue> workQueue = new SceneUtil::WorkQueue(state.range(1));
+
+        for (auto _ : state)
+        {
+            if (state.range(1) > 0)
+                workQueue->parallelFor(actors.size(), [&] (unsigned int index) { cell.solve(actors[index]); });
+            else
+            {
+                for (TestActor& actor : actors)
+                    cell.solve(actor);
+            }
+            cell.commit();
+        }
+        state.SetItemsProcessed(state.iterations() * actors.size());
+    }
+}
+
+BENCHMARK(moveActors)
+    ->Args({100, 0})->Args({100, 1})->Args({100, 2})->Args({100, 4})
+    ->Args({300, 0})->Args({300, 1})->Args({300, 2})->Args({300, 4})
+    ->Unit(benchmark::kMillisecond);
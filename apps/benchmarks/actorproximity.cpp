@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <components/misc/spatialgrid.hpp>
+
+namespace
+{
+    const float sCellSize = 8192;
+    const float sGridCellSize = 1024;
+
+    /// Actors spread over one exterior cell, as the head tracking and sneak checks of MWMechanics::Actors see them.
+    std::vector<osg::Vec3f> makeActors(int count)
+    {
+        std::mt19937 generator(count);
+        std::uniform_real_distribution<float> coordinate(0, sCellSize);
+        std::vector<osg::Vec3f> positions;
+        for (int i = 0; i < count; ++i)
+            positions.push_back(osg::Vec3f(coordinate(generator), coordinate(generator), 0));
+        return positions;
+    }
+
+    /// Every actor looks for the actors within state.range(1) of it, by going through all of them.
+    /// @param state.range(0) Number of actors.
+    void findNeighboursByScan(benchmark::State& state)
+    {
+        const std::vector<osg::Vec3f> positions = makeActors(state.range(0));
+        const float radius = state.range(1);
+        std::vector<int> out;
+
+        for (auto _ : state)
+        {
+            for (const osg::Vec3f& position : positions)
+            {
+                out.clear();
+                for (size_t i = 0; i < positions.size(); ++i)
+                    if ((positions[i] - position).length2() <= radius * radius)
+                        out.push_back(i);
+                benchmark::DoNotOptimize(out.data());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * positions.size());
+    }
+
+    /// Same as findNeighboursByScan, through a grid that is rebuilt once per iteration, as once per frame.
+    void findNeighboursByGrid(benchmark::State& state)
+    {
+        const std::vector<osg::Vec3f> positions = makeActors(state.range(0));
+        const float radius = state.range(1);
+        Misc::SpatialGrid<int> grid(sGridCellSize);
+        std::vector<int> out;
+
+        for (auto _ : state)
+        {
+            grid.clear();
+            for (size_t i = 0; i < positions.size(); ++i)
+                grid.add(i, positions[i]);
+
+            for (const osg::Vec3f& position : positions)
+            {
+                out.clear();
+                grid.getInRange(position, radius, out);
+                benchmark::DoNotOptimize(out.data());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * positions.size());
+    }
+}
+
+// 500 is about the head tracking distance, 7168 the AI processing distance
+BENCHMARK(findNeighboursByScan)->Args({300, 500})->Args({300, 7168});
+BENCHMARK(findNeighboursByGrid)->Args({300, 500})->Args({300, 7168});
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <components/esm/loadmgef.hpp>
+#include <components/esm/loadskil.hpp>
+#include <components/sceneutil/commandbuffer.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "../openmw/mwmechanics/magiceffects.hpp"
+#include "../openmw/mwmechanics/stat.hpp"
+
+namespace
+{
+    const int sNumNpcs = 200;
+
+    /// The part of an NPC that MWMechanics::Actors::updateNpc() touches
+    struct TestNpc
+    {
+        MWMechanics::MagicEffects mEffects;
+        MWMechanics::SkillValue mSkills[ESM::Skill::Length];
+        float mTimeToStartDrowning;
+        float mHealth;
+    };
+
+    std::vector<TestNpc> makeNpcs()
+    {
+        std::vector<TestNpc> npcs(sNumNpcs);
+        for (int i = 0; i < sNumNpcs; ++i)
+        {
+            // A few active effects, as a buffed or diseased NPC has
+            npcs[i].mEffects.add(MWMechanics::EffectKey(ESM::MagicEffect::FortifySkill, i % ESM::Skill::Length), 10);
+            npcs[i].mEffects.add(MWMechanics::EffectKey(ESM::MagicEffect::DrainSkill, (i * 7) % ESM::Skill::Length), 5);
+            npcs[i].mEffects.add(MWMechanics::EffectKey(ESM::MagicEffect::FortifyAttribute, i % 8), 10);
+            npcs[i].mEffects.add(MWMechanics::EffectKey(ESM::MagicEffect::ResistFire), 20);
+            npcs[i].mTimeToStartDrowning = (i % 10) * 2.f;
+            npcs[i].mHealth = 100.f;
+        }
+        return npcs;
+    }
+
+    /// Same work as Actors::updateNpc(): the skill modifiers and the drowning timer
+    void updateNpc(std::vector<TestNpc>& npcs, unsigned int index, SceneUtil::CommandBuffer& commands)
+    {
+        const float duration = 1.f / 60.f;
+        TestNpc& npc = npcs[index];
+        const MWMechanics::MagicEffects& effects = npc.mEffects;
+        for (int i = 0; i < ESM::Skill::Length; ++i)
+        {
+            npc.mSkills[i].setModifier(static_cast<int>(
+                effects.get(MWMechanics::EffectKey(ESM::MagicEffect::FortifySkill, i)).getMagnitude() -
+                effects.get(MWMechanics::EffectKey(ESM::MagicEffect::DrainSkill, i)).getMagnitude() -
+                effects.get(MWMechanics::EffectKey(ESM::MagicEffect::AbsorbSkill, i)).getMagnitude()));
+        }
+
+        if (effects.get(ESM::MagicEffect::WaterBreathing).getMagnitude() == 0)
+        {
+            npc.mTimeToStartDrowning = std::max(0.f, npc.mTimeToStartDrowning - duration);
+            if (npc.mTimeToStartDrowning == 0.f)
+            {
+                const float damage = 3.f * duration;
+                commands.push([&npcs, index, damage] { npcs[index].mHealth -= damage; });
+            }
+        }
+    }
+
+    /// Updates every NPC once per iteration, in parallel on the given number of worker threads,
+    /// or right after each other without any. Compare to see what the batching costs and saves.
+    void updateNpcs(benchmark::State& state)
+    {
+        const int numThreads = state.range(0);
+        osg::ref_ptr<SceneUtil::WorkQueue> workQueue;
+        if (numThreads > 0)
+            workQueue = new SceneUtil::WorkQueue(numThreads);
+
+        std::vector<TestNpc> npcs = makeNpcs();
+        for (auto _ : state)
+        {
+            if (!workQueue)
+            {
+                for (unsigned int i = 0; i < npcs.size(); ++i)
+                {
+                    SceneUtil::CommandBuffer commands;
+                    updateNpc(npcs, i, commands);
+                    commands.commit();
+                }
+            }
+            else
+            {
+                SceneUtil::runJobs(workQueue.get(), npcs.size(), [&npcs] (unsigned int index, SceneUtil::CommandBuffer& commands)
+                {
+                    updateNpc(npcs, index, commands);
+                });
+            }
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * npcs.size());
+    }
+}
+
+BENCHMARK(updateNpcs)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
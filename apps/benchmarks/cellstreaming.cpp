@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <osg/Group>
+#include <osg/Timer>
+
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/vfs/filesystemarchive.hpp>
+#include <components/vfs/manager.hpp>
+
+#include "../openmw/mwworld/cellstreamer.hpp"
+
+namespace
+{
+    const size_t sMaxModels = 300;
+    const float sCellSize = 8192;
+
+    // A busy exterior cell, e.g. around Balmora
+    const int sObjectsPerCell = 400;
+
+    /// The models under meshes/ of the data directory in OPENMW_BENCHMARK_DATA, as in resourceloading.cpp.
+    class Models
+    {
+        std::unique_ptr<VFS::Manager> mVFS;
+        std::vector<std::string> mNames;
+
+    public:
+        Models()
+        {
+            const char* dataDir = std::getenv("OPENMW_BENCHMARK_DATA");
+            if (!dataDir)
+                return;
+
+            mVFS.reset(new VFS::Manager(false));
+            mVFS->addArchive(new VFS::FileSystemArchive(dataDir));
+            mVFS->buildIndex();
+
+            for (const auto& file : mVFS->getRecursiveDirectoryIterator("meshes/"))
+            {
+                const std::string& name = file.first;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nif") == 0)
+                    mNames.push_back(name);
+                if (mNames.size() >= sMaxModels)
+                    break;
+            }
+        }
+
+        const VFS::Manager* getVFS() const { return mVFS.get(); }
+        const std::vector<std::string>& getNames() const { return mNames; }
+    };
+
+    const Models& getModels()
+    {
+        static Models models;
+        return models;
+    }
+
+    struct Object
+    {
+        osg::Vec3f mPosition;
+        const std::string* mModel;
+    };
+
+    /// The row of three cells loaded when walking north over a cell border with the default grid, their models
+    /// preloaded as the CellPreloader does before the player gets there.
+    std::vector<std::vector<Object> > makeCells(const Models& models)
+    {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<float> coordinate(0, sCellSize);
+        std::uniform_int_distribution<size_t> model(0, models.getNames().size() - 1);
+
+        std::vector<std::vector<Object> > cells (3);
+        for (int x = 0; x < 3; ++x)
+        {
+            for (int i = 0; i < sObjectsPerCell; ++i)
+            {
+                Object object;
+                object.mPosition = osg::Vec3f((x - 1) * sCellSize + coordinate(generator), sCellSize + coordinate(generator), 0);
+                object.mModel = &models.getNames()[model(generator)];
+                cells[x].push_back(object);
+            }
+        }
+        return cells;
+    }
+
+    /// Cross the border, inserting each object as the instance of its model in the scene graph, which is the bulk
+    /// of Class::insertObjectRendering, and run frames until all cells are in.
+    /// @param state.range(0) Streaming budget in milliseconds per frame, 0 to insert everything in one frame as
+    /// Scene::changeCellGrid does without streaming.
+    void crossCellBorder(benchmark::State& state)
+    {
+        const Models& models = getModels();
+        if (models.getNames().empty())
+        {
+            state.SkipWithError("Set OPENMW_BENCHMARK_DATA to a directory with meshes");
+            return;
+        }
+
+        Resource::ResourceSystem resourceSystem(models.getVFS());
+        Resource::SceneManager* sceneManager = resourceSystem.getSceneManager();
+        for (const std::string& name : models.getNames())
+            sceneManager->getTemplate(name);
+
+        const std::vector<std::vector<Object> > cells = makeCells(models);
+        const osg::Vec3f eye (sCellSize / 2, sCellSize - 100, 0);
+        const osg::Vec3f direction (0, 1, 0);
+
+        double longestFrames = 0;
+        size_t frames = 0;
+        for (auto _ : state)
+        {
+            osg::ref_ptr<osg::Group> root (new osg::Group);
+            MWWorld::CellStreamer streamer(state.range(0));
+            for (const std::vector<Object>& cell : cells)
+            {
+                osg::ref_ptr<osg::Group> cellNode (new osg::Group);
+                const unsigned int id = streamer.addCell([root, cellNode] () { root->addChild(cellNode); });
+                for (const Object& object : cell)
+                    streamer.addObject(id, object.mPosition, [sceneManager, cellNode, &object] ()
+                    {
+                        sceneManager->getInstance(*object.mModel, cellNode);
+                    });
+            }
+
+            double longestFrame = 0;
+            while (!streamer.isEmpty())
+            {
+                const osg::Timer_t start = osg::Timer::instance()->tick();
+                streamer.update(eye, direction);
+                longestFrame = std::max(longestFrame, osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()));
+                ++frames;
+            }
+            longestFrames += longestFrame;
+
+            state.PauseTiming();
+            root = NULL;
+            state.ResumeTiming();
+        }
+        state.counters["objects"] = cells.size() * sObjectsPerCell;
+        state.counters["frames"] = benchmark::Counter(frames, benchmark::Counter::kAvgIterations);
+        state.counters["longest frame ms"] = benchmark::Counter(longestFrames, benchmark::Counter::kAvgIterations);
+    }
+}
+
+BENCHMARK(crossCellBorder)->ArgName("budget ms")->Arg(0)->Arg(2)->Arg(5)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,209 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../openmw/mwmechanics/revisioncheck.hpp"
+
+namespace
+{
+    const int sNumItems = 60;
+    const int sNumSpells = 40;
+    const int sCarriedRight = 16;
+
+    /// The part of MWWorld::Class that choosing a combat action asks each item about
+    class TestItemClass
+    {
+    public:
+        virtual ~TestItemClass() {}
+        virtual std::string getEnchantment() const { return std::string(); }
+        virtual std::pair<std::vector<int>, bool> getEquipmentSlots() const
+        {
+            return std::make_pair(std::vector<int>(), false);
+        }
+        virtual bool isPotion() const { return false; }
+    };
+
+    class TestMisc : public TestItemClass
+    {
+    };
+
+    class TestPotion : public TestItemClass
+    {
+    public:
+        bool isPotion() const override { return true; }
+    };
+
+    class TestWeapon : public TestItemClass
+    {
+    public:
+        explicit TestWeapon(const std::string& enchantment) : mEnchantment(enchantment) {}
+        std::string getEnchantment() const override { return mEnchantment; }
+        std::pair<std::vector<int>, bool> getEquipmentSlots() const override
+        {
+            return std::make_pair(std::vector<int>(1, sCarriedRight), false);
+        }
+
+    private:
+        std::string mEnchantment;
+    };
+
+    /// Mostly junk, like the inventory of an NPC in a brawl, with a few potions and weapons
+    struct TestInventory
+    {
+        std::vector<std::unique_ptr<TestItemClass> > mItems;
+        unsigned int mRevision;
+
+        TestInventory() : mRevision(1)
+        {
+            for (int i = 0; i < sNumItems; ++i)
+            {
+                if (i % 10 == 0)
+                    mItems.emplace_back(new TestPotion);
+                else if (i % 15 == 1)
+                    mItems.emplace_back(new TestWeapon(i % 2 ? "fire enchantment" : ""));
+                else
+                    mItems.emplace_back(new TestMisc);
+            }
+        }
+
+        unsigned int getRevision() const { return mRevision; }
+    };
+
+    struct TestSpell
+    {
+        bool mCastable;
+    };
+
+    /// Mostly abilities and diseases, with a few spells that can be cast
+    struct TestSpells
+    {
+        std::vector<TestSpell> mSpells;
+        unsigned int mRevision;
+
+        TestSpells() : mRevision(1)
+        {
+            for (int i = 0; i < sNumSpells; ++i)
+                mSpells.push_back(TestSpell{i % 5 == 0});
+        }
+
+        unsigned int getRevision() const { return mRevision; }
+    };
+
+    /// Stands in for rateAction(); only its number of calls matters here
+    float rate(const void* candidate)
+    {
+        benchmark::DoNotOptimize(candidate);
+        return 1.f;
+    }
+
+    /// What prepareNextAction() did before the cache: go through every item and spell
+    float selectAll(const TestInventory& inventory, const TestSpells& spells)
+    {
+        float best = 0.f;
+        for (const auto& item : inventory.mItems)
+        {
+            if (item->isPotion())
+                best = std::max(best, rate(item.get()));
+            if (!item->getEnchantment().empty())
+                best = std::max(best, rate(item.get()));
+            std::vector<int> slots = item->getEquipmentSlots().first;
+            if (std::find(slots.begin(), slots.end(), sCarriedRight) != slots.end())
+                best = std::max(best, rate(item.get()));
+        }
+        for (const TestSpell& spell : spells.mSpells)
+        {
+            if (spell.mCastable)
+                best = std::max(best, rate(&spell));
+        }
+        return best;
+    }
+
+    /// What CombatActionCache does: list the candidates once per revision, then only go through those
+    struct TestCache
+    {
+        MWMechanics::RevisionCheck<TestInventory> mStore;
+        MWMechanics::RevisionCheck<TestSpells> mSpellList;
+        std::vector<const TestItemClass*> mPotions;
+        std::vector<const TestItemClass*> mMagicItems;
+        std::vector<const TestItemClass*> mWeapons;
+        std::vector<const TestSpell*> mSpells;
+
+        void update(const TestInventory& inventory, const TestSpells& spells)
+        {
+            if (mStore.update(inventory))
+            {
+                mPotions.clear();
+                mMagicItems.clear();
+                mWeapons.clear();
+                for (const auto& item : inventory.mItems)
+                {
+                    if (item->isPotion())
+                        mPotions.push_back(item.get());
+                    if (!item->getEnchantment().empty())
+                        mMagicItems.push_back(item.get());
+                    std::vector<int> slots = item->getEquipmentSlots().first;
+                    if (std::find(slots.begin(), slots.end(), sCarriedRight) != slots.end())
+                        mWeapons.push_back(item.get());
+                }
+            }
+
+            if (mSpellList.update(spells))
+            {
+                mSpells.clear();
+                for (const TestSpell& spell : spells.mSpells)
+                {
+                    if (spell.mCastable)
+                        mSpells.push_back(&spell);
+                }
+            }
+        }
+
+        float select(const TestInventory& inventory, const TestSpells& spells)
+        {
+            update(inventory, spells);
+            float best = 0.f;
+            for (const TestItemClass* item : mPotions)
+                best = std::max(best, rate(item));
+            for (const TestItemClass* item : mMagicItems)
+                best = std::max(best, rate(item));
+            for (const TestItemClass* item : mWeapons)
+                best = std::max(best, rate(item));
+            for (const TestSpell* spell : mSpells)
+                best = std::max(best, rate(spell));
+            return best;
+        }
+    };
+
+    void selectCombatActionUncached(benchmark::State& state)
+    {
+        const TestInventory inventory;
+        const TestSpells spells;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(selectAll(inventory, spells));
+    }
+
+    /// The argument is how many selections in a row find the inventory unchanged; 1 means it changes every time.
+    void selectCombatActionCached(benchmark::State& state)
+    {
+        const int unchanged = state.range(0);
+        TestInventory inventory;
+        const TestSpells spells;
+        TestCache cache;
+        int count = 0;
+        for (auto _ : state)
+        {
+            if (++count == unchanged)
+            {
+                count = 0;
+                ++inventory.mRevision;
+            }
+            benchmark::DoNotOptimize(cache.select(inventory, spells));
+        }
+    }
+}
+
+BENCHMARK(selectCombatActionUncached);
+BENCHMARK(selectCombatActionCached)->Arg(1)->Arg(10)->Arg(1000);
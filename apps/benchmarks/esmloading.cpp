@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/esm/loadweap.hpp>
+#include <components/files/constrainedfilestream.hpp>
+#include <components/files/mappedfilestream.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace
+{
+    namespace bfs = boost::filesystem;
+
+    const int sRecordsPerFile = 2000;
+
+    /// A synthetic load order of plugins filled with weapon records, written to a temporary
+    /// directory on first use and removed again on exit.
+    class ContentList
+    {
+        bfs::path mDirectory;
+        std::vector<std::string> mFiles;
+
+    public:
+        ContentList()
+            : mDirectory(bfs::temp_directory_path() / bfs::unique_path("openmw-benchmark-%%%%-%%%%"))
+        {
+            bfs::create_directories(mDirectory);
+        }
+
+        ~ContentList()
+        {
+            boost::system::error_code ec;
+            bfs::remove_all(mDirectory, ec);
+        }
+
+        const std::vector<std::string>& get(size_t count)
+        {
+            while (mFiles.size() < count)
+                mFiles.push_back(write(mFiles.size()));
+            return mFiles;
+        }
+
+    private:
+        std::string write(size_t index)
+        {
+            std::ostringstream name;
+            name << "plugin" << index << ".esp";
+            std::string path = (mDirectory / name.str()).string();
+
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.setVersion();
+            writer.setRecordCount(sRecordsPerFile);
+            writer.setAuthor("benchmark");
+            writer.setDescription("Synthetic content file");
+
+            std::ofstream stream(path.c_str(), std::ios::binary);
+            writer.save(stream);
+
+            for (int i = 0; i < sRecordsPerFile; ++i)
+            {
+                std::ostringstream id;
+                id << "weapon_" << index << "_" << i;
+
+                ESM::Weapon weapon;
+                weapon.blank();
+                weapon.mId = id.str();
+                weapon.mName = "Synthetic Weapon of Benchmarking";
+                weapon.mModel = "w\\w_synthetic_weapon.nif";
+                weapon.mIcon = "w\\tx_synthetic_weapon.tga";
+                weapon.mScript = "syntheticWeaponScript";
+
+                writer.startRecord(ESM::Weapon::sRecordId);
+                weapon.save(writer);
+                writer.endRecord(ESM::Weapon::sRecordId);
+            }
+
+            writer.close();
+            return path;
+        }
+    };
+
+    ContentList sContentList;
+
+    template <Files::IStreamPtr (*Open)(const char*, size_t, size_t)>
+    void loadContentList(benchmark::State& state)
+    {
+        const std::vector<std::string>& files = sContentList.get(state.range(0));
+        ToUTF8::Utf8Encoder encoder(ToUTF8::WINDOWS_1252);
+
+        for (auto _ : state)
+        {
+            size_t records = 0;
+            for (size_t i = 0; i < static_cast<size_t>(state.range(0)); ++i)
+            {
+                ESM::ESMReader reader;
+                reader.setEncoder(&encoder);
+                reader.open(Open(files[i].c_str(), 0, 0xFFFFFFFF), files[i]);
+
+                while (reader.hasMoreRecs())
+                {
+                    reader.getRecName();
+                    reader.getRecHeader();
+
+                    ESM::Weapon weapon;
+                    bool isDeleted = false;
+                    weapon.load(reader, isDeleted);
+                    benchmark::DoNotOptimize(weapon);
+                    ++records;
+                }
+            }
+            state.counters["records"] = records;
+        }
+    }
+
+    void constrainedFileStream(benchmark::State& state)
+    {
+        loadContentList<Files::openConstrainedFileStream>(state);
+    }
+
+    void mappedFileStream(benchmark::State& state)
+    {
+        loadContentList<Files::openMappedFileStream>(state);
+    }
+}
+
+BENCHMARK(constrainedFileStream)->Arg(30)->Arg(300)->Unit(benchmark::kMillisecond);
+BENCHMARK(mappedFileStream)->Arg(30)->Arg(300)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/esm/loadscpt.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace
+{
+    namespace bfs = boost::filesystem;
+
+    const int sNumScripts = 5000;
+
+    /// A plugin with scripts of a few kilobytes each, about the size of the larger vanilla ones
+    class ScriptPlugin
+    {
+        std::string mFile;
+
+    public:
+        ScriptPlugin()
+            : mFile((bfs::temp_directory_path() / bfs::unique_path("openmw-benchmark-%%%%-%%%%.esp")).string())
+        {
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.setVersion();
+            writer.setRecordCount(sNumScripts);
+
+            std::ofstream stream(mFile.c_str(), std::ios::binary);
+            writer.save(stream);
+
+            for (int i = 0; i < sNumScripts; ++i)
+            {
+                std::ostringstream id;
+                id << "benchmark_script_" << i;
+
+                ESM::Script script;
+                script.mId = id.str();
+                script.blank();
+
+                std::ostringstream text;
+                text << "Begin " << script.mId << "\n\nshort doOnce\n\n";
+                for (int line = 0; line < 60; ++line)
+                    text << "if ( GetJournalIndex \"benchmark_quest\" >= " << line << " )\n    set doOnce to 1\nendif\n";
+                text << "\nEnd " << script.mId << "\n";
+                script.mScriptText = text.str();
+
+                writer.startRecord(ESM::Script::sRecordId);
+                script.save(writer);
+                writer.endRecord(ESM::Script::sRecordId);
+            }
+
+            writer.close();
+        }
+
+        ~ScriptPlugin()
+        {
+            boost::system::error_code ec;
+            bfs::remove(mFile, ec);
+        }
+
+        const std::string& get() const
+        {
+            return mFile;
+        }
+    };
+
+    ScriptPlugin sScriptPlugin;
+
+    void loadScripts(benchmark::State& state)
+    {
+        ToUTF8::Utf8Encoder encoder(ToUTF8::WINDOWS_1252);
+        const bool lazy = state.range(0) != 0;
+
+        for (auto _ : state)
+        {
+            ESM::ESMReader reader;
+            reader.setEncoder(&encoder);
+            reader.setLazyLoading(lazy);
+            reader.open(sScriptPlugin.get());
+
+            std::vector<ESM::Script> scripts;
+            scripts.reserve(sNumScripts);
+            while (reader.hasMoreRecs())
+            {
+                reader.getRecName();
+                reader.getRecHeader();
+
+                scripts.push_back(ESM::Script());
+                bool isDeleted = false;
+                scripts.back().load(reader, isDeleted);
+            }
+
+            // Text that stays in memory after loading
+            size_t residentText = 0;
+            for (std::vector<ESM::Script>::const_iterator it = scripts.begin(); it != scripts.end(); ++it)
+            {
+                if (!it->mScriptText.isDeferred())
+                    residentText += it->mScriptText.get().capacity();
+            }
+            state.counters["resident text KiB"] = residentText / 1024;
+        }
+    }
+}
+
+BENCHMARK(loadScripts)->ArgName("lazy")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
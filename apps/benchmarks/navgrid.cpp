@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <components/navigator/navgrid.hpp>
+#include <components/navigator/navgridbuilder.hpp>
+
+namespace
+{
+    const float sCellSize = 8192;
+
+    /// Rolling hills with boxes of all sizes standing on them, as a stand-in for the terrain and buildings of an
+    /// exterior cell. Answers the builder without Bullet, so that only the builder itself is measured.
+    class TestCell : public Navigator::Geometry
+    {
+    public:
+        explicit TestCell(int numBoxes)
+        {
+            std::mt19937 generator(numBoxes);
+            std::uniform_real_distribution<float> position(0, sCellSize);
+            std::uniform_real_distribution<float> size(64, 1024);
+            std::uniform_real_distribution<float> height(20, 400);
+            for (int i = 0; i < numBoxes; ++i)
+            {
+                const float x = position(generator);
+                const float y = position(generator);
+                const float width = size(generator);
+                const float depth = size(generator);
+                const float ground = getGroundHeight(x, y);
+                Box box = {osg::Vec3f(x - width / 2, y - depth / 2, ground - 50),
+                           osg::Vec3f(x + width / 2, y + depth / 2, ground + height(generator))};
+                mBoxes.push_back(box);
+            }
+        }
+
+        virtual void castDown(float x, float y, float fromZ, float toZ, std::vector<Hit>& hits) const
+        {
+            const size_t first = hits.size();
+            for (const Box& box : mBoxes)
+            {
+                if (x >= box.mMin.x() && x <= box.mMax.x() && y >= box.mMin.y() && y <= box.mMax.y()
+                        && box.mMax.z() <= fromZ && box.mMax.z() >= toZ)
+                {
+                    Hit hit = {box.mMax.z(), 1.f};
+                    hits.push_back(hit);
+                }
+            }
+
+            const float dx = 200.f / 1500 * std::cos(x / 1500) * std::cos(y / 1300);
+            const float dy = -200.f / 1300 * std::sin(x / 1500) * std::sin(y / 1300);
+            Hit ground = {getGroundHeight(x, y), 1.f / std::sqrt(1 + dx * dx + dy * dy)};
+            hits.push_back(ground);
+
+            std::sort(hits.begin() + first, hits.end(), [] (const Hit& left, const Hit& right) { return left.mZ > right.mZ; });
+        }
+
+        virtual bool isBlocked(const osg::Vec3f& from, const osg::Vec3f& to) const
+        {
+            for (const Box& box : mBoxes)
+            {
+                float enter = 0;
+                float leave = 1;
+                for (int axis = 0; axis < 3 && enter <= leave; ++axis)
+                {
+                    const float delta = to[axis] - from[axis];
+                    if (delta == 0)
+                    {
+                        if (from[axis] < box.mMin[axis] || from[axis] > box.mMax[axis])
+                            leave = -1;
+                        continue;
+                    }
+                    const float near = (box.mMin[axis] - from[axis]) / delta;
+                    const float far = (box.mMax[axis] - from[axis]) / delta;
+                    enter = std::max(enter, std::min(near, far));
+                    leave = std::min(leave, std::max(near, far));
+                }
+                if (enter <= leave)
+                    return true;
+            }
+            return false;
+        }
+
+        static float getGroundHeight(float x, float y)
+        {
+            return 200 * std::sin(x / 1500) * std::cos(y / 1300);
+        }
+
+    private:
+        struct Box
+        {
+            osg::Vec3f mMin;
+            osg::Vec3f mMax;
+        };
+
+        std::vector<Box> mBoxes;
+    };
+
+    osg::ref_ptr<Navigator::NavGrid> buildCell(const TestCell& cell)
+    {
+        return Navigator::buildNavGrid(cell, osg::Vec3f(0, 0, -500), osg::Vec3f(sCellSize, sCellSize, 1000),
+                                       Navigator::BuildSettings());
+    }
+
+    /// Build the grid of one exterior cell, as the navigation worker thread does when a cell without a cached grid loads.
+    /// @param state.range(0) Number of boxes in the cell.
+    void buildNavGrid(benchmark::State& state)
+    {
+        const TestCell cell (state.range(0));
+        for (auto _ : state)
+            benchmark::DoNotOptimize(buildCell(cell).get());
+    }
+
+    /// Find paths between random points of one exterior cell, as PathFinder does for AI packages.
+    /// @param state.range(1) Longest distance between the points.
+    void findPathOnNavGrid(benchmark::State& state)
+    {
+        const TestCell cell (state.range(0));
+        osg::ref_ptr<Navigator::NavGrid> grid = buildCell(cell);
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> position(0, sCellSize);
+        std::uniform_real_distribution<float> offset(-state.range(1), state.range(1));
+        std::vector<std::pair<osg::Vec3f, osg::Vec3f> > queries;
+        while (queries.size() < 100)
+        {
+            const float x = position(generator);
+            const float y = position(generator);
+            const float endX = std::min(std::max(x + offset(generator), 0.f), sCellSize);
+            const float endY = std::min(std::max(y + offset(generator), 0.f), sCellSize);
+            queries.push_back(std::make_pair(osg::Vec3f(x, y, TestCell::getGroundHeight(x, y)),
+                                             osg::Vec3f(endX, endY, TestCell::getGroundHeight(endX, endY))));
+        }
+
+        std::vector<osg::Vec3f> path;
+        size_t index = 0;
+        for (auto _ : state)
+        {
+            const std::pair<osg::Vec3f, osg::Vec3f>& query = queries[index++ % queries.size()];
+            benchmark::DoNotOptimize(grid->findPath(query.first, query.second, 64, path));
+        }
+    }
+}
+
+BENCHMARK(buildNavGrid)->Arg(100)->Unit(benchmark::kMillisecond);
+// 2048 is about how far AiWander and AiTravel paths go, 8192 crosses the cell
+BENCHMARK(findPathOnNavGrid)->Args({100, 2048})->Args({100, 8192})->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,151 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <osg/Node>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <components/resource/bulletshape.hpp>
+#include <components/resource/bulletshapemanager.hpp>
+#include <components/resource/compiledcache.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/vfs/filesystemarchive.hpp>
+#include <components/vfs/manager.hpp>
+
+namespace
+{
+    const size_t sMaxModels = 2000;
+
+    /// The models under meshes/ of the data directory in OPENMW_BENCHMARK_DATA, as in resourceloading.cpp.
+    class Models
+    {
+        std::unique_ptr<VFS::Manager> mVFS;
+        std::vector<std::string> mNames;
+
+    public:
+        Models()
+        {
+            const char* dataDir = std::getenv("OPENMW_BENCHMARK_DATA");
+            if (!dataDir)
+                return;
+
+            mVFS.reset(new VFS::Manager(false));
+            mVFS->addArchive(new VFS::FileSystemArchive(dataDir));
+            mVFS->buildIndex();
+
+            for (const auto& file : mVFS->getRecursiveDirectoryIterator("meshes/"))
+            {
+                const std::string& name = file.first;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nif") == 0)
+                    mNames.push_back(name);
+                if (mNames.size() >= sMaxModels)
+                    break;
+            }
+        }
+
+        const VFS::Manager* getVFS() const { return mVFS.get(); }
+        const std::vector<std::string>& getNames() const { return mNames; }
+    };
+
+    const Models& getModels()
+    {
+        static Models models;
+        return models;
+    }
+
+    /// A cache directory that is removed again after the benchmark.
+    class TemporaryDirectory
+    {
+        boost::filesystem::path mPath;
+
+    public:
+        TemporaryDirectory()
+            : mPath(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+        {
+        }
+
+        ~TemporaryDirectory()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mPath, ec);
+        }
+
+        const boost::filesystem::path& getPath() const { return mPath; }
+    };
+
+    /// @param state.range(0) 0 converts every NIF, 1 reads from a compiled cache filled before timing.
+    void loadScenes(benchmark::State& state)
+    {
+        const Models& models = getModels();
+        if (models.getNames().empty())
+        {
+            state.SkipWithError("Set OPENMW_BENCHMARK_DATA to a directory with meshes");
+            return;
+        }
+
+        TemporaryDirectory directory;
+        Resource::ResourceSystem resourceSystem(models.getVFS());
+        if (state.range(0))
+        {
+            resourceSystem.setCompiledCache(new Resource::CompiledCache(directory.getPath(), models.getVFS()));
+            for (const std::string& name : models.getNames())
+                resourceSystem.getSceneManager()->getTemplate(name);
+            resourceSystem.clearCache();
+        }
+
+        for (auto _ : state)
+        {
+            for (const std::string& name : models.getNames())
+                benchmark::DoNotOptimize(resourceSystem.getSceneManager()->getTemplate(name));
+
+            state.PauseTiming();
+            resourceSystem.clearCache();
+            state.ResumeTiming();
+        }
+        state.counters["models"] = models.getNames().size();
+    }
+
+    /// @param state.range(0) 0 converts every NIF, 1 reads from a compiled cache filled before timing.
+    void loadShapes(benchmark::State& state)
+    {
+        const Models& models = getModels();
+        if (models.getNames().empty())
+        {
+            state.SkipWithError("Set OPENMW_BENCHMARK_DATA to a directory with meshes");
+            return;
+        }
+
+        TemporaryDirectory directory;
+        Resource::ResourceSystem resourceSystem(models.getVFS());
+        Resource::BulletShapeManager shapeManager(models.getVFS(), resourceSystem.getSceneManager(), resourceSystem.getNifFileManager());
+        if (state.range(0))
+        {
+            resourceSystem.setCompiledCache(new Resource::CompiledCache(directory.getPath(), models.getVFS()));
+            shapeManager.setCompiledCache(resourceSystem.getCompiledCache());
+            for (const std::string& name : models.getNames())
+                shapeManager.getShape(name);
+            shapeManager.clearCache();
+            resourceSystem.clearCache();
+        }
+
+        for (auto _ : state)
+        {
+            for (const std::string& name : models.getNames())
+                benchmark::DoNotOptimize(shapeManager.getShape(name));
+
+            state.PauseTiming();
+            shapeManager.clearCache();
+            resourceSystem.clearCache();
+            state.ResumeTiming();
+        }
+        state.counters["models"] = models.getNames().size();
+    }
+}
+
+BENCHMARK(loadScenes)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(loadShapes)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../openmw/mwmechanics/pathgrid.hpp"
+
+namespace
+{
+    /// Points scattered over a cell and linked to those near them both ways, the way the construction set
+    /// generates pathgrids. Vanilla pathgrids have from a handful of points in small interiors to a few hundred
+    /// in towns and large dungeons.
+    ESM::Pathgrid makePathgrid(int numPoints)
+    {
+        const int cellSize = 8192;
+        const int linkDistance = static_cast<int>(1.5f * cellSize / std::sqrt(static_cast<float>(numPoints)));
+
+        std::mt19937 generator(numPoints);
+        std::uniform_int_distribution<int> coordinate(0, cellSize);
+        std::uniform_int_distribution<int> height(-200, 200);
+
+        ESM::Pathgrid pathgrid;
+        for (int i = 0; i < numPoints; ++i)
+            pathgrid.mPoints.push_back(ESM::Pathgrid::Point(coordinate(generator), coordinate(generator), height(generator)));
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            for (int j = 0; j < numPoints; ++j)
+            {
+                const ESM::Pathgrid::Point& a = pathgrid.mPoints[i];
+                const ESM::Pathgrid::Point& b = pathgrid.mPoints[j];
+                if (i != j && std::abs(a.mX - b.mX) + std::abs(a.mY - b.mY) < linkDistance)
+                {
+                    ESM::Pathgrid::Edge edge;
+                    edge.mV0 = i;
+                    edge.mV1 = j;
+                    pathgrid.mEdges.push_back(edge);
+                }
+            }
+        }
+        return pathgrid;
+    }
+
+    /// Set up the graph of a cell, as AiPackage does the first time an actor looks for a path in it.
+    /// @param state.range(0) Number of points.
+    void buildPathgridGraph(benchmark::State& state)
+    {
+        const ESM::Pathgrid pathgrid = makePathgrid(state.range(0));
+        for (auto _ : state)
+        {
+            MWMechanics::PathgridGraph graph (&pathgrid);
+            benchmark::DoNotOptimize(graph.getPathgrid());
+        }
+    }
+
+    /// Find paths between random points, as PathFinder does for AiWander, AiTravel and AiCombat.
+    /// @param state.range(0) Number of points.
+    /// @param state.range(1) Number of different paths asked for, more than the graph caches means every search misses.
+    void findPathOnPathgrid(benchmark::State& state)
+    {
+        const ESM::Pathgrid pathgrid = makePathgrid(state.range(0));
+        const MWMechanics::PathgridGraph graph (&pathgrid);
+
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> point(0, static_cast<int>(pathgrid.mPoints.size()) - 1);
+        std::vector<std::pair<int, int> > queries;
+        while (queries.size() < static_cast<size_t>(state.range(1)))
+        {
+            const int start = point(generator);
+            const int end = point(generator);
+            if (graph.isPointConnected(start, end))
+                queries.push_back(std::make_pair(start, end));
+        }
+
+        size_t index = 0;
+        for (auto _ : state)
+        {
+            const std::pair<int, int>& query = queries[index++ % queries.size()];
+            benchmark::DoNotOptimize(graph.aStarSearch(query.first, query.second));
+        }
+    }
+}
+
+BENCHMARK(buildPathgridGraph)->Arg(32)->Arg(128)->Arg(512);
+BENCHMARK(findPathOnPathgrid)->Args({32, 1000})->Args({128, 1000})->Args({512, 1000})->Args({512, 8});
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <components/esm/defs.hpp>
+#include <components/esm/refid.hpp>
+#include <components/misc/stringops.hpp>
+
+namespace
+{
+    const size_t sNumRecords = 20000;
+    const size_t sRefsPerCell = 500;
+
+    /// IDs as they appear in the NAME subrecord of cell references
+    std::vector<std::string> makeIds()
+    {
+        std::vector<std::string> ids;
+        for (size_t i = 0; i < sNumRecords; ++i)
+        {
+            std::ostringstream id;
+            id << "Furn_Com_Benchmark_Ref_" << i;
+            ids.push_back(id.str());
+        }
+        return ids;
+    }
+
+    const std::vector<std::string> sIds = makeIds();
+
+    /// Resolving the record type of every reference in a cell, as CellStore::loadRef() does.
+    /// This used to lower case the ID and look it up in a std::map<std::string, int>.
+    void resolveCellRefsString(benchmark::State& state)
+    {
+        std::map<std::string, int> ids;
+        for (size_t i = 0; i < sIds.size(); ++i)
+            ids[Misc::StringUtils::lowerCase(sIds[i])] = ESM::REC_STAT;
+
+        size_t first = 0;
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < sRefsPerCell; ++i)
+            {
+                std::string id = sIds[(first + i * 7919) % sIds.size()];
+                Misc::StringUtils::lowerCaseInPlace(id);
+                benchmark::DoNotOptimize(ids.find(id));
+            }
+            first += sRefsPerCell;
+        }
+    }
+
+    /// The same with RefIds, like ESM::CellRef::loadId() followed by ESMStore::find()
+    void resolveCellRefsRefId(benchmark::State& state)
+    {
+        std::unordered_map<ESM::RefId, int> ids;
+        for (size_t i = 0; i < sIds.size(); ++i)
+            ids[ESM::RefId(sIds[i])] = ESM::REC_STAT;
+
+        size_t first = 0;
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < sRefsPerCell; ++i)
+            {
+                ESM::RefId id(sIds[(first + i * 7919) % sIds.size()]);
+                benchmark::DoNotOptimize(ids.find(id));
+            }
+            first += sRefsPerCell;
+        }
+    }
+
+    /// Comparing the IDs of items, e.g. when ContainerStore::stacks() looks for a matching stack
+    void compareItemsString(benchmark::State& state)
+    {
+        std::vector<std::string> items(sIds.begin(), sIds.begin() + 100);
+        const std::string item = Misc::StringUtils::lowerCase(items.back());
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < items.size(); ++i)
+                benchmark::DoNotOptimize(Misc::StringUtils::ciEqual(items[i], item));
+        }
+    }
+
+    void compareItemsRefId(benchmark::State& state)
+    {
+        std::vector<ESM::RefId> items(sIds.begin(), sIds.begin() + 100);
+        const ESM::RefId item = items.back();
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < items.size(); ++i)
+                benchmark::DoNotOptimize(items[i] == item);
+        }
+    }
+}
+
+BENCHMARK(resolveCellRefsString)->Unit(benchmark::kMicrosecond);
+BENCHMARK(resolveCellRefsRefId)->Unit(benchmark::kMicrosecond);
+BENCHMARK(compareItemsString);
+BENCHMARK(compareItemsRefId);
@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <osg/Node>
+
+#include <components/resource/loadqueue.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/vfs/filesystemarchive.hpp>
+#include <components/vfs/manager.hpp>
+
+namespace
+{
+    const size_t sMaxModels = 2000;
+
+    /// The models under meshes/ of the data directory in OPENMW_BENCHMARK_DATA, e.g. the extracted
+    /// Data Files directory of a game installation. Disk caches are warm after the first run.
+    class Models
+    {
+        std::unique_ptr<VFS::Manager> mVFS;
+        std::vector<std::string> mNames;
+
+    public:
+        Models()
+        {
+            const char* dataDir = std::getenv("OPENMW_BENCHMARK_DATA");
+            if (!dataDir)
+                return;
+
+            mVFS.reset(new VFS::Manager(false));
+            mVFS->addArchive(new VFS::FileSystemArchive(dataDir));
+            mVFS->buildIndex();
+
+            for (const auto& file : mVFS->getRecursiveDirectoryIterator("meshes/"))
+            {
+                const std::string& name = file.first;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nif") == 0)
+                    mNames.push_back(name);
+                if (mNames.size() >= sMaxModels)
+                    break;
+            }
+        }
+
+        const VFS::Manager* getVFS() const { return mVFS.get(); }
+        const std::vector<std::string>& getNames() const { return mNames; }
+    };
+
+    const Models& getModels()
+    {
+        static Models models;
+        return models;
+    }
+
+    /// The way Scene::loadCell used to get its models: one after another on the calling thread.
+    void loadSynchronously(benchmark::State& state)
+    {
+        const Models& models = getModels();
+        if (models.getNames().empty())
+        {
+            state.SkipWithError("Set OPENMW_BENCHMARK_DATA to a directory with meshes");
+            return;
+        }
+
+        Resource::ResourceSystem resourceSystem(models.getVFS());
+        for (auto _ : state)
+        {
+            for (const std::string& name : models.getNames())
+                benchmark::DoNotOptimize(resourceSystem.getSceneManager()->getTemplate(name));
+
+            state.PauseTiming();
+            resourceSystem.clearCache();
+            state.ResumeTiming();
+        }
+        state.counters["models"] = models.getNames().size();
+    }
+
+    /// Requests all models at once, then waits for them as Scene::loadCell does now.
+    /// @param state.range(0) Number of worker threads, the waiting thread helps in addition.
+    void loadThroughQueue(benchmark::State& state)
+    {
+        const Models& models = getModels();
+        if (models.getNames().empty())
+        {
+            state.SkipWithError("Set OPENMW_BENCHMARK_DATA to a directory with meshes");
+            return;
+        }
+
+        Resource::ResourceSystem resourceSystem(models.getVFS());
+        osg::ref_ptr<SceneUtil::WorkQueue> workQueue = new SceneUtil::WorkQueue(state.range(0));
+        osg::ref_ptr<Resource::LoadQueue> loadQueue = new Resource::LoadQueue(&resourceSystem, workQueue);
+
+        for (auto _ : state)
+        {
+            std::vector<osg::ref_ptr<Resource::LoadRequest> > requests;
+            for (const std::string& name : models.getNames())
+                requests.push_back(loadQueue->requestTemplate(name, Resource::Priority_Visible));
+            for (const auto& request : requests)
+                request->wait();
+
+            state.PauseTiming();
+            requests.clear();
+            resourceSystem.clearCache();
+            state.ResumeTiming();
+        }
+        state.counters["models"] = models.getNames().size();
+    }
+}
+
+BENCHMARK(loadSynchronously)->Unit(benchmark::kMillisecond);
+BENCHMARK(loadThroughQueue)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond);
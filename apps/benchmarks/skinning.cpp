@@ -0,0 +1,166 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include <components/sceneutil/skinning.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+namespace
+{
+    const unsigned int sNumVertices = 2000;
+    const unsigned int sNumBones = 30;
+
+    typedef std::map<SceneUtil::Skinning::BoneWeights, std::vector<unsigned short> > Runs;
+
+    /// An NPC body of sNumVertices, as RigGeometry gets it from the influence map.
+    struct Rig
+    {
+        std::vector<osg::Vec3f> mPositions;
+        std::vector<osg::Vec3f> mNormals;
+        std::vector<osg::Vec4f> mTangents;
+        std::vector<osg::Matrixf> mInvBindMatrices;
+        std::vector<osg::Matrixf> mBoneMatrices;
+        Runs mRuns;
+
+        osg::ref_ptr<SceneUtil::Skinning> mSkinning;
+
+        std::vector<osg::Vec3f> mDstPositions;
+        std::vector<osg::Vec3f> mDstNormals;
+        std::vector<osg::Vec4f> mDstTangents;
+        std::vector<osg::Matrixf> mSkinningMatrices;
+    };
+
+    /// @param blendPercent How many vertices blend two to four bones, the others follow a single bone,
+    /// which is common for the limbs of Morrowind meshes.
+    Rig makeRig(int blendPercent, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> value(-1.f, 1.f);
+        std::uniform_int_distribution<unsigned int> bone(0, sNumBones - 1);
+        std::uniform_int_distribution<int> percent(0, 99);
+        std::uniform_int_distribution<unsigned int> numWeights(2, 4);
+
+        Rig rig;
+        for (unsigned int i = 0; i < sNumBones; ++i)
+        {
+            osg::Matrixf matrix;
+            for (int row = 0; row < 4; ++row)
+                for (int column = 0; column < 3; ++column)
+                    matrix(row, column) = value(generator);
+            rig.mInvBindMatrices.push_back(matrix);
+            rig.mBoneMatrices.push_back(matrix);
+        }
+
+        for (unsigned int i = 0; i < sNumVertices; ++i)
+        {
+            rig.mPositions.push_back(osg::Vec3f(value(generator), value(generator), value(generator)) * 50.f);
+            rig.mNormals.push_back(osg::Vec3f(value(generator), value(generator), value(generator)));
+            rig.mTangents.push_back(osg::Vec4f(value(generator), value(generator), value(generator), 1.f));
+
+            SceneUtil::Skinning::BoneWeights weights;
+            if (percent(generator) < blendPercent)
+            {
+                const unsigned int count = numWeights(generator);
+                for (unsigned int j = 0; j < count; ++j)
+                    weights.push_back(std::make_pair(bone(generator), 1.f / count));
+            }
+            else
+                weights.push_back(std::make_pair(i * sNumBones / sNumVertices, 1.f));
+            rig.mRuns[weights].push_back(i);
+        }
+
+        rig.mSkinning = new SceneUtil::Skinning(true, true);
+        for (Runs::const_iterator it = rig.mRuns.begin(); it != rig.mRuns.end(); ++it)
+            rig.mSkinning->addRun(it->first, it->second, &rig.mPositions[0], &rig.mNormals[0], &rig.mTangents[0]);
+
+        rig.mDstPositions.resize(sNumVertices);
+        rig.mDstNormals.resize(sNumVertices);
+        rig.mDstTangents = rig.mTangents;
+        rig.mSkinningMatrices.resize(sNumBones);
+        return rig;
+    }
+
+    /// What RigGeometry::cull used to do, matrix by matrix and vertex by vertex
+    void skinReference(Rig& rig)
+    {
+        for (Runs::const_iterator it = rig.mRuns.begin(); it != rig.mRuns.end(); ++it)
+        {
+            osg::Matrixf resultMat (0, 0, 0, 0,
+                                    0, 0, 0, 0,
+                                    0, 0, 0, 0,
+                                    0, 0, 0, 1);
+            for (SceneUtil::Skinning::BoneWeights::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
+            {
+                osg::Matrixf m = rig.mInvBindMatrices[weightIt->first] * rig.mBoneMatrices[weightIt->first];
+                for (int row = 0; row < 4; ++row)
+                    for (int column = 0; column < 3; ++column)
+                        resultMat(row, column) += m(row, column) * weightIt->second;
+            }
+
+            for (std::vector<unsigned short>::const_iterator vertexIt = it->second.begin(); vertexIt != it->second.end(); ++vertexIt)
+            {
+                const unsigned short vertex = *vertexIt;
+                rig.mDstPositions[vertex] = resultMat.preMult(rig.mPositions[vertex]);
+                rig.mDstNormals[vertex] = osg::Matrix::transform3x3(rig.mNormals[vertex], resultMat);
+                const osg::Vec4f& srcTangent = rig.mTangents[vertex];
+                osg::Vec3f transformedTangent = osg::Matrix::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
+                rig.mDstTangents[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+            }
+        }
+    }
+
+    /// What RigGeometry does now: the bone matrices on the cull thread, the vertices with SceneUtil::Skinning
+    void skin(Rig& rig)
+    {
+        for (unsigned int i = 0; i < sNumBones; ++i)
+            rig.mSkinningMatrices[i] = rig.mInvBindMatrices[i] * rig.mBoneMatrices[i];
+        rig.mSkinning->skin(&rig.mSkinningMatrices[0], NULL, &rig.mDstPositions[0], &rig.mDstNormals[0], &rig.mDstTangents[0]);
+    }
+
+    /// Skin one rig as the cull thread used to.
+    /// @param state.range(0) Percentage of vertices that blend several bones.
+    void skinRigReference(benchmark::State& state)
+    {
+        Rig rig = makeRig(state.range(0), 1);
+        for (auto _ : state)
+        {
+            skinReference(rig);
+            benchmark::DoNotOptimize(&rig.mDstPositions[0]);
+        }
+        state.SetItemsProcessed(state.iterations() * sNumVertices);
+    }
+
+    /// Skin one rig with SceneUtil::Skinning.
+    /// @param state.range(0) Percentage of vertices that blend several bones.
+    void skinRig(benchmark::State& state)
+    {
+        Rig rig = makeRig(state.range(0), 1);
+        for (auto _ : state)
+        {
+            skin(rig);
+            benchmark::DoNotOptimize(&rig.mDstPositions[0]);
+        }
+        state.SetItemsProcessed(state.iterations() * sNumVertices);
+        state.SetLabel(SceneUtil::Skinning::getInstructionSet());
+    }
+
+    /// Skin a crowd of 32 rigs on worker threads, as RigGeometry does once given a WorkQueue.
+    /// @param state.range(0) Number of worker threads, the calling thread helps as well.
+    void skinCrowd(benchmark::State& state)
+    {
+        osg::ref_ptr<SceneUtil::WorkQueue> workQueue (new SceneUtil::WorkQueue(state.range(0)));
+        std::vector<Rig> rigs;
+        for (unsigned int i = 0; i < 32; ++i)
+            rigs.push_back(makeRig(30, i));
+
+        for (auto _ : state)
+            workQueue->parallelFor(rigs.size(), [&] (unsigned int i) { skin(rigs[i]); });
+        state.SetItemsProcessed(state.iterations() * rigs.size() * sNumVertices);
+    }
+}
+
+BENCHMARK(skinRigReference)->Arg(0)->Arg(30)->Arg(100)->Unit(benchmark::kMicrosecond);
+BENCHMARK(skinRig)->Arg(0)->Arg(30)->Arg(100)->Unit(benchmark::kMicrosecond);
+BENCHMARK(skinCrowd)->Arg(1)->Arg(3)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <components/esm/loadstat.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "apps/openmw/mwworld/store.hpp"
+
+namespace
+{
+    const size_t sNumRecords = 20000;
+
+    /// Record IDs as scripts and dialogue spell them, in mixed case and longer than the small string buffer
+    std::vector<std::string> makeIds()
+    {
+        std::vector<std::string> ids;
+        for (size_t i = 0; i < sNumRecords; ++i)
+        {
+            std::ostringstream id;
+            id << "Furn_Com_Benchmark_Static_" << i;
+            ids.push_back(id.str());
+        }
+        return ids;
+    }
+
+    /// The lookup as Store<T>::search() used to do it: lower case copy of the key, then a plain std::map.
+    class LowerCaseCopyStore
+    {
+        std::map<std::string, ESM::Static> mStatic;
+        std::map<std::string, ESM::Static> mDynamic;
+
+    public:
+        void insert(const ESM::Static& record)
+        {
+            mStatic[Misc::StringUtils::lowerCase(record.mId)] = record;
+        }
+
+        const ESM::Static* search(const std::string& id) const
+        {
+            std::string idLower = Misc::StringUtils::lowerCase(id);
+
+            std::map<std::string, ESM::Static>::const_iterator dit = mDynamic.find(idLower);
+            if (dit != mDynamic.end())
+                return &dit->second;
+
+            std::map<std::string, ESM::Static>::const_iterator it = mStatic.find(idLower);
+            if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id))
+                return &it->second;
+
+            return 0;
+        }
+    };
+
+    template <class StoreType>
+    void lookup(benchmark::State& state)
+    {
+        const std::vector<std::string> ids = makeIds();
+
+        StoreType store;
+        for (size_t i = 0; i < ids.size(); ++i)
+            store.insert(ESM::Static(Misc::StringUtils::lowerCase(ids[i]), "model.nif"));
+
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(store.search(ids[i]));
+            i = (i + 7919) % ids.size();
+        }
+    }
+
+    /// Exposes insertStatic() under the same name as LowerCaseCopyStore
+    class RecordStore : public MWWorld::Store<ESM::Static>
+    {
+    public:
+        void insert(const ESM::Static& record)
+        {
+            insertStatic(record);
+        }
+    };
+
+    void lowerCaseCopyLookup(benchmark::State& state)
+    {
+        lookup<LowerCaseCopyStore>(state);
+    }
+
+    void hashedLookup(benchmark::State& state)
+    {
+        lookup<RecordStore>(state);
+    }
+}
+
+BENCHMARK(lowerCaseCopyLookup);
+BENCHMARK(hashedLookup);
@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <components/misc/stringops.hpp>
+#include <components/vfs/archive.hpp>
+#include <components/vfs/manager.hpp>
+
+namespace
+{
+    const size_t sNumFiles = 200000;
+
+    class NullFile : public VFS::File
+    {
+    public:
+        virtual Files::IStreamPtr open() { return Files::IStreamPtr(); }
+    };
+
+    /// Resource paths as content files spell them, in mixed case with backslashes
+    std::vector<std::string> makePaths()
+    {
+        static const char* const directories[] = { "Meshes\\x\\", "Meshes\\f\\", "Textures\\", "Sound\\Fx\\", "Icons\\m\\" };
+
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < sNumFiles; ++i)
+        {
+            std::ostringstream path;
+            path << directories[i % 5] << "Ex_Benchmark_Resource_" << i << ".nif";
+            paths.push_back(path.str());
+        }
+        return paths;
+    }
+
+    class PathArchive : public VFS::Archive
+    {
+        std::vector<std::string> mPaths;
+        NullFile mFile;
+
+    public:
+        PathArchive(const std::vector<std::string>& paths) : mPaths(paths) {}
+
+        virtual void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char))
+        {
+            for (std::vector<std::string>::const_iterator it = mPaths.begin(); it != mPaths.end(); ++it)
+            {
+                std::string name = *it;
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &mFile;
+            }
+        }
+    };
+
+    char normalizeChar(char ch)
+    {
+        return ch == '\\' ? '/' : Misc::StringUtils::toLower(ch);
+    }
+
+    /// The lookup as VFS::Manager::exists() used to do it: normalized copy of the name, then a plain std::map.
+    void mapLookup(benchmark::State& state)
+    {
+        const std::vector<std::string> paths = makePaths();
+
+        std::map<std::string, VFS::File*> index;
+        PathArchive(paths).listResources(index, &normalizeChar);
+
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            std::string normalized = paths[i];
+            std::transform(normalized.begin(), normalized.end(), normalized.begin(), &normalizeChar);
+            benchmark::DoNotOptimize(index.find(normalized) != index.end());
+            i = (i + 7919) % paths.size();
+        }
+    }
+
+    void hashedLookup(benchmark::State& state)
+    {
+        const std::vector<std::string> paths = makePaths();
+
+        VFS::Manager manager(false);
+        manager.addArchive(new PathArchive(paths));
+        manager.buildIndex();
+
+        size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(manager.exists(paths[i]));
+            i = (i + 7919) % paths.size();
+        }
+    }
+
+    void buildIndex(benchmark::State& state)
+    {
+        VFS::Manager manager(false);
+        manager.addArchive(new PathArchive(makePaths()));
+
+        for (auto _ : state)
+            manager.buildIndex();
+    }
+}
+
+BENCHMARK(mapLookup);
+BENCHMARK(hashedLookup);
+BENCHMARK(buildIndex)->Unit(benchmark::kMillisecond);
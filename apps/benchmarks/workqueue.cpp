@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace
+{
+    const int sNumWorkerThreads = 4;
+    const int sItemsPerBatch = 64;
+
+    /// About as much work as updating a cache entry or releasing a few objects
+    class TinyItem : public SceneUtil::WorkItem
+    {
+    public:
+        virtual void doWork()
+        {
+            int value = 0;
+            for (int i = 0; i < 100; ++i)
+                benchmark::DoNotOptimize(value += i);
+        }
+    };
+
+    SceneUtil::WorkQueue* getWorkQueue()
+    {
+        static osg::ref_ptr<SceneUtil::WorkQueue> workQueue = new SceneUtil::WorkQueue(sNumWorkerThreads);
+        return workQueue.get();
+    }
+
+    /// Several threads add batches of tiny items to the same queue and wait for them,
+    /// the worst case for a queue where adding and taking items go through a single lock.
+    void addAndWait(benchmark::State& state)
+    {
+        SceneUtil::WorkQueue* workQueue = getWorkQueue();
+        std::vector<osg::ref_ptr<SceneUtil::WorkItem> > items(sItemsPerBatch);
+        for (auto _ : state)
+        {
+            for (int i = 0; i < sItemsPerBatch; ++i)
+            {
+                items[i] = new TinyItem;
+                workQueue->addWorkItem(items[i], SceneUtil::WorkItem::Priority(i % SceneUtil::WorkItem::Priority_Count));
+            }
+            for (int i = 0; i < sItemsPerBatch; ++i)
+                items[i]->waitTillDone();
+        }
+        state.SetItemsProcessed(state.iterations() * sItemsPerBatch);
+    }
+
+    /// Chains of items that each wait for the previous one, as a loaded resource would be followed by its setup.
+    void addChains(benchmark::State& state)
+    {
+        SceneUtil::WorkQueue* workQueue = getWorkQueue();
+        std::vector<osg::ref_ptr<SceneUtil::WorkItem> > items(sItemsPerBatch);
+        for (auto _ : state)
+        {
+            for (int i = 0; i < sItemsPerBatch; ++i)
+            {
+                items[i] = new TinyItem;
+                if (i % 4 == 0)
+                    workQueue->addWorkItem(items[i]);
+                else
+                    workQueue->addWorkItemAfter(items[i], items[i - 1]);
+            }
+            for (int i = 0; i < sItemsPerBatch; ++i)
+                items[i]->waitTillDone();
+        }
+        state.SetItemsProcessed(state.iterations() * sItemsPerBatch);
+    }
+}
+
+BENCHMARK(addAndWait)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(addChains)->ThreadRange(1, 8)->UseRealTime();
@@ -812,7 +812,7 @@ void Record<ESM::DialInfo>::print()
     for (sit = mData.mSelects.begin(); sit != mData.mSelects.end(); ++sit)
         std::cout << "  Select Rule: " << ruleString(*sit) << std::endl;
 
-    if (mData.mResultScript != "")
+    if (!mData.mResultScript.empty())
     {
         if (mPrintPlain)
         {
@@ -339,12 +339,10 @@ namespace ESSImport
                 // non-indexed RefNum, i.e. no CREC/NPCC/CNTC record associated with it
                 // this could be any type of object really (even creatures/npcs too)
                 out.mRefID = cellref.mIndexedRefId;
-                std::string idLower = Misc::StringUtils::lowerCase(out.mRefID);
 
                 ESM::ObjectState objstate;
                 objstate.blank();
                 objstate.mRef = out;
-                objstate.mRef.mRefID = idLower;
                 objstate.mHasCustomState = false;
                 convertCellRef(cellref, objstate);
                 esm.writeHNT ("OBJE", 0);
@@ -354,18 +352,17 @@ namespace ESSImport
             else
             {
                 int refIndex;
-                splitIndexedRefId(cellref.mIndexedRefId, refIndex, out.mRefID);
-
-                std::string idLower = Misc::StringUtils::lowerCase(out.mRefID);
+                std::string refId;
+                splitIndexedRefId(cellref.mIndexedRefId, refIndex, refId);
+                out.mRefID = refId;
 
                 std::map<std::pair<int, std::string>, NPCC>::const_iterator npccIt = mContext->mNpcChanges.find(
-                            std::make_pair(refIndex, out.mRefID));
+                            std::make_pair(refIndex, refId));
                 if (npccIt != mContext->mNpcChanges.end())
                 {
                     ESM::NpcState objstate;
                     objstate.blank();
                     objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
                     // TODO: need more micromanagement here so we don't overwrite values
                     // from the ESM with default values
                     if (cellref.mHasACDT)
@@ -377,7 +374,7 @@ namespace ESSImport
                     convertCellRef(cellref, objstate);
 
                     objstate.mCreatureStats.mActorId = mContext->generateActorId();
-                    mContext->mActorIdMap.insert(std::make_pair(std::make_pair(refIndex, out.mRefID), objstate.mCreatureStats.mActorId));
+                    mContext->mActorIdMap.insert(std::make_pair(std::make_pair(refIndex, refId), objstate.mCreatureStats.mActorId));
 
                     esm.writeHNT ("OBJE", ESM::REC_NPC_);
                     objstate.save(esm);
@@ -385,13 +382,12 @@ namespace ESSImport
                 }
 
                 std::map<std::pair<int, std::string>, CNTC>::const_iterator cntcIt = mContext->mContainerChanges.find(
-                            std::make_pair(refIndex, out.mRefID));
+                            std::make_pair(refIndex, refId));
                 if (cntcIt != mContext->mContainerChanges.end())
                 {
                     ESM::ContainerState objstate;
                     objstate.blank();
                     objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
                     convertCNTC(cntcIt->second, objstate);
                     convertCellRef(cellref, objstate);
                     esm.writeHNT ("OBJE", ESM::REC_CONT);
@@ -400,13 +396,12 @@ namespace ESSImport
                 }
 
                 std::map<std::pair<int, std::string>, CREC>::const_iterator crecIt = mContext->mCreatureChanges.find(
-                            std::make_pair(refIndex, out.mRefID));
+                            std::make_pair(refIndex, refId));
                 if (crecIt != mContext->mCreatureChanges.end())
                 {
                     ESM::CreatureState objstate;
                     objstate.blank();
                     objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
                     // TODO: need more micromanagement here so we don't overwrite values
                     // from the ESM with default values
                     if (cellref.mHasACDT)
@@ -417,7 +412,7 @@ namespace ESSImport
                     convertCellRef(cellref, objstate);
 
                     objstate.mCreatureStats.mActorId = mContext->generateActorId();
-                    mContext->mActorIdMap.insert(std::make_pair(std::make_pair(refIndex, out.mRefID), objstate.mCreatureStats.mActorId));
+                    mContext->mActorIdMap.insert(std::make_pair(std::make_pair(refIndex, refId), objstate.mCreatureStats.mActorId));
 
                     esm.writeHNT ("OBJE", ESM::REC_CREA);
                     objstate.save(esm);
@@ -256,7 +256,7 @@ public:
             for (unsigned int i=0; i<invState.mItems.size(); ++i)
             {
                 // FIXME: in case of conflict (multiple items with this refID) use the already equipped one?
-                if (Misc::StringUtils::ciEqual(invState.mItems[i].mRef.mRefID, refr.mActorData.mSelectedEnchantItem))
+                if (Misc::StringUtils::ciEqual(invState.mItems[i].mRef.mRefID.toString(), refr.mActorData.mSelectedEnchantItem))
                     invState.mSelectedEnchantItem = i;
             }
         }
@@ -9,6 +9,7 @@
 #include "MasterServer.hpp"
 
 #include <components/openmw-mp/Master/PacketMasterQuery.hpp>
+#include <components/openmw-mp/Master/PacketMasterQueryDelta.hpp>
 #include <components/openmw-mp/Master/PacketMasterUpdate.hpp>
 #include <components/openmw-mp/Master/PacketMasterAnnounce.hpp>
 #include <components/openmw-mp/Version.hpp>
@@ -27,6 +28,10 @@ MasterServer::MasterServer(unsigned short maxConnections, unsigned short port)
     peer->SetMaximumIncomingConnections(maxConnections);
     peer->SetIncomingPassword(TES3MP_MASTERSERVER_PASSW, (int) strlen(TES3MP_MASTERSERVER_PASSW));
     run = false;
+
+    listVersion = 1;
+    forgottenVersion = 0;
+    queryCacheVersion = 0;
 }
 
 MasterServer::~MasterServer()
@@ -52,6 +57,9 @@ void MasterServer::Thread()
     PacketMasterAnnounce pma(peer);
     pma.SetSendStream(&send);
 
+    PacketMasterQueryDelta pmqd(peer);
+    pmqd.SetSendStream(&send);
+
     while (run)
     {
         Packet *packet = peer->Receive();
@@ -64,9 +72,22 @@ void MasterServer::Thread()
             {
 
                 if (it->second.lastUpdate + 60s <= now)
-                    servers.erase(it++);
+                    it = RemoveServer(it);
                 else ++it;
             }
+            {
+                lock_guard<mutex> lock(versionMutex);
+                for (auto it = removedServers.begin(); it != removedServers.end();)
+                {
+                    if (now - it->second.time >= 10min)
+                    {
+                        forgottenVersion = max(forgottenVersion, it->second.version);
+                        it = removedServers.erase(it);
+                    }
+                    else
+                        ++it;
+                }
+            }
             for(auto id = pendingACKs.begin(); id != pendingACKs.end();)
             {
                 if(now - id->second >= 30s)
@@ -100,14 +121,41 @@ void MasterServer::Thread()
                         break;
                     case ID_MASTER_QUERY:
                     {
-                        pmq.SetServers(reinterpret_cast<map<SystemAddress, QueryData> *>(&servers));
-                        pmq.Send(packet->systemAddress);
+                        if (queryCacheVersion != listVersion)
+                        {
+                            lock_guard<mutex> lock(versionMutex);
+                            queryCache.Reset();
+                            pmq.SetServers(reinterpret_cast<map<SystemAddress, QueryData> *>(&servers));
+                            pmq.Packet(&queryCache, true);
+                            queryCacheVersion = listVersion;
+                        }
+                        pmq.SendSerialized(&queryCache, packet->systemAddress);
                         pendingACKs[packet->guid] = steady_clock::now();
 
                         cout << "Sent info about all " << servers.size() << " servers to "
                              << packet->systemAddress.ToString() << endl;
                         break;
                     }
+                    case ID_MASTER_QUERY_DELTA:
+                    {
+                        uint32_t sinceVersion = 0;
+                        data.Read(sinceVersion);
+
+                        ServerMap changed;
+                        vector<SystemAddress> removed;
+                        uint32_t version = 0;
+                        bool full = GetDelta(sinceVersion, changed, removed, version);
+
+                        pmqd.SetServers(reinterpret_cast<map<SystemAddress, QueryData> *>(&changed));
+                        pmqd.SetRemoved(&removed);
+                        pmqd.SetVersion(version, full);
+                        pmqd.Send(packet->systemAddress);
+                        pendingACKs[packet->guid] = steady_clock::now();
+
+                        cout << "Sent " << (full ? "full list" : "changes") << " of " << changed.size() << " servers and "
+                             << removed.size() << " removals to " << packet->systemAddress.ToString() << endl;
+                        break;
+                    }
                     case ID_MASTER_UPDATE:
                     {
                         SystemAddress addr;
@@ -136,6 +184,8 @@ void MasterServer::Thread()
 
                         auto keepAliveFunc = [&]() {
                             iter->second.lastUpdate = now;
+                            if (pma.GetFunc() == PacketMasterAnnounce::FUNCTION_ANNOUNCE)
+                                MarkChanged(iter);
                             pma.SetFunc(PacketMasterAnnounce::FUNCTION_KEEP);
                             pma.Send(packet->systemAddress);
                             pendingACKs[packet->guid] = steady_clock::now();
@@ -145,7 +195,7 @@ void MasterServer::Thread()
                         {
                             if (pma.GetFunc() == PacketMasterAnnounce::FUNCTION_DELETE)
                             {
-                                servers.erase(iter);
+                                RemoveServer(iter);
                                 cout << "Deleted";
                                 pma.Send(packet->systemAddress);
                                 pendingACKs[packet->guid] = steady_clock::now();
@@ -153,7 +203,7 @@ void MasterServer::Thread()
                             else if (pma.GetFunc() == PacketMasterAnnounce::FUNCTION_ANNOUNCE)
                             {
                                 cout << "Updated";
-                                iter->second = server;
+                                UpdateServer(iter, server);
                                 keepAliveFunc();
                             }
                             else
@@ -165,7 +215,7 @@ void MasterServer::Thread()
                         else if (pma.GetFunc() == PacketMasterAnnounce::FUNCTION_ANNOUNCE)
                         {
                             cout << "Added";
-                            iter = servers.insert({packet->systemAddress, server}).first;
+                            iter = AddServer(packet->systemAddress, server).first;
                             keepAliveFunc();
                         }
                         else
@@ -234,3 +284,93 @@ MasterServer::ServerMap *MasterServer::GetServers()
 {
     return &servers;
 }
+
+uint32_t MasterServer::GetVersion() const
+{
+    return listVersion;
+}
+
+pair<MasterServer::ServerIter, bool> MasterServer::AddServer(const SystemAddress &addr, const SServer &server)
+{
+    lock_guard<mutex> lock(versionMutex);
+    return servers.insert({addr, server});
+}
+
+void MasterServer::UpdateServer(ServerIter it, const SServer &server)
+{
+    lock_guard<mutex> lock(versionMutex);
+    it->second = server;
+}
+
+void MasterServer::MarkChanged(ServerIter it)
+{
+    {
+        lock_guard<mutex> lock(versionMutex);
+        it->second.version = ++listVersion;
+        removedServers.erase(it->first);
+    }
+    NotifyUpdated();
+}
+
+MasterServer::ServerIter MasterServer::RemoveServer(ServerIter it)
+{
+    {
+        lock_guard<mutex> lock(versionMutex);
+        removedServers[it->first] = {++listVersion, steady_clock::now()};
+        it = servers.erase(it);
+    }
+    NotifyUpdated();
+    return it;
+}
+
+bool MasterServer::GetRemovedSince(uint32_t sinceVersion, uint32_t untilVersion, vector<SystemAddress> &removed)
+{
+    lock_guard<mutex> lock(versionMutex);
+    if (sinceVersion < forgottenVersion)
+        return false;
+
+    for (const auto &server : removedServers)
+    {
+        if (server.second.version > sinceVersion && server.second.version <= untilVersion)
+            removed.push_back(server.first);
+    }
+    return true;
+}
+
+MasterServer::ServerMap MasterServer::GetChangedSince(uint32_t sinceVersion, uint32_t &version)
+{
+    lock_guard<mutex> lock(versionMutex);
+    version = listVersion;
+    ServerMap changed;
+    for (const auto &server : servers)
+    {
+        if (server.second.version > sinceVersion)
+            changed.insert(server);
+    }
+    return changed;
+}
+
+bool MasterServer::GetDelta(uint32_t sinceVersion, ServerMap &changed, vector<SystemAddress> &removed, uint32_t &version)
+{
+    // Removals are read after the changes and only up to their version. Anything later is left for the next
+    // delta, which the client asks for from that version.
+    changed = GetChangedSince(sinceVersion, version);
+    bool full = sinceVersion == 0 || sinceVersion > version || !GetRemovedSince(sinceVersion, version, removed);
+    if (full && sinceVersion != 0)
+    {
+        removed.clear();
+        changed = GetChangedSince(0, version);
+    }
+    return full;
+}
+
+void MasterServer::SetUpdateCallback(function<void()> callback)
+{
+    updateCallback = move(callback);
+}
+
+void MasterServer::NotifyUpdated()
+{
+    if (updateCallback)
+        updateCallback();
+}
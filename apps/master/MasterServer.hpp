@@ -7,6 +7,10 @@
 
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <BitStream.h>
 #include <RakPeerInterface.h>
 #include <components/openmw-mp/Master/MasterData.hpp>
 
@@ -24,6 +28,7 @@ public:
     struct SServer : QueryData
     {
         std::chrono::steady_clock::time_point lastUpdate;
+        uint32_t version = 0; // list version at which this entry was last changed
     };
     typedef std::map<RakNet::SystemAddress, SServer> ServerMap;
     //typedef ServerMap::const_iterator ServerCIter;
@@ -39,8 +44,34 @@ public:
 
     ServerMap* GetServers();
 
+    /*
+     * Every change to the server list bumps the list version. Entries remember the version at which
+     * they last changed and removed entries leave a tombstone, so clients can ask for what changed
+     * since the version they already have instead of downloading the whole list.
+     */
+    uint32_t GetVersion() const;
+    /// Add a server unless one with the same address is listed, under the version lock
+    std::pair<ServerIter, bool> AddServer(const RakNet::SystemAddress &addr, const SServer &server);
+    /// Replace the data of a listed server, under the version lock
+    void UpdateServer(ServerIter it, const SServer &server);
+    void MarkChanged(ServerIter it);
+    ServerIter RemoveServer(ServerIter it);
+    /// Removals after sinceVersion up to and including untilVersion
+    /// @return false if removals older than sinceVersion were already forgotten and a full list must be sent
+    bool GetRemovedSince(uint32_t sinceVersion, uint32_t untilVersion, std::vector<RakNet::SystemAddress> &removed);
+    /// @param version Set to the list version the copied servers are current as of
+    ServerMap GetChangedSince(uint32_t sinceVersion, uint32_t &version);
+    /// Servers changed and removed since sinceVersion, or the full list if that is too old or 0
+    /// @param version Set to the list version the result is current as of, for the client to ask from next time
+    /// @return Whether the full list was returned
+    bool GetDelta(uint32_t sinceVersion, ServerMap &changed, std::vector<RakNet::SystemAddress> &removed, uint32_t &version);
+
+    /// Called from the master thread whenever the server list changed
+    void SetUpdateCallback(std::function<void()> callback);
+
 private:
     void Thread();
+    void NotifyUpdated();
 
 private:
     std::thread tMasterThread;
@@ -49,6 +80,21 @@ private:
     ServerMap servers;
     bool run;
     std::map<RakNet::RakNetGUID, std::chrono::steady_clock::time_point> pendingACKs;
+
+    struct RemovedServer
+    {
+        uint32_t version;
+        std::chrono::steady_clock::time_point time;
+    };
+    std::atomic<uint32_t> listVersion;
+    std::mutex versionMutex;
+    std::map<RakNet::SystemAddress, RemovedServer> removedServers;
+    uint32_t forgottenVersion; // newest version of a pruned tombstone
+    std::function<void()> updateCallback;
+
+    // Pre-serialized answer to ID_MASTER_QUERY, rebuilt only when the list version changes
+    RakNet::BitStream queryCache;
+    uint32_t queryCacheVersion;
 };
 
 
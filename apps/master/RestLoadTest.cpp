@@ -0,0 +1,145 @@
+//
+// Load test for the REST server list: hammers /api/servers from several local clients and
+// reports throughput and latency for plain, gzipped, conditional and delta requests.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <boost/asio.hpp>
+
+using namespace std;
+using namespace chrono;
+using boost::asio::ip::tcp;
+
+struct Reply
+{
+    int status = 0;
+    string headers;
+    size_t bodySize = 0;
+};
+
+static bool request(boost::asio::io_service &ioService, const string &host, const string &port, const string &path,
+                    const string &extraHeaders, Reply &reply)
+{
+    try
+    {
+        tcp::resolver resolver(ioService);
+        tcp::socket socket(ioService);
+        boost::asio::connect(socket, resolver.resolve({host, port}));
+
+        string req = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\n" + extraHeaders + "Connection: close\r\n\r\n";
+        boost::asio::write(socket, boost::asio::buffer(req));
+
+        string response;
+        boost::system::error_code error;
+        char buf[8192];
+        size_t len;
+        while ((len = socket.read_some(boost::asio::buffer(buf), error)) > 0)
+            response.append(buf, len);
+
+        size_t headerEnd = response.find("\r\n\r\n");
+        if (headerEnd == string::npos || response.size() < 12)
+            return false;
+
+        reply.status = stoi(response.substr(9, 3));
+        reply.headers = response.substr(0, headerEnd);
+        reply.bodySize = response.size() - headerEnd - 4;
+        return true;
+    }
+    catch (exception &e)
+    {
+        cerr << e.what() << endl;
+        return false;
+    }
+}
+
+static string getHeader(const string &headers, const string &name)
+{
+    size_t pos = headers.find(name + ": ");
+    if (pos == string::npos)
+        return string();
+    pos += name.size() + 2;
+    return headers.substr(pos, headers.find("\r\n", pos) - pos);
+}
+
+static void runCase(const string &name, const string &host, const string &port, const string &path,
+                    const string &extraHeaders, int threads, int requestsPerThread)
+{
+    atomic<int> failures{0};
+    vector<vector<double>> latencies(threads);
+    vector<thread> workers;
+    size_t bodySize = 0;
+    int status = 0;
+
+    auto start = steady_clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            boost::asio::io_service ioService;
+            for (int i = 0; i < requestsPerThread; ++i)
+            {
+                Reply reply;
+                auto begin = steady_clock::now();
+                if (!request(ioService, host, port, path, extraHeaders, reply))
+                {
+                    failures++;
+                    continue;
+                }
+                latencies[t].push_back(duration<double, milli>(steady_clock::now() - begin).count());
+                if (t == 0 && i == 0)
+                {
+                    bodySize = reply.bodySize;
+                    status = reply.status;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    double total = duration<double>(steady_clock::now() - start).count();
+
+    vector<double> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+
+    cout << name << ": status " << status << ", " << bodySize << " bytes, "
+         << all.size() / total << " req/s";
+    if (!all.empty())
+        cout << ", p50 " << all[all.size() / 2] << " ms, p99 " << all[all.size() * 99 / 100] << " ms";
+    cout << ", " << failures << " failures" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    string host = argc > 1 ? argv[1] : "127.0.0.1";
+    string port = argc > 2 ? argv[2] : "8080";
+    int threads = argc > 3 ? stoi(argv[3]) : 8;
+    int requests = argc > 4 ? stoi(argv[4]) : 500;
+
+    boost::asio::io_service ioService;
+    Reply first;
+    if (!request(ioService, host, port, "/api/servers", "", first))
+    {
+        cerr << "Can't reach master server at " << host << ":" << port << endl;
+        return 1;
+    }
+    string etag = getHeader(first.headers, "ETag");
+    cout << "Server list is " << first.bodySize << " bytes, ETag " << etag << endl;
+
+    runCase("full", host, port, "/api/servers", "", threads, requests);
+    runCase("gzip", host, port, "/api/servers", "Accept-Encoding: gzip\r\n", threads, requests);
+    if (!etag.empty())
+        runCase("not modified", host, port, "/api/servers", "If-None-Match: " + etag + "\r\n", threads, requests);
+
+    // the ETag is the quoted list version, so it doubles as the "since" argument of a delta query
+    string version = etag.size() > 2 ? etag.substr(1, etag.size() - 2) : "0";
+    runCase("delta", host, port, "/api/servers?since=" + version, "", threads, requests);
+
+    return 0;
+}
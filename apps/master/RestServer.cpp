@@ -7,6 +7,8 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <zlib.h>
+
 using namespace std;
 using namespace chrono;
 using namespace boost::property_tree;
@@ -15,14 +17,68 @@ static string response201 = "HTTP/1.1 201 Created\r\nContent-Length: 7\r\n\r\nCr
 static string response202 = "HTTP/1.1 202 Accepted\r\nContent-Length: 8\r\n\r\nAccepted";
 static string response400 = "HTTP/1.1 400 Bad Request\r\nContent-Length: 11\r\n\r\nbad request";
 
-inline void ResponseStr(HttpServer::Response &response, string content, string type = "", string code = "200 OK")
+inline void ResponseStr(HttpServer::Response &response, const string &content, string type = "", string code = "200 OK",
+                        const string &headers = "")
 {
     response << "HTTP/1.1 " << code << "\r\n";
     if (!type.empty())
         response << "Content-Type: " << type <<"\r\n";
+    response << headers;
     response << "Content-Length: " << content.length() << "\r\n\r\n" << content;
 }
 
+inline bool headerContains(const HttpServer::Request &request, const string &name, const string &value)
+{
+    auto range = request.header.equal_range(name);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.find(value) != string::npos)
+            return true;
+    }
+    return false;
+}
+
+inline bool getQueryVersion(const string &queryString, uint32_t &version)
+{
+    static const string key = "since=";
+    size_t pos = queryString.find(key);
+    if (pos == string::npos || (pos != 0 && queryString[pos - 1] != '&'))
+        return false;
+    try
+    {
+        version = (uint32_t) stoul(queryString.substr(pos + key.size()));
+    }
+    catch (exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+static string gzipCompress(const string &data)
+{
+    z_stream zs = {};
+    // windowBits 15 + 16 makes zlib write a gzip header instead of a zlib one
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return string();
+
+    string out;
+    out.resize(deflateBound(&zs, data.size()));
+
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    zs.avail_in = (uInt) data.size();
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = (uInt) out.size();
+
+    int result = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    if (result != Z_STREAM_END)
+        return string();
+    return out;
+}
+
 inline void ptreeToServer(boost::property_tree::ptree &pt, MasterServer::SServer &server)
 {
     server.SetName(pt.get<string>("hostname").c_str());
@@ -48,11 +104,70 @@ inline void queryToStringStream(stringstream &ss, string addr, MasterServer::SSe
     ss << "}";
 }
 
-RestServer::RestServer(unsigned short port, MasterServer::ServerMap *pMap) : serverMap(pMap)
+inline void serversToStringStream(stringstream &ss, const string &name, MasterServer::ServerMap &servers)
+{
+    ss << "\"" << name << "\":{";
+    for (auto query = servers.begin(); query != servers.end(); query++)
+    {
+        queryToStringStream(ss, query->first.ToString(true, ':'), query->second);
+        if (next(query) != servers.end())
+            ss << ", ";
+    }
+    ss << "}";
+}
+
+RestServer::RestServer(unsigned short port, MasterServer *master) : master(master), serverMap(master->GetServers())
 {
     httpServer.config.port = port;
 }
 
+shared_ptr<const RestServer::ListCache> RestServer::getCache()
+{
+    lock_guard<mutex> lock(cacheMutex);
+
+    if (cache && !updatedCache.exchange(false))
+        return cache;
+
+    // "last_update" is relative to the moment the list was built, keep-alives alone do not rebuild it
+    // The master thread changes the list while this runs, so serialize a copy taken under its lock
+    auto newCache = make_shared<ListCache>();
+    MasterServer::ServerMap servers = master->GetChangedSince(0, newCache->version);
+    newCache->etag = "\"" + to_string(newCache->version) + "\"";
+
+    stringstream ss;
+    ss << "{";
+    serversToStringStream(ss, "list servers", servers);
+    ss << "}";
+    newCache->json = ss.str();
+    newCache->gzipped = gzipCompress(newCache->json);
+
+    cache = newCache;
+    return cache;
+}
+
+string RestServer::getDelta(uint32_t sinceVersion)
+{
+    MasterServer::ServerMap changed;
+    vector<RakNet::SystemAddress> removed;
+    uint32_t version = 0;
+    bool full = master->GetDelta(sinceVersion, changed, removed, version);
+
+    stringstream ss;
+    ss << "{";
+    ss << "\"version\": " << version << ", ";
+    ss << "\"full\": " << (full ? "true" : "false") << ", ";
+    serversToStringStream(ss, "list servers", changed);
+    ss << ", \"removed\":[";
+    for (auto addr = removed.begin(); addr != removed.end(); addr++)
+    {
+        ss << "\"" << addr->ToString(true, ':') << "\"";
+        if (next(addr) != removed.end())
+            ss << ", ";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
 void RestServer::start()
 {
     static const string ValidIpAddressRegex = "(?:[0-9]{1,3}\\.){3}[0-9]{1,3}";
@@ -79,24 +194,27 @@ void RestServer::start()
         }
         else
         {
-            static string str;
+            uint32_t sinceVersion;
+            if (getQueryVersion(request->query_string, sinceVersion))
+            {
+                ResponseStr(*response, getDelta(sinceVersion), "application/json");
+                return;
+            }
+
+            auto listCache = getCache();
+            string headers = "ETag: " + listCache->etag + "\r\nVary: Accept-Encoding\r\n";
 
-            //if (updatedCache)
+            if (headerContains(*request, "If-None-Match", listCache->etag))
             {
-                stringstream ss;
-                ss << "{";
-                ss << "\"list servers\":{";
-                for (auto query = serverMap->begin(); query != serverMap->end(); query++)
-                {
-                    queryToStringStream(ss, query->first.ToString(true, ':'), query->second);
-                    if (next(query) != serverMap->end())
-                        ss << ", ";
-                }
-                ss << "}}";
-                ResponseStr(*response, ss.str(), "application/json");
-                updatedCache = false;
+                *response << "HTTP/1.1 304 Not Modified\r\n" << headers << "Content-Length: 0\r\n\r\n";
+                return;
             }
-            *response << str;
+
+            if (!listCache->gzipped.empty() && headerContains(*request, "Accept-Encoding", "gzip"))
+                ResponseStr(*response, listCache->gzipped, "application/json", "200 OK",
+                            headers + "Content-Encoding: gzip\r\n");
+            else
+                ResponseStr(*response, listCache->json, "application/json", "200 OK", headers);
         }
     };
 
@@ -112,8 +230,9 @@ void RestServer::start()
 
             unsigned short port = pt.get<unsigned short>("port");
             server.lastUpdate = steady_clock::now();
-            serverMap->insert({RakNet::SystemAddress(request->remote_endpoint_address.c_str(), port), server});
-            updatedCache = true;
+            auto result = master->AddServer(RakNet::SystemAddress(request->remote_endpoint_address.c_str(), port), server);
+            if (result.second)
+                master->MarkChanged(result.first);
 
             *response << response201;
         }
@@ -145,9 +264,11 @@ void RestServer::start()
                 ptree pt;
                 read_json(request->content, pt);
 
-                ptreeToServer(pt, query->second);
+                MasterServer::SServer server = query->second;
+                ptreeToServer(pt, server);
+                master->UpdateServer(query, server);
 
-                updatedCache = true;
+                master->MarkChanged(query);
             }
             catch(exception &e)
             {
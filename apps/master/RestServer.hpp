@@ -6,6 +6,9 @@
 #define NEWRESTAPI_RESTSERVER_HPP
 
 #include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <unordered_map>
 #include "MasterServer.hpp"
 #include "SimpleWeb/http_server.hpp"
@@ -15,15 +18,33 @@ typedef SimpleWeb::Server<SimpleWeb::HTTP> HttpServer;
 class RestServer
 {
 public:
-    RestServer(unsigned short port, MasterServer::ServerMap *pMap);
+    RestServer(unsigned short port, MasterServer *master);
     void start();
     void stop();
     void cacheUpdated();
 
 private:
+    /*
+     * Server list as sent to clients. It is built once per list version, together with its gzipped
+     * form, and shared by every GET until cacheUpdated() is called again.
+     */
+    struct ListCache
+    {
+        uint32_t version;
+        std::string etag;
+        std::string json;
+        std::string gzipped;
+    };
+
+    std::shared_ptr<const ListCache> getCache();
+    std::string getDelta(uint32_t sinceVersion);
+
     HttpServer httpServer;
+    MasterServer *master;
     MasterServer::ServerMap *serverMap;
-    bool updatedCache = true;
+    std::mutex cacheMutex;
+    std::shared_ptr<const ListCache> cache;
+    std::atomic<bool> updatedCache{true};
 };
 
 
@@ -12,6 +12,7 @@
 #include <components/openmw-mp/Master/PacketMasterAnnounce.hpp>
 #include <components/openmw-mp/Master/PacketMasterUpdate.hpp>
 #include <components/openmw-mp/Master/PacketMasterQuery.hpp>
+#include <components/openmw-mp/Master/PacketMasterQueryDelta.hpp>
 #include <components/openmw-mp/NetworkMessages.hpp>
 
 using namespace std;
@@ -43,6 +44,10 @@ int main()
     PacketMasterAnnounce pma(peer);
     pma.SetSendStream(&send);
 
+    PacketMasterQueryDelta pmqd(peer);
+    map<SystemAddress, QueryData> knownServers;
+    uint32_t knownVersion = 0;
+
     while (true)
     {
         RakSleep(30);
@@ -75,6 +80,14 @@ int main()
                 send.Write((unsigned char) (ID_MASTER_QUERY));
                 peer->Send(&send, HIGH_PRIORITY, RELIABLE_ORDERED, CHANNEL_MASTER, masterAddr, false);
             }
+            else if (strcmp(message, "getdelta") == 0)
+            {
+                cout << "Request changes since version " << knownVersion << endl;
+                send.Reset();
+                send.Write((unsigned char) (ID_MASTER_QUERY_DELTA));
+                send.Write(knownVersion);
+                peer->Send(&send, HIGH_PRIORITY, RELIABLE_ORDERED, CHANNEL_MASTER, masterAddr, false);
+            }
             else if (strcmp(message, "getme") == 0)
             {
                 send.Reset();
@@ -165,6 +178,29 @@ int main()
 
                     break;
                 }
+                case ID_MASTER_QUERY_DELTA:
+                {
+                    map<SystemAddress, QueryData> changed;
+                    vector<SystemAddress> removed;
+
+                    pmqd.SetReadStream(&data);
+                    pmqd.SetServers(&changed);
+                    pmqd.SetRemoved(&removed);
+                    pmqd.Read();
+
+                    if (pmqd.IsFull())
+                        knownServers.clear();
+                    for (auto &serv : changed)
+                        knownServers[serv.first] = serv.second;
+                    for (auto &addr : removed)
+                        knownServers.erase(addr);
+                    knownVersion = pmqd.GetVersion();
+
+                    cout << "Received " << (pmqd.IsFull() ? "full list" : "changes") << " at version " << knownVersion
+                         << ": " << changed.size() << " changed, " << removed.size() << " removed, "
+                         << knownServers.size() << " known" << endl;
+                    break;
+                }
                 case ID_MASTER_UPDATE:
                 {
                     pair<SystemAddress, QueryData> serverPair;
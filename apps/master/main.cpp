@@ -14,7 +14,8 @@ bool run = true;
 int main()
 {
     masterServer.reset(new MasterServer(2000, 25560));
-    restServer.reset(new RestServer(8080, masterServer->GetServers()));
+    restServer.reset(new RestServer(8080, masterServer.get()));
+    masterServer->SetUpdateCallback([]() { restServer->cacheUpdated(); });
 
     auto onExit = [](int /*sig*/){
         restServer->stop();
@@ -0,0 +1,146 @@
+///Program to fill the compiled model cache ahead of time, so that the game does not convert NIF files on first use.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <components/files/configurationmanager.hpp>
+#include <components/files/escape.hpp>
+#include <components/files/collections.hpp>
+#include <components/vfs/manager.hpp>
+#include <components/vfs/registerarchives.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/resource/bulletshapemanager.hpp>
+#include <components/resource/compiledcache.hpp>
+
+// Create local aliases for brevity
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+struct Arguments
+{
+    Files::PathContainer dataDirs;
+    std::vector<std::string> archives;
+    bfs::path cacheDir;
+    bool fsStrict;
+};
+
+bool parseOptions(int argc, char** argv, Files::ConfigurationManager& cfgMgr, Arguments& info)
+{
+    bpo::options_description desc("Converts all NIF files in the data directories and archives of openmw.cfg\n"
+            "and stores the results in the compiled model cache.\n\n"
+            "Usage: nifcache [options]\n\n"
+            "Allowed options");
+
+    desc.add_options()
+        ("help,h", "print help message.")
+        ("data", bpo::value<Files::EscapePathContainer>()->default_value(Files::EscapePathContainer(), "data")
+            ->multitoken()->composing(), "set data directories (later directories have higher priority)")
+        ("data-local", bpo::value<Files::EscapeHashString>()->default_value(""),
+            "set local data directory (highest priority)")
+        ("fallback-archive", bpo::value<Files::EscapeStringVector>()->default_value(Files::EscapeStringVector(), "fallback-archive")
+            ->multitoken(), "set fallback BSA archives (later archives have higher priority)")
+        ("fs-strict", bpo::value<bool>()->implicit_value(true)->default_value(false),
+            "strict file system handling (no case folding)")
+        ("cache", bpo::value<std::string>()->default_value(""),
+            "set the cache directory (defaults to the one the game uses)")
+        ;
+
+    bpo::variables_map variables;
+    try
+    {
+        bpo::parsed_options valid_opts = bpo::command_line_parser(argc, argv).options(desc).allow_unregistered().run();
+        bpo::store(valid_opts, variables);
+        bpo::notify(variables);
+    }
+    catch (std::exception& e)
+    {
+        std::cout << "ERROR parsing arguments: " << e.what() << "\n\n" << desc << std::endl;
+        return false;
+    }
+
+    if (variables.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return false;
+    }
+
+    cfgMgr.readConfiguration(variables, desc);
+
+    info.dataDirs = Files::EscapePath::toPathContainer(variables["data"].as<Files::EscapePathContainer>());
+
+    std::string local(variables["data-local"].as<Files::EscapeHashString>().toStdString());
+    if (!local.empty())
+    {
+        if (local.front() == '\"')
+            local = local.substr(1, local.length() - 2);
+
+        info.dataDirs.push_back(Files::PathContainer::value_type(local));
+    }
+
+    cfgMgr.processPaths(info.dataDirs);
+
+    info.archives = variables["fallback-archive"].as<Files::EscapeStringVector>().toStdStringVector();
+    info.fsStrict = variables["fs-strict"].as<bool>();
+
+    std::string cache = variables["cache"].as<std::string>();
+    info.cacheDir = cache.empty() ? cfgMgr.getCachePath() / "models" : bfs::path(cache);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Files::ConfigurationManager cfgMgr;
+    Arguments info;
+    if (!parseOptions(argc, argv, cfgMgr, info))
+        return 1;
+
+    // Must index the same files the game does, since the textures that exist are part of the cache key
+    Files::Collections collections(info.dataDirs, !info.fsStrict);
+    VFS::Manager vfs(info.fsStrict);
+    VFS::registerArchives(&vfs, collections, info.archives, true);
+
+    std::cout << "Writing to " << info.cacheDir << std::endl;
+
+    Resource::ResourceSystem resourceSystem(&vfs);
+    resourceSystem.setCompiledCache(new Resource::CompiledCache(info.cacheDir, &vfs));
+
+    Resource::BulletShapeManager shapeManager(&vfs, resourceSystem.getSceneManager(), resourceSystem.getNifFileManager());
+    shapeManager.setCompiledCache(resourceSystem.getCompiledCache());
+
+    unsigned int numFiles = 0;
+    unsigned int numErrors = 0;
+    for (const auto& file : vfs.getRecursiveDirectoryIterator("meshes/"))
+    {
+        const std::string& name = file.first;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".nif") != 0)
+            continue;
+
+        try
+        {
+            resourceSystem.getSceneManager()->getTemplate(name);
+            shapeManager.getShape(name);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Error converting " << name << ": " << e.what() << std::endl;
+            ++numErrors;
+        }
+
+        // Nothing is used twice, so do not let the caches grow
+        if (++numFiles % 100 == 0)
+        {
+            resourceSystem.clearCache();
+            shapeManager.clearCache();
+            std::cout << numFiles << " files converted" << std::endl;
+        }
+    }
+
+    std::cout << numFiles << " files converted, " << numErrors << " errors" << std::endl;
+    return numErrors == 0 ? 0 : 1;
+}
@@ -33,11 +33,11 @@ void CSMTools::ReferenceCheckStage::perform(int stage, CSMDoc::Messages &message
         messages.push_back(std::make_pair(id, " is an empty instance (not based on an object)"));
     } else {
         // Check for non existing referenced object
-        if (mReferencables.searchId(cellRef.mRefID) == -1) {
-            messages.push_back(std::make_pair(id, " is referencing non existing object " + cellRef.mRefID));
+        if (mReferencables.searchId(cellRef.mRefID.toString()) == -1) {
+            messages.push_back(std::make_pair(id, " is referencing non existing object " + cellRef.mRefID.getSpelling()));
         } else {
             // Check if reference charge is valid for it's proper referenced type
-            CSMWorld::RefIdData::LocalIndex localIndex = mDataSet.searchId(cellRef.mRefID);
+            CSMWorld::RefIdData::LocalIndex localIndex = mDataSet.searchId(cellRef.mRefID.toString());
             bool isLight = localIndex.second == CSMWorld::UniversalId::Type_Light;
             if ((isLight && cellRef.mChargeFloat < -1) || (!isLight && cellRef.mChargeInt < -1)) {
                 std::string str = " has invalid charge ";
@@ -956,7 +956,7 @@ namespace CSMWorld
 
         virtual QVariant get (const Record<ESXRecordT>& record) const
         {
-            return QString::fromUtf8 (record.get().mRefID.c_str());
+            return QString::fromUtf8 (record.get().mRefID.getSpelling().c_str());
         }
 
         virtual void set (Record<ESXRecordT>& record, const QVariant& data)
@@ -59,7 +59,7 @@ void CSMWorld::RefCollection::load (ESM::ESMReader& reader, int cellIndex, bool
                 if (index.first != mref.mTarget[0] || index.second != mref.mTarget[1])
                 {
                     std::cerr << "The Position of moved ref "
-                        << ref.mRefID << " does not match the target cell" << std::endl;
+                        << ref.mRefID.getSpelling() << " does not match the target cell" << std::endl;
                     std::cerr << "Position: #" << index.first << " " << index.second
                         <<", Target #"<< mref.mTarget[0] << " " << mref.mTarget[1] << std::endl;
 
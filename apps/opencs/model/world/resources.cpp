@@ -22,14 +22,10 @@ void CSMWorld::Resources::recreate(const VFS::Manager* vfs, const char * const *
 
     int baseSize = mBaseDirectory.size();
 
-    const std::map<std::string, VFS::File*>& index = vfs->getIndex();
-    for (std::map<std::string, VFS::File*>::const_iterator it = index.begin(); it != index.end(); ++it)
+    VFS::RecursiveDirectoryRange files = vfs->getRecursiveDirectoryIterator (mBaseDirectory + "/");
+    for (VFS::RecursiveDirectoryRange::const_iterator it = files.begin(); it != files.end(); ++it)
     {
-        std::string filepath = it->first;
-        if (static_cast<int> (filepath.size())<baseSize+1 ||
-            filepath.substr (0, baseSize)!=mBaseDirectory ||
-            (filepath[baseSize]!='/' && filepath[baseSize]!='\\'))
-            continue;
+        const std::string& filepath = it->first;
 
         if (extensions)
         {
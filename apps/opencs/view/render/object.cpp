@@ -449,7 +449,7 @@ CSVRender::Object::Object (CSMWorld::Data& data, osg::Group* parentNode,
     else
     {
         mReferenceId = id;
-        mReferenceableId = getReference().mRefID;
+        mReferenceableId = getReference().mRefID.toString();
     }
 
     adjustTransform();
@@ -15,7 +15,7 @@ CSVWorld::PreviewSubView::PreviewSubView (const CSMWorld::UniversalId& id, CSMDo
     if (document.getData().getReferenceables().searchId (id.getId())==-1)
     {
         std::string referenceableId =
-            document.getData().getReferences().getRecord (id.getId()).get().mRefID;
+            document.getData().getReferences().getRecord (id.getId()).get().mRefID.toString();
 
         referenceableIdChanged (referenceableId);
 
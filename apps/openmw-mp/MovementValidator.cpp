@@ -0,0 +1,213 @@
+#include "MovementValidator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <components/openmw-mp/Log.hpp>
+#include <components/openmw-mp/NetworkMessages.hpp>
+
+#include "Networking.hpp"
+#include "Player.hpp"
+
+using namespace std;
+using namespace chrono;
+
+MovementValidator *MovementValidator::sThis = nullptr;
+
+// Packets can be sent in quick succession, so never judge speed over less than this interval
+static const float minimumInterval = 0.1f;
+
+void MovementValidator::create(const Limits &limits, unsigned int threads)
+{
+    assert(!sThis);
+    sThis = new MovementValidator(limits, threads);
+}
+
+void MovementValidator::destroy()
+{
+    assert(sThis);
+    delete sThis;
+    sThis = nullptr;
+}
+
+MovementValidator *MovementValidator::get()
+{
+    return sThis;
+}
+
+MovementValidator::MovementValidator(const Limits &limits, unsigned int threads) : limits(limits), running(true),
+    validatedCount(0), rejectedCount(0), validationTime(0), lastStatistics(steady_clock::now())
+{
+    if (threads == 0)
+        threads = 1;
+
+    for (unsigned int i = 0; i < threads; ++i)
+        workers.emplace_back(&MovementValidator::workerThread, this);
+}
+
+MovementValidator::~MovementValidator()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        running = false;
+    }
+    condition.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void MovementValidator::queuePosition(Player *player)
+{
+    PlayerState &state = players[player->guid];
+
+    Job job;
+    job.guid = player->guid;
+    job.sequence = ++state.sequence;
+    job.cell = player->cell.getCellId();
+    job.position = player->position;
+    job.time = steady_clock::now();
+    job.accepted = true;
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        pending.emplace_back(job, state);
+    }
+    condition.notify_one();
+}
+
+void MovementValidator::resetPlayer(Player *player)
+{
+    PlayerState &state = players[player->guid];
+    state.hasBaseline = true;
+    state.cell = player->cell.getCellId();
+    state.position = player->position;
+    state.time = steady_clock::now();
+    // verdicts on positions queued before the reset no longer matter
+    ++state.sequence;
+}
+
+void MovementValidator::removePlayer(RakNet::RakNetGUID guid)
+{
+    players.erase(guid);
+}
+
+void MovementValidator::processResults()
+{
+    vector<Job> results;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        results.swap(finished);
+    }
+
+    for (const auto &job : results)
+    {
+        auto stateIt = players.find(job.guid);
+        Player *player = Players::getPlayer(job.guid);
+        if (stateIt == players.end() || player == nullptr)
+            continue;
+
+        PlayerState &state = stateIt->second;
+        bool latest = job.sequence == state.sequence;
+
+        if (job.accepted)
+        {
+            if (!state.hasBaseline || job.time > state.time)
+            {
+                state.hasBaseline = true;
+                state.cell = job.cell;
+                state.position = job.position;
+                state.time = job.time;
+            }
+
+            // The packet is serialized from the player's current data, so only the newest position can be forwarded
+            if (latest && !player->creatureStats.mDead)
+            {
+                mwmp::PlayerPacket *packet = mwmp::Networking::get().getPlayerPacketController()->GetPacket(ID_PLAYER_POSITION);
+                player->sendToLoaded(packet);
+            }
+        }
+        else if (latest)
+        {
+            rejectedCount++;
+
+            LOG_MESSAGE_SIMPLE(Log::LOG_WARN, "Rejected position of %s moving from %f, %f, %f to %f, %f, %f",
+                player->npc.mName.c_str(), state.position.pos[0], state.position.pos[1], state.position.pos[2],
+                job.position.pos[0], job.position.pos[1], job.position.pos[2]);
+
+            player->position = state.position;
+
+            mwmp::PlayerPacket *packet = mwmp::Networking::get().getPlayerPacketController()->GetPacket(ID_PLAYER_POSITION);
+            packet->setPlayer(player);
+            packet->Send(false);
+        }
+    }
+
+    if (steady_clock::now() - lastStatistics >= seconds(60))
+        logStatistics();
+}
+
+void MovementValidator::logStatistics()
+{
+    unsigned long long count;
+    nanoseconds time;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        count = validatedCount;
+        time = validationTime;
+    }
+
+    if (count > 0)
+    {
+        LOG_MESSAGE_SIMPLE(Log::LOG_INFO, "Validated %llu positions in %.3f ms (%.3f us per packet), rejected %llu",
+            count, duration<double, milli>(time).count(), duration<double, micro>(time).count() / count, rejectedCount);
+    }
+
+    lastStatistics = steady_clock::now();
+}
+
+void MovementValidator::workerThread()
+{
+    while (true)
+    {
+        pair<Job, PlayerState> item;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            condition.wait(lock, [this]() { return !running || !pending.empty(); });
+
+            if (!running)
+                return;
+
+            item = pending.front();
+            pending.pop_front();
+        }
+
+        auto start = steady_clock::now();
+        item.first.accepted = validate(item.first, item.second);
+        auto elapsed = steady_clock::now() - start;
+
+        lock_guard<mutex> lock(queueMutex);
+        finished.push_back(item.first);
+        validatedCount++;
+        validationTime += duration_cast<nanoseconds>(elapsed);
+    }
+}
+
+bool MovementValidator::validate(const Job &job, const PlayerState &baseline) const
+{
+    // The first position in a cell is always trusted, cell changes are handled separately
+    if (!baseline.hasBaseline || baseline.cell != job.cell)
+        return true;
+
+    float dx = job.position.pos[0] - baseline.position.pos[0];
+    float dy = job.position.pos[1] - baseline.position.pos[1];
+    float dz = job.position.pos[2] - baseline.position.pos[2];
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+    if (!std::isfinite(distance) || distance > limits.maximumDistance)
+        return false;
+
+    float interval = std::max(duration<float>(job.time - baseline.time).count(), minimumInterval);
+    return distance <= limits.maximumSpeed * interval;
+}
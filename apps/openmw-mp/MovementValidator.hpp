@@ -0,0 +1,101 @@
+#ifndef OPENMW_MOVEMENTVALIDATOR_HPP
+#define OPENMW_MOVEMENTVALIDATOR_HPP
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <RakNetTypes.h>
+
+#include <components/esm/defs.hpp>
+#include <components/esm/cellid.hpp>
+
+class Player;
+
+/*
+ * Optional sanity check of player positions before they are forwarded to other players.
+ *
+ * Checks run on a small pool of worker threads so the main loop only queues a position and later
+ * picks up the verdict. A position is rejected when it is further than maximumDistance from the last
+ * accepted position, or would need the player to move faster than maximumSpeed to get there.
+ * Rejected players are put back at their last accepted position.
+ *
+ * Cell changes and server-side teleports reset the baseline, see resetPlayer().
+ */
+class MovementValidator
+{
+public:
+    struct Limits
+    {
+        float maximumSpeed; // units per second
+        float maximumDistance; // units since the last accepted position
+    };
+
+    static void create(const Limits &limits, unsigned int threads);
+    static void destroy();
+    /// @return nullptr if movement validation is disabled
+    static MovementValidator *get();
+
+    /// Queue the position currently stored in the player for validation
+    void queuePosition(Player *player);
+
+    /// Forward accepted positions and correct rejected ones, call from the main loop
+    void processResults();
+
+    /// Accept the player's current position as a new baseline without checking it
+    void resetPlayer(Player *player);
+    void removePlayer(RakNet::RakNetGUID guid);
+
+private:
+    MovementValidator(const Limits &limits, unsigned int threads);
+    ~MovementValidator();
+
+    MovementValidator(MovementValidator&); // not used
+
+    struct Job
+    {
+        RakNet::RakNetGUID guid;
+        unsigned int sequence;
+        ESM::CellId cell;
+        ESM::Position position;
+        std::chrono::steady_clock::time_point time;
+        bool accepted;
+    };
+
+    struct PlayerState
+    {
+        bool hasBaseline = false;
+        ESM::CellId cell;
+        ESM::Position position;
+        std::chrono::steady_clock::time_point time;
+        unsigned int sequence = 0;
+    };
+
+    void workerThread();
+    bool validate(const Job &job, const PlayerState &baseline) const;
+    void logStatistics();
+
+    static MovementValidator *sThis;
+
+    Limits limits;
+
+    std::vector<std::thread> workers;
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    std::deque<std::pair<Job, PlayerState>> pending;
+    std::vector<Job> finished;
+    bool running;
+
+    // baselines are only touched on the main thread, workers get a copy with each job
+    std::map<RakNet::RakNetGUID, PlayerState> players;
+
+    unsigned long long validatedCount;
+    unsigned long long rejectedCount;
+    std::chrono::nanoseconds validationTime;
+    std::chrono::steady_clock::time_point lastStatistics;
+};
+
+#endif //OPENMW_MOVEMENTVALIDATOR_HPP
@@ -17,6 +17,7 @@
 
 #include "Networking.hpp"
 #include "MasterClient.hpp"
+#include "MovementValidator.hpp"
 #include "Cell.hpp"
 #include "CellController.hpp"
 #include "processors/PlayerProcessor.hpp"
@@ -372,6 +373,10 @@ void Networking::disconnectPlayer(RakNet::RakNetGUID guid)
 
     playerPacketController->GetPacket(ID_USER_DISCONNECTED)->setPlayer(player);
     playerPacketController->GetPacket(ID_USER_DISCONNECTED)->Send(true);
+
+    if (MovementValidator::get())
+        MovementValidator::get()->removePlayer(guid);
+
     Players::deletePlayer(guid);
 }
 
@@ -530,6 +535,9 @@ int Networking::mainLoop()
                 }
             }
         }
+        if (MovementValidator::get())
+            MovementValidator::get()->processResults();
+
         TimerAPI::Tick();
         this_thread::sleep_for(chrono::milliseconds(1));
     }
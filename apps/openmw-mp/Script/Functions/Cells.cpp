@@ -6,6 +6,7 @@
 #include <apps/openmw-mp/Script/ScriptFunctions.hpp>
 #include <apps/openmw-mp/Player.hpp>
 #include <apps/openmw-mp/Networking.hpp>
+#include <apps/openmw-mp/MovementValidator.hpp>
 
 #include <iostream>
 using namespace std;
@@ -124,4 +125,7 @@ void CellFunctions::SendCell(unsigned short pid) noexcept
     packet->setPlayer(player);
 
     packet->Send(false);
+
+    if (MovementValidator::get())
+        MovementValidator::get()->resetPlayer(player);
 }
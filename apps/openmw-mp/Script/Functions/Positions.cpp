@@ -3,6 +3,7 @@
 #include <components/openmw-mp/NetworkMessages.hpp>
 #include <apps/openmw-mp/Player.hpp>
 #include <apps/openmw-mp/Networking.hpp>
+#include <apps/openmw-mp/MovementValidator.hpp>
 
 #include <iostream>
 using namespace std;
@@ -109,6 +110,9 @@ void PositionFunctions::SendPos(unsigned short pid) noexcept
     packet->setPlayer(player);
 
     packet->Send(false);
+
+    if (MovementValidator::get())
+        MovementValidator::get()->resetPlayer(player);
 }
 
 void PositionFunctions::SendMomentum(unsigned short pid) noexcept
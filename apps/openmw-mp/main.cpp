@@ -22,6 +22,7 @@
 
 #include "Player.hpp"
 #include "Networking.hpp"
+#include "MovementValidator.hpp"
 #include "MasterClient.hpp"
 #include "Utils.hpp"
 
@@ -318,10 +319,25 @@ int main(int argc, char *argv[])
             networking.getMasterClient()->Start();
         }
 
+        if (mgr.getBool("enabled", "MovementValidation"))
+        {
+            MovementValidator::Limits limits;
+            limits.maximumSpeed = mgr.getFloat("maximumSpeed", "MovementValidation");
+            limits.maximumDistance = mgr.getFloat("maximumDistance", "MovementValidation");
+            int threads = mgr.getInt("threads", "MovementValidation");
+
+            LOG_MESSAGE_SIMPLE(Log::LOG_INFO, "Validating player movement with %i threads, maximum speed %f, maximum distance %f",
+                threads, limits.maximumSpeed, limits.maximumDistance);
+            MovementValidator::create(limits, (unsigned int) (threads > 0 ? threads : 1));
+        }
+
         networking.postInit();
 
         code = networking.mainLoop();
 
+        if (MovementValidator::get())
+            MovementValidator::destroy();
+
         networking.getMasterClient()->Stop();
     }
     catch (std::exception &e)
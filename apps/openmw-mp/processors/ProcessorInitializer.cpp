@@ -73,6 +73,7 @@
 #include "object/ProcessorScriptMemberFloat.hpp"
 #include "object/ProcessorScriptGlobalShort.hpp"
 #include "object/ProcessorScriptGlobalFloat.hpp"
+#include "object/ProcessorScriptState.hpp"
 #include "object/ProcessorVideoPlay.hpp"
 #include "WorldstateProcessor.hpp"
 #include "worldstate/ProcessorRecordDynamic.hpp"
@@ -152,6 +153,7 @@ void ProcessorInitializer()
     ObjectProcessor::AddProcessor(new ProcessorScriptMemberFloat());
     ObjectProcessor::AddProcessor(new ProcessorScriptGlobalShort());
     ObjectProcessor::AddProcessor(new ProcessorScriptGlobalFloat());
+    ObjectProcessor::AddProcessor(new ProcessorScriptState());
     ObjectProcessor::AddProcessor(new ProcessorVideoPlay());
 
     WorldstateProcessor::AddProcessor(new ProcessorRecordDynamic());
@@ -0,0 +1,18 @@
+#ifndef OPENMW_PROCESSORSCRIPTSTATE_HPP
+#define OPENMW_PROCESSORSCRIPTSTATE_HPP
+
+#include "../ObjectProcessor.hpp"
+
+namespace mwmp
+{
+    class ProcessorScriptState : public ObjectProcessor
+    {
+    public:
+        ProcessorScriptState()
+        {
+            BPP_INIT(ID_SCRIPT_STATE)
+        }
+    };
+}
+
+#endif //OPENMW_PROCESSORSCRIPTSTATE_HPP
@@ -8,6 +8,7 @@
 #include "../PlayerProcessor.hpp"
 #include "apps/openmw-mp/Networking.hpp"
 #include "apps/openmw-mp/Script/Script.hpp"
+#include "apps/openmw-mp/MovementValidator.hpp"
 #include <components/openmw-mp/Controllers/PlayerPacketController.hpp>
 
 namespace mwmp
@@ -31,6 +32,9 @@ namespace mwmp
 
             player.exchangeFullInfo = true;
 
+            if (MovementValidator::get())
+                MovementValidator::get()->resetPlayer(&player);
+
             player.forEachLoaded([this](Player *pl, Player *other) {
 
                 LOG_APPEND(Log::LOG_INFO, "- Started information exchange with %s", other->npc.mName.c_str());
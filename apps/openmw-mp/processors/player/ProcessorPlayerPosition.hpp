@@ -6,6 +6,7 @@
 #define OPENMW_PROCESSORPLAYERPOSITION_HPP
 
 #include "../PlayerProcessor.hpp"
+#include "apps/openmw-mp/MovementValidator.hpp"
 
 namespace mwmp
 {
@@ -22,7 +23,10 @@ namespace mwmp
             //DEBUG_PRINTF(strPacketID);
             if (!player.creatureStats.mDead)
             {
-                player.sendToLoaded(&packet);
+                if (MovementValidator::get())
+                    MovementValidator::get()->queuePosition(&player);
+                else
+                    player.sendToLoaded(&packet);
             }
         }
     };
@@ -11,6 +11,7 @@
 
 namespace osg
 {
+    class Stats;
     class Vec3f;
 }
 
@@ -60,6 +61,9 @@ namespace MWBase
             virtual void updateCell(const MWWorld::Ptr &old, const MWWorld::Ptr &ptr) = 0;
             ///< Moves an object to a new cell
 
+            virtual void updatePosition(const MWWorld::Ptr &ptr) = 0;
+            ///< An object was moved within the scene
+
             virtual void drop (const MWWorld::CellStore *cellStore) = 0;
             ///< Deregister all objects in the given cell.
 
@@ -198,6 +202,8 @@ namespace MWBase
             virtual bool toggleAI() = 0;
             virtual bool isAIActive() = 0;
 
+            virtual void reportStats (unsigned int frameNumber, osg::Stats* stats) const = 0;
+
             virtual void getObjectsInRange (const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& objects) = 0;
             virtual void getActorsInRange(const osg::Vec3f &position, float radius, std::vector<MWWorld::Ptr> &objects) = 0;
 
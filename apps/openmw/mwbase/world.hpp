@@ -17,6 +17,7 @@ namespace osg
     class Matrixf;
     class Quat;
     class Image;
+    class Stats;
 }
 
 namespace Loading
@@ -513,6 +514,8 @@ namespace MWBase
 
             virtual void updateWindowManager () = 0;
 
+            virtual void reportStats (unsigned int frameNumber, osg::Stats* stats) const = 0;
+
             virtual MWWorld::Ptr placeObject (const MWWorld::ConstPtr& object, float cursorX, float cursorY, int amount) = 0;
             ///< copy and place an object into the gameworld at the specified cursor position
             /// @param object
@@ -605,6 +608,14 @@ namespace MWBase
             virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) = 0;
             ///< get Line of Sight (morrowind stupid implementation)
 
+            virtual void prefetchLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& pairs) = 0;
+            ///< Work out the Line of Sight for all of these pairs at once, for the getLOS() calls that follow in this frame.
+
+            virtual bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                            std::vector<osg::Vec3f>& path) const = 0;
+            ///< Find a path from \a start to \a end over the collision geometry of \a cell, if its navigation grid is built.
+            /// \a path receives the points to walk through after \a start, excluding \a end.
+
             virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false) = 0;
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable) = 0;
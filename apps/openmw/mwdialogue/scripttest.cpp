@@ -50,7 +50,7 @@ void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::
                 {
                     errorHandler.reset();
 
-                    std::istringstream input (info->mResultScript + "\n");
+                    std::istringstream input (info->mResultScript.get() + "\n");
 
                     Compiler::Scanner scanner (errorHandler, input, extensions);
 
@@ -18,4 +18,9 @@ namespace MWMechanics
     {
         return mCharacterController.get();
     }
+
+    AiSchedule& Actor::getAiSchedule()
+    {
+        return mAiSchedule;
+    }
 }
@@ -3,6 +3,8 @@
 
 #include <memory>
 
+#include "aischeduler.hpp"
+
 namespace MWRender
 {
     class Animation;
@@ -27,8 +29,11 @@ namespace MWMechanics
 
         CharacterController* getCharacterController();
 
+        AiSchedule& getAiSchedule();
+
     private:
         std::unique_ptr<CharacterController> mCharacterController;
+        AiSchedule mAiSchedule;
     };
 
 }
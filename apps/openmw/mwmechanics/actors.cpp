@@ -1,13 +1,20 @@
 #include "actors.hpp"
 
+#include <cmath>
 #include <typeinfo>
 #include <iostream>
+#include <algorithm>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/loadnpc.hpp>
 
+#include <components/sceneutil/commandbuffer.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include <osg/Stats>
+#include <osg/Timer>
 
 #include <components/settings/settings.hpp>
 
@@ -161,6 +168,19 @@ void getRestorationPerHourOfSleep (const MWWorld::Ptr& ptr, float& health, float
     }
 }
 
+float getMaxHeadTrackDistance(const MWWorld::Ptr& actor)
+{
+    static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
+            .find("fMaxHeadTrackDistance")->getFloat();
+    static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
+            .find("fInteriorHeadTrackMult")->getFloat();
+    float maxDistance = fMaxHeadTrackDistance;
+    const ESM::Cell* currentCell = actor.getCell()->getCell();
+    if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
+        maxDistance *= fInteriorHeadTrackMult;
+    return maxDistance;
+}
+
 }
 
 namespace MWMechanics
@@ -178,6 +198,9 @@ namespace MWMechanics
     */
     const float sqrAiProcessingDistance = aiProcessingDistance*aiProcessingDistance;
 
+    // About twice the head tracking and sneak detection range, which are the most frequent queries
+    const float actorGridCellSize = 1024;
+
     class SoulTrap : public MWMechanics::EffectSourceVisitor
     {
         MWWorld::Ptr mCreature;
@@ -351,46 +374,112 @@ namespace MWMechanics
         calculateRestoration(ptr, duration);
     }
 
-    void Actors::updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
-                                    MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance)
+    bool Actors::mayHeadTrack(const MWWorld::Ptr& actor, const MWWorld::Ptr& player) const
     {
-        static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fMaxHeadTrackDistance")->getFloat();
-        static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fInteriorHeadTrackMult")->getFloat();
-        float maxDistance = fMaxHeadTrackDistance;
-        const ESM::Cell* currentCell = actor.getCell()->getCell();
-        if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
-            maxDistance *= fInteriorHeadTrackMult;
+        /*
+            Start of tes3mp addition
 
-        const ESM::Position& actor1Pos = actor.getRefData().getPosition();
-        const ESM::Position& actor2Pos = targetActor.getRefData().getPosition();
-        float sqrDist = (actor1Pos.asVec3() - actor2Pos.asVec3()).length2();
+            Only actors whose AI is processed here
+        */
+        if ((player.getRefData().getPosition().asVec3() - actor.getRefData().getPosition().asVec3()).length2() > sqrAiProcessingDistance)
+            return false;
 
-        if (sqrDist > maxDistance*maxDistance)
-            return;
+        if (!MWBase::Environment::get().getMechanicsManager()->isAIActive()
+                && !mwmp::Main::get().getCellController()->isLocalActor(actor)
+                && !mwmp::Main::get().getCellController()->isDedicatedActor(actor))
+            return false;
+        /*
+            End of tes3mp addition
+        */
 
-        if (targetActor.getClass().getCreatureStats(targetActor).isDead())
-            return;
+        const CreatureStats& stats = actor.getClass().getCreatureStats(actor);
+
+        // 1. Unconsious actor can not track target
+        // 2. Actors in combat and pursue mode do not bother to headtrack
+        // 3. Player character does not use headtracking in the 1st-person view
+        return !stats.isDead()
+            && !stats.getKnockedDown()
+            && !stats.getAiSequence().isInCombat()
+            && !stats.getAiSequence().hasPackage(AiPackage::TypeIdPursue)
+            && !(actor == player && MWBase::Environment::get().getWorld()->isFirstPerson());
+    }
 
+    void Actors::getHeadTrackingCandidates(const MWWorld::Ptr& actor, std::vector<MWWorld::Ptr>& candidates)
+    {
         if (!actor.getRefData().getBaseNode())
             return;
 
-        // stop tracking when target is behind the actor
+        const float maxDistance = getMaxHeadTrackDistance(actor);
+        const osg::Vec3f actorPos = actor.getRefData().getPosition().asVec3();
+
+        std::vector<MWWorld::Ptr> targets;
+        getObjectsInRange(actorPos, maxDistance, targets);
+
         osg::Vec3f actorDirection = actor.getRefData().getBaseNode()->getAttitude() * osg::Vec3f(0,1,0);
-        osg::Vec3f targetDirection (actor2Pos.asVec3() - actor1Pos.asVec3());
         actorDirection.z() = 0;
-        targetDirection.z() = 0;
-        actorDirection.normalize();
-        targetDirection.normalize();
-        if (std::acos(actorDirection * targetDirection) < osg::DegreesToRadians(90.f)
-            && sqrDist <= sqrHeadTrackDistance
-            && MWBase::Environment::get().getWorld()->getLOS(actor, targetActor) // check LOS and awareness last as it's the most expensive function
-            && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(targetActor, actor))
+
+        std::vector<std::pair<float, MWWorld::Ptr> > sorted;
+        for (std::vector<MWWorld::Ptr>::const_iterator it = targets.begin(); it != targets.end(); ++it)
+        {
+            if (*it == actor || it->getClass().getCreatureStats(*it).isDead())
+                continue;
+
+            osg::Vec3f targetDirection (it->getRefData().getPosition().asVec3() - actorPos);
+            const float sqrDist = targetDirection.length2();
+            if (sqrDist > maxDistance*maxDistance)
+                continue;
+
+            // stop tracking when target is behind the actor
+            targetDirection.z() = 0;
+            if (actorDirection * targetDirection <= 0)
+                continue;
+
+            sorted.push_back(std::make_pair(sqrDist, *it));
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [] (const std::pair<float, MWWorld::Ptr>& lhs, const std::pair<float, MWWorld::Ptr>& rhs) { return lhs.first < rhs.first; });
+
+        for (std::vector<std::pair<float, MWWorld::Ptr> >::const_iterator it = sorted.begin(); it != sorted.end(); ++it)
+            candidates.push_back(it->second);
+    }
+
+    void Actors::updateHeadTracking(const MWWorld::Ptr& actor, MWWorld::Ptr& headTrackTarget)
+    {
+        std::vector<MWWorld::Ptr> candidates;
+        getHeadTrackingCandidates(actor, candidates);
+
+        // The nearest target that is seen wins, so the expensive checks stop at the first one that passes
+        for (std::vector<MWWorld::Ptr>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+        {
+            if (MWBase::Environment::get().getWorld()->getLOS(actor, *it)
+                && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(*it, actor))
+            {
+                headTrackTarget = *it;
+                return;
+            }
+        }
+    }
+
+    void Actors::prefetchHeadTrackingLOS(const MWWorld::Ptr& player)
+    {
+        // Rays that updateHeadTracking() is sure to ask for, so that they are cast together. Only the
+        // nearest candidate is: the ones after it are only checked if it is not seen.
+        std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> > pairs;
+        std::vector<MWWorld::Ptr> candidates;
+        for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
         {
-            sqrHeadTrackDistance = sqrDist;
-            headTrackTarget = targetActor;
+            const MWWorld::Ptr& actor = iter->first;
+            if (!mayHeadTrack(actor, player))
+                continue;
+
+            candidates.clear();
+            getHeadTrackingCandidates(actor, candidates);
+            if (!candidates.empty())
+                pairs.push_back(std::make_pair(MWWorld::ConstPtr(actor), MWWorld::ConstPtr(candidates.front())));
         }
+
+        MWBase::Environment::get().getWorld()->prefetchLOS(pairs);
     }
 
     void Actors::engageCombat (const MWWorld::Ptr& actor1, const MWWorld::Ptr& actor2, std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >& cachedAllies, bool againstPlayer)
@@ -555,9 +644,9 @@ namespace MWMechanics
         }
     }
 
-    void Actors::updateNpc (const MWWorld::Ptr& ptr, float duration)
+    void Actors::updateNpc (const MWWorld::Ptr& ptr, float duration, SceneUtil::CommandBuffer& commands)
     {
-        updateDrowning(ptr, duration);
+        updateDrowning(ptr, duration, commands);
         calculateNpcStatModifiers(ptr, duration);
     }
 
@@ -987,7 +1076,7 @@ namespace MWMechanics
         return ctrl->isSneaking();
     }
 
-    void Actors::updateDrowning(const MWWorld::Ptr& ptr, float duration)
+    void Actors::updateDrowning(const MWWorld::Ptr& ptr, float duration, SceneUtil::CommandBuffer& commands)
     {
         PtrActorMap::iterator it = mActors.find(ptr);
         if (it == mActors.end())
@@ -1004,9 +1093,11 @@ namespace MWMechanics
         if (ptr.getClass().isNpc() && stats.getTimeToStartDrowning() < fHoldBreathTime / 2)
         {
             if(ptr != MWMechanics::getPlayer() ) {
-                MWMechanics::AiSequence& seq = ptr.getClass().getCreatureStats(ptr).getAiSequence();
-                if(seq.getTypeId() != MWMechanics::AiPackage::TypeIdBreathe) //Only add it once
-                    seq.stack(MWMechanics::AiBreathe(), ptr);
+                commands.push([ptr] {
+                    MWMechanics::AiSequence& seq = ptr.getClass().getCreatureStats(ptr).getAiSequence();
+                    if(seq.getTypeId() != MWMechanics::AiPackage::TypeIdBreathe) //Only add it once
+                        seq.stack(MWMechanics::AiBreathe(), ptr);
+                });
             }
         }
 
@@ -1032,17 +1123,23 @@ namespace MWMechanics
             {
                 // If drowning, apply 3 points of damage per second
                 static const float fSuffocationDamage = world->getStore().get<ESM::GameSetting>().find("fSuffocationDamage")->getFloat();
-                DynamicStat<float> health = stats.getHealth();
-                health.setCurrent(health.getCurrent() - fSuffocationDamage*duration);
-                stats.setHealth(health);
-
-                // Play a drowning sound
-                MWBase::SoundManager *sndmgr = MWBase::Environment::get().getSoundManager();
-                if(!sndmgr->getSoundPlaying(ptr, "drown"))
-                    sndmgr->playSound3D(ptr, "drown", 1.0f, 1.0f);
-
-                if(ptr == world->getPlayerPtr())
-                    MWBase::Environment::get().getWindowManager()->activateHitOverlay(false);
+                const float damage = fSuffocationDamage*duration;
+
+                // Setting the health reaches the world when the actor dies, so it waits for the main thread
+                commands.push([ptr, damage] {
+                    MWMechanics::CreatureStats& creatureStats = ptr.getClass().getCreatureStats(ptr);
+                    DynamicStat<float> health = creatureStats.getHealth();
+                    health.setCurrent(health.getCurrent() - damage);
+                    creatureStats.setHealth(health);
+
+                    // Play a drowning sound
+                    MWBase::SoundManager *sndmgr = MWBase::Environment::get().getSoundManager();
+                    if(!sndmgr->getSoundPlaying(ptr, "drown"))
+                        sndmgr->playSound3D(ptr, "drown", 1.0f, 1.0f);
+
+                    if(ptr == MWBase::Environment::get().getWorld()->getPlayerPtr())
+                        MWBase::Environment::get().getWindowManager()->activateHitOverlay(false);
+                });
             }
         }
         else
@@ -1247,8 +1344,16 @@ namespace MWMechanics
         }
     }
 
-    Actors::Actors() {
+    Actors::Actors()
+        : mGrid(actorGridCellSize)
+        , mGridDirty(true)
+        , mAiScheduler(Settings::Manager::getFloat("ai update budget", "Game"))
+    {
         mTimerDisposeSummonsCorpses = 0.2f; // We should add a delay between summoned creature death and its corpse despawning
+
+        int numThreads = Settings::Manager::getInt("actor update threads", "Game");
+        if (numThreads > 0)
+            mWorkQueue = new SceneUtil::WorkQueue(numThreads);
     }
 
     Actors::~Actors()
@@ -1264,6 +1369,7 @@ namespace MWMechanics
         if (!anim)
             return;
         mActors.insert(std::make_pair(ptr, new Actor(ptr, anim)));
+        mGridDirty = true;
         if (updateImmediately)
             mActors[ptr]->getCharacterController()->update(0);
     }
@@ -1275,6 +1381,7 @@ namespace MWMechanics
         {
             delete iter->second;
             mActors.erase(iter);
+            mGridDirty = true;
         }
     }
 
@@ -1328,6 +1435,7 @@ namespace MWMechanics
 
             actor->updatePtr(ptr);
             mActors.insert(std::make_pair(ptr, actor));
+            mGridDirty = true;
         }
     }
 
@@ -1340,6 +1448,7 @@ namespace MWMechanics
             {
                 delete iter->second;
                 mActors.erase(iter++);
+                mGridDirty = true;
             }
             else
                 ++iter;
@@ -1410,6 +1519,16 @@ namespace MWMechanics
 
             std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> > cachedAllies; // will be filled as engageCombat iterates
 
+            std::vector<MWWorld::Ptr> npcs; // updated after the AI, all at once, if there are worker threads
+
+            // Actors have moved since the last update
+            mGridDirty = true;
+
+            if (timerUpdateHeadTrack == 0)
+                prefetchHeadTrackingLOS(player);
+
+            scheduleAi(player, duration);
+
              // AI and magic effects update
             for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
             {
@@ -1533,27 +1652,9 @@ namespace MWMechanics
                         }
                         if (timerUpdateHeadTrack == 0)
                         {
-                            float sqrHeadTrackDistance = std::numeric_limits<float>::max();
                             MWWorld::Ptr headTrackTarget;
-
-                            MWMechanics::CreatureStats& stats = iter->first.getClass().getCreatureStats(iter->first);
-                            bool firstPersonPlayer = isPlayer && MWBase::Environment::get().getWorld()->isFirstPerson();
-
-                            // 1. Unconsious actor can not track target
-                            // 2. Actors in combat and pursue mode do not bother to headtrack
-                            // 3. Player character does not use headtracking in the 1st-person view
-                            if (!stats.getKnockedDown() &&
-                                !stats.getAiSequence().isInCombat() &&
-                                !stats.getAiSequence().hasPackage(AiPackage::TypeIdPursue) &&
-                                !firstPersonPlayer)
-                            {
-                                for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
-                                {
-                                    if (it->first == iter->first)
-                                        continue;
-                                    updateHeadTracking(iter->first, it->first, headTrackTarget, sqrHeadTrackDistance);
-                                }
-                            }
+                            if (mayHeadTrack(iter->first, player))
+                                updateHeadTracking(iter->first, headTrackTarget);
 
                             iter->second->getCharacterController()->setHeadTrackTarget(headTrackTarget);
                         }
@@ -1565,7 +1666,12 @@ namespace MWMechanics
                         {
                             CreatureStats &stats = iter->first.getClass().getCreatureStats(iter->first);
                             if (isConscious(iter->first))
-                                stats.getAiSequence().execute(iter->first, *iter->second->getCharacterController(), duration);
+                            {
+                                AiSchedule& schedule = iter->second->getAiSchedule();
+                                osg::Timer_t beforeAiTick = osg::Timer::instance()->tick();
+                                const bool decided = stats.getAiSequence().execute(iter->first, *iter->second->getCharacterController(), duration, schedule.mMayDecide);
+                                mAiScheduler.reportTime(schedule, osg::Timer::instance()->delta_m(beforeAiTick, osg::Timer::instance()->tick()), decided);
+                            }
                         }
                     }
                     /*
@@ -1574,7 +1680,15 @@ namespace MWMechanics
 
                     if(iter->first.getTypeName() == typeid(ESM::NPC).name())
                     {
-                        updateNpc(iter->first, duration);
+                        if (mWorkQueue)
+                            npcs.push_back(iter->first);
+                        else
+                        {
+                            // Without worker threads, keep updating each NPC right after its AI
+                            SceneUtil::CommandBuffer commands;
+                            updateNpc(iter->first, duration, commands);
+                            commands.commit();
+                        }
 
                         if (timerUpdateEquippedLight == 0)
                             updateEquippedLight(iter->first, updateEquippedLightInterval, showTorches);
@@ -1582,6 +1696,14 @@ namespace MWMechanics
                 }
             }
 
+            mAiScheduler.endFrame();
+
+            // Every NPC only changes its own stats here, and leaves everything else to the commands
+            SceneUtil::runJobs(mWorkQueue.get(), npcs.size(), [&] (unsigned int index, SceneUtil::CommandBuffer& commands)
+            {
+                updateNpc(npcs[index], duration, commands);
+            });
+
             timerUpdateAITargets += duration;
             timerUpdateHeadTrack += duration;
             timerUpdateEquippedLight += duration;
@@ -1678,19 +1800,30 @@ namespace MWMechanics
 
                     bool detected = false;
 
-                    for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+                    // the observers in range
+                    std::vector<MWWorld::Ptr> observers;
+                    getObjectsInRange(player.getRefData().getPosition().asVec3(), radius, observers);
+
+                    std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> > lines;
+                    for (std::vector<MWWorld::Ptr>::const_iterator it = observers.begin(); it != observers.end(); ++it)
                     {
-                        MWWorld::Ptr observer = iter->first;
+                        if (*it != player && !it->getClass().getCreatureStats(*it).isDead())
+                            lines.push_back(std::make_pair(MWWorld::ConstPtr(player), MWWorld::ConstPtr(*it)));
+                    }
+                    MWBase::Environment::get().getWorld()->prefetchLOS(lines);
+
+                    for (std::vector<MWWorld::Ptr>::const_iterator it = observers.begin(); it != observers.end(); ++it)
+                    {
+                        const MWWorld::Ptr& observer = *it;
 
-                        if (iter->first == player)  // not the player
+                        if (observer == player)  // not the player
                             continue;
 
                         if (observer.getClass().getCreatureStats(observer).isDead())
                             continue;
 
-                        // is the player in range and can they be detected
-                        if ((observer.getRefData().getPosition().asVec3() - player.getRefData().getPosition().asVec3()).length2() <= radius*radius
-                            && MWBase::Environment::get().getWorld()->getLOS(player, observer))
+                        // can the player be detected
+                        if (MWBase::Environment::get().getWorld()->getLOS(player, observer))
                         {
                             if (MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, observer))
                             {
@@ -1999,22 +2132,90 @@ namespace MWMechanics
 
     void Actors::getObjectsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out)
     {
-        for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+        updateGrid();
+        if (!mGrid.isNarrow(position, radius))
         {
-            if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
-                out.push_back(iter->first);
+            for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+            {
+                if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+                    out.push_back(iter->first);
+            }
+            return;
         }
+
+        size_t first = out.size();
+        mGrid.getInRange(position, radius, out);
+
+        // In the order of mActors, so that the callers do not depend on how the grid is laid out
+        std::sort(out.begin() + first, out.end(), mActors.key_comp());
     }
 
     bool Actors::isAnyObjectInRange(const osg::Vec3f& position, float radius)
     {
+        updateGrid();
+        if (!mGrid.isNarrow(position, radius))
+        {
+            for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+            {
+                if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+                    return true;
+            }
+            return false;
+        }
+
+        return mGrid.isAnyInRange(position, radius);
+    }
+
+    void Actors::updatePosition(const MWWorld::Ptr& ptr)
+    {
+        if (mActors.find(ptr) != mActors.end())
+            mGridDirty = true;
+    }
+
+    void Actors::scheduleAi(const MWWorld::Ptr& player, float duration)
+    {
+        mAiScheduler.beginFrame(duration);
+
+        const bool isAIActive = MWBase::Environment::get().getMechanicsManager()->isAIActive();
+        const osg::Vec3f playerPos = player.getRefData().getPosition().asVec3();
         for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
         {
-            if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
-                return true;
+            // Same as the AI update itself
+            if (iter->first == player || !isConscious(iter->first))
+                continue;
+            if (!isAIActive && !mwmp::Main::get().getCellController()->isLocalActor(iter->first))
+                continue;
+
+            const float distSqr = (playerPos - iter->first.getRefData().getPosition().asVec3()).length2();
+            if (distSqr > sqrAiProcessingDistance)
+                continue;
+
+            const bool inCombat = iter->first.getClass().getCreatureStats(iter->first).getAiSequence().isInCombat();
+            mAiScheduler.addActor(iter->second->getAiSchedule(), AiScheduler::getPriority(std::sqrt(distSqr), inCombat));
         }
 
-        return false;
+        mAiScheduler.schedule();
+    }
+
+    void Actors::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        const AiScheduler::Stats& aiStats = mAiScheduler.getStats();
+        stats->setAttribute(frameNumber, "AI Actor", aiStats.mActors);
+        stats->setAttribute(frameNumber, "AI Decision", aiStats.mDecisions);
+        stats->setAttribute(frameNumber, "AI ms", aiStats.mTime);
+        stats->setAttribute(frameNumber, "AI Overrun ms", aiStats.mOverrun);
+        stats->setAttribute(frameNumber, "AI Overrun", aiStats.mOverrunFrames);
+    }
+
+    void Actors::updateGrid()
+    {
+        if (!mGridDirty)
+            return;
+
+        mGrid.clear();
+        for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+            mGrid.add(iter->first, iter->first.getRefData().getPosition().asVec3());
+        mGridDirty = false;
     }
 
     std::list<MWWorld::Ptr> Actors::getActorsSidingWith(const MWWorld::Ptr& actor)
@@ -2218,6 +2419,7 @@ namespace MWMechanics
             it->second = NULL;
         }
         mActors.clear();
+        mGridDirty = true;
         mDeathCount.clear();
     }
 
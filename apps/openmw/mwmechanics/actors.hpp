@@ -6,9 +6,14 @@
 #include <string>
 #include <list>
 
+#include <osg/ref_ptr>
+
+#include <components/misc/spatialgrid.hpp>
+
 #include "../mwbase/world.hpp"
 
 #include "movement.hpp"
+#include "aischeduler.hpp"
 
 namespace MWWorld
 {
@@ -16,6 +21,17 @@ namespace MWWorld
     class CellStore;
 }
 
+namespace osg
+{
+    class Stats;
+}
+
+namespace SceneUtil
+{
+    class CommandBuffer;
+    class WorkQueue;
+}
+
 namespace MWMechanics
 {
     class Actor;
@@ -28,7 +44,9 @@ namespace MWMechanics
             void addBoundItem (const std::string& itemId, const MWWorld::Ptr& actor);
             void removeBoundItem (const std::string& itemId, const MWWorld::Ptr& actor);
 
-            void updateNpc(const MWWorld::Ptr &ptr, float duration);
+            /// @note May run on a worker thread, alongside the same for other NPCs. Anything that is not about
+            /// \a ptr alone has to go through \a commands.
+            void updateNpc(const MWWorld::Ptr &ptr, float duration, SceneUtil::CommandBuffer& commands);
 
             void adjustMagicEffects (const MWWorld::Ptr& creature);
 
@@ -39,7 +57,7 @@ namespace MWMechanics
 
             void calculateRestoration (const MWWorld::Ptr& ptr, float duration);
 
-            void updateDrowning (const MWWorld::Ptr& ptr, float duration);
+            void updateDrowning (const MWWorld::Ptr& ptr, float duration, SceneUtil::CommandBuffer& commands);
 
             void updateEquippedLight (const MWWorld::Ptr& ptr, float duration, bool mayEquip);
 
@@ -82,6 +100,9 @@ namespace MWMechanics
             void updateActor(const MWWorld::Ptr &old, const MWWorld::Ptr& ptr);
             ///< Updates an actor with a new Ptr
 
+            void updatePosition(const MWWorld::Ptr& ptr);
+            ///< An actor was moved, so range queries have to look at its new position
+
             void dropActors (const MWWorld::CellStore *cellStore, const MWWorld::Ptr& ignore);
             ///< Deregister all actors (except for \a ignore) in the given cell.
 
@@ -101,8 +122,23 @@ namespace MWMechanics
             */
             void engageCombat(const MWWorld::Ptr& actor1, const MWWorld::Ptr& actor2, std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >& cachedAllies, bool againstPlayer);
 
-            void updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
-                                            MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance);
+            /// Does \a actor look for a head tracking target this frame? Decides both which actors
+            /// updateHeadTracking() is called for and which rays prefetchHeadTrackingLOS() casts.
+            bool mayHeadTrack(const MWWorld::Ptr& actor, const MWWorld::Ptr& player) const;
+
+            /// The actors in front of \a actor and close enough to be looked at, nearest first.
+            void getHeadTrackingCandidates(const MWWorld::Ptr& actor, std::vector<MWWorld::Ptr>& candidates);
+
+            /// Set \a headTrackTarget to the nearest candidate that \a actor sees.
+            void updateHeadTracking(const MWWorld::Ptr& actor, MWWorld::Ptr& headTrackTarget);
+
+            /// Work out the Line of Sight for the pairs of actors that head tracking is going to check, all at once.
+            void prefetchHeadTrackingLOS(const MWWorld::Ptr& player);
+
+            /// Decide which of the actors whose AI runs this frame may make decisions.
+            void scheduleAi(const MWWorld::Ptr& player, float duration);
+
+            void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
 
             void rest(bool sleep);
             ///< Update actors while the player is waiting or sleeping. This should be called every hour.
@@ -181,6 +217,17 @@ namespace MWMechanics
         PtrActorMap mActors;
         float mTimerDisposeSummonsCorpses;
 
+        // Rebuilt from mActors when dirty, for the range queries
+        Misc::SpatialGrid<MWWorld::Ptr> mGrid;
+        bool mGridDirty;
+
+        void updateGrid();
+
+        // Updates NPCs in parallel, NULL to update them on the main thread
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
+        AiScheduler mAiScheduler;
+
     };
 }
 
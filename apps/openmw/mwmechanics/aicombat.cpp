@@ -173,9 +173,10 @@ namespace MWMechanics
         {
             timerReact += duration;
         }
-        else
+        else if (mMayDecide)
         {
             timerReact = 0;
+            mDecided = true;
             if (attack(actor, target, storage, characterController))
                 return true;
         }
@@ -1,7 +1,10 @@
 #include "aicombataction.hpp"
 
+#include <algorithm>
+
 #include <components/esm/loadench.hpp>
 #include <components/esm/loadmgef.hpp>
+#include <components/esm/loadrace.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -14,13 +17,138 @@
 #include "../mwworld/cellstore.hpp"
 
 #include "npcstats.hpp"
+#include "aipackage.hpp"
+#include "aisequence.hpp"
 #include "spellcasting.hpp"
 #include "combat.hpp"
 #include "weaponpriority.hpp"
 #include "spellpriority.hpp"
 
+namespace
+{
+    float rateCachedAmmo(const MWMechanics::CombatActionCache::Items& ammo, const MWWorld::Ptr& actor, const MWWorld::Ptr& enemy,
+                         MWWorld::Ptr& bestAmmo, ESM::Weapon::Type ammoType)
+    {
+        float bestAmmoRating = 0.f;
+        for (MWMechanics::CombatActionCache::Items::const_iterator it = ammo.begin(); it != ammo.end(); ++it)
+        {
+            float rating = MWMechanics::rateWeapon(**it, actor, enemy, ammoType);
+            if (rating > bestAmmoRating)
+            {
+                bestAmmoRating = rating;
+                bestAmmo = **it;
+            }
+        }
+        return bestAmmoRating;
+    }
+
+    /// Candidates are relisted as soon as the inventory changes, but an item that was used up in between is skipped
+    bool isAvailable(const MWWorld::ContainerStoreIterator& item)
+    {
+        return item->getRefData().getCount() > 0;
+    }
+}
+
 namespace MWMechanics
 {
+    void CombatActionCache::update(const MWWorld::Ptr& actor)
+    {
+        if (actor.getClass().hasInventoryStore(actor))
+        {
+            MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
+            if (mStore.update(store))
+            {
+                mPotions.clear();
+                mMagicItems.clear();
+                mWeapons.clear();
+                mAmmo.clear();
+
+                for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+                {
+                    if (it.getType() == MWWorld::ContainerStore::Type_Potion)
+                        mPotions.push_back(it);
+
+                    if (!it->getClass().getEnchantment(*it).empty())
+                        mMagicItems.push_back(it);
+
+                    if (it.getType() == MWWorld::ContainerStore::Type_Weapon)
+                    {
+                        int type = it->get<ESM::Weapon>()->mBase->mData.mType;
+                        if (type == ESM::Weapon::Arrow || type == ESM::Weapon::Bolt)
+                            mAmmo.push_back(it);
+                    }
+
+                    std::vector<int> equipmentSlots = it->getClass().getEquipmentSlots(*it).first;
+                    if (std::find(equipmentSlots.begin(), equipmentSlots.end(), (int)MWWorld::InventoryStore::Slot_CarriedRight)
+                            != equipmentSlots.end())
+                        mWeapons.push_back(it);
+                }
+            }
+        }
+
+        const Spells& spells = actor.getClass().getCreatureStats(actor).getSpells();
+        if (mSpellList.update(spells))
+        {
+            mSpells.clear();
+
+            // Don't make use of racial bonus spells, like MW. Can be made optional later
+            const ESM::Race* race = NULL;
+            if (actor.getClass().isNpc())
+                race = MWBase::Environment::get().getWorld()->getStore().get<ESM::Race>().find(actor.get<ESM::NPC>()->mBase->mRace);
+
+            for (Spells::TIterator it = spells.begin(); it != spells.end(); ++it)
+            {
+                const ESM::Spell* spell = it->first;
+                if (spell->mData.mType != ESM::Spell::ST_Spell)
+                    continue;
+                if (race && race->mPowers.exists(spell->mId))
+                    continue;
+                mSpells.push_back(spell);
+            }
+        }
+    }
+
+    void CombatActionCache::advance(float duration)
+    {
+        for (std::vector<TargetRating>::iterator it = mRatings.begin(); it != mRatings.end();)
+        {
+            it->mAge += duration;
+            if (it->mAge > AI_REACTION_TIME)
+                it = mRatings.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    bool CombatActionCache::getRating(const MWWorld::Ptr& target, float& rating) const
+    {
+        for (std::vector<TargetRating>::const_iterator it = mRatings.begin(); it != mRatings.end(); ++it)
+        {
+            if (it->mTarget == target.getBase())
+            {
+                rating = it->mRating;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CombatActionCache::setRating(const MWWorld::Ptr& target, float rating)
+    {
+        for (std::vector<TargetRating>::iterator it = mRatings.begin(); it != mRatings.end(); ++it)
+        {
+            if (it->mTarget == target.getBase())
+            {
+                it->mRating = rating;
+                it->mAge = 0.f;
+                return;
+            }
+        }
+
+        TargetRating entry = {target.getBase(), rating, 0.f};
+        mRatings.push_back(entry);
+    }
+
     float suggestCombatRange(int rangeTypes)
     {
         static const float fCombatDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fCombatDistance")->getFloat();
@@ -144,8 +272,6 @@ namespace MWMechanics
 
     std::shared_ptr<Action> prepareNextAction(const MWWorld::Ptr &actor, const MWWorld::Ptr &enemy)
     {
-        Spells& spells = actor.getClass().getCreatureStats(actor).getSpells();
-
         float bestActionRating = 0.f;
         float antiFleeRating = 0.f;
         // Default to hand-to-hand combat
@@ -156,49 +282,54 @@ namespace MWMechanics
             return bestAction;
         }
 
+        CombatActionCache& cache = actor.getClass().getCreatureStats(actor).getAiSequence().getCombatActionCache();
+        cache.update(actor);
+
         if (actor.getClass().hasInventoryStore(actor))
         {
-            MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
-
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (CombatActionCache::Items::const_iterator it = cache.getPotions().begin(); it != cache.getPotions().end(); ++it)
             {
-                float rating = ratePotion(*it, actor);
+                if (!isAvailable(*it))
+                    continue;
+
+                float rating = ratePotion(**it, actor);
                 if (rating > bestActionRating)
                 {
                     bestActionRating = rating;
-                    bestAction.reset(new ActionPotion(*it));
+                    bestAction.reset(new ActionPotion(**it));
                     antiFleeRating = std::numeric_limits<float>::max();
                 }
             }
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (CombatActionCache::Items::const_iterator it = cache.getMagicItems().begin(); it != cache.getMagicItems().end(); ++it)
             {
-                float rating = rateMagicItem(*it, actor, enemy);
+                if (!isAvailable(*it))
+                    continue;
+
+                float rating = rateMagicItem(**it, actor, enemy);
                 if (rating > bestActionRating)
                 {
                     bestActionRating = rating;
-                    bestAction.reset(new ActionEnchantedItem(it));
+                    bestAction.reset(new ActionEnchantedItem(*it));
                     antiFleeRating = std::numeric_limits<float>::max();
                 }
             }
 
             MWWorld::Ptr bestArrow;
-            float bestArrowRating = rateAmmo(actor, enemy, bestArrow, ESM::Weapon::Arrow);
+            float bestArrowRating = rateCachedAmmo(cache.getAmmo(), actor, enemy, bestArrow, ESM::Weapon::Arrow);
 
             MWWorld::Ptr bestBolt;
-            float bestBoltRating = rateAmmo(actor, enemy, bestBolt, ESM::Weapon::Bolt);
+            float bestBoltRating = rateCachedAmmo(cache.getAmmo(), actor, enemy, bestBolt, ESM::Weapon::Bolt);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (CombatActionCache::Items::const_iterator it = cache.getWeapons().begin(); it != cache.getWeapons().end(); ++it)
             {
-                std::vector<int> equipmentSlots = it->getClass().getEquipmentSlots(*it).first;
-                if (std::find(equipmentSlots.begin(), equipmentSlots.end(), (int)MWWorld::InventoryStore::Slot_CarriedRight)
-                        == equipmentSlots.end())
+                if (!isAvailable(*it))
                     continue;
 
-                float rating = rateWeapon(*it, actor, enemy, -1, bestArrowRating, bestBoltRating);
+                float rating = rateWeapon(**it, actor, enemy, -1, bestArrowRating, bestBoltRating);
                 if (rating > bestActionRating)
                 {
-                    const ESM::Weapon* weapon = it->get<ESM::Weapon>()->mBase;
+                    const ESM::Weapon* weapon = (*it)->get<ESM::Weapon>()->mBase;
 
                     MWWorld::Ptr ammo;
                     if (weapon->mData.mType == ESM::Weapon::MarksmanBow)
@@ -207,15 +338,15 @@ namespace MWMechanics
                         ammo = bestBolt;
 
                     bestActionRating = rating;
-                    bestAction.reset(new ActionWeapon(*it, ammo));
-                    antiFleeRating = vanillaRateWeaponAndAmmo(*it, ammo, actor, enemy);
+                    bestAction.reset(new ActionWeapon(**it, ammo));
+                    antiFleeRating = vanillaRateWeaponAndAmmo(**it, ammo, actor, enemy);
                 }
             }
         }
 
-        for (Spells::TIterator it = spells.begin(); it != spells.end(); ++it)
+        for (std::vector<const ESM::Spell*>::const_iterator it = cache.getSpells().begin(); it != cache.getSpells().end(); ++it)
         {
-            const ESM::Spell* spell = it->first;
+            const ESM::Spell* spell = *it;
 
             float rating = rateSpell(spell, actor, enemy);
             if (rating > bestActionRating)
@@ -237,8 +368,6 @@ namespace MWMechanics
 
     float getBestActionRating(const MWWorld::Ptr &actor, const MWWorld::Ptr &enemy)
     {
-        Spells& spells = actor.getClass().getCreatureStats(actor).getSpells();
-
         float bestActionRating = 0.f;
         // Default to hand-to-hand combat
         if (actor.getClass().isNpc() && actor.getClass().getNpcStats(actor).isWerewolf())
@@ -246,31 +375,35 @@ namespace MWMechanics
             return bestActionRating;
         }
 
+        CombatActionCache& cache = actor.getClass().getCreatureStats(actor).getAiSequence().getCombatActionCache();
+        cache.update(actor);
+
         if (actor.getClass().hasInventoryStore(actor))
         {
-            MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
-
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (CombatActionCache::Items::const_iterator it = cache.getMagicItems().begin(); it != cache.getMagicItems().end(); ++it)
             {
-                float rating = rateMagicItem(*it, actor, enemy);
+                if (!isAvailable(*it))
+                    continue;
+
+                float rating = rateMagicItem(**it, actor, enemy);
                 if (rating > bestActionRating)
                 {
                     bestActionRating = rating;
                 }
             }
 
-            float bestArrowRating = rateAmmo(actor, enemy, ESM::Weapon::Arrow);
+            MWWorld::Ptr bestArrow;
+            float bestArrowRating = rateCachedAmmo(cache.getAmmo(), actor, enemy, bestArrow, ESM::Weapon::Arrow);
 
-            float bestBoltRating = rateAmmo(actor, enemy, ESM::Weapon::Bolt);
+            MWWorld::Ptr bestBolt;
+            float bestBoltRating = rateCachedAmmo(cache.getAmmo(), actor, enemy, bestBolt, ESM::Weapon::Bolt);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (CombatActionCache::Items::const_iterator it = cache.getWeapons().begin(); it != cache.getWeapons().end(); ++it)
             {
-                std::vector<int> equipmentSlots = it->getClass().getEquipmentSlots(*it).first;
-                if (std::find(equipmentSlots.begin(), equipmentSlots.end(), (int)MWWorld::InventoryStore::Slot_CarriedRight)
-                        == equipmentSlots.end())
+                if (!isAvailable(*it))
                     continue;
 
-                float rating = rateWeapon(*it, actor, enemy, -1, bestArrowRating, bestBoltRating);
+                float rating = rateWeapon(**it, actor, enemy, -1, bestArrowRating, bestBoltRating);
                 if (rating > bestActionRating)
                 {
                     bestActionRating = rating;
@@ -278,11 +411,9 @@ namespace MWMechanics
             }
         }
 
-        for (Spells::TIterator it = spells.begin(); it != spells.end(); ++it)
+        for (std::vector<const ESM::Spell*>::const_iterator it = cache.getSpells().begin(); it != cache.getSpells().end(); ++it)
         {
-            const ESM::Spell* spell = it->first;
-
-            float rating = rateSpell(spell, actor, enemy);
+            float rating = rateSpell(*it, actor, enemy);
             if (rating > bestActionRating)
             {
                 bestActionRating = rating;
@@ -2,14 +2,19 @@
 #define OPENMW_AICOMBAT_ACTION_H
 
 #include <memory>
+#include <vector>
 
 #include <components/esm/loadspel.hpp>
 
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/containerstore.hpp"
 
+#include "revisioncheck.hpp"
+
 namespace MWMechanics
 {
+    class Spells;
+
     class Action
     {
     public:
@@ -87,6 +92,52 @@ namespace MWMechanics
         virtual const ESM::Weapon* getWeapon() const;
     };
 
+    /// @brief The items and spells an actor could use in combat, and how it recently rated its targets.
+    /// @par Most of an inventory or spell list (clothing, ingredients, abilities...) is never of use in combat, yet
+    /// rating a target used to go through all of it. The candidates are only listed again once the revision of the
+    /// inventory or spells changed.
+    class CombatActionCache
+    {
+    public:
+        typedef std::vector<MWWorld::ContainerStoreIterator> Items;
+
+        /// List the candidates again if the inventory or spells of \a actor changed since the last call.
+        void update(const MWWorld::Ptr& actor);
+
+        /// Age the ratings of targets by \a duration, forgetting those rated longer than AI_REACTION_TIME ago.
+        void advance(float duration);
+
+        /// @return false if \a target was not rated recently.
+        bool getRating(const MWWorld::Ptr& target, float& rating) const;
+        void setRating(const MWWorld::Ptr& target, float rating);
+
+        const Items& getPotions() const { return mPotions; }
+        const Items& getMagicItems() const { return mMagicItems; }
+        /// Items that go in the right hand, and so may be weapons.
+        const Items& getWeapons() const { return mWeapons; }
+        const Items& getAmmo() const { return mAmmo; }
+        /// Only ESM::Spell::ST_Spell, without racial powers.
+        const std::vector<const ESM::Spell*>& getSpells() const { return mSpells; }
+
+    private:
+        RevisionCheck<MWWorld::ContainerStore> mStore;
+        RevisionCheck<Spells> mSpellList;
+
+        Items mPotions;
+        Items mMagicItems;
+        Items mWeapons;
+        Items mAmmo;
+        std::vector<const ESM::Spell*> mSpells;
+
+        struct TargetRating
+        {
+            const MWWorld::LiveCellRefBase* mTarget;
+            float mRating;
+            float mAge;
+        };
+        std::vector<TargetRating> mRatings;
+    };
+
     std::shared_ptr<Action> prepareNextAction (const MWWorld::Ptr& actor, const MWWorld::Ptr& enemy);
     float getBestActionRating(const MWWorld::Ptr &actor, const MWWorld::Ptr &enemy);
 
@@ -12,6 +12,7 @@
 #include "../mwworld/action.hpp"
 #include "../mwworld/class.hpp"
 #include "../mwworld/cellstore.hpp"
+#include "../mwworld/esmstore.hpp"
 #include "../mwworld/inventorystore.hpp"
 
 #include "pathgrid.hpp"
@@ -27,6 +28,8 @@ MWMechanics::AiPackage::~AiPackage() {}
 
 MWMechanics::AiPackage::AiPackage() : 
     mTimer(AI_REACTION_TIME + 1.0f), // to force initial pathbuild
+    mMayDecide(true),
+    mDecided(false),
     mTargetActorRefId(""),
     mTargetActorId(-1),
     mRotateOnTheRunChecks(0),
@@ -96,6 +99,17 @@ void MWMechanics::AiPackage::reset()
     mObstacleCheck.clear();
 }
 
+void MWMechanics::AiPackage::setMayDecide(bool mayDecide)
+{
+    mMayDecide = mayDecide;
+    mDecided = false;
+}
+
+bool MWMechanics::AiPackage::hasDecided() const
+{
+    return mDecided;
+}
+
 bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgrid::Point& dest, float duration, float destTolerance)
 {
     mTimer += duration; //Update timer
@@ -118,8 +132,10 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const ESM::Pathgr
     float distToTarget = distance(start, dest);
     bool isDestReached = (distToTarget <= destTolerance);
 
-    if (!isDestReached && mTimer > AI_REACTION_TIME)
+    if (!isDestReached && mTimer > AI_REACTION_TIME && mMayDecide)
     {
+        mDecided = true;
+
         if (actor.getClass().isBipedal(actor))
             openDoors(actor);
 
@@ -261,7 +277,8 @@ const MWMechanics::PathgridGraph& MWMechanics::AiPackage::getPathGridGraph(const
     CacheMap::iterator found = cache.find(id);
     if (found == cache.end())
     {
-        cache.insert(std::make_pair(id, std::unique_ptr<MWMechanics::PathgridGraph>(new MWMechanics::PathgridGraph(cell))));
+        const ESM::Pathgrid* pathgrid = MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell());
+        cache.insert(std::make_pair(id, std::unique_ptr<MWMechanics::PathgridGraph>(new MWMechanics::PathgridGraph(pathgrid))));
     }
     return *cache[id].get();
 }
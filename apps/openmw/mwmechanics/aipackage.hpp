@@ -102,6 +102,13 @@ namespace MWMechanics
             /// Reset pathfinding state
             void reset();
 
+            /// Set whether the next execute() may make expensive decisions, see AiScheduler. Packages that may not
+            /// keep going by their last decisions and make them once they may again.
+            void setMayDecide(bool mayDecide);
+
+            /// Did the last execute() make decisions? Packages only do when they may and their reaction time is up.
+            bool hasDecided() const;
+
             bool isTargetMagicallyHidden(const MWWorld::Ptr& target);
 
             /// Return if actor's rotation speed is sufficient to rotate to the destination pathpoint on the run. Otherwise actor should rotate while standing.
@@ -134,6 +141,9 @@ namespace MWMechanics
 
             float mTimer;
 
+            bool mMayDecide;
+            bool mDecided;
+
             std::string mTargetActorRefId;
             mutable int mTargetActorId;
 
@@ -0,0 +1,146 @@
+#include "aischeduler.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // The longest an actor is kept from deciding, however much over the budget that goes
+    const float sMaxWait = 1.f;
+
+    // How quickly the running averages of the costs follow changes
+    const float sCostSmoothing = 0.2f;
+
+    // Actors this far from the player are half as important as the nearest ones
+    const float sHalfPriorityDistance = 2048.f;
+
+    const float sCombatPriority = 4.f;
+
+    // Averages start out negative, until there is something to average
+    void updateAverage(float& average, float value)
+    {
+        if (average < 0)
+            average = value;
+        else
+            average += (value - average) * sCostSmoothing;
+    }
+
+    float getAverage(float average)
+    {
+        return std::max(0.f, average);
+    }
+}
+
+namespace MWMechanics
+{
+
+    AiSchedule::AiSchedule()
+        : mWaited(sMaxWait)
+        , mDecisionCost(-1)
+        , mSteeringCost(-1)
+        , mMayDecide(true)
+    {
+    }
+
+    AiScheduler::Stats::Stats()
+        : mActors(0)
+        , mDecisions(0)
+        , mTime(0)
+        , mOverrun(0)
+        , mFrames(0)
+        , mOverrunFrames(0)
+    {
+    }
+
+    AiScheduler::AiScheduler(float budget)
+        : mBudget(budget)
+        , mDuration(0)
+    {
+    }
+
+    float AiScheduler::getPriority(float distance, bool inCombat)
+    {
+        const float priority = sHalfPriorityDistance / (sHalfPriorityDistance + distance);
+        return inCombat ? priority * sCombatPriority : priority;
+    }
+
+    void AiScheduler::beginFrame(float duration)
+    {
+        mDuration = duration;
+        mCandidates.clear();
+        mStats.mActors = 0;
+        mStats.mDecisions = 0;
+        mStats.mTime = 0;
+        mStats.mOverrun = 0;
+    }
+
+    void AiScheduler::addActor(AiSchedule& schedule, float priority)
+    {
+        schedule.mWaited += mDuration;
+
+        Candidate candidate;
+        candidate.mSchedule = &schedule;
+        candidate.mUrgency = schedule.mWaited * priority;
+        mCandidates.push_back(candidate);
+    }
+
+    void AiScheduler::schedule()
+    {
+        mStats.mActors = mCandidates.size();
+
+        if (mBudget <= 0)
+        {
+            for (std::vector<Candidate>::iterator it = mCandidates.begin(); it != mCandidates.end(); ++it)
+                it->mSchedule->mMayDecide = true;
+            return;
+        }
+
+        std::sort(mCandidates.begin(), mCandidates.end(), [] (const Candidate& left, const Candidate& right)
+        {
+            return left.mUrgency > right.mUrgency;
+        });
+
+        // Every actor steers, what is left of the budget goes to decisions
+        float remaining = mBudget;
+        for (std::vector<Candidate>::const_iterator it = mCandidates.begin(); it != mCandidates.end(); ++it)
+            remaining -= getAverage(it->mSchedule->mSteeringCost);
+
+        for (std::vector<Candidate>::iterator it = mCandidates.begin(); it != mCandidates.end(); ++it)
+        {
+            AiSchedule& schedule = *it->mSchedule;
+            const float cost = std::max(0.f, getAverage(schedule.mDecisionCost) - getAverage(schedule.mSteeringCost));
+            schedule.mMayDecide = cost <= remaining || schedule.mWaited >= sMaxWait;
+            if (schedule.mMayDecide)
+                remaining -= cost;
+        }
+    }
+
+    void AiScheduler::reportTime(AiSchedule& schedule, float milliseconds, bool decided)
+    {
+        if (decided)
+        {
+            updateAverage(schedule.mDecisionCost, milliseconds);
+            schedule.mWaited = 0;
+            ++mStats.mDecisions;
+        }
+        else
+            updateAverage(schedule.mSteeringCost, milliseconds);
+
+        mStats.mTime += milliseconds;
+    }
+
+    void AiScheduler::endFrame()
+    {
+        ++mStats.mFrames;
+        if (mBudget > 0 && mStats.mTime > mBudget)
+        {
+            mStats.mOverrun = mStats.mTime - mBudget;
+            ++mStats.mOverrunFrames;
+        }
+    }
+
+    const AiScheduler::Stats& AiScheduler::getStats() const
+    {
+        return mStats;
+    }
+
+}
@@ -0,0 +1,86 @@
+#ifndef GAME_MWMECHANICS_AISCHEDULER_H
+#define GAME_MWMECHANICS_AISCHEDULER_H
+
+#include <vector>
+
+namespace MWMechanics
+{
+    /// @brief Scheduling state of the AI of one actor, kept in its Actor.
+    struct AiSchedule
+    {
+        AiSchedule();
+
+        /// Seconds since the AI of the actor last made decisions.
+        float mWaited;
+
+        /// Running averages of the milliseconds its AI takes in frames with and without decisions,
+        /// negative until measured.
+        float mDecisionCost;
+        float mSteeringCost;
+
+        /// Whether its AI may make decisions this frame, see AiScheduler::schedule.
+        bool mMayDecide;
+    };
+
+    /// @brief Spreads the expensive decisions of AI packages over frames, so that the AI of all actors takes
+    /// about a given time each frame.
+    /// @par Decisions are choosing combat targets and actions, wandering and building paths. AI packages still
+    /// steer every frame, along the last decisions they made. The actors that waited longest, weighted by
+    /// their priority, decide first. No actor waits longer than a second, whatever the budget.
+    class AiScheduler
+    {
+    public:
+        struct Stats
+        {
+            Stats();
+
+            // This frame
+            unsigned int mActors;
+            unsigned int mDecisions; // Actors whose AI made decisions
+            float mTime; // milliseconds
+            float mOverrun; // milliseconds over the budget
+
+            // Since the start
+            unsigned int mFrames;
+            unsigned int mOverrunFrames;
+        };
+
+        /// @param budget Milliseconds per frame for the AI of all actors, 0 for no limit.
+        explicit AiScheduler(float budget);
+
+        /// How much the decisions of an actor matter, higher for actors near the player or in combat.
+        static float getPriority(float distance, bool inCombat);
+
+        /// Start scheduling a frame that goes on for \a duration seconds.
+        void beginFrame(float duration);
+
+        /// Add an actor whose AI runs this frame.
+        void addActor(AiSchedule& schedule, float priority);
+
+        /// Decide which of the added actors may make decisions this frame, setting AiSchedule::mMayDecide.
+        void schedule();
+
+        /// Report how long the AI of an added actor took this frame.
+        /// @param decided Whether it made decisions, which only actors that may decide do, and only when their
+        /// reaction time is up. Otherwise the time counts as steering and the actor keeps waiting.
+        void reportTime(AiSchedule& schedule, float milliseconds, bool decided);
+
+        void endFrame();
+
+        const Stats& getStats() const;
+
+    private:
+        struct Candidate
+        {
+            AiSchedule* mSchedule;
+            float mUrgency;
+        };
+
+        float mBudget;
+        float mDuration;
+        std::vector<Candidate> mCandidates;
+        Stats mStats;
+    };
+}
+
+#endif
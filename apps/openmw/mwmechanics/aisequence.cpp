@@ -178,29 +178,41 @@ bool AiSequence::isPackageDone() const
     return mDone;
 }
 
+CombatActionCache& AiSequence::getCombatActionCache()
+{
+    if (!mCombatActionCache)
+        mCombatActionCache.reset(new CombatActionCache);
+    return *mCombatActionCache;
+}
+
 bool isActualAiPackage(int packageTypeId)
 {
     return (packageTypeId >= AiPackage::TypeIdWander &&
             packageTypeId <= AiPackage::TypeIdActivate);
 }
 
-void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& characterController, float duration)
+bool AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& characterController, float duration, bool mayDecide)
 {
+    bool decided = false;
     if(actor != getPlayer())
     {
         if (mPackages.empty())
         {
             mLastAiPackage = -1;
-            return;
+            return false;
         }
 
+        if (mCombatActionCache)
+            mCombatActionCache->advance(duration);
+
         MWMechanics::AiPackage* package = mPackages.front();
         int packageTypeId = package->getTypeId();
         // workaround ai packages not being handled as in the vanilla engine
         if (isActualAiPackage(packageTypeId))
             mLastAiPackage = packageTypeId;
         // if active package is combat one, choose nearest target
-        if (packageTypeId == AiPackage::TypeIdCombat)
+        // rating the targets goes through all spells and items of the actor, so keep the current one in between decisions
+        if (packageTypeId == AiPackage::TypeIdCombat && mayDecide)
         {
             std::list<AiPackage *>::iterator itActualCombat;
 
@@ -223,7 +235,13 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
                 }
                 else
                 {
-                    float rating = MWMechanics::getBestActionRating(actor, target);
+                    float rating;
+                    if (!getCombatActionCache().getRating(target, rating))
+                    {
+                        rating = MWMechanics::getBestActionRating(actor, target);
+                        getCombatActionCache().setRating(target, rating);
+                        decided = true;
+                    }
 
                     const ESM::Position &targetPos = target.getRefData().getPosition();
 
@@ -258,7 +276,10 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
 
         try
         {
-            if (package->execute (actor, characterController, mAiState, duration))
+            package->setMayDecide(mayDecide);
+            const bool finished = package->execute (actor, characterController, mAiState, duration);
+            decided = decided || package->hasDecided();
+            if (finished)
             {
                 // Put repeating noncombat AI packages on the end of the stack so they can be used again
                 if (isActualAiPackage(packageTypeId) && (mRepeat || package->getRepeat()))
@@ -285,6 +306,7 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
             std::cerr << "Error during AiSequence::execute: " << e.what() << std::endl;
         }
     }
+    return decided;
 }
 
 void AiSequence::clear()
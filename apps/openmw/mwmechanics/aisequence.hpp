@@ -2,6 +2,7 @@
 #define GAME_MWMECHANICS_AISEQUENCE_H
 
 #include <list>
+#include <memory>
 
 #include "aistate.hpp"
 
@@ -26,6 +27,7 @@ namespace MWMechanics
 {
     class AiPackage;
     class CharacterController;
+    class CombatActionCache;
     
     template< class Base > class DerivedClassStorage;
     struct AiTemporaryBase;
@@ -51,6 +53,9 @@ namespace MWMechanics
             int mLastAiPackage;
             AiState mAiState;
 
+            /// Created on first use, so that only actors that ever fought carry one. Not copied.
+            std::unique_ptr<CombatActionCache> mCombatActionCache;
+
         public:
             ///Default constructor
             AiSequence();
@@ -107,7 +112,11 @@ namespace MWMechanics
             void stopPursuit();
 
             /// Execute current package, switching if needed.
-            void execute (const MWWorld::Ptr& actor, CharacterController& characterController, float duration);
+            /// @param mayDecide Whether to choose between combat targets and let the package make decisions, see AiScheduler.
+            /// @return Whether any decisions were made, rather than only steering along the last ones.
+            bool execute (const MWWorld::Ptr& actor, CharacterController& characterController, float duration, bool mayDecide = true);
+
+            CombatActionCache& getCombatActionCache();
 
             /// Simulate the passing of time using the currently active AI package
             void fastForward(const MWWorld::Ptr &actor);
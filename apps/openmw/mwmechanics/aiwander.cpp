@@ -169,9 +169,10 @@ namespace MWMechanics
 
         float& lastReaction = storage.mReaction;
         lastReaction += duration;
-        if (AI_REACTION_TIME <= lastReaction)
+        if (AI_REACTION_TIME <= lastReaction && mMayDecide)
         {
             lastReaction = 0;
+            mDecided = true;
             return reactionTimeActions(actor, storage, currentCell, cellChange, pos, duration);
         }
         else
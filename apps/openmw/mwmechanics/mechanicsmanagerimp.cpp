@@ -291,6 +291,12 @@ namespace MWMechanics
             mObjects.updateObject(old, ptr);
     }
 
+    void MechanicsManager::updatePosition(const MWWorld::Ptr &ptr)
+    {
+        if(ptr.getClass().isActor())
+            mActors.updatePosition(ptr);
+    }
+
 
     void MechanicsManager::drop(const MWWorld::CellStore *cellStore)
     {
@@ -862,6 +868,11 @@ namespace MWMechanics
         return mAI;
     }
 
+    void MechanicsManager::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        mActors.reportStats(frameNumber, stats);
+    }
+
     void MechanicsManager::playerLoaded()
     {
         mUpdatePlayer = true;
@@ -61,6 +61,9 @@ namespace MWMechanics
             virtual void updateCell(const MWWorld::Ptr &old, const MWWorld::Ptr &ptr);
             ///< Moves an object to a new cell
 
+            virtual void updatePosition(const MWWorld::Ptr &ptr);
+            ///< An object was moved within the scene
+
             virtual void drop(const MWWorld::CellStore *cellStore);
             ///< Deregister all objects in the given cell.
 
@@ -186,6 +189,8 @@ namespace MWMechanics
             virtual bool toggleAI();
             virtual bool isAIActive();
 
+            virtual void reportStats (unsigned int frameNumber, osg::Stats* stats) const;
+
             virtual void playerLoaded();
 
             virtual int countSavedGameRecords() const;
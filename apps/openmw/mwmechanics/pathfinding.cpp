@@ -1,6 +1,7 @@
 #include "pathfinding.hpp"
 
 #include <limits>
+#include <vector>
 
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
@@ -141,7 +142,8 @@ namespace MWMechanics
      *
      * NOTE: startPoint & endPoint are in world coordinates
      *
-     * Updates mPath using aStarSearch() or ray test (if shortcut allowed).
+     * Updates mPath using the navigation grid of the cell once it is built,
+     * otherwise using aStarSearch() or ray test (if shortcut allowed).
      * mPath consists of pathgrid points, except the last element which is
      * endPoint.  This may be useful where the endPoint is not on a pathgrid
      * point (e.g. combat).  However, if the caller has already chosen a
@@ -180,6 +182,17 @@ namespace MWMechanics
             mPathgrid = pathgridGraph.getPathgrid();
         }
 
+        // Walk over the navigation grid of the cell once it is built. It knows about every wall and ledge,
+        // rather than only the places the pathgrid was laid out for.
+        std::vector<osg::Vec3f> navigationPath;
+        if (MWBase::Environment::get().getWorld()->findNavigationPath(cell, MakeOsgVec3(startPoint), MakeOsgVec3(endPoint), navigationPath))
+        {
+            for (std::vector<osg::Vec3f>::const_iterator it = navigationPath.begin(); it != navigationPath.end(); ++it)
+                mPath.push_back(MakePathgridPoint(*it));
+            mPath.push_back(endPoint);
+            return;
+        }
+
         // Refer to AiWander reseach topic on openmw forums for some background.
         // Maybe there is no pathgrid for this cell.  Just go to destination and let
         // physics take care of any blockages.
@@ -1,13 +1,24 @@
 #include "pathgrid.hpp"
 
-#include "../mwbase/world.hpp"
-#include "../mwbase/environment.hpp"
-
-#include "../mwworld/cellstore.hpp"
-#include "../mwworld/esmstore.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
 
 namespace
 {
+    // Pathgrids with at most this many points keep the next point of every shortest path,
+    // which is 16 KiB for the largest of them. Most interiors have far fewer points.
+    const int sMaxNextPointsSize = 128;
+    const unsigned char sNoNextPoint = 0xff;
+
+    // How many paths large pathgrids remember, enough for the actors of a cell going back and forth
+    const size_t sPathCacheSize = 16;
+
+    typedef std::pair<float, int> QueueEntry; // first is cost, second is point index
+    typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > Queue;
+
     // See https://theory.stanford.edu/~amitp/GameProgramming/Heuristics.html
     //
     // One of the smallest cost in Seyda Neen is between points 77 & 78:
@@ -49,25 +60,14 @@ namespace
 
 namespace MWMechanics
 {
-    PathgridGraph::PathgridGraph(const MWWorld::CellStore *cell)
-        : mCell(NULL)
-        , mPathgrid(NULL)
-        , mIsExterior(0)
-        , mGraph(0)
-        , mIsGraphConstructed(false)
-        , mSCCId(0)
-        , mSCCIndex(0)
-    {
-        load(cell);
-    }
-
     /*
-     * mGraph is populated with the cost of each allowed edge.
+     * The edges of each point are stored one after another in mEdges, along
+     * with the cost of each allowed edge.
      *
      * The data structure is based on the code in buildPath2() but modified.
      * Please check git history if interested.
      *
-     * mGraph[v].edges[i].index = w
+     * mEdges[mEdgeBegin[v] + i].index = w
      *
      *   v = point index of location "from"
      *   i = index of edges from point v
@@ -76,14 +76,14 @@ namespace MWMechanics
      *
      * Example: (notice from p(0) to p(2) is not allowed in this example)
      *
-     *   mGraph[0].edges[0].index = 1
-     *            .edges[1].index = 3
+     *   mEdgeBegin = 0, 2, 5, 6, ...
      *
-     *   mGraph[1].edges[0].index = 0
-     *            .edges[1].index = 2
-     *            .edges[2].index = 3
-     *
-     *   mGraph[2].edges[0].index = 1
+     *   mEdges[0].index = 1   (p(0))
+     *   mEdges[1].index = 3
+     *   mEdges[2].index = 0   (p(1))
+     *   mEdges[3].index = 2
+     *   mEdges[4].index = 3
+     *   mEdges[5].index = 1   (p(2))
      *
      *   (etc, etc)
      *
@@ -97,38 +97,37 @@ namespace MWMechanics
      *    +---------------->
      *      high cost
      */
-    bool PathgridGraph::load(const MWWorld::CellStore *cell)
+    PathgridGraph::PathgridGraph(const ESM::Pathgrid* pathgrid)
+        : mPathgrid(pathgrid)
+        , mPathCacheClock(0)
+        , mSCCId(0)
+        , mSCCIndex(0)
     {
-        if(!cell)
-            return false;
-
-        if(mIsGraphConstructed)
-            return true;
-
-        mCell = cell->getCell();
-        mIsExterior = cell->getCell()->isExterior();
-        mPathgrid = MWBase::Environment::get().getWorld()->getStore().get<ESM::Pathgrid>().search(*cell->getCell());
         if(!mPathgrid)
-            return false;
+            return;
 
+        const int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+        mEdgeBegin.assign(pointsSize + 1, 0);
+        for(int i = 0; i < static_cast<int> (mPathgrid->mEdges.size()); i++)
+            mEdgeBegin[mPathgrid->mEdges[i].mV0 + 1]++;
+        for(int v = 0; v < pointsSize; v++)
+            mEdgeBegin[v + 1] += mEdgeBegin[v];
 
-        mGraph.resize(mPathgrid->mPoints.size());
+        mEdges.resize(mPathgrid->mEdges.size());
+        std::vector<int> edgeEnd (mEdgeBegin.begin(), mEdgeBegin.end() - 1);
         for(int i = 0; i < static_cast<int> (mPathgrid->mEdges.size()); i++)
         {
-            ConnectedPoint neighbour;
-            neighbour.cost = costAStar(mPathgrid->mPoints[mPathgrid->mEdges[i].mV0],
-                                       mPathgrid->mPoints[mPathgrid->mEdges[i].mV1]);
+            const ESM::Pathgrid::Edge& edge = mPathgrid->mEdges[i];
+            ConnectedPoint& neighbour = mEdges[edgeEnd[edge.mV0]++];
+            neighbour.cost = costAStar(mPathgrid->mPoints[edge.mV0], mPathgrid->mPoints[edge.mV1]);
             // forward path of the edge
-            neighbour.index = mPathgrid->mEdges[i].mV1;
-            mGraph[mPathgrid->mEdges[i].mV0].edges.push_back(neighbour);
-            // reverse path of the edge
-            // NOTE: These are redundant, ESM already contains the required reverse paths
-            //neighbour.index = mPathgrid->mEdges[i].mV0;
-            //mGraph[mPathgrid->mEdges[i].mV1].edges.push_back(neighbour);
+            // NOTE: The reverse paths are not added, ESM already contains them
+            neighbour.index = edge.mV1;
         }
+
         buildConnectedPoints();
-        mIsGraphConstructed = true;
-        return true;
+        if(pointsSize <= sMaxNextPointsSize)
+            buildNextPoints();
     }
 
     const ESM::Pathgrid *PathgridGraph::getPathgrid() const
@@ -143,11 +142,12 @@ namespace MWMechanics
         mSCCPoint[v].second = mSCCIndex; // lowlink
         mSCCIndex++;
         mSCCStack.push_back(v);
+        mSCCOnStack[v] = true;
         int w;
 
-        for(int i = 0; i < static_cast<int> (mGraph[v].edges.size()); i++)
+        for(int i = mEdgeBegin[v]; i < mEdgeBegin[v + 1]; i++)
         {
-            w = mGraph[v].edges[i].index;
+            w = mEdges[i].index;
             if(mSCCPoint[w].first == -1) // not visited
             {
                 recursiveStrongConnect(w); // recurse
@@ -156,7 +156,7 @@ namespace MWMechanics
             }
             else
             {
-                if(find(mSCCStack.begin(), mSCCStack.end(), w) != mSCCStack.end())
+                if(mSCCOnStack[w])
                     mSCCPoint[v].second = std::min(mSCCPoint[v].second,
                                                    mSCCPoint[w].first);
             }
@@ -168,7 +168,8 @@ namespace MWMechanics
             {
                 w = mSCCStack.back();
                 mSCCStack.pop_back();
-                mGraph[w].componentId = mSCCId;
+                mSCCOnStack[w] = false;
+                mComponentIds[w] = mSCCId;
             }
             while(w != v);
             mSCCId++;
@@ -177,26 +178,26 @@ namespace MWMechanics
     }
 
     /*
-     * mGraph contains the strongly connected component group id's along
-     * with pre-calculated edge costs.
+     * mComponentIds contains the strongly connected component group id's
+     * of the pathgrid points.
      *
      * A cell can have disjointed pathgrids, e.g. Seyda Neen has 3
      *
-     * mGraph for Seyda Neen will therefore have 3 different values.  When
-     * selecting a random pathgrid point for AiWander, mGraph can be checked
-     * for quickly finding whether the destination is reachable.
+     * mComponentIds for Seyda Neen will therefore have 3 different values.
+     * When selecting a random pathgrid point for AiWander, mComponentIds can
+     * be checked for quickly finding whether the destination is reachable.
      *
      * Otherwise, buildPath can automatically select a closest reachable end
      * pathgrid point (reachable from the closest start point).
      *
      * Using Tarjan's algorithm:
      *
-     *  mGraph                   | graph G   |
+     *  mEdges                   | graph G   |
      *  mSCCPoint                | V         | derived from mPoints
-     *  mGraph[v].edges          | E (for v) |
+     *  mEdges of v              | E (for v) |
      *  mSCCIndex                | index     | tracking smallest unused index
      *  mSCCStack                | S         |
-     *  mGraph[v].edges[i].index | w         |
+     *  mEdges[i].index          | w         |
      *
      */
     void PathgridGraph::buildConnectedPoints()
@@ -205,7 +206,9 @@ namespace MWMechanics
         //mSCCId = 0; // how many strongly connected components in this cell
         //mSCCIndex = 0;
         int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+        mComponentIds.resize(pointsSize, -1);
         mSCCPoint.resize(pointsSize, std::pair<int, int> (-1, -1));
+        mSCCOnStack.resize(pointsSize, false);
         mSCCStack.reserve(pointsSize);
 
         for(int v = 0; v < pointsSize; v++)
@@ -215,113 +218,206 @@ namespace MWMechanics
         }
     }
 
+    /*
+     * Finds the shortest paths from every point to every other point, so that
+     * searches on small pathgrids only have to follow them.
+     *
+     * Runs Dijkstra's algorithm from each goal along the reversed edges. The
+     * point a point is reached from is the next point on its way to the goal,
+     * and is always settled before it, so following mNextPoints from any point
+     * ends up at the goal.
+     *
+     * The edge costs are the same manhattan distances aStarSearch() uses as
+     * its heuristic, so the paths cost as much as the ones it finds.
+     */
+    void PathgridGraph::buildNextPoints()
+    {
+        const int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+
+        // the reversed edges, in the same layout as mEdges
+        std::vector<int> reverseBegin (pointsSize + 1, 0);
+        for(int i = 0; i < static_cast<int> (mEdges.size()); i++)
+            reverseBegin[mEdges[i].index + 1]++;
+        for(int v = 0; v < pointsSize; v++)
+            reverseBegin[v + 1] += reverseBegin[v];
+
+        std::vector<ConnectedPoint> reverseEdges (mEdges.size());
+        std::vector<int> reverseEnd (reverseBegin.begin(), reverseBegin.end() - 1);
+        for(int v = 0; v < pointsSize; v++)
+        {
+            for(int i = mEdgeBegin[v]; i < mEdgeBegin[v + 1]; i++)
+            {
+                ConnectedPoint& reverse = reverseEdges[reverseEnd[mEdges[i].index]++];
+                reverse.index = v;
+                reverse.cost = mEdges[i].cost;
+            }
+        }
+
+        mNextPoints.assign(static_cast<size_t>(pointsSize) * pointsSize, sNoNextPoint);
+        std::vector<float> cost (pointsSize);
+        for(int goal = 0; goal < pointsSize; goal++)
+        {
+            unsigned char* nextPoints = &mNextPoints[static_cast<size_t>(goal) * pointsSize];
+            std::fill(cost.begin(), cost.end(), std::numeric_limits<float>::max());
+            cost[goal] = 0;
+
+            Queue queue;
+            queue.push(QueueEntry(0, goal));
+            while(!queue.empty())
+            {
+                const QueueEntry current = queue.top();
+                queue.pop();
+                if(current.first > cost[current.second])
+                    continue; // already settled for less
+
+                for(int i = reverseBegin[current.second]; i < reverseBegin[current.second + 1]; i++)
+                {
+                    const int from = reverseEdges[i].index;
+                    const float tentative = current.first + reverseEdges[i].cost;
+                    if(tentative < cost[from])
+                    {
+                        cost[from] = tentative;
+                        nextPoints[from] = static_cast<unsigned char>(current.second);
+                        queue.push(QueueEntry(tentative, from));
+                    }
+                }
+            }
+        }
+    }
+
     bool PathgridGraph::isPointConnected(const int start, const int end) const
     {
-        return (mGraph[start].componentId == mGraph[end].componentId);
+        return (mComponentIds[start] == mComponentIds[end]);
     }
 
     void PathgridGraph::getNeighbouringPoints(const int index, ESM::Pathgrid::PointList &nodes) const
     {
-        for(int i = 0; i < static_cast<int> (mGraph[index].edges.size()); i++)
+        for(int i = mEdgeBegin[index]; i < mEdgeBegin[index + 1]; i++)
         {
-            int neighbourIndex = mGraph[index].edges[i].index;
+            int neighbourIndex = mEdges[i].index;
             if (neighbourIndex != index)
                 nodes.push_back(mPathgrid->mPoints[neighbourIndex]);
         }
     }
 
     /*
-     * NOTE: Based on buildPath2(), please check git history if interested
-     *       Should consider using a 3rd party library version (e.g. boost)
-     *
-     * Find the shortest path to the target goal using a well known algorithm.
-     * Uses mGraph which has pre-computed costs for allowed edges.  It is assumed
-     * that mGraph is already constructed.
-     *
-     * Should be possible to make this MT safe.
-     *
      * Returns path which may be empty.  path contains pathgrid points in local
      * cell coordinates (indoors) or world coordinates (external).
      *
+     * Small pathgrids look the path up in mNextPoints. Large ones search for
+     * it, and remember the last few paths found, since actors of a cell tend
+     * to walk between the same points again and again.
+     *
      * Input params:
      *   start, goal - pathgrid point indexes (for this cell)
-     *
-     * Variables:
-     *   openset - point indexes to be traversed, lowest cost at the front
-     *   closedset - point indexes already traversed
-     *   gScore - past accumulated costs vector indexed by point index
-     *   fScore - future estimated costs vector indexed by point index
-     *
-     * TODO: An intersting exercise might be to cache the paths created for a
-     *       start/goal pair.  To cache the results the paths need to be in
-     *       pathgrid points form (currently they are converted to world
-     *       coordinates).  Essentially trading speed w/ memory.
      */
     std::list<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start,
                                                                const int goal) const
     {
-        std::list<ESM::Pathgrid::Point> path;
         if(!isPointConnected(start, goal))
         {
-            return path; // there is no path, return an empty path
+            return std::list<ESM::Pathgrid::Point>(); // there is no path, return an empty path
+        }
+
+        if(!mNextPoints.empty())
+            return followNextPoints(start, goal);
+
+        CachedPath* leastRecentlyUsed = NULL;
+        for(std::vector<CachedPath>::iterator it = mPathCache.begin(); it != mPathCache.end(); ++it)
+        {
+            if(it->mStart == start && it->mEnd == goal)
+            {
+                it->mLastUsed = ++mPathCacheClock;
+                return it->mPath;
+            }
+            if(!leastRecentlyUsed || it->mLastUsed < leastRecentlyUsed->mLastUsed)
+                leastRecentlyUsed = &*it;
         }
 
-        int graphSize = static_cast<int> (mGraph.size());
-        std::vector<float> gScore (graphSize, -1);
-        std::vector<float> fScore (graphSize, -1);
+        if(mPathCache.size() < sPathCacheSize)
+        {
+            mPathCache.push_back(CachedPath());
+            leastRecentlyUsed = &mPathCache.back();
+        }
+
+        leastRecentlyUsed->mStart = start;
+        leastRecentlyUsed->mEnd = goal;
+        leastRecentlyUsed->mLastUsed = ++mPathCacheClock;
+        leastRecentlyUsed->mPath = searchPath(start, goal);
+        return leastRecentlyUsed->mPath;
+    }
+
+    std::list<ESM::Pathgrid::Point> PathgridGraph::followNextPoints(int start, int goal) const
+    {
+        std::list<ESM::Pathgrid::Point> path;
+        const unsigned char* nextPoints = &mNextPoints[static_cast<size_t>(goal) * mPathgrid->mPoints.size()];
+
+        path.push_back(mPathgrid->mPoints[start]);
+        for(int current = start; current != goal; current = nextPoints[current])
+        {
+            if(nextPoints[current] == sNoNextPoint)
+                return std::list<ESM::Pathgrid::Point>();
+            path.push_back(mPathgrid->mPoints[nextPoints[current]]);
+        }
+        return path;
+    }
+
+    /*
+     * NOTE: Based on buildPath2(), please check git history if interested
+     *
+     * Find the shortest path to the target goal using a well known algorithm.
+     * Uses mEdges which has pre-computed costs for allowed edges.
+     *
+     * Variables:
+     *   openset - point indexes to be traversed, lowest estimated cost on top;
+     *             points are pushed again when a cheaper way to them is found
+     *             and the stale entries skipped when popped
+     *   closed - whether a point has been traversed already
+     *   gScore - past accumulated costs vector indexed by point index
+     */
+    std::list<ESM::Pathgrid::Point> PathgridGraph::searchPath(int start, int goal) const
+    {
+        std::list<ESM::Pathgrid::Point> path;
+
+        int graphSize = static_cast<int> (mPathgrid->mPoints.size());
+        std::vector<float> gScore (graphSize, std::numeric_limits<float>::max());
         std::vector<int> graphParent (graphSize, -1);
+        std::vector<bool> closed (graphSize, false);
 
-        // gScore & fScore keep costs for each pathgrid point in mPoints
         gScore[start] = 0;
-        fScore[start] = costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]);
 
-        std::list<int> openset;
-        std::list<int> closedset;
-        openset.push_back(start);
+        Queue openset;
+        openset.push(QueueEntry(costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]), start));
 
         int current = -1;
 
         while(!openset.empty())
         {
-            current = openset.front(); // front has the lowest cost
-            openset.pop_front();
+            current = openset.top().second; // top has the lowest cost
+            openset.pop();
 
             if(current == goal)
                 break;
 
-            closedset.push_back(current); // remember we've been here
+            if(closed[current])
+                continue;
+            closed[current] = true; // remember we've been here
 
             // check all edges for the current point index
-            for(int j = 0; j < static_cast<int> (mGraph[current].edges.size()); j++)
+            for(int j = mEdgeBegin[current]; j < mEdgeBegin[current + 1]; j++)
             {
-                if(std::find(closedset.begin(), closedset.end(), mGraph[current].edges[j].index) ==
-                   closedset.end())
+                int dest = mEdges[j].index;
+                if(closed[dest])
+                    continue; // traversed this edge destination already, try the next edge
+
+                float tentative_g = gScore[current] + mEdges[j].cost;
+                if(tentative_g < gScore[dest])
                 {
-                    // not in closedset - i.e. have not traversed this edge destination
-                    int dest = mGraph[current].edges[j].index;
-                    float tentative_g = gScore[current] + mGraph[current].edges[j].cost;
-                    bool isInOpenSet = std::find(openset.begin(), openset.end(), dest) != openset.end();
-                    if(!isInOpenSet
-                        || tentative_g < gScore[dest])
-                    {
-                        graphParent[dest] = current;
-                        gScore[dest] = tentative_g;
-                        fScore[dest] = tentative_g + costAStar(mPathgrid->mPoints[dest],
-                                                               mPathgrid->mPoints[goal]);
-                        if(!isInOpenSet)
-                        {
-                            // add this edge to openset, lowest cost goes to the front
-                            // TODO: if this causes performance problems a hash table may help
-                            std::list<int>::iterator it = openset.begin();
-                            for(it = openset.begin(); it!= openset.end(); ++it)
-                            {
-                                if(fScore[*it] > fScore[dest])
-                                    break;
-                            }
-                            openset.insert(it, dest);
-                        }
-                    }
-                } // if in closedset, i.e. traversed this edge already, try the next edge
+                    graphParent[dest] = current;
+                    gScore[dest] = tentative_g;
+                    openset.push(QueueEntry(tentative_g + costAStar(mPathgrid->mPoints[dest],
+                                                                    mPathgrid->mPoints[goal]), dest));
+                }
             }
         }
 
@@ -340,4 +436,3 @@ namespace MWMechanics
         return path;
     }
 }
-
@@ -2,27 +2,17 @@
 #define GAME_MWMECHANICS_PATHGRID_H
 
 #include <list>
+#include <vector>
 
 #include <components/esm/loadpgrd.hpp>
 
-namespace ESM
-{
-    struct Cell;
-}
-
-namespace MWWorld
-{
-    class CellStore;
-}
-
 namespace MWMechanics
 {
     class PathgridGraph
     {
         public:
-            PathgridGraph(const MWWorld::CellStore* cell);
-
-            bool load(const MWWorld::CellStore *cell);
+            /// @param pathgrid May be NULL, for cells without a pathgrid.
+            explicit PathgridGraph(const ESM::Pathgrid* pathgrid);
 
             const ESM::Pathgrid* getPathgrid() const;
 
@@ -37,14 +27,15 @@ namespace MWMechanics
             // the output list is in local (internal cells) or world (external
             // cells) coordinates
             //
-            // NOTE: if start equals end an empty path is returned
+            // NOTE: if start equals end the path only has the start point,
+            // if end is not reachable from start an empty path is returned
+            //
+            // NOTE: not thread safe, the paths of large pathgrids are cached
             std::list<ESM::Pathgrid::Point> aStarSearch(const int start,
                                                         const int end) const;
         private:
 
-            const ESM::Cell *mCell;
             const ESM::Pathgrid *mPathgrid;
-            bool mIsExterior;
 
             struct ConnectedPoint // edge
             {
@@ -52,11 +43,9 @@ namespace MWMechanics
                 float cost;
             };
 
-            struct Node // point
-            {
-                int componentId;
-                std::vector<ConnectedPoint> edges; // neighbours
-            };
+            // The edges of point v are mEdges[mEdgeBegin[v]] up to mEdges[mEdgeBegin[v + 1]]
+            std::vector<int> mEdgeBegin;
+            std::vector<ConnectedPoint> mEdges;
 
             // componentId is an integer indicating the groups of connected
             // pathgrid points (all connected points will have the same value)
@@ -67,18 +56,37 @@ namespace MWMechanics
             //   48, 49, 50, 51, 84, 85, 86, 87, 88, 89, 90 (ship & office)
             //   all other pathgrid points are the third set
             //
-            std::vector<Node> mGraph;
-            bool mIsGraphConstructed;
+            std::vector<int> mComponentIds;
+
+            // For small pathgrids, mNextPoints[goal * size + v] is the point
+            // after v on the shortest path from v to goal
+            std::vector<unsigned char> mNextPoints;
+
+            // Most recently found paths of large pathgrids
+            struct CachedPath
+            {
+                int mStart;
+                int mEnd;
+                unsigned int mLastUsed;
+                std::list<ESM::Pathgrid::Point> mPath;
+            };
+            mutable std::vector<CachedPath> mPathCache;
+            mutable unsigned int mPathCacheClock;
 
             // variables used to calculate connected components
             int mSCCId;
             int mSCCIndex;
             std::vector<int> mSCCStack;
+            std::vector<bool> mSCCOnStack;
             typedef std::pair<int, int> VPair; // first is index, second is lowlink
             std::vector<VPair> mSCCPoint;
             // methods used to calculate connected components
             void recursiveStrongConnect(int v);
             void buildConnectedPoints();
+
+            void buildNextPoints();
+            std::list<ESM::Pathgrid::Point> followNextPoints(int start, int goal) const;
+            std::list<ESM::Pathgrid::Point> searchPath(int start, int goal) const;
     };
 }
 
@@ -0,0 +1,38 @@
+#ifndef GAME_MWMECHANICS_REVISIONCHECK_H
+#define GAME_MWMECHANICS_REVISIONCHECK_H
+
+#include <cstddef>
+
+namespace MWMechanics
+{
+    /// @brief Remembers which list, and which revision of it, something was worked out from.
+    /// @par \a List is anything with an unsigned int getRevision() that changes whenever its contents do, such as
+    /// MWWorld::ContainerStore or Spells.
+    template <class List>
+    class RevisionCheck
+    {
+    public:
+        RevisionCheck()
+            : mList(NULL)
+            , mRevision(0)
+        {
+        }
+
+        /// @return whether \a list is another list than the last one, or changed since. Remembers it either way.
+        bool update(const List& list)
+        {
+            if (&list == mList && list.getRevision() == mRevision)
+                return false;
+
+            mList = &list;
+            mRevision = list.getRevision();
+            return true;
+        }
+
+    private:
+        const List* mList;
+        unsigned int mRevision;
+    };
+}
+
+#endif
@@ -107,11 +107,11 @@ namespace MWMechanics
     {
         const CreatureStats& stats = actor.getClass().getCreatureStats(actor);
 
-        float successChance = MWMechanics::getSpellSuccessChance(spell, actor);
-        if (successChance == 0.f)
+        if (spell->mData.mType != ESM::Spell::ST_Spell)
             return 0.f;
 
-        if (spell->mData.mType != ESM::Spell::ST_Spell)
+        float successChance = MWMechanics::getSpellSuccessChance(spell, actor);
+        if (successChance == 0.f)
             return 0.f;
 
         // Don't make use of racial bonus spells, like MW. Can be made optional later
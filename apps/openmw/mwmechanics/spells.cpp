@@ -17,6 +17,7 @@ namespace MWMechanics
 {
     Spells::Spells()
         : mSpellsChanged(false)
+        , mRevision(0)
     {
     }
 
@@ -30,6 +31,11 @@ namespace MWMechanics
         return mSpells.end();
     }
 
+    unsigned int Spells::getRevision() const
+    {
+        return mRevision;
+    }
+
     const ESM::Spell* Spells::getSpell(const std::string& id) const
     {
         return MWBase::Environment::get().getWorld()->getStore().get<ESM::Spell>().find(id);
@@ -113,6 +119,7 @@ namespace MWMechanics
             params.mEffectRands = random;
             mSpells.insert (std::make_pair (spell, params));
             mSpellsChanged = true;
+            ++mRevision;
         }
     }
 
@@ -123,7 +130,11 @@ namespace MWMechanics
 
     void Spells::remove (const std::string& spellId)
     {
-        const ESM::Spell* spell = getSpell(spellId);
+        remove(getSpell(spellId));
+    }
+
+    void Spells::remove (const ESM::Spell* spell)
+    {
         TContainer::iterator iter = mSpells.find (spell);
 
         std::map<SpellKey, CorprusStats>::iterator corprusIt = mCorprusSpells.find(spell);
@@ -151,9 +162,10 @@ namespace MWMechanics
         {
             mSpells.erase (iter);
             mSpellsChanged = true;
+            ++mRevision;
         }
 
-        if (spellId==mSelectedSpell)
+        if (Misc::StringUtils::ciEqual(spell->mId, mSelectedSpell))
             mSelectedSpell.clear();
     }
 
@@ -170,6 +182,7 @@ namespace MWMechanics
     {
         mSpells.clear();
         mSpellsChanged = true;
+        ++mRevision;
     }
 
     void Spells::setSelectedSpell (const std::string& spellId)
@@ -228,6 +241,7 @@ namespace MWMechanics
             {
                 mSpells.erase(iter++);
                 mSpellsChanged = true;
+                ++mRevision;
             }
             else
                 ++iter;
@@ -243,6 +257,7 @@ namespace MWMechanics
             {
                 mSpells.erase(iter++);
                 mSpellsChanged = true;
+                ++mRevision;
             }
             else
                 ++iter;
@@ -258,6 +273,7 @@ namespace MWMechanics
             {
                 mSpells.erase(iter++);
                 mSpellsChanged = true;
+                ++mRevision;
             }
             else
                 ++iter;
@@ -273,6 +289,7 @@ namespace MWMechanics
             {
                 mSpells.erase(iter++);
                 mSpellsChanged = true;
+                ++mRevision;
             }
             else
                 ++iter;
@@ -319,6 +336,7 @@ namespace MWMechanics
                 magnitude *= std::max(1, mCorprusSpells[spell].mWorsenings);
                 mPermanentSpellEffects[spell].add(MWMechanics::EffectKey(*effectIt), MWMechanics::EffectParam(magnitude));
                 mSpellsChanged = true;
+                ++mRevision;
             }
         }
     }
@@ -351,6 +369,7 @@ namespace MWMechanics
                 {
                     spellIt->second.mPurgedEffects.insert(i);
                     mSpellsChanged = true;
+                    ++mRevision;
                 }
                 ++i;
             }
@@ -371,6 +390,7 @@ namespace MWMechanics
             {
                 spellIt->second.mPurgedEffects.insert(i);
                 mSpellsChanged = true;
+                ++mRevision;
             }
             ++i;
         }
@@ -439,6 +459,7 @@ namespace MWMechanics
         }
 
         mSpellsChanged = true;
+        ++mRevision;
     }
 
     void Spells::writeState(ESM::SpellState &state) const
@@ -63,6 +63,7 @@ namespace MWMechanics
             std::map<SpellKey, CorprusStats> mCorprusSpells;
 
             mutable bool mSpellsChanged;
+            unsigned int mRevision;
             mutable MagicEffects mEffects;
             mutable std::map<SpellKey, MagicEffects> mSourcedEffects;
             void rebuildEffects() const;
@@ -92,6 +93,9 @@ namespace MWMechanics
 
             TIterator end() const;
 
+            unsigned int getRevision() const;
+            ///< Changes whenever spells are added or removed, or their effects change.
+
             bool hasSpell(const std::string& spell) const;
             bool hasSpell(const ESM::Spell* spell) const;
 
@@ -105,6 +109,10 @@ namespace MWMechanics
             ///< If the spell to be removed is the selected spell, the selected spell will be changed to
             /// no spell (empty string).
 
+            void remove (const ESM::Spell* spell);
+            ///< If the spell to be removed is the selected spell, the selected spell will be changed to
+            /// no spell (empty string).
+
             MagicEffects getMagicEffects() const;
             ///< Return sum of magic effects resulting from abilities, blights, deseases and curses.
 
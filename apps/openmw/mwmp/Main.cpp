@@ -208,6 +208,8 @@ void Main::frame(float dt)
 
     get().getGUIController()->update(dt);
 
+    // Send the script variable changes made since the last frame
+    get().getNetworking()->getScriptStateSync()->send();
 }
 
 void Main::updateWorld(float dt) const
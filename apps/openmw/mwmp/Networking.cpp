@@ -260,6 +260,9 @@ void Networking::update()
 
     if (!errmsg.empty())
     {
+        // Whatever the server knew of our script variables is gone with the connection
+        scriptStateSync.clear();
+
         LOG_MESSAGE_SIMPLE(Log::LOG_ERROR, errmsg.c_str());
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "tes3mp", errmsg.c_str(), 0);
         MWBase::Environment::get().getStateManager()->requestQuit();
@@ -480,6 +483,11 @@ ObjectList *Networking::getObjectList()
     return &objectList;
 }
 
+ScriptStateSync *Networking::getScriptStateSync()
+{
+    return &scriptStateSync;
+}
+
 Worldstate *Networking::getWorldstate()
 {
     return &worldstate;
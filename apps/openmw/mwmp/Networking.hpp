@@ -16,6 +16,7 @@
 
 #include "ActorList.hpp"
 #include "ObjectList.hpp"
+#include "ScriptStateSync.hpp"
 #include "Worldstate.hpp"
 
 namespace mwmp
@@ -45,6 +46,7 @@ namespace mwmp
         LocalPlayer *getLocalPlayer();
         ActorList *getActorList();
         ObjectList *getObjectList();
+        ScriptStateSync *getScriptStateSync();
         Worldstate *getWorldstate();
 
     private:
@@ -60,6 +62,7 @@ namespace mwmp
 
         ActorList actorList;
         ObjectList objectList;
+        ScriptStateSync scriptStateSync;
         Worldstate worldstate;
 
         void receiveMessage(RakNet::Packet *packet);
@@ -748,6 +748,10 @@ void ObjectList::setLocalShorts(MWWorld::CellStore* cellStore)
                                ptrFound.getCellRef().getRefNum(), ptrFound.getCellRef().getMpNum());
 
             ptrFound.getRefData().getLocals().mShorts.at(baseObject.index) = baseObject.shortVal;
+
+            mwmp::BaseObject knownObject = baseObject;
+            knownObject.variableType = LOCAL_SHORT;
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->setKnownValue(knownObject, cell);
         }
     }
 }
@@ -767,6 +771,10 @@ void ObjectList::setLocalFloats(MWWorld::CellStore* cellStore)
                                ptrFound.getCellRef().getRefNum(), ptrFound.getCellRef().getMpNum());
 
             ptrFound.getRefData().getLocals().mFloats.at(baseObject.index) = baseObject.floatVal;
+
+            mwmp::BaseObject knownObject = baseObject;
+            knownObject.variableType = LOCAL_FLOAT;
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->setKnownValue(knownObject, cell);
         }
     }
 }
@@ -792,6 +800,10 @@ void ObjectList::setMemberShorts()
                 *MWBase::Environment::get().getWorld()->getStore().get<ESM::Script>().find(scriptId));
 
             ptrFound.getRefData().getLocals().mShorts.at(baseObject.index) = baseObject.shortVal;;
+
+            mwmp::BaseObject knownObject = baseObject;
+            knownObject.variableType = MEMBER_SHORT;
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->setKnownValue(knownObject, cell);
         }
     }
 }
@@ -803,6 +815,76 @@ void ObjectList::setGlobalShorts()
         LOG_APPEND(Log::LOG_VERBOSE, "- varName: %s, shortVal: %i", baseObject.varName.c_str(), baseObject.shortVal);
 
         MWBase::Environment::get().getWorld()->setGlobalInt(baseObject.varName, baseObject.shortVal);
+
+        mwmp::BaseObject knownObject = baseObject;
+        knownObject.variableType = GLOBAL_SHORT;
+        mwmp::Main::get().getNetworking()->getScriptStateSync()->setKnownValue(knownObject, cell);
+    }
+}
+
+void ObjectList::setScriptState(MWWorld::CellStore* cellStore)
+{
+    ScriptStateSync *scriptStateSync = mwmp::Main::get().getNetworking()->getScriptStateSync();
+
+    for (const auto &baseObject : baseObjects)
+    {
+        switch (baseObject.variableType)
+        {
+            case LOCAL_SHORT:
+            case LOCAL_FLOAT:
+            {
+                LOG_APPEND(Log::LOG_VERBOSE, "- cellRef: %s %i-%i, index: %i, shortVal: %i, floatVal: %f",
+                           baseObject.refId.c_str(), baseObject.refNum, baseObject.mpNum, baseObject.index,
+                           baseObject.shortVal, baseObject.floatVal);
+
+                if (!cellStore)
+                    continue;
+
+                MWWorld::Ptr ptrFound = cellStore->searchExact(baseObject.refNum, baseObject.mpNum);
+
+                if (!ptrFound)
+                    continue;
+
+                if (baseObject.variableType == LOCAL_SHORT)
+                    ptrFound.getRefData().getLocals().mShorts.at(baseObject.index) = baseObject.shortVal;
+                else
+                    ptrFound.getRefData().getLocals().mFloats.at(baseObject.index) = baseObject.floatVal;
+                break;
+            }
+            case MEMBER_SHORT:
+            case MEMBER_FLOAT:
+            {
+                LOG_APPEND(Log::LOG_VERBOSE, "- cellRef: %s, index: %i, shortVal: %i, floatVal: %f",
+                           baseObject.refId.c_str(), baseObject.index, baseObject.shortVal, baseObject.floatVal);
+
+                // Mimic the way a Ptr is fetched in InterpreterContext for similar situations
+                MWWorld::Ptr ptrFound = MWBase::Environment::get().getWorld()->searchPtr(baseObject.refId, false);
+
+                if (ptrFound.isEmpty())
+                    continue;
+
+                std::string scriptId = ptrFound.getClass().getScript(ptrFound);
+
+                ptrFound.getRefData().setLocals(
+                    *MWBase::Environment::get().getWorld()->getStore().get<ESM::Script>().find(scriptId));
+
+                if (baseObject.variableType == MEMBER_SHORT)
+                    ptrFound.getRefData().getLocals().mShorts.at(baseObject.index) = baseObject.shortVal;
+                else
+                    ptrFound.getRefData().getLocals().mFloats.at(baseObject.index) = baseObject.floatVal;
+                break;
+            }
+            case GLOBAL_SHORT:
+                LOG_APPEND(Log::LOG_VERBOSE, "- varName: %s, shortVal: %i", baseObject.varName.c_str(), baseObject.shortVal);
+                MWBase::Environment::get().getWorld()->setGlobalInt(baseObject.varName, baseObject.shortVal);
+                break;
+            case GLOBAL_FLOAT:
+                LOG_APPEND(Log::LOG_VERBOSE, "- varName: %s, floatVal: %f", baseObject.varName.c_str(), baseObject.floatVal);
+                MWBase::Environment::get().getWorld()->setGlobalFloat(baseObject.varName, baseObject.floatVal);
+                break;
+        }
+
+        scriptStateSync->setKnownValue(baseObject, cell);
     }
 }
 
@@ -1258,6 +1340,15 @@ void ObjectList::sendScriptGlobalShort()
     mwmp::Main::get().getNetworking()->getObjectPacket(ID_SCRIPT_GLOBAL_SHORT)->Send();
 }
 
+void ObjectList::sendScriptState()
+{
+    LOG_MESSAGE_SIMPLE(Log::LOG_VERBOSE, "Sending ID_SCRIPT_STATE with %i variables about %s", (int) baseObjects.size(),
+                       cell.getDescription().c_str());
+
+    mwmp::Main::get().getNetworking()->getObjectPacket(ID_SCRIPT_STATE)->setObjectList(this);
+    mwmp::Main::get().getNetworking()->getObjectPacket(ID_SCRIPT_STATE)->Send();
+}
+
 void ObjectList::sendContainer()
 {
     LOG_MESSAGE_SIMPLE(Log::LOG_VERBOSE, "Sending ID_CONTAINER");
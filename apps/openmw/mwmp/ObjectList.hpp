@@ -43,6 +43,7 @@ namespace mwmp
         void setLocalFloats(MWWorld::CellStore* cellStore);
         void setMemberShorts();
         void setGlobalShorts();
+        void setScriptState(MWWorld::CellStore* cellStore);
 
         void playMusic();
         void playVideo();
@@ -85,6 +86,7 @@ namespace mwmp
         void sendScriptLocalFloat();
         void sendScriptMemberShort();
         void sendScriptGlobalShort();
+        void sendScriptState();
         void sendContainer();
 
     private:
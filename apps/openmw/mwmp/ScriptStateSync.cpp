@@ -0,0 +1,175 @@
+#include "ScriptStateSync.hpp"
+
+#include <components/misc/stringops.hpp>
+#include <components/openmw-mp/Log.hpp>
+
+#include "../mwworld/cellstore.hpp"
+
+#include "Main.hpp"
+#include "Networking.hpp"
+#include "ObjectList.hpp"
+
+using namespace mwmp;
+
+void ScriptStateSync::addLocalShort(const MWWorld::Ptr& ptr, int index, int shortVal, unsigned char packetOrigin)
+{
+    BaseObject baseObject;
+    baseObject.variableType = BaseObjectList::LOCAL_SHORT;
+    baseObject.refId = ptr.getCellRef().getRefId();
+    baseObject.refNum = ptr.getCellRef().getRefNum().mIndex;
+    baseObject.mpNum = ptr.getCellRef().getMpNum();
+    baseObject.index = index;
+    baseObject.shortVal = shortVal;
+    addVariable(baseObject, *ptr.getCell()->getCell(), packetOrigin);
+}
+
+void ScriptStateSync::addLocalFloat(const MWWorld::Ptr& ptr, int index, float floatVal, unsigned char packetOrigin)
+{
+    BaseObject baseObject;
+    baseObject.variableType = BaseObjectList::LOCAL_FLOAT;
+    baseObject.refId = ptr.getCellRef().getRefId();
+    baseObject.refNum = ptr.getCellRef().getRefNum().mIndex;
+    baseObject.mpNum = ptr.getCellRef().getMpNum();
+    baseObject.index = index;
+    baseObject.floatVal = floatVal;
+    addVariable(baseObject, *ptr.getCell()->getCell(), packetOrigin);
+}
+
+void ScriptStateSync::addMemberShort(const std::string& refId, int index, int shortVal, unsigned char packetOrigin)
+{
+    BaseObject baseObject;
+    baseObject.variableType = BaseObjectList::MEMBER_SHORT;
+    baseObject.refId = refId;
+    baseObject.index = index;
+    baseObject.shortVal = shortVal;
+
+    ESM::Cell cell;
+    cell.blank();
+    addVariable(baseObject, cell, packetOrigin);
+}
+
+void ScriptStateSync::addGlobalShort(const std::string& varName, int shortVal, unsigned char packetOrigin)
+{
+    BaseObject baseObject;
+    baseObject.variableType = BaseObjectList::GLOBAL_SHORT;
+    baseObject.varName = varName;
+    baseObject.shortVal = shortVal;
+
+    ESM::Cell cell;
+    cell.blank();
+    addVariable(baseObject, cell, packetOrigin);
+}
+
+void ScriptStateSync::addVariable(const BaseObject& baseObject, const ESM::Cell& cell, unsigned char packetOrigin)
+{
+    Batch &batch = batches[std::make_pair(packetOrigin, cell.getDescription())];
+
+    if (batch.baseObjects.empty())
+    {
+        batch.cell = cell;
+        batch.packetOrigin = packetOrigin;
+    }
+
+    std::string key = getKey(baseObject, cell);
+    auto it = batch.indexes.find(key);
+
+    if (it != batch.indexes.end())
+        batch.baseObjects[it->second] = baseObject;
+    else
+    {
+        batch.indexes[key] = batch.baseObjects.size();
+        batch.baseObjects.push_back(baseObject);
+    }
+}
+
+void ScriptStateSync::setKnownValue(const BaseObject& baseObject, const ESM::Cell& cell)
+{
+    knownValues[getCellKey(baseObject, cell)][getKey(baseObject, cell)] = getValue(baseObject);
+}
+
+void ScriptStateSync::send()
+{
+    if (batches.empty())
+        return;
+
+    ObjectList *objectList = Main::get().getNetworking()->getObjectList();
+
+    for (auto &batchPair : batches)
+    {
+        Batch &batch = batchPair.second;
+
+        objectList->reset();
+        objectList->packetOrigin = batch.packetOrigin;
+        objectList->cell = batch.cell;
+
+        for (const auto &baseObject : batch.baseObjects)
+        {
+            std::string key = getKey(baseObject, batch.cell);
+            double value = getValue(baseObject);
+
+            std::map<std::string, double> &cellValues = knownValues[getCellKey(baseObject, batch.cell)];
+
+            auto known = cellValues.find(key);
+            if (known != cellValues.end() && known->second == value)
+                continue;
+
+            cellValues[key] = value;
+            objectList->addObject(baseObject);
+        }
+
+        if (!objectList->baseObjects.empty())
+            objectList->sendScriptState();
+    }
+
+    batches.clear();
+}
+
+void ScriptStateSync::clearCell(const ESM::Cell& cell)
+{
+    knownValues.erase(cell.getDescription());
+}
+
+void ScriptStateSync::clear()
+{
+    batches.clear();
+    knownValues.clear();
+}
+
+std::string ScriptStateSync::getKey(const BaseObject& baseObject, const ESM::Cell& cell)
+{
+    std::string key(1, (char) ('0' + baseObject.variableType));
+
+    switch (baseObject.variableType)
+    {
+        case BaseObjectList::LOCAL_SHORT:
+        case BaseObjectList::LOCAL_FLOAT:
+            key += cell.getDescription() + ':' + std::to_string(baseObject.refNum) + '-' +
+                std::to_string(baseObject.mpNum) + ':' + std::to_string(baseObject.index);
+            break;
+        case BaseObjectList::MEMBER_SHORT:
+        case BaseObjectList::MEMBER_FLOAT:
+            key += Misc::StringUtils::lowerCase(baseObject.refId) + ':' + std::to_string(baseObject.index);
+            break;
+        default:
+            key += Misc::StringUtils::lowerCase(baseObject.varName);
+    }
+
+    return key;
+}
+
+std::string ScriptStateSync::getCellKey(const BaseObject& baseObject, const ESM::Cell& cell)
+{
+    if (baseObject.variableType == BaseObjectList::LOCAL_SHORT || baseObject.variableType == BaseObjectList::LOCAL_FLOAT)
+        return cell.getDescription();
+
+    return std::string();
+}
+
+double ScriptStateSync::getValue(const BaseObject& baseObject)
+{
+    if (baseObject.variableType == BaseObjectList::LOCAL_FLOAT || baseObject.variableType == BaseObjectList::MEMBER_FLOAT ||
+        baseObject.variableType == BaseObjectList::GLOBAL_FLOAT)
+        return baseObject.floatVal;
+
+    return baseObject.shortVal;
+}
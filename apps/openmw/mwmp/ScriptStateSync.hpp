@@ -0,0 +1,60 @@
+#ifndef OPENMW_SCRIPTSTATESYNC_HPP
+#define OPENMW_SCRIPTSTATESYNC_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <components/openmw-mp/Base/BaseObject.hpp>
+#include "../mwworld/ptr.hpp"
+
+namespace mwmp
+{
+    /*
+     * Gathers the script variable changes made during a frame and sends them as one ID_SCRIPT_STATE
+     * packet per packet origin and cell, instead of one packet for every single change.
+     *
+     * Only the last value of a variable within a frame is sent, and nothing is sent for a variable
+     * that already has that value as far as the server knows, i.e. the value we last sent or received.
+     * What the server knows is forgotten for the local variables of a cell when it is unloaded, and for
+     * everything on disconnecting, starting a new game or loading.
+     */
+    class ScriptStateSync
+    {
+    public:
+        void addLocalShort(const MWWorld::Ptr& ptr, int index, int shortVal, unsigned char packetOrigin);
+        void addLocalFloat(const MWWorld::Ptr& ptr, int index, float floatVal, unsigned char packetOrigin);
+        void addMemberShort(const std::string& refId, int index, int shortVal, unsigned char packetOrigin);
+        void addGlobalShort(const std::string& varName, int shortVal, unsigned char packetOrigin);
+
+        // Remember a value that was received from the server so that it is not sent back
+        void setKnownValue(const BaseObject& baseObject, const ESM::Cell& cell);
+
+        void send();
+
+        // Forget the known values of local variables in this cell
+        void clearCell(const ESM::Cell& cell);
+        void clear();
+
+    private:
+        struct Batch
+        {
+            ESM::Cell cell;
+            unsigned char packetOrigin;
+            std::vector<BaseObject> baseObjects;
+            std::map<std::string, size_t> indexes;
+        };
+
+        void addVariable(const BaseObject& baseObject, const ESM::Cell& cell, unsigned char packetOrigin);
+
+        static std::string getKey(const BaseObject& baseObject, const ESM::Cell& cell);
+        static std::string getCellKey(const BaseObject& baseObject, const ESM::Cell& cell);
+        static double getValue(const BaseObject& baseObject);
+
+        std::map<std::pair<unsigned char, std::string>, Batch> batches;
+
+        // By the description of the cell for local variables, by an empty string for member and global ones
+        std::map<std::string, std::map<std::string, double> > knownValues;
+    };
+}
+
+#endif //OPENMW_SCRIPTSTATESYNC_HPP
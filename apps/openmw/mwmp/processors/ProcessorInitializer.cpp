@@ -69,6 +69,7 @@
 #include "object/ProcessorScriptMemberFloat.hpp"
 #include "object/ProcessorScriptGlobalShort.hpp"
 #include "object/ProcessorScriptGlobalFloat.hpp"
+#include "object/ProcessorScriptState.hpp"
 #include "object/ProcessorVideoPlay.hpp"
 
 #include "ActorProcessor.hpp"
@@ -168,6 +169,7 @@ void ProcessorInitializer()
     ObjectProcessor::AddProcessor(new ProcessorScriptMemberFloat());
     ObjectProcessor::AddProcessor(new ProcessorScriptGlobalShort());
     ObjectProcessor::AddProcessor(new ProcessorScriptGlobalFloat());
+    ObjectProcessor::AddProcessor(new ProcessorScriptState());
     ObjectProcessor::AddProcessor(new ProcessorVideoPlay());
 
     ActorProcessor::AddProcessor(new ProcessorActorAI());
@@ -0,0 +1,39 @@
+#ifndef OPENMW_PROCESSORSCRIPTSTATE_HPP
+#define OPENMW_PROCESSORSCRIPTSTATE_HPP
+
+#include "../ObjectProcessor.hpp"
+#include "apps/openmw/mwmp/Main.hpp"
+#include "apps/openmw/mwmp/CellController.hpp"
+#include "apps/openmw/mwworld/cellstore.hpp"
+
+namespace mwmp
+{
+    class ProcessorScriptState : public ObjectProcessor
+    {
+    public:
+        ProcessorScriptState()
+        {
+            BPP_INIT(ID_SCRIPT_STATE)
+        }
+
+        virtual void Do(ObjectPacket &packet, ObjectList &objectList)
+        {
+            LOG_MESSAGE_SIMPLE(Log::LOG_VERBOSE, "Received %s about %s", strPacketID.c_str(), objectList.cell.getDescription().c_str());
+
+            // Only local variables need their cell, and it may legitimately not be loaded here
+            MWWorld::CellStore *ptrCellStore = nullptr;
+            for (const auto &baseObject : objectList.baseObjects)
+            {
+                if (baseObject.variableType == BaseObjectList::LOCAL_SHORT || baseObject.variableType == BaseObjectList::LOCAL_FLOAT)
+                {
+                    ptrCellStore = Main::get().getCellController()->getCellStore(objectList.cell);
+                    break;
+                }
+            }
+
+            objectList.setScriptState(ptrCellStore);
+        }
+    };
+}
+
+#endif //OPENMW_PROCESSORSCRIPTSTATE_HPP
@@ -0,0 +1,212 @@
+#include "navigation.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadland.hpp>
+#include <components/navigator/bulletgeometry.hpp>
+#include <components/navigator/hash.hpp>
+#include <components/navigator/navgrid.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "../mwworld/cellstore.hpp"
+
+namespace
+{
+    // Most columns along either side of a grid. Larger cells are sampled more coarsely.
+    const float sMaxColumns = 512;
+
+    // How far above or below the surface the points of a path may be, about half the height of an NPC
+    const float sMaxZDistance = 64;
+
+    std::string toHex(uint64_t value)
+    {
+        char buffer[17];
+        for (int i = 15; i >= 0; --i, value >>= 4)
+            buffer[i] = "0123456789abcdef"[value & 0xf];
+        buffer[16] = 0;
+        return buffer;
+    }
+}
+
+namespace MWPhysics
+{
+
+    class NavGridWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// @param clampBounds Whether to only cover \a min to \a max on the XY plane, rather than all of \a geometry.
+        NavGridWorkItem(osg::ref_ptr<Navigator::BulletGeometry> geometry, bool clampBounds,
+                        const osg::Vec3f& min, const osg::Vec3f& max, const boost::filesystem::path& cacheDirectory)
+            : mGeometry(geometry)
+            , mClampBounds(clampBounds)
+            , mMin(min)
+            , mMax(max)
+            , mCacheDirectory(cacheDirectory)
+        {
+        }
+
+        virtual void doWork()
+        {
+            try
+            {
+                mGrid = loadOrBuild();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to build navigation grid: " << e.what() << std::endl;
+            }
+
+            // Let go of the meshes as soon as possible
+            mGeometry = NULL;
+        }
+
+        /// @return NULL until the grid is done, or if it could not be built.
+        const Navigator::NavGrid* getGrid() const
+        {
+            return isDone() ? mGrid.get() : NULL;
+        }
+
+    private:
+        osg::ref_ptr<Navigator::NavGrid> loadOrBuild()
+        {
+            if (mGeometry->isEmpty())
+                return NULL;
+
+            osg::Vec3f min, max;
+            mGeometry->getBounds(min, max);
+            if (mClampBounds)
+            {
+                min.x() = std::max(min.x(), mMin.x());
+                min.y() = std::max(min.y(), mMin.y());
+                max.x() = std::min(max.x(), mMax.x());
+                max.y() = std::min(max.y(), mMax.y());
+            }
+            if (!(min.x() < max.x() && min.y() < max.y()))
+                return NULL;
+
+            Navigator::BuildSettings settings;
+            settings.mSpacing = std::max(settings.mSpacing, std::max(max.x() - min.x(), max.y() - min.y()) / sMaxColumns);
+
+            uint64_t key = Navigator::hashValue(mGeometry->getHash(), settings.getHash());
+            key = Navigator::hashValue(key, min);
+            key = Navigator::hashValue(key, max);
+
+            if (mCacheDirectory.empty())
+                return Navigator::buildNavGrid(*mGeometry, min, max, settings);
+
+            const boost::filesystem::path path = mCacheDirectory / (toHex(key) + ".navgrid");
+            {
+                boost::filesystem::ifstream stream(path, std::ios::binary);
+                if (stream)
+                {
+                    osg::ref_ptr<Navigator::NavGrid> grid = Navigator::NavGrid::read(stream, key);
+                    if (grid)
+                        return grid;
+                }
+            }
+
+            osg::ref_ptr<Navigator::NavGrid> grid = Navigator::buildNavGrid(*mGeometry, min, max, settings);
+            write(*grid, key, path);
+            return grid;
+        }
+
+        /// Write through a temporary file, so that readers never see half of a grid.
+        static void write(const Navigator::NavGrid& grid, uint64_t key, const boost::filesystem::path& path)
+        {
+            boost::system::error_code ec;
+            boost::filesystem::path temp = path;
+            temp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+
+            {
+                boost::filesystem::ofstream stream(temp, std::ios::binary);
+                grid.write(stream, key);
+                if (!stream)
+                {
+                    std::cerr << "Failed to write " << temp.string() << std::endl;
+                    boost::filesystem::remove(temp, ec);
+                    return;
+                }
+            }
+
+            boost::filesystem::rename(temp, path, ec);
+            if (ec)
+                boost::filesystem::remove(temp, ec);
+        }
+
+        osg::ref_ptr<Navigator::BulletGeometry> mGeometry;
+        bool mClampBounds;
+        osg::Vec3f mMin;
+        osg::Vec3f mMax;
+        boost::filesystem::path mCacheDirectory;
+
+        osg::ref_ptr<Navigator::NavGrid> mGrid;
+    };
+
+    Navigation::Navigation(const boost::filesystem::path& cacheDirectory)
+        : mCacheDirectory(cacheDirectory)
+        , mWorkQueue(new SceneUtil::WorkQueue(1))
+    {
+        if (!mCacheDirectory.empty())
+        {
+            boost::system::error_code ec;
+            boost::filesystem::create_directories(mCacheDirectory, ec);
+            if (ec)
+            {
+                std::cerr << "Failed to create " << mCacheDirectory.string() << ": " << ec.message() << std::endl;
+                mCacheDirectory.clear();
+            }
+        }
+    }
+
+    Navigation::~Navigation()
+    {
+        for (CellMap::iterator it = mCells.begin(); it != mCells.end(); ++it)
+            it->second->cancel();
+    }
+
+    void Navigation::addCell(const MWWorld::CellStore* cell, osg::ref_ptr<Navigator::BulletGeometry> geometry)
+    {
+        removeCell(cell);
+
+        // Exterior cells only cover their own square, even where their objects reach into the next cell
+        const ESM::Cell* record = cell->getCell();
+        const bool exterior = record->isExterior();
+        const osg::Vec3f min (record->getGridX() * ESM::Land::REAL_SIZE, record->getGridY() * ESM::Land::REAL_SIZE, 0);
+        const osg::Vec3f max = min + osg::Vec3f(ESM::Land::REAL_SIZE, ESM::Land::REAL_SIZE, 0);
+
+        osg::ref_ptr<NavGridWorkItem> item (new NavGridWorkItem(geometry, exterior, min, max, mCacheDirectory));
+        mWorkQueue->addWorkItem(item, SceneUtil::WorkItem::Priority_Low);
+        mCells[cell] = item;
+    }
+
+    void Navigation::removeCell(const MWWorld::CellStore* cell)
+    {
+        CellMap::iterator found = mCells.find(cell);
+        if (found == mCells.end())
+            return;
+
+        found->second->cancel();
+        mCells.erase(found);
+    }
+
+    bool Navigation::findPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                              std::vector<osg::Vec3f>& path) const
+    {
+        CellMap::const_iterator found = mCells.find(cell);
+        if (found == mCells.end())
+            return false;
+
+        const Navigator::NavGrid* grid = found->second->getGrid();
+        if (!grid || !grid->contains(start) || !grid->contains(end))
+            return false;
+
+        return grid->findPath(start, end, sMaxZDistance, path);
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef OPENMW_MWPHYSICS_NAVIGATION_H
+#define OPENMW_MWPHYSICS_NAVIGATION_H
+
+#include <map>
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Vec3f>
+
+#include <boost/filesystem/path.hpp>
+
+namespace MWWorld
+{
+    class CellStore;
+}
+
+namespace Navigator
+{
+    class BulletGeometry;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace MWPhysics
+{
+    class NavGridWorkItem;
+
+    /// @brief Builds a Navigator::NavGrid for each active cell on a worker thread, and finds paths on them.
+    /// @par Grids are kept on disk by a hash of the geometry they were built from, so a cell that has not changed
+    /// since it was last visited is read instead of built.
+    class Navigation
+    {
+    public:
+        /// @param cacheDirectory Where to keep the grids. Empty to build them on every load.
+        Navigation(const boost::filesystem::path& cacheDirectory);
+        ~Navigation();
+
+        /// Start building the grid of \a cell from \a geometry, replacing any it had.
+        void addCell(const MWWorld::CellStore* cell, osg::ref_ptr<Navigator::BulletGeometry> geometry);
+
+        void removeCell(const MWWorld::CellStore* cell);
+
+        /// Find a path from \a start to \a end within \a cell, see Navigator::NavGrid::findPath.
+        /// @return false if the grid of \a cell is not ready yet, or has no path between the points.
+        bool findPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                      std::vector<osg::Vec3f>& path) const;
+
+    private:
+        boost::filesystem::path mCacheDirectory;
+
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
+        typedef std::map<const MWWorld::CellStore*, osg::ref_ptr<NavGridWorkItem> > CellMap;
+        CellMap mCells;
+    };
+
+}
+
+#endif
@@ -1,9 +1,11 @@
 #include "physicssystem.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
 #include <osg/Group>
+#include <osg/Stats>
 
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #include <BulletCollision/CollisionShapes/btConeShape.h>
@@ -22,8 +24,11 @@
 #include <components/resource/bulletshapemanager.hpp>
 
 #include <components/esm/loadgmst.hpp>
+#include <components/navigator/bulletgeometry.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/settings/settings.hpp>
 
 #include <components/nifosg/particle.hpp> // FindRecIndexVisitor
 
@@ -47,6 +52,7 @@
 #include "collisiontype.hpp"
 #include "actor.hpp"
 #include "convert.hpp"
+#include "navigation.hpp"
 #include "trace.h"
 
 namespace MWPhysics
@@ -214,6 +220,39 @@ namespace MWPhysics
         }
     };
 
+    /// Everything needed to solve the movement of one actor. It is gathered on the main thread beforehand, so that
+    /// solving reads nothing but the frame, the Actor's shape and the collision world, and can run on any thread.
+    struct ActorFrame
+    {
+        MWWorld::Ptr mPtr;
+        Actor* mActor;
+        osg::Vec3f mMovement;
+        float mWaterlevel;
+        float mSwimlevel;
+        float mSlowFall;
+        bool mFlying;
+        bool mWasOnGround;
+        bool mIsMobile;
+        bool mIsDead;
+        bool mIsPureWaterCreature;
+        osg::Quat mRotation; ///< Around the X and Z axes, for swimming and flying
+        osg::Quat mRotationZ;
+        float mStormWalkMult; ///< 0 when there is no storm
+        osg::Vec3f mStormDirection;
+
+        // State of the Actor, solved and then committed back to it
+        osg::Vec3f mInertia;
+        bool mOnGround;
+        bool mOnSlope;
+        bool mWalkingOnWater;
+
+        // Results
+        osg::Vec3f mPosition;
+        osg::Vec3f mPreviousStepPosition;
+        bool mPositionChanged;
+        MWWorld::Ptr mStandingOn;
+    };
+
     class MovementSolver
     {
     private:
@@ -274,24 +313,23 @@ namespace MWPhysics
             }
         }
 
-        static osg::Vec3f move(osg::Vec3f position, const MWWorld::Ptr &ptr, Actor* physicActor, const osg::Vec3f &movement, float time,
-                                  bool isFlying, float waterlevel, float slowFall, const btCollisionWorld* collisionWorld,
-                               std::map<MWWorld::Ptr, MWWorld::Ptr>& standingCollisionTracker)
+        static osg::Vec3f move(osg::Vec3f position, ActorFrame& frame, float time, const btCollisionWorld* collisionWorld)
         {
-            const ESM::Position& refpos = ptr.getRefData().getPosition();
+            const Actor* physicActor = frame.mActor;
+            const osg::Vec3f& movement = frame.mMovement;
+            const bool isFlying = frame.mFlying;
+
             // Early-out for totally static creatures
             // (Not sure if gravity should still apply?)
-            if (!ptr.getClass().isMobile(ptr))
+            if (!frame.mIsMobile)
                 return position;
 
             // Reset per-frame data
-            physicActor->setWalkingOnWater(false);
+            frame.mWalkingOnWater = false;
             // Anything to collide with?
             if(!physicActor->getCollisionMode())
             {
-                return position +  (osg::Quat(refpos.rot[0], osg::Vec3f(-1, 0, 0)) *
-                                    osg::Quat(refpos.rot[2], osg::Vec3f(0, 0, -1))
-                                    ) * movement * time;
+                return position + frame.mRotation * movement * time;
             }
 
             const btCollisionObject *colobj = physicActor->getCollisionObject();
@@ -303,45 +341,38 @@ namespace MWPhysics
             // While this is strictly speaking wrong, it's needed for MW compatibility.
             position.z() += halfExtents.z();
 
-            static const float fSwimHeightScale = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                    .find("fSwimHeightScale")->getFloat();
-            float swimlevel = waterlevel + halfExtents.z() - (physicActor->getRenderingHalfExtents().z() * 2 * fSwimHeightScale);
+            const float swimlevel = frame.mSwimlevel;
 
             ActorTracer tracer;
 
-            osg::Vec3f inertia = physicActor->getInertialForce();
+            osg::Vec3f inertia = frame.mInertia;
             osg::Vec3f velocity;
 
             if(position.z() < swimlevel || isFlying)
             {
-                velocity = (osg::Quat(refpos.rot[0], osg::Vec3f(-1, 0, 0)) *
-                            osg::Quat(refpos.rot[2], osg::Vec3f(0, 0, -1))) * movement;
+                velocity = frame.mRotation * movement;
             }
             else
             {
-                velocity = (osg::Quat(refpos.rot[2], osg::Vec3f(0, 0, -1))) * movement;
+                velocity = frame.mRotationZ * movement;
 
-                if ((velocity.z() > 0.f && physicActor->getOnGround() && !physicActor->getOnSlope())
-                 || (velocity.z() > 0.f && velocity.z() + inertia.z() <= -velocity.z() && physicActor->getOnSlope()))
+                if ((velocity.z() > 0.f && frame.mOnGround && !frame.mOnSlope)
+                 || (velocity.z() > 0.f && velocity.z() + inertia.z() <= -velocity.z() && frame.mOnSlope))
                     inertia = velocity;
-                else if (!physicActor->getOnGround() || physicActor->getOnSlope())
+                else if (!frame.mOnGround || frame.mOnSlope)
                     velocity = velocity + inertia;
             }
 
             // dead actors underwater will float to the surface, if the CharacterController tells us to do so
-            if (movement.z() > 0 && ptr.getClass().getCreatureStats(ptr).isDead() && position.z() < swimlevel)
+            if (movement.z() > 0 && frame.mIsDead && position.z() < swimlevel)
                 velocity = osg::Vec3f(0,0,1) * 25;
 
-            ptr.getClass().getMovementSettings(ptr).mPosition[2] = 0;
-
             // Now that we have the effective movement vector, apply wind forces to it
-            if (MWBase::Environment::get().getWorld()->isInStorm())
+            if (frame.mStormWalkMult != 0.f)
             {
-                osg::Vec3f stormDirection = MWBase::Environment::get().getWorld()->getStormDirection();
+                const osg::Vec3f& stormDirection = frame.mStormDirection;
                 float angleDegrees = osg::RadiansToDegrees(std::acos(stormDirection * velocity / (stormDirection.length() * velocity.length())));
-                static const float fStromWalkMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                        .find("fStromWalkMult")->getFloat();
-                velocity *= 1.f-(fStromWalkMult * (angleDegrees/180.f));
+                velocity *= 1.f-(frame.mStormWalkMult * (angleDegrees/180.f));
             }
 
             Stepper stepper(collisionWorld, colobj);
@@ -413,8 +444,8 @@ namespace MWPhysics
                 if (result)
                 {
                     // don't let pure water creatures move out of water after stepMove
-                    if (ptr.getClass().isPureWaterCreature(ptr)
-                            && newPosition.z() + halfExtents.z() > waterlevel)
+                    if (frame.mIsPureWaterCreature
+                            && newPosition.z() + halfExtents.z() > frame.mWaterlevel)
                         newPosition = oldPosition;
                 }
                 else
@@ -441,19 +472,19 @@ namespace MWPhysics
             if (!(inertia.z() > 0.f) && !(newPosition.z() < swimlevel))
             {
                 osg::Vec3f from = newPosition;
-                osg::Vec3f to = newPosition - (physicActor->getOnGround() ?
+                osg::Vec3f to = newPosition - (frame.mOnGround ?
                              osg::Vec3f(0,0,sStepSizeDown + 2*sGroundOffset) : osg::Vec3f(0,0,2*sGroundOffset));
                 tracer.doTrace(colobj, from, to, collisionWorld);
                 if(tracer.mFraction < 1.0f
                         && tracer.mHitObject->getBroadphaseHandle()->m_collisionFilterGroup != CollisionType_Actor)
                 {
-                    const btCollisionObject* standingOn = tracer.mHitObject;
-                    PtrHolder* ptrHolder = static_cast<PtrHolder*>(standingOn->getUserPointer());
+                    const btCollisionObject* hitObject = tracer.mHitObject;
+                    PtrHolder* ptrHolder = static_cast<PtrHolder*>(hitObject->getUserPointer());
                     if (ptrHolder)
-                        standingCollisionTracker[ptr] = ptrHolder->getPtr();
+                        frame.mStandingOn = ptrHolder->getPtr();
 
-                    if (standingOn->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Water)
-                        physicActor->setWalkingOnWater(true);
+                    if (hitObject->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Water)
+                        frame.mWalkingOnWater = true;
                     if (!isFlying)
                         newPosition.z() = tracer.mEndPos.z() + sGroundOffset;
 
@@ -484,26 +515,111 @@ namespace MWPhysics
             }
 
             if((isOnGround && !isOnSlope) || newPosition.z() < swimlevel || isFlying)
-                physicActor->setInertialForce(osg::Vec3f(0.f, 0.f, 0.f));
+                frame.mInertia = osg::Vec3f(0.f, 0.f, 0.f);
             else
             {
                 inertia.z() += time * -627.2f;
                 if (inertia.z() < 0)
-                    inertia.z() *= slowFall;
-                if (slowFall < 1.f) {
-                    inertia.x() *= slowFall;
-                    inertia.y() *= slowFall;
+                    inertia.z() *= frame.mSlowFall;
+                if (frame.mSlowFall < 1.f) {
+                    inertia.x() *= frame.mSlowFall;
+                    inertia.y() *= frame.mSlowFall;
                 }
-                physicActor->setInertialForce(inertia);
+                frame.mInertia = inertia;
             }
-            physicActor->setOnGround(isOnGround);
-            physicActor->setOnSlope(isOnSlope);
+            frame.mOnGround = isOnGround;
+            frame.mOnSlope = isOnSlope;
 
             newPosition.z() -= halfExtents.z(); // remove what was added at the beginning
             return newPosition;
         }
     };
 
+    /// Solve all substeps of the actor's movement, without moving its collision object yet.
+    /// Other actors are collided against wherever their collision objects are.
+    static void solveActorMovement(ActorFrame& frame, int numSteps, float physicsDt, const btCollisionWorld* collisionWorld)
+    {
+        frame.mPosition = frame.mActor->getPosition();
+        frame.mPreviousStepPosition = frame.mPosition;
+        frame.mPositionChanged = false;
+        for (int i=0; i<numSteps; ++i)
+        {
+            frame.mPreviousStepPosition = frame.mPosition;
+            frame.mPosition = MovementSolver::move(frame.mPosition, frame, physicsDt, collisionWorld);
+            if (frame.mPosition != frame.mPreviousStepPosition)
+                frame.mPositionChanged = true;
+        }
+    }
+
+    /// Solve the movement of all actors, in parallel if a WorkQueue is given.
+    static void solveActorsMovement(std::vector<ActorFrame>& frames, int numSteps, float physicsDt, const btCollisionWorld* collisionWorld,
+                                    SceneUtil::WorkQueue* workQueue)
+    {
+        if (workQueue && numSteps > 0 && frames.size() > 1)
+        {
+            workQueue->parallelFor(frames.size(), [&frames, numSteps, physicsDt, collisionWorld] (unsigned int index)
+            {
+                solveActorMovement(frames[index], numSteps, physicsDt, collisionWorld);
+            });
+        }
+        else
+        {
+            for (std::vector<ActorFrame>::iterator it = frames.begin(); it != frames.end(); ++it)
+                solveActorMovement(*it, numSteps, physicsDt, collisionWorld);
+        }
+    }
+
+    /// Solves the movement of one frame's actors in the background, for async movement.
+    class MovementWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        MovementWorkItem(std::vector<ActorFrame>& frames, int numSteps, float physicsDt, float interpolationFactor,
+                         const btCollisionWorld* collisionWorld, SceneUtil::WorkQueue* workQueue)
+            : mNumSteps(numSteps)
+            , mPhysicsDt(physicsDt)
+            , mInterpolationFactor(interpolationFactor)
+            , mCollisionWorld(collisionWorld)
+            , mWorkQueue(workQueue)
+        {
+            mFrames.swap(frames);
+        }
+
+        virtual void doWork()
+        {
+            // This item takes one of the worker threads, so only spread the actors if there are others
+            solveActorsMovement(mFrames, mNumSteps, mPhysicsDt, mCollisionWorld,
+                                mWorkQueue->getNumThreads() > 1 ? mWorkQueue : NULL);
+        }
+
+        std::vector<ActorFrame> mFrames;
+        int mNumSteps;
+        float mPhysicsDt;
+        float mInterpolationFactor;
+
+    private:
+        const btCollisionWorld* mCollisionWorld;
+        SceneUtil::WorkQueue* mWorkQueue;
+    };
+
+    /// Whether Bullet was built with BT_THREADSAFE. Otherwise all queries share one broadphase stack.
+    static bool isThreadSafeBullet()
+    {
+#if BT_BULLET_VERSION >= 286
+        btDbvtBroadphase broadphase;
+        return broadphase.m_rayTestStacks.size() > 1;
+#else
+        return false;
+#endif
+    }
+
+    // Line of sight results stay valid while neither actor moves further than this
+    static const float sLineOfSightTolerance = 1.f;
+
+    static osg::Vec3f getEyePosition(const Actor* actor)
+    {
+        return actor->getCollisionObjectPosition() + osg::Vec3f(0, 0, actor->getHalfExtents().z() * 0.9f);
+    }
+
 
     // ---------------------------------------------------------------
 
@@ -511,6 +627,13 @@ namespace MWPhysics
     {
     public:
         HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
+            : mHeights(heights)
+            , mX(x)
+            , mY(y)
+            , mTriSize(triSize)
+            , mSqrtVerts(sqrtVerts)
+            , mMinH(minH)
+            , mMaxH(maxH)
         {
             mShape = new btHeightfieldTerrainShape(
                 sqrtVerts, sqrtVerts, heights, 1,
@@ -541,7 +664,20 @@ namespace MWPhysics
             return mCollisionObject;
         }
 
+        void addTo(Navigator::BulletGeometry& geometry) const
+        {
+            geometry.addHeightField(mHeights, mX, mY, mTriSize, mSqrtVerts, mMinH, mMaxH, mHoldObject.get());
+        }
+
     private:
+        const float* mHeights;
+        int mX;
+        int mY;
+        float mTriSize;
+        float mSqrtVerts;
+        float mMinH;
+        float mMaxH;
+
         btHeightfieldTerrainShape* mShape;
         btCollisionObject* mCollisionObject;
         osg::ref_ptr<const osg::Object> mHoldObject;
@@ -687,8 +823,16 @@ namespace MWPhysics
         , mWaterEnabled(false)
         , mParentNode(parentNode)
         , mPhysicsDt(1.f / 60.f)
+        , mTime(0.0)
+        , mLineOfSightQueries(0)
+        , mLineOfSightHits(0)
+        , mLineOfSightRays(0)
+        , mLastLineOfSightQueries(0)
+        , mLastLineOfSightHits(0)
+        , mLastLineOfSightRays(0)
     {
         mResourceSystem->addResourceManager(mShapeManager.get());
+        mShapeManager->setCompiledCache(mResourceSystem->getCompiledCache());
 
         mCollisionConfiguration = new btDefaultCollisionConfiguration();
         mDispatcher = new btCollisionDispatcher(mCollisionConfiguration);
@@ -700,6 +844,21 @@ namespace MWPhysics
         // Should a "static" object ever be moved, we have to update its AABB manually using DynamicsWorld::updateSingleAabb.
         mCollisionWorld->setForceUpdateAllAabbs(false);
 
+        mThreadSafeBullet = isThreadSafeBullet();
+        mAsyncMovement = Settings::Manager::getBool("async movement", "Physics");
+        int numThreads = Settings::Manager::getInt("movement threads", "Physics");
+        if (numThreads > 0 && !mThreadSafeBullet)
+        {
+            std::cerr << "Warning: Bullet was built without BT_THREADSAFE, actor movement will be solved on one thread" << std::endl;
+            numThreads = 0;
+        }
+        if (mAsyncMovement)
+            numThreads = std::max(numThreads, 1);
+        if (numThreads > 0)
+            mMovementWorkQueue = new SceneUtil::WorkQueue(numThreads);
+
+        mLineOfSightCacheTime = Settings::Manager::getFloat("line of sight cache time", "Physics");
+
         // Check if a user decided to override a physics system FPS
         const char* env = getenv("OPENMW_PHYSICS_FPS");
         if (env)
@@ -715,6 +874,9 @@ namespace MWPhysics
 
     PhysicsSystem::~PhysicsSystem()
     {
+        if (mMovementJob)
+            mMovementJob->waitTillDone();
+
         mResourceSystem->removeResourceManager(mShapeManager.get());
 
         if (mWaterCollisionObject.get())
@@ -755,6 +917,7 @@ namespace MWPhysics
 
     bool PhysicsSystem::toggleDebugRendering()
     {
+        syncMovement();
         mDebugDrawEnabled = !mDebugDrawEnabled;
 
         if (mDebugDrawEnabled && !mDebugDrawer.get())
@@ -872,6 +1035,7 @@ namespace MWPhysics
                                                                      const osg::Quat &orient,
                                                                      float queryDistance, std::vector<MWWorld::Ptr> targets)
     {
+        waitForMovement();
         // First of all, try to hit where you aim to
         int hitmask = CollisionType_World | CollisionType_Door | CollisionType_HeightMap | CollisionType_Actor;
         RayResult result = castRay(origin, origin + (orient * osg::Vec3f(0.0f, queryDistance, 0.0f)), actor, targets, CollisionType_Actor, hitmask);
@@ -929,6 +1093,7 @@ namespace MWPhysics
 
     float PhysicsSystem::getHitDistance(const osg::Vec3f &point, const MWWorld::ConstPtr &target) const
     {
+        waitForMovement();
         btCollisionObject* targetCollisionObj = NULL;
         const Actor* actor = getActor(target);
         if (actor)
@@ -988,6 +1153,7 @@ namespace MWPhysics
 
     PhysicsSystem::RayResult PhysicsSystem::castRay(const osg::Vec3f &from, const osg::Vec3f &to, const MWWorld::ConstPtr& ignore, std::vector<MWWorld::Ptr> targets, int mask, int group) const
     {
+        waitForMovement();
         btVector3 btFrom = toBullet(from);
         btVector3 btTo = toBullet(to);
 
@@ -1037,6 +1203,7 @@ namespace MWPhysics
 
     PhysicsSystem::RayResult PhysicsSystem::castSphere(const osg::Vec3f &from, const osg::Vec3f &to, float radius)
     {
+        waitForMovement();
         btCollisionWorld::ClosestConvexResultCallback callback(toBullet(from), toBullet(to));
         callback.m_collisionFilterGroup = 0xff;
         callback.m_collisionFilterMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Door;
@@ -1061,20 +1228,129 @@ namespace MWPhysics
 
     bool PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor1, const MWWorld::ConstPtr &actor2) const
     {
+        waitForMovement();
         const Actor* physactor1 = getActor(actor1);
         const Actor* physactor2 = getActor(actor2);
 
         if (!physactor1 || !physactor2)
             return false;
 
-        osg::Vec3f pos1 (physactor1->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.9)); // eye level
-        osg::Vec3f pos2 (physactor2->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.9));
+        ++mLineOfSightQueries;
+
+        LineOfSightKey key = std::minmax(physactor1, physactor2);
+        osg::Vec3f from = getEyePosition(key.first);
+        osg::Vec3f to = getEyePosition(key.second);
+
+        if (const LineOfSight* cached = findLineOfSight(key, from, to))
+        {
+            ++mLineOfSightHits;
+            return cached->mVisible;
+        }
+
+        RayResult result = castRay(from, to, MWWorld::ConstPtr(), std::vector<MWWorld::Ptr>(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door);
+        ++mLineOfSightRays;
 
-        RayResult result = castRay(pos1, pos2, MWWorld::ConstPtr(), std::vector<MWWorld::Ptr>(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door);
+        if (mLineOfSightCacheTime > 0)
+        {
+            LineOfSight& entry = mLineOfSightCache[key];
+            entry.mFrom = from;
+            entry.mTo = to;
+            entry.mTime = mTime;
+            entry.mVisible = !result.mHit;
+        }
 
         return !result.mHit;
     }
 
+    void PhysicsSystem::prefetchLineOfSight(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& pairs)
+    {
+        if (!mMovementWorkQueue || !mThreadSafeBullet || mLineOfSightCacheTime <= 0)
+            return;
+
+        struct Ray
+        {
+            LineOfSightKey mKey;
+            osg::Vec3f mFrom;
+            osg::Vec3f mTo;
+            bool mHit;
+        };
+        std::vector<Ray> rays;
+        std::set<LineOfSightKey> queued;
+
+        for (std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+        {
+            const Actor* physactor1 = getActor(it->first);
+            const Actor* physactor2 = getActor(it->second);
+            if (!physactor1 || !physactor2 || physactor1 == physactor2)
+                continue;
+
+            Ray ray;
+            ray.mKey = std::minmax(physactor1, physactor2);
+            ray.mFrom = getEyePosition(ray.mKey.first);
+            ray.mTo = getEyePosition(ray.mKey.second);
+            ray.mHit = false;
+            if (findLineOfSight(ray.mKey, ray.mFrom, ray.mTo) || !queued.insert(ray.mKey).second)
+                continue;
+
+            rays.push_back(ray);
+        }
+
+        if (rays.empty())
+            return;
+
+        // Only reads the collision world, which a thread safe Bullet allows alongside the movement solved in the background
+        mMovementWorkQueue->parallelFor(rays.size(), [&] (unsigned int index)
+        {
+            Ray& ray = rays[index];
+            ray.mHit = castRay(ray.mFrom, ray.mTo, MWWorld::ConstPtr(), std::vector<MWWorld::Ptr>(),
+                               CollisionType_World|CollisionType_HeightMap|CollisionType_Door).mHit;
+        });
+        mLineOfSightRays += rays.size();
+
+        for (std::vector<Ray>::const_iterator it = rays.begin(); it != rays.end(); ++it)
+        {
+            LineOfSight& entry = mLineOfSightCache[it->mKey];
+            entry.mFrom = it->mFrom;
+            entry.mTo = it->mTo;
+            entry.mTime = mTime;
+            entry.mVisible = !it->mHit;
+        }
+    }
+
+    const PhysicsSystem::LineOfSight* PhysicsSystem::findLineOfSight(const LineOfSightKey& key, const osg::Vec3f& from, const osg::Vec3f& to) const
+    {
+        LineOfSightCache::const_iterator found = mLineOfSightCache.find(key);
+        if (found == mLineOfSightCache.end())
+            return NULL;
+
+        const LineOfSight& entry = found->second;
+        if (mTime - entry.mTime > mLineOfSightCacheTime
+                || (entry.mFrom - from).length2() > sLineOfSightTolerance * sLineOfSightTolerance
+                || (entry.mTo - to).length2() > sLineOfSightTolerance * sLineOfSightTolerance)
+            return NULL;
+
+        return &entry;
+    }
+
+    void PhysicsSystem::removeLineOfSight(const Actor* actor)
+    {
+        for (LineOfSightCache::iterator it = mLineOfSightCache.begin(); it != mLineOfSightCache.end(); )
+        {
+            if (it->first.first == actor || it->first.second == actor)
+                it = mLineOfSightCache.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void PhysicsSystem::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        stats->setAttribute(frameNumber, "LOS Query", mLastLineOfSightQueries);
+        if (mLastLineOfSightQueries > 0)
+            stats->setAttribute(frameNumber, "LOS Hit %", 100.0 * mLastLineOfSightHits / mLastLineOfSightQueries);
+        stats->setAttribute(frameNumber, "LOS Ray", mLastLineOfSightRays);
+    }
+
     bool PhysicsSystem::isOnGround(const MWWorld::Ptr &actor)
     {
         Actor* physactor = getActor(actor);
@@ -1150,6 +1426,7 @@ namespace MWPhysics
 
     std::vector<MWWorld::Ptr> PhysicsSystem::getCollisions(const MWWorld::ConstPtr &ptr, int collisionGroup, int collisionMask) const
     {
+        waitForMovement();
         btCollisionObject* me = NULL;
 
         ObjectMap::const_iterator found = mObjects.find(ptr);
@@ -1167,6 +1444,7 @@ namespace MWPhysics
 
     osg::Vec3f PhysicsSystem::traceDown(const MWWorld::Ptr &ptr, const osg::Vec3f& position, float maxHeight)
     {
+        syncMovement();
         ActorMap::iterator found = mActors.find(ptr);
         if (found ==  mActors.end())
             return ptr.getRefData().getPosition().asVec3();
@@ -1176,6 +1454,7 @@ namespace MWPhysics
 
     void PhysicsSystem::addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
     {
+        syncMovement();
         HeightField *heightfield = new HeightField(heights, x, y, triSize, sqrtVerts, minH, maxH, holdObject);
         mHeightFields[std::make_pair(x,y)] = heightfield;
 
@@ -1185,6 +1464,7 @@ namespace MWPhysics
 
     void PhysicsSystem::removeHeightField (int x, int y)
     {
+        syncMovement();
         HeightFieldMap::iterator heightfield = mHeightFields.find(std::make_pair(x,y));
         if(heightfield != mHeightFields.end())
         {
@@ -1194,12 +1474,57 @@ namespace MWPhysics
         }
     }
 
+    void PhysicsSystem::enableNavigation(const std::string& cacheDirectory)
+    {
+        mNavigation.reset(new Navigation(cacheDirectory));
+    }
+
+    void PhysicsSystem::addNavigationCell(const MWWorld::CellStore* cell)
+    {
+        if (!mNavigation)
+            return;
+
+        // Doors open and animated objects move, so only the objects that stay where they are make up the grid
+        osg::ref_ptr<Navigator::BulletGeometry> geometry (new Navigator::BulletGeometry);
+        for (ObjectMap::const_iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            const Object* object = it->second;
+            if (it->first.getCell() != cell || object->isAnimated()
+                    || object->getCollisionObject()->getBroadphaseHandle()->m_collisionFilterGroup != CollisionType_World)
+                continue;
+            geometry->addShape(*object->getShapeInstance(), object->getCollisionObject()->getWorldTransform());
+        }
+
+        if (cell->isExterior())
+        {
+            HeightFieldMap::const_iterator found = mHeightFields.find(std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY()));
+            if (found != mHeightFields.end())
+                found->second->addTo(*geometry);
+        }
+
+        mNavigation->addCell(cell, geometry);
+    }
+
+    void PhysicsSystem::removeNavigationCell(const MWWorld::CellStore* cell)
+    {
+        if (mNavigation)
+            mNavigation->removeCell(cell);
+    }
+
+    bool PhysicsSystem::findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                           std::vector<osg::Vec3f>& path) const
+    {
+        return mNavigation && mNavigation->findPath(cell, start, end, path);
+    }
+
     void PhysicsSystem::addObject (const MWWorld::Ptr& ptr, const std::string& mesh, int collisionType)
     {
         osg::ref_ptr<Resource::BulletShapeInstance> shapeInstance = mShapeManager->getInstance(mesh);
         if (!shapeInstance || !shapeInstance->getCollisionShape())
             return;
 
+        syncMovement();
+
         Object *obj = new Object(ptr, shapeInstance);
         mObjects.insert(std::make_pair(ptr, obj));
 
@@ -1212,6 +1537,7 @@ namespace MWPhysics
 
     void PhysicsSystem::remove(const MWWorld::Ptr &ptr)
     {
+        syncMovement();
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
@@ -1229,9 +1555,14 @@ namespace MWPhysics
         ActorMap::iterator foundActor = mActors.find(ptr);
         if (foundActor != mActors.end())
         {
+            // A new actor could get the same address
+            removeLineOfSight(foundActor->second);
+
             delete foundActor->second;
             mActors.erase(foundActor);
         }
+
+        removeAsyncResult(ptr);
     }
 
     void PhysicsSystem::updateCollisionMapPtr(CollisionMap& map, const MWWorld::Ptr &old, const MWWorld::Ptr &updated)
@@ -1252,6 +1583,7 @@ namespace MWPhysics
 
     void PhysicsSystem::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &updated)
     {
+        syncMovement();
         ObjectMap::iterator found = mObjects.find(old);
         if (found != mObjects.end())
         {
@@ -1271,10 +1603,17 @@ namespace MWPhysics
         }
 
         updateCollisionMapPtr(mStandingCollisions, old, updated);
+
+        for (PtrVelocityList::iterator it = mAsyncResults.begin(); it != mAsyncResults.end(); ++it)
+        {
+            if (it->first == old)
+                it->first = updated;
+        }
     }
 
     Actor *PhysicsSystem::getActor(const MWWorld::Ptr &ptr)
     {
+        syncMovement();
         ActorMap::iterator found = mActors.find(ptr);
         if (found != mActors.end())
             return found->second;
@@ -1299,6 +1638,7 @@ namespace MWPhysics
 
     void PhysicsSystem::updateScale(const MWWorld::Ptr &ptr)
     {
+        syncMovement();
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
@@ -1318,6 +1658,7 @@ namespace MWPhysics
 
     void PhysicsSystem::updateRotation(const MWWorld::Ptr &ptr)
     {
+        syncMovement();
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
@@ -1339,6 +1680,7 @@ namespace MWPhysics
 
     void PhysicsSystem::updatePosition(const MWWorld::Ptr &ptr)
     {
+        syncMovement();
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
@@ -1351,6 +1693,8 @@ namespace MWPhysics
         {
             foundActor->second->updatePosition();
             mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
+            // Teleported, so the movement solved before must not move it back
+            removeAsyncResult(ptr);
             return;
         }
     }
@@ -1360,12 +1704,15 @@ namespace MWPhysics
         if (!shape)
             return;
 
+        syncMovement();
+
         Actor* actor = new Actor(ptr, shape, mCollisionWorld);
         mActors.insert(std::make_pair(ptr, actor));
     }
 
     bool PhysicsSystem::toggleCollisionMode()
     {
+        syncMovement();
         ActorMap::iterator found = mActors.find(MWMechanics::getPlayer());
         if (found != mActors.end())
         {
@@ -1396,6 +1743,8 @@ namespace MWPhysics
 
     void PhysicsSystem::clearQueuedMovement()
     {
+        syncMovement();
+        mAsyncResults.clear();
         mMovementQueue.clear();
         mStandingCollisions.clear();
     }
@@ -1404,6 +1753,13 @@ namespace MWPhysics
     {
         mMovementResults.clear();
 
+        // Return the movement solved in the background since the previous call
+        if (mAsyncMovement)
+        {
+            syncMovement();
+            mMovementResults.swap(mAsyncResults);
+        }
+
         mTimeAccum += dt;
 
         const int maxAllowedSteps = 20;
@@ -1412,13 +1768,17 @@ namespace MWPhysics
 
         mTimeAccum -= numSteps * mPhysicsDt;
 
-        if (numSteps)
-        {
-            // Collision events should be available on every frame
-            mStandingCollisions.clear();
-        }
+        float interpolationFactor = mTimeAccum / mPhysicsDt;
 
         const MWBase::World *world = MWBase::Environment::get().getWorld();
+        const MWWorld::Store<ESM::GameSetting>& gmst = world->getStore().get<ESM::GameSetting>();
+        static const float fSwimHeightScale = gmst.find("fSwimHeightScale")->getFloat();
+        static const float fStromWalkMult = gmst.find("fStromWalkMult")->getFloat();
+        const bool inStorm = world->isInStorm();
+        const osg::Vec3f stormDirection = inStorm ? world->getStormDirection() : osg::Vec3f();
+
+        std::vector<ActorFrame> frames;
+        frames.reserve(mMovementQueue.size());
         PtrVelocityList::iterator iter = mMovementQueue.begin();
         for(;iter != mMovementQueue.end();++iter)
         {
@@ -1448,38 +1808,73 @@ namespace MWPhysics
             }
             physicActor->setCanWaterWalk(waterCollision);
 
-            // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
-            float slowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+            const MWWorld::Ptr& ptr = iter->first;
+            const ESM::Position& refpos = ptr.getRefData().getPosition();
 
-            bool flying = world->isFlying(iter->first);
+            ActorFrame frame;
+            frame.mPtr = ptr;
+            frame.mActor = physicActor;
+            frame.mMovement = iter->second;
+            frame.mWaterlevel = waterlevel;
+            frame.mSwimlevel = waterlevel + physicActor->getHalfExtents().z()
+                    - (physicActor->getRenderingHalfExtents().z() * 2 * fSwimHeightScale);
+            // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
+            frame.mSlowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+            frame.mFlying = world->isFlying(ptr);
+            frame.mWasOnGround = physicActor->getOnGround();
+            frame.mIsMobile = ptr.getClass().isMobile(ptr);
+            frame.mIsDead = ptr.getClass().getCreatureStats(ptr).isDead();
+            frame.mIsPureWaterCreature = ptr.getClass().isPureWaterCreature(ptr);
+            frame.mRotationZ = osg::Quat(refpos.rot[2], osg::Vec3f(0, 0, -1));
+            frame.mRotation = osg::Quat(refpos.rot[0], osg::Vec3f(-1, 0, 0)) * frame.mRotationZ;
+            frame.mStormWalkMult = inStorm ? fStromWalkMult : 0.f;
+            frame.mStormDirection = stormDirection;
+            frame.mInertia = physicActor->getInertialForce();
+            frame.mOnGround = physicActor->getOnGround();
+            frame.mOnSlope = physicActor->getOnSlope();
+            frame.mWalkingOnWater = physicActor->isWalkingOnWater();
+            frames.push_back(frame);
+
+            // Jumping is a single impulse
+            if (numSteps > 0 && frame.mIsMobile && physicActor->getCollisionMode())
+                ptr.getClass().getMovementSettings(ptr).mPosition[2] = 0;
+        }
 
-            bool wasOnGround = physicActor->getOnGround();
-            osg::Vec3f position = physicActor->getPosition();
-            float oldHeight = position.z();
-            bool positionChanged = false;
-            for (int i=0; i<numSteps; ++i)
+        if (mAsyncMovement)
+        {
+            // Everything read from the World is in the frames now, so the rest of this frame may go on
+            mMovementJob = new MovementWorkItem(frames, numSteps, mPhysicsDt, interpolationFactor, mCollisionWorld, mMovementWorkQueue);
+            mMovementWorkQueue->addWorkItem(mMovementJob, SceneUtil::WorkItem::Priority_High);
+        }
+        else if (mMovementWorkQueue)
+        {
+            if (numSteps)
             {
-                position = MovementSolver::move(position, physicActor->getPtr(), physicActor, iter->second, mPhysicsDt,
-                                                flying, waterlevel, slowFall, mCollisionWorld, mStandingCollisions);
-                if (position != physicActor->getPosition())
-                    positionChanged = true;
-                physicActor->setPosition(position); // always set even if unchanged to make sure interpolation is correct
+                // Collision events should be available on every frame
+                mStandingCollisions.clear();
             }
-            if (positionChanged)
-                mCollisionWorld->updateSingleAabb(physicActor->getCollisionObject());
-
-            float interpolationFactor = mTimeAccum / mPhysicsDt;
-            osg::Vec3f interpolated = position * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
 
-            float heightDiff = position.z() - oldHeight;
+            // Every actor collides against the others where they were at the start of the frame, so the result
+            // does not depend on which thread gets to which actor first. Nothing moves until all are solved.
+            solveActorsMovement(frames, numSteps, mPhysicsDt, mCollisionWorld, mMovementWorkQueue);
 
-            MWMechanics::CreatureStats& stats = iter->first.getClass().getCreatureStats(iter->first);
-            if ((wasOnGround && physicActor->getOnGround()) || flying || world->isSwimming(iter->first) || slowFall < 1)
-                stats.land();
-            else if (heightDiff < 0)
-                stats.addToFallHeight(-heightDiff);
+            for (std::vector<ActorFrame>::iterator it = frames.begin(); it != frames.end(); ++it)
+                commitActorMovement(*it, numSteps, interpolationFactor, mMovementResults);
+        }
+        else
+        {
+            if (numSteps)
+            {
+                // Collision events should be available on every frame
+                mStandingCollisions.clear();
+            }
 
-            mMovementResults.push_back(std::make_pair(iter->first, interpolated));
+            // Each actor collides against the ones before it where they just moved to
+            for (std::vector<ActorFrame>::iterator it = frames.begin(); it != frames.end(); ++it)
+            {
+                solveActorMovement(*it, numSteps, mPhysicsDt, mCollisionWorld);
+                commitActorMovement(*it, numSteps, interpolationFactor, mMovementResults);
+            }
         }
 
         mMovementQueue.clear();
@@ -1487,8 +1882,105 @@ namespace MWPhysics
         return mMovementResults;
     }
 
+    void PhysicsSystem::syncMovement()
+    {
+        if (!mMovementJob)
+            return;
+
+        osg::ref_ptr<MovementWorkItem> job = mMovementJob;
+        mMovementJob = NULL;
+        job->waitTillDone();
+
+        if (job->mNumSteps)
+        {
+            // Collision events should be available on every frame
+            mStandingCollisions.clear();
+        }
+
+        // Anything that removes actors syncs first, so they are all still there
+        for (std::vector<ActorFrame>::iterator it = job->mFrames.begin(); it != job->mFrames.end(); ++it)
+            commitActorMovement(*it, job->mNumSteps, job->mInterpolationFactor, mAsyncResults);
+    }
+
+    void PhysicsSystem::waitForMovement() const
+    {
+        // A thread safe Bullet lets any number of threads read the collision world at once
+        if (mMovementJob && !mThreadSafeBullet)
+            mMovementJob->waitTillDone();
+    }
+
+    void PhysicsSystem::removeAsyncResult(const MWWorld::Ptr& ptr)
+    {
+        for (PtrVelocityList::iterator it = mAsyncResults.begin(); it != mAsyncResults.end(); )
+        {
+            if (it->first == ptr)
+                it = mAsyncResults.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void PhysicsSystem::commitActorMovement(const ActorFrame& frame, int numSteps, float interpolationFactor, PtrVelocityList& results)
+    {
+        Actor* physicActor = frame.mActor;
+        float oldHeight = physicActor->getPosition().z();
+
+        if (numSteps > 0)
+        {
+            // Two steps, so that the previous position is where the last substep started, for the interpolation
+            physicActor->setPosition(frame.mPreviousStepPosition);
+            physicActor->setPosition(frame.mPosition);
+
+            if (frame.mIsMobile)
+            {
+                physicActor->setWalkingOnWater(frame.mWalkingOnWater);
+                if (physicActor->getCollisionMode())
+                {
+                    physicActor->setInertialForce(frame.mInertia);
+                    physicActor->setOnGround(frame.mOnGround);
+                    physicActor->setOnSlope(frame.mOnSlope);
+                }
+            }
+        }
+        if (frame.mPositionChanged)
+            mCollisionWorld->updateSingleAabb(physicActor->getCollisionObject());
+
+        if (!frame.mStandingOn.isEmpty())
+            mStandingCollisions[frame.mPtr] = frame.mStandingOn;
+
+        osg::Vec3f interpolated = physicActor->getPosition() * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
+
+        float heightDiff = physicActor->getPosition().z() - oldHeight;
+
+        const MWBase::World *world = MWBase::Environment::get().getWorld();
+        MWMechanics::CreatureStats& stats = frame.mPtr.getClass().getCreatureStats(frame.mPtr);
+        if ((frame.mWasOnGround && physicActor->getOnGround()) || frame.mFlying || world->isSwimming(frame.mPtr) || frame.mSlowFall < 1)
+            stats.land();
+        else if (heightDiff < 0)
+            stats.addToFallHeight(-heightDiff);
+
+        results.push_back(std::make_pair(frame.mPtr, interpolated));
+    }
+
     void PhysicsSystem::stepSimulation(float dt)
     {
+        syncMovement();
+
+        mTime += dt;
+        for (LineOfSightCache::iterator it = mLineOfSightCache.begin(); it != mLineOfSightCache.end(); )
+        {
+            if (mTime - it->second.mTime > mLineOfSightCacheTime)
+                it = mLineOfSightCache.erase(it);
+            else
+                ++it;
+        }
+
+        // The mechanics update that asks for lines of sight comes before the physics in a frame
+        mLastLineOfSightQueries = mLineOfSightQueries;
+        mLastLineOfSightHits = mLineOfSightHits;
+        mLastLineOfSightRays = mLineOfSightRays;
+        mLineOfSightQueries = mLineOfSightHits = mLineOfSightRays = 0;
+
         for (std::set<Object*>::iterator it = mAnimatedObjects.begin(); it != mAnimatedObjects.end(); ++it)
             (*it)->animateCollisionShapes(mCollisionWorld);
 
@@ -1500,6 +1992,7 @@ namespace MWPhysics
 
     void PhysicsSystem::debugDraw()
     {
+        waitForMovement();
         if (mDebugDrawer.get())
             mDebugDrawer->step();
     }
@@ -1537,6 +2030,7 @@ namespace MWPhysics
 
     void PhysicsSystem::disableWater()
     {
+        syncMovement();
         if (mWaterEnabled)
         {
             mWaterEnabled = false;
@@ -1546,6 +2040,7 @@ namespace MWPhysics
 
     void PhysicsSystem::enableWater(float height)
     {
+        syncMovement();
         if (!mWaterEnabled || mWaterHeight != height)
         {
             mWaterEnabled = true;
@@ -1556,6 +2051,7 @@ namespace MWPhysics
 
     void PhysicsSystem::setWaterHeight(float height)
     {
+        syncMovement();
         if (mWaterHeight != height)
         {
             mWaterHeight = height;
@@ -16,6 +16,7 @@ namespace osg
 {
     class Group;
     class Object;
+    class Stats;
 }
 
 namespace MWRender
@@ -32,6 +33,7 @@ namespace Resource
 namespace SceneUtil
 {
     class UnrefQueue;
+    class WorkQueue;
 }
 
 class btCollisionWorld;
@@ -48,6 +50,9 @@ namespace MWPhysics
     class HeightField;
     class Object;
     class Actor;
+    struct ActorFrame;
+    class MovementWorkItem;
+    class Navigation;
 
     class PhysicsSystem
     {
@@ -85,11 +90,34 @@ namespace MWPhysics
 
             void removeHeightField (int x, int y);
 
+            /// Build navigation grids for the cells added with addNavigationCell(), see Navigation.
+            /// @param cacheDirectory Where to keep the grids between runs. Empty to build them on every load.
+            void enableNavigation(const std::string& cacheDirectory);
+
+            /// Start building the navigation grid of \a cell from the static objects and terrain it has now.
+            /// Call once the objects of the cell are added. Does nothing unless navigation is enabled.
+            void addNavigationCell(const MWWorld::CellStore* cell);
+
+            void removeNavigationCell(const MWWorld::CellStore* cell);
+
+            /// Find a path from \a start to \a end on the navigation grid of \a cell.
+            /// @param path Receives the points to walk through after \a start, excluding \a end itself.
+            /// @return false if navigation is disabled, the grid is not built yet, or it has no such path.
+            bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                    std::vector<osg::Vec3f>& path) const;
+
             bool toggleCollisionMode();
 
             void stepSimulation(float dt);
             void debugDraw();
 
+            /// Wait for the actor movement solved in the background, if any, and move the actors accordingly.
+            /// Their new positions are returned by the next applyQueuedMovement().
+            /// @note Everything that changes the collision world or the physics actors calls this first. Queries such as
+            /// castRay() and getHitContact() do not, they see the actors where they were before. They only wait for the
+            /// solving to finish if Bullet was built without BT_THREADSAFE.
+            void syncMovement();
+
             std::vector<MWWorld::Ptr> getCollisions(const MWWorld::ConstPtr &ptr, int collisionGroup, int collisionMask) const; ///< get handles this object collides with
             osg::Vec3f traceDown(const MWWorld::Ptr &ptr, const osg::Vec3f& position, float maxHeight);
 
@@ -121,8 +149,15 @@ namespace MWPhysics
             RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius);
 
             /// Return true if actor1 can see actor2.
+            /// @note The result is cached for a short time, or until either actor moves. Both orders of a pair share one result.
             bool getLineOfSight(const MWWorld::ConstPtr& actor1, const MWWorld::ConstPtr& actor2) const;
 
+            /// Cast the rays for the pairs of actors whose line of sight is not cached yet, in parallel on the movement
+            /// worker threads, so that the getLineOfSight() calls for them that follow in this frame are cache hits.
+            /// @note Does nothing unless actor movement is solved on worker threads, since the rays would only be cast
+            /// on the main thread either way, and possibly for pairs that are never asked about.
+            void prefetchLineOfSight(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& pairs);
+
             bool isOnGround (const MWWorld::Ptr& actor);
 
             bool canMoveToWaterSurface (const MWWorld::ConstPtr &actor, const float waterlevel);
@@ -142,6 +177,8 @@ namespace MWPhysics
             void queueObjectMovement(const MWWorld::Ptr &ptr, const osg::Vec3f &velocity);
 
             /// Apply all queued movements, then clear the list.
+            /// @note With async movement, the movement is solved in the background while the frame goes on,
+            /// and the results are those of the movement queued for the previous frame.
             const PtrVelocityList& applyQueuedMovement(float dt);
 
             /// Clear the queued movements list without applying.
@@ -170,6 +207,9 @@ namespace MWPhysics
 
             bool isOnSolidGround (const MWWorld::Ptr& actor) const;
 
+            /// Report the line of sight queries of the last frame and how many of them the cache answered.
+            void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
             /*
                 Start of tes3mp addition
 
@@ -184,6 +224,31 @@ namespace MWPhysics
 
             void updateWater();
 
+            /// Move the actor to where its movement was solved, and add the results of its movement to \a results.
+            void commitActorMovement(const ActorFrame& frame, int numSteps, float interpolationFactor, PtrVelocityList& results);
+
+            /// Wait for the movement solved in the background to stop reading the collision world.
+            void waitForMovement() const;
+
+            void removeAsyncResult(const MWWorld::Ptr& ptr);
+
+            // Ordered by address, so that both orders of a pair find the same entry
+            typedef std::pair<const Actor*, const Actor*> LineOfSightKey;
+
+            struct LineOfSight
+            {
+                // Eye positions of the actors in the key when the ray was cast
+                osg::Vec3f mFrom;
+                osg::Vec3f mTo;
+                double mTime;
+                bool mVisible;
+            };
+
+            /// @return NULL unless there is a result for these eye positions that has not expired yet.
+            const LineOfSight* findLineOfSight(const LineOfSightKey& key, const osg::Vec3f& from, const osg::Vec3f& to) const;
+
+            void removeLineOfSight(const Actor* actor);
+
             osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
             btBroadphaseInterface* mBroadphase;
@@ -205,6 +270,9 @@ namespace MWPhysics
             typedef std::map<std::pair<int, int>, HeightField*> HeightFieldMap;
             HeightFieldMap mHeightFields;
 
+            // NULL unless navigation is enabled
+            std::unique_ptr<Navigation> mNavigation;
+
             bool mDebugDrawEnabled;
 
             // Tracks standing collisions happening during a single frame. <actor handle, collided handle>
@@ -218,6 +286,29 @@ namespace MWPhysics
             PtrVelocityList mMovementQueue;
             PtrVelocityList mMovementResults;
 
+            // Solves actor movement in parallel or in the background, NULL to solve on the main thread
+            osg::ref_ptr<SceneUtil::WorkQueue> mMovementWorkQueue;
+            bool mThreadSafeBullet;
+
+            // Solve actor movement in the background while the frame goes on
+            bool mAsyncMovement;
+            osg::ref_ptr<MovementWorkItem> mMovementJob;
+            // Committed by syncMovement(), returned by the next applyQueuedMovement()
+            PtrVelocityList mAsyncResults;
+
+            typedef std::map<LineOfSightKey, LineOfSight> LineOfSightCache;
+            mutable LineOfSightCache mLineOfSightCache;
+            float mLineOfSightCacheTime;
+            double mTime;
+
+            // Counted for this frame, moved to the last frame by stepSimulation()
+            mutable unsigned int mLineOfSightQueries;
+            mutable unsigned int mLineOfSightHits;
+            mutable unsigned int mLineOfSightRays;
+            unsigned int mLastLineOfSightQueries;
+            unsigned int mLastLineOfSightHits;
+            unsigned int mLastLineOfSightRays;
+
             float mTimeAccum;
 
             float mWaterHeight;
@@ -26,6 +26,7 @@
 #include <components/resource/imagemanager.hpp>
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/keyframemanager.hpp>
+#include <components/resource/loadqueue.hpp>
 #include <components/shader/shadermanager.hpp>
 
 #include <components/settings/settings.hpp>
@@ -35,6 +36,7 @@
 #include <components/sceneutil/statesetupdater.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/workqueue.hpp>
+#include <components/sceneutil/riggeometry.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
 #include <components/sceneutil/writescene.hpp>
 
@@ -192,6 +194,7 @@ namespace MWRender
         , mRootNode(rootNode)
         , mResourceSystem(resourceSystem)
         , mWorkQueue(workQueue)
+        , mLoadQueue(new Resource::LoadQueue(resourceSystem, workQueue))
         , mUnrefQueue(new SceneUtil::UnrefQueue)
         , mLandFogStart(0.f)
         , mLandFogEnd(std::numeric_limits<float>::max())
@@ -218,6 +221,13 @@ namespace MWRender
         resourceSystem->getSceneManager()->setAutoUseSpecularMaps(Settings::Manager::getBool("auto use object specular maps", "Shaders"));
         resourceSystem->getSceneManager()->setSpecularMapPattern(Settings::Manager::getString("specular map pattern", "Shaders"));
 
+        int numSkinningThreads = Settings::Manager::getInt("skinning threads", "General");
+        if (numSkinningThreads > 0)
+        {
+            mSkinningQueue = new SceneUtil::WorkQueue(numSkinningThreads);
+            SceneUtil::RigGeometry::setWorkQueue(mSkinningQueue.get());
+        }
+
         osg::ref_ptr<SceneUtil::LightManager> sceneRoot = new SceneUtil::LightManager;
         sceneRoot->setLightingMask(Mask_Lighting);
         mSceneRoot = sceneRoot;
@@ -333,7 +343,14 @@ namespace MWRender
     RenderingManager::~RenderingManager()
     {
         // let background loading thread finish before we delete anything else
+        mLoadQueue = NULL;
         mWorkQueue = NULL;
+
+        if (mSkinningQueue)
+        {
+            SceneUtil::RigGeometry::setWorkQueue(NULL);
+            mSkinningQueue = NULL;
+        }
     }
 
     MWRender::Objects& RenderingManager::getObjects()
@@ -351,6 +368,11 @@ namespace MWRender
         return mWorkQueue.get();
     }
 
+    Resource::LoadQueue* RenderingManager::getLoadQueue()
+    {
+        return mLoadQueue.get();
+    }
+
     SceneUtil::UnrefQueue* RenderingManager::getUnrefQueue()
     {
         return mUnrefQueue.get();
@@ -27,6 +27,7 @@ namespace osgUtil
 namespace Resource
 {
     class ResourceSystem;
+    class LoadQueue;
 }
 
 namespace osgViewer
@@ -81,6 +82,7 @@ namespace MWRender
         Resource::ResourceSystem* getResourceSystem();
 
         SceneUtil::WorkQueue* getWorkQueue();
+        Resource::LoadQueue* getLoadQueue();
         SceneUtil::UnrefQueue* getUnrefQueue();
         Terrain::World* getTerrain();
 
@@ -229,6 +231,8 @@ namespace MWRender
         Resource::ResourceSystem* mResourceSystem;
 
         osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        osg::ref_ptr<SceneUtil::WorkQueue> mSkinningQueue;
+        osg::ref_ptr<Resource::LoadQueue> mLoadQueue;
         osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
         osg::ref_ptr<osg::Light> mSunLight;
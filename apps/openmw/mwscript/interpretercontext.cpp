@@ -225,16 +225,13 @@ namespace MWScript
         /*
             Start of tes3mp addition
 
-            Send an ID_SCRIPT_LOCAL_SHORT packet every time a local short changes its value
-            in a script approved for packet sending
+            Queue the new value of a local short for the next ID_SCRIPT_STATE packet every time
+            it is set in a script approved for packet sending
         */
         if (sendPackets)
         {
-            mwmp::ObjectList *objectList = mwmp::Main::get().getNetworking()->getObjectList();
-            objectList->reset();
-            objectList->packetOrigin = ScriptController::getPacketOriginFromContextType(getContextType());
-            objectList->addScriptLocalShort(mReference, index, value);
-            objectList->sendScriptLocalShort();
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->addLocalShort(mReference, index, value,
+                ScriptController::getPacketOriginFromContextType(getContextType()));
         }
         /*
             End of tes3mp addition
@@ -259,17 +256,14 @@ namespace MWScript
         /*
             Start of tes3mp addition
 
-            Send an ID_SCRIPT_LOCAL_FLOAT packet every time a local float changes its value
-            to one without decimals (to avoid packet spam for timers) in a script approved
+            Queue the new value of a local float for the next ID_SCRIPT_STATE packet every time
+            it is set to one without decimals (to avoid packet spam for timers) in a script approved
             for packet sending
         */
         if (sendPackets && value == (int) value)
         {
-            mwmp::ObjectList *objectList = mwmp::Main::get().getNetworking()->getObjectList();
-            objectList->reset();
-            objectList->packetOrigin = ScriptController::getPacketOriginFromContextType(getContextType());
-            objectList->addScriptLocalFloat(mReference, index, value);
-            objectList->sendScriptLocalFloat();
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->addLocalFloat(mReference, index, value,
+                ScriptController::getPacketOriginFromContextType(getContextType()));
         }
         /*
             End of tes3mp addition
@@ -324,16 +318,13 @@ namespace MWScript
         /*
             Start of tes3mp addition
 
-            Send an ID_SCRIPT_GLOBAL_SHORT packet every time a global short changes its value
-            in a script approved for packet sending
+            Queue the new value of a global short for the next ID_SCRIPT_STATE packet every time
+            it is set in a script approved for packet sending
         */
         if (sendPackets)
         {
-            mwmp::ObjectList *objectList = mwmp::Main::get().getNetworking()->getObjectList();
-            objectList->reset();
-            objectList->packetOrigin = ScriptController::getPacketOriginFromContextType(getContextType());
-            objectList->addScriptGlobalShort(name, value);
-            objectList->sendScriptGlobalShort();
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->addGlobalShort(name, value,
+                ScriptController::getPacketOriginFromContextType(getContextType()));
         }
         /*
             End of tes3mp addition
@@ -733,16 +724,13 @@ namespace MWScript
         /*
             Start of tes3mp addition
 
-            Send an ID_SCRIPT_MEMBER_SHORT packet every time a member short changes its value
-            in a script approved for packet sending
+            Queue the new value of a member short for the next ID_SCRIPT_STATE packet every time
+            it is set in a script approved for packet sending
         */
         if (sendPackets && !global)
         {
-            mwmp::ObjectList *objectList = mwmp::Main::get().getNetworking()->getObjectList();
-            objectList->reset();
-            objectList->packetOrigin = ScriptController::getPacketOriginFromContextType(getContextType());
-            objectList->addScriptMemberShort(id, index, value);
-            objectList->sendScriptMemberShort();
+            mwmp::Main::get().getNetworking()->getScriptStateSync()->addMemberShort(id, index, value,
+                ScriptController::getPacketOriginFromContextType(getContextType()));
         }
         /*
             End of tes3mp addition
@@ -0,0 +1,99 @@
+#include "cellprediction.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace
+{
+    // Teleports from other cells than the current one count this much to where the next one goes
+    const float sElsewhereWeight = 0.5f;
+
+    struct CompareScore
+    {
+        bool operator() (const MWWorld::CellPrediction::Destination& left, const MWWorld::CellPrediction::Destination& right) const
+        {
+            return left.mScore > right.mScore;
+        }
+    };
+}
+
+namespace MWWorld
+{
+
+    CellPrediction::CellPrediction(unsigned int historySize)
+        : mHistorySize(historySize)
+    {
+    }
+
+    float CellPrediction::getApproachScore(const osg::Vec3f& position, const osg::Vec3f& velocity, float time,
+                                           const osg::Vec3f& target, float distance)
+    {
+        if (distance <= 0)
+            return 0.f;
+
+        // The point of the path over the next \a time seconds that is closest to the target
+        const osg::Vec3f path = velocity * time;
+        const float pathLength2 = path.length2();
+        float along = 0.f;
+        if (pathLength2 > 0)
+            along = std::min(std::max(((target - position) * path) / pathLength2, 0.f), 1.f);
+        const osg::Vec3f closest = position + path * along;
+
+        return std::max(1.f - (target - closest).length() / distance, 0.f);
+    }
+
+    void CellPrediction::recordTeleport(CellStore* from, CellStore* to, const osg::Vec3f& position)
+    {
+        if (!from || mHistorySize == 0)
+            return;
+
+        Teleport teleport;
+        teleport.mFrom = from;
+        teleport.mTo = to;
+        teleport.mPosition = position;
+        mHistory.push_back(teleport);
+
+        while (mHistory.size() > mHistorySize)
+            mHistory.pop_front();
+    }
+
+    void CellPrediction::getLikelyDestinations(CellStore* current, std::vector<Destination>& destinations) const
+    {
+        std::map<CellStore*, size_t> indices;
+        float totalWeight = 0.f;
+
+        // Newest first, so that each destination gets the position of the last teleport into it
+        for (std::deque<Teleport>::const_reverse_iterator it = mHistory.rbegin(); it != mHistory.rend(); ++it)
+        {
+            const float weight = it->mFrom == current ? 1.f : sElsewhereWeight;
+            totalWeight += weight;
+
+            if (it->mTo == current)
+                continue;
+
+            std::map<CellStore*, size_t>::const_iterator found = indices.find(it->mTo);
+            if (found == indices.end())
+            {
+                Destination destination;
+                destination.mCell = it->mTo;
+                destination.mPosition = it->mPosition;
+                destination.mScore = weight;
+                indices[it->mTo] = destinations.size();
+                destinations.push_back(destination);
+            }
+            else
+                destinations[found->second].mScore += weight;
+        }
+
+        for (std::vector<Destination>::iterator it = destinations.begin(); it != destinations.end(); ++it)
+            it->mScore /= totalWeight;
+
+        std::stable_sort(destinations.begin(), destinations.end(), CompareScore());
+    }
+
+    void CellPrediction::clear()
+    {
+        mHistory.clear();
+    }
+
+}
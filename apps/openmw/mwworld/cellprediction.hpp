@@ -0,0 +1,62 @@
+#ifndef GAME_MWWORLD_CELLPREDICTION_H
+#define GAME_MWWORLD_CELLPREDICTION_H
+
+#include <deque>
+#include <vector>
+
+#include <osg/Vec3f>
+
+namespace MWWorld
+{
+    class CellStore;
+
+    /// @brief Scores how likely the player is to enter a cell soon, from 0 for unlikely to 1 for certain.
+    /// @par The scores rank preload requests in CellPreloader, which keeps the cells with the best scores when its
+    /// cache is full. Teleports that no door or travel service in reach hints at, like Mark and Recall, scripted
+    /// or server-driven teleports, are predicted from where the last teleports went.
+    class CellPrediction
+    {
+    public:
+        struct Destination
+        {
+            CellStore* mCell;
+            osg::Vec3f mPosition; // Where the last teleport into the cell went
+            float mScore;
+        };
+
+        /// @param historySize The number of teleports to remember.
+        explicit CellPrediction(unsigned int historySize);
+
+        /// Score a cell that is entered at \a target, for a player at \a position moving at \a velocity.
+        /// @return 1 if the player is at \a target, down to 0 if they won't get within \a distance of it in the
+        /// next \a time seconds. Targets ahead of the player score higher than those as far behind.
+        static float getApproachScore(const osg::Vec3f& position, const osg::Vec3f& velocity, float time,
+                                      const osg::Vec3f& target, float distance);
+
+        /// Remember that the player was teleported from \a from to \a position in \a to.
+        /// @param from NULL when the player was not in a cell before, which is not remembered.
+        void recordTeleport(CellStore* from, CellStore* to, const osg::Vec3f& position);
+
+        /// Get the cells that recent teleports went to other than \a current, best score first. Teleports out of
+        /// \a current count the most, those from anywhere else half as much.
+        void getLikelyDestinations(CellStore* current, std::vector<Destination>& destinations) const;
+
+        /// Forget all teleports, for when the cells are gone.
+        void clear();
+
+    private:
+        struct Teleport
+        {
+            CellStore* mFrom;
+            CellStore* mTo;
+            osg::Vec3f mPosition;
+        };
+
+        unsigned int mHistorySize;
+
+        // Oldest first
+        std::deque<Teleport> mHistory;
+    };
+}
+
+#endif
@@ -1,11 +1,14 @@
 #include "cellpreloader.hpp"
 
+#include <algorithm>
+#include <cfloat>
 #include <iostream>
 
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/bulletshapemanager.hpp>
 #include <components/resource/keyframemanager.hpp>
+#include <components/resource/loadqueue.hpp>
 #include <components/misc/resourcehelpers.hpp>
 #include <components/misc/stringops.hpp>
 #include <components/nifosg/nifloader.hpp>
@@ -23,6 +26,17 @@
 #include "manualref.hpp"
 #include "class.hpp"
 
+namespace
+{
+    // A cell in a full cache is only replaced by one that is this much more likely to be needed, so that cells
+    // of about the same score don't keep replacing each other
+    const float sReplaceMargin = 0.1f;
+
+    // Cells are kept for at least this fraction of the expiry delay, however unlikely they are to be needed, so
+    // that cells that are preloaded again and again are not thrown out in between
+    const float sMinKeepScore = 0.2f;
+}
+
 namespace MWWorld
 {
 
@@ -43,48 +57,27 @@ namespace MWWorld
         std::vector<std::string>& mOut;
     };
 
-    /// Worker thread item: preload models in a cell.
+    /// Worker thread item: preload the terrain of a cell. Holds on to the load requests for the models of the
+    /// cell, to keep them in the cache as long as the cell is in the preloaded state.
     class PreloadItem : public SceneUtil::WorkItem
     {
     public:
         /// Constructor to be called from the main thread.
-        PreloadItem(MWWorld::CellStore* cell, Resource::SceneManager* sceneManager, Resource::BulletShapeManager* bulletShapeManager, Resource::KeyframeManager* keyframeManager, Terrain::World* terrain, MWRender::LandManager* landManager, bool preloadInstances)
+        PreloadItem(MWWorld::CellStore* cell, Terrain::World* terrain, MWRender::LandManager* landManager, const std::vector<osg::ref_ptr<Resource::LoadRequest> >& requests)
             : mIsExterior(cell->getCell()->isExterior())
             , mX(cell->getCell()->getGridX())
             , mY(cell->getCell()->getGridY())
-            , mSceneManager(sceneManager)
-            , mBulletShapeManager(bulletShapeManager)
-            , mKeyframeManager(keyframeManager)
             , mTerrain(terrain)
             , mLandManager(landManager)
-            , mPreloadInstances(preloadInstances)
-            , mAbort(false)
+            , mRequests(requests)
         {
             mTerrainView = mTerrain->createView();
-
-            ListModelsVisitor visitor (mMeshes);
-            if (cell->getState() == MWWorld::CellStore::State_Loaded)
-            {
-                cell->forEach(visitor);
-            }
-            else
-            {
-                const std::vector<std::string>& objectIds = cell->getPreloadedIds();
-
-                // could possibly build the model list in the worker thread if we manage to make the Store thread safe
-                for (std::vector<std::string>::const_iterator it = objectIds.begin(); it != objectIds.end(); ++it)
-                {
-                    MWWorld::ManualRef ref(MWBase::Environment::get().getWorld()->getStore(), *it);
-                    std::string model = ref.getPtr().getClass().getModel(ref.getPtr());
-                    if (!model.empty())
-                        mMeshes.push_back(model);
-                }
-            }
         }
 
         virtual void abort()
         {
-            mAbort = true;
+            for (std::vector<osg::ref_ptr<Resource::LoadRequest> >::const_iterator it = mRequests.begin(); it != mRequests.end(); ++it)
+                (*it)->abort();
         }
 
         /// Preload work to be called from the worker thread.
@@ -95,77 +88,30 @@ namespace MWWorld
                 try
                 {
                     mTerrain->cacheCell(mTerrainView.get(), mX, mY);
-                    mPreloadedObjects.push_back(mLandManager->getLand(mX, mY));
+                    mPreloadedLand = mLandManager->getLand(mX, mY);
                 }
                 catch(std::exception& e)
                 {
                 }
             }
 
-            for (MeshList::const_iterator it = mMeshes.begin(); it != mMeshes.end(); ++it)
-            {
-                if (mAbort)
-                    break;
-
-                try
-                {
-                    std::string mesh  = *it;
-                    mesh = Misc::ResourceHelpers::correctActorModelPath(mesh, mSceneManager->getVFS());
-
-                    if (mPreloadInstances)
-                    {
-                        mPreloadedObjects.push_back(mSceneManager->cacheInstance(mesh));
-                        mPreloadedObjects.push_back(mBulletShapeManager->cacheInstance(mesh));
-                    }
-                    else
-                    {
-                        mPreloadedObjects.push_back(mSceneManager->getTemplate(mesh));
-                        mPreloadedObjects.push_back(mBulletShapeManager->getShape(mesh));
-                    }
-
-                    size_t slashpos = mesh.find_last_of("/\\");
-                    if (slashpos != std::string::npos && slashpos != mesh.size()-1)
-                    {
-                        Misc::StringUtils::lowerCaseInPlace(mesh);
-                        if (mesh[slashpos+1] == 'x')
-                        {
-                            std::string kfname = mesh;
-                            if(kfname.size() > 4 && kfname.compare(kfname.size()-4, 4, ".nif") == 0)
-                            {
-                                kfname.replace(kfname.size()-4, 4, ".kf");
-                                mPreloadedObjects.push_back(mKeyframeManager->get(kfname));
-                            }
-
-                        }
-                    }
-                }
-                catch (std::exception& e)
-                {
-                    // ignore error for now, would spam the log too much
-                    // error will be shown when visiting the cell
-                }
-            }
+            // Help with the models, so the cell is fully preloaded once this item is done. Returns right
+            // away for aborted requests, so waitTillDone() ensures that none of them is still loading.
+            for (std::vector<osg::ref_ptr<Resource::LoadRequest> >::const_iterator it = mRequests.begin(); it != mRequests.end(); ++it)
+                (*it)->wait();
         }
 
     private:
-        typedef std::vector<std::string> MeshList;
         bool mIsExterior;
         int mX;
         int mY;
-        MeshList mMeshes;
-        Resource::SceneManager* mSceneManager;
-        Resource::BulletShapeManager* mBulletShapeManager;
-        Resource::KeyframeManager* mKeyframeManager;
         Terrain::World* mTerrain;
         MWRender::LandManager* mLandManager;
-        bool mPreloadInstances;
-
-        volatile bool mAbort;
 
         osg::ref_ptr<Terrain::View> mTerrainView;
 
-        // keep a ref to the loaded objects to make sure it stays loaded as long as this cell is in the preloaded state
-        std::vector<osg::ref_ptr<const osg::Object> > mPreloadedObjects;
+        std::vector<osg::ref_ptr<Resource::LoadRequest> > mRequests;
+        osg::ref_ptr<const osg::Object> mPreloadedLand;
     };
 
     /// Worker thread item: update the resource system's cache, effectively deleting unused entries.
@@ -188,6 +134,14 @@ namespace MWWorld
         Resource::ResourceSystem* mResourceSystem;
     };
 
+    CellPreloader::Stats::Stats()
+        : mCells(0)
+        , mHits(0)
+        , mLate(0)
+        , mMisses(0)
+    {
+    }
+
     CellPreloader::CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain, MWRender::LandManager* landManager)
         : mResourceSystem(resourceSystem)
         , mBulletShapeManager(bulletShapeManager)
@@ -217,7 +171,7 @@ namespace MWWorld
         }
 
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
-            it->second.mWorkItem->abort();
+            it->second.mWorkItem->cancel();
 
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
             it->second.mWorkItem->waitTillDone();
@@ -225,9 +179,9 @@ namespace MWWorld
         mPreloadCells.clear();
     }
 
-    void CellPreloader::preload(CellStore *cell, double timestamp)
+    void CellPreloader::preload(CellStore *cell, double timestamp, float score)
     {
-        if (!mWorkQueue)
+        if (!mWorkQueue || !mLoadQueue)
         {
             std::cerr << "Error: can't preload, no work queue set " << std::endl;
             return;
@@ -241,50 +195,148 @@ namespace MWWorld
         PreloadMap::iterator found = mPreloadCells.find(cell);
         if (found != mPreloadCells.end())
         {
-            // already preloaded, nothing to do other than updating the timestamp
+            // already preloaded, nothing to do other than updating the prediction, the best one if the cell is
+            // requested several times at once
+            if (found->second.mTimeStamp != timestamp || found->second.mScore < score)
+                found->second.mScore = score;
             found->second.mTimeStamp = timestamp;
             return;
         }
 
         while (mPreloadCells.size() >= mMaxCacheSize)
         {
-            // throw out oldest cell to make room
-            PreloadMap::iterator oldestCell = mPreloadCells.begin();
-            double oldestTimestamp = DBL_MAX;
-            double threshold = 1.0; // seconds
+            // throw out the cell least likely to be needed to make room
+            PreloadMap::iterator leastLikely = mPreloadCells.begin();
+            float leastReuse = FLT_MAX;
             for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end(); ++it)
             {
-                if (it->second.mTimeStamp < oldestTimestamp)
+                float reuse = getPredictedReuse(it->second, timestamp);
+                if (reuse < leastReuse)
                 {
-                    oldestTimestamp = it->second.mTimeStamp;
-                    oldestCell = it;
+                    leastReuse = reuse;
+                    leastLikely = it;
                 }
             }
 
-            if (oldestTimestamp + threshold < timestamp)
+            if (leastReuse + sReplaceMargin < score)
             {
-                oldestCell->second.mWorkItem->abort();
-                mPreloadCells.erase(oldestCell);
+                leastLikely->second.mWorkItem->cancel();
+                mPreloadCells.erase(leastLikely);
             }
             else
                 return;
         }
 
-        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mLandManager, mPreloadInstances));
+        std::vector<osg::ref_ptr<Resource::LoadRequest> > requests;
+        requestModels(cell, Resource::Priority_Preload, mPreloadInstances, requests);
+
+        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mTerrain, mLandManager, requests));
         mWorkQueue->addWorkItem(item);
 
-        mPreloadCells[cell] = PreloadEntry(timestamp, item);
+        mPreloadCells[cell] = PreloadEntry(timestamp, score, item);
+    }
+
+    void CellPreloader::loadModels(CellStore *cell)
+    {
+        if (!mLoadQueue)
+            return;
+
+        // The instances are about to be created by the cell itself, caching more of them would leave them unused
+        std::vector<osg::ref_ptr<Resource::LoadRequest> > requests;
+        requestModels(cell, Resource::Priority_Visible, false, requests);
+
+        for (std::vector<osg::ref_ptr<Resource::LoadRequest> >::const_iterator it = requests.begin(); it != requests.end(); ++it)
+            (*it)->wait();
+    }
+
+    void CellPreloader::requestModels(CellStore *cell)
+    {
+        if (!mLoadQueue)
+            return;
+
+        std::vector<osg::ref_ptr<Resource::LoadRequest> > requests;
+        requestModels(cell, Resource::Priority_Visible, false, requests);
+    }
+
+    void CellPreloader::requestModels(CellStore *cell, Resource::LoadPriority priority, bool preloadInstances, std::vector<osg::ref_ptr<Resource::LoadRequest> >& requests)
+    {
+        std::vector<std::string> meshes;
+        ListModelsVisitor visitor (meshes);
+        if (cell->getState() == MWWorld::CellStore::State_Loaded)
+        {
+            cell->forEach(visitor);
+        }
+        else
+        {
+            const std::vector<std::string>& objectIds = cell->getPreloadedIds();
+
+            // could possibly build the model list in the worker thread if we manage to make the Store thread safe
+            for (std::vector<std::string>::const_iterator it = objectIds.begin(); it != objectIds.end(); ++it)
+            {
+                MWWorld::ManualRef ref(MWBase::Environment::get().getWorld()->getStore(), *it);
+                std::string model = ref.getPtr().getClass().getModel(ref.getPtr());
+                if (!model.empty())
+                    meshes.push_back(model);
+            }
+        }
+
+        Resource::BulletShapeManager* bulletShapeManager = mBulletShapeManager;
+
+        for (std::vector<std::string>::const_iterator it = meshes.begin(); it != meshes.end(); ++it)
+        {
+            std::string mesh = Misc::ResourceHelpers::correctActorModelPath(*it, mResourceSystem->getVFS());
+
+            if (preloadInstances)
+            {
+                requests.push_back(mLoadQueue->requestInstance(mesh, priority));
+                requests.push_back(mLoadQueue->request(std::string(), [bulletShapeManager, mesh] () -> osg::ref_ptr<const osg::Object>
+                {
+                    return bulletShapeManager->cacheInstance(mesh);
+                }, priority));
+            }
+            else
+            {
+                requests.push_back(mLoadQueue->requestTemplate(mesh, priority));
+                requests.push_back(mLoadQueue->request("shape:" + Misc::StringUtils::lowerCase(mesh), [bulletShapeManager, mesh] () -> osg::ref_ptr<const osg::Object>
+                {
+                    return bulletShapeManager->getShape(mesh);
+                }, priority));
+            }
+
+            size_t slashpos = mesh.find_last_of("/\\");
+            if (slashpos != std::string::npos && slashpos != mesh.size()-1)
+            {
+                Misc::StringUtils::lowerCaseInPlace(mesh);
+                if (mesh[slashpos+1] == 'x')
+                {
+                    std::string kfname = mesh;
+                    if(kfname.size() > 4 && kfname.compare(kfname.size()-4, 4, ".nif") == 0)
+                    {
+                        kfname.replace(kfname.size()-4, 4, ".kf");
+                        if (mResourceSystem->getVFS()->exists(kfname))
+                            requests.push_back(mLoadQueue->requestKeyframes(kfname, priority));
+                    }
+                }
+            }
+        }
     }
 
     void CellPreloader::notifyLoaded(CellStore *cell)
     {
         PreloadMap::iterator found = mPreloadCells.find(cell);
+        if (found == mPreloadCells.end())
+            ++mStats.mMisses;
+        else if (!found->second.mWorkItem || found->second.mWorkItem->isDone())
+            ++mStats.mHits;
+        else
+            ++mStats.mLate;
+
         if (found != mPreloadCells.end())
         {
             // do the deletion in the background thread
             if (found->second.mWorkItem)
             {
-                found->second.mWorkItem->abort();
+                found->second.mWorkItem->cancel();
                 mUnrefQueue->push(mPreloadCells[cell].mWorkItem);
             }
 
@@ -298,7 +350,7 @@ namespace MWWorld
         {
             if (it->second.mWorkItem)
             {
-                it->second.mWorkItem->abort();
+                it->second.mWorkItem->cancel();
                 mUnrefQueue->push(it->second.mWorkItem);
             }
 
@@ -310,11 +362,11 @@ namespace MWWorld
     {
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
         {
-            if (mPreloadCells.size() >= mMinCacheSize && it->second.mTimeStamp < timestamp - mExpiryDelay)
+            if (mPreloadCells.size() >= mMinCacheSize && getPredictedReuse(it->second, timestamp) < 0)
             {
                 if (it->second.mWorkItem)
                 {
-                    it->second.mWorkItem->abort();
+                    it->second.mWorkItem->cancel();
                     mUnrefQueue->push(it->second.mWorkItem);
                 }
                 mPreloadCells.erase(it++);
@@ -323,15 +375,25 @@ namespace MWWorld
                 ++it;
         }
 
+        mStats.mCells = mPreloadCells.size();
+
         if (timestamp - mLastResourceCacheUpdate > 1.0 && (!mUpdateCacheItem || mUpdateCacheItem->isDone()))
         {
             // the resource cache is cleared from the worker thread so that we're not holding up the main thread with delete operations
             mUpdateCacheItem = new UpdateCacheItem(mResourceSystem, timestamp);
-            mWorkQueue->addWorkItem(mUpdateCacheItem, true);
+            mWorkQueue->addWorkItem(mUpdateCacheItem, SceneUtil::WorkItem::Priority_High);
             mLastResourceCacheUpdate = timestamp;
         }
     }
 
+    float CellPreloader::getPredictedReuse(const PreloadEntry& entry, double timestamp) const
+    {
+        const double age = timestamp - entry.mTimeStamp;
+        if (mExpiryDelay <= 0)
+            return age > 0 ? -1.f : entry.mScore;
+        return std::max(entry.mScore, sMinKeepScore) - static_cast<float>(age / mExpiryDelay);
+    }
+
     void CellPreloader::setExpiryDelay(double expiryDelay)
     {
         mExpiryDelay = expiryDelay;
@@ -362,6 +424,16 @@ namespace MWWorld
         mWorkQueue = workQueue;
     }
 
+    const CellPreloader::Stats& CellPreloader::getStats() const
+    {
+        return mStats;
+    }
+
+    void CellPreloader::setLoadQueue(Resource::LoadQueue* loadQueue)
+    {
+        mLoadQueue = loadQueue;
+    }
+
     void CellPreloader::setUnrefQueue(SceneUtil::UnrefQueue* unrefQueue)
     {
         mUnrefQueue = unrefQueue;
@@ -5,6 +5,7 @@
 #include <osg/ref_ptr>
 #include <osg/Vec3f>
 #include <components/sceneutil/workqueue.hpp>
+#include <components/resource/loadqueue.hpp>
 
 namespace Resource
 {
@@ -35,21 +36,46 @@ namespace MWWorld
     class CellPreloader
     {
     public:
+        struct Stats
+        {
+            Stats();
+
+            unsigned int mCells; // In the cache
+
+            // Cells loaded since the start, whose objects were preloaded, still being preloaded or not requested
+            unsigned int mHits;
+            unsigned int mLate;
+            unsigned int mMisses;
+        };
+
         CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain, MWRender::LandManager* landManager);
         ~CellPreloader();
 
         /// Ask a background thread to preload rendering meshes and collision shapes for objects in this cell.
+        /// @param score How likely the player is to enter the cell soon, from 0 to 1, see CellPrediction. When the
+        /// cache is full, the cell replaces the one least likely to be needed, if any is clearly less likely.
+        /// @note The cell itself must be in State_Loaded or State_Preloaded.
+        void preload(MWWorld::CellStore* cell, double timestamp, float score);
+
+        /// Load rendering meshes and collision shapes for objects in this cell that are not in the cache yet, and
+        /// wait until they are loaded. They are loaded before any preloading, and by the worker threads and the calling thread together.
         /// @note The cell itself must be in State_Loaded or State_Preloaded.
-        void preload(MWWorld::CellStore* cell, double timestamp);
+        void loadModels(MWWorld::CellStore* cell);
+
+        /// Have the worker threads load rendering meshes and collision shapes for objects in this cell that are not
+        /// in the cache yet, without waiting for them. For cells whose objects are inserted over several frames.
+        /// @note The cell itself must be in State_Loaded or State_Preloaded.
+        void requestModels(MWWorld::CellStore* cell);
 
         void notifyLoaded(MWWorld::CellStore* cell);
 
         void clear();
 
-        /// Removes preloaded cells that have not had a preload request for a while.
+        /// Removes preloaded cells that have not had a preload request for a while, the sooner the less likely
+        /// they were to be needed.
         void updateCache(double timestamp);
 
-        /// How long to keep a preloaded cell in cache after it's no longer requested.
+        /// How long to keep a preloaded cell with a score of 1 in cache after it's no longer requested.
         void setExpiryDelay(double expiryDelay);
 
         /// The minimum number of preloaded cells before unused cells get thrown out.
@@ -65,16 +91,24 @@ namespace MWWorld
 
         void setWorkQueue(osg::ref_ptr<SceneUtil::WorkQueue> workQueue);
 
+        void setLoadQueue(Resource::LoadQueue* loadQueue);
+
         void setUnrefQueue(SceneUtil::UnrefQueue* unrefQueue);
 
         void setTerrainPreloadPositions(const std::vector<osg::Vec3f>& positions);
 
+        const Stats& getStats() const;
+
     private:
+        /// @param preloadInstances Cache instances of the meshes and shapes, rather than only the meshes and shapes.
+        void requestModels(MWWorld::CellStore* cell, Resource::LoadPriority priority, bool preloadInstances, std::vector<osg::ref_ptr<Resource::LoadRequest> >& requests);
+
         Resource::ResourceSystem* mResourceSystem;
         Resource::BulletShapeManager* mBulletShapeManager;
         Terrain::World* mTerrain;
         MWRender::LandManager* mLandManager;
         osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        osg::ref_ptr<Resource::LoadQueue> mLoadQueue;
         osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
         double mExpiryDelay;
         unsigned int mMinCacheSize;
@@ -83,21 +117,30 @@ namespace MWWorld
 
         double mLastResourceCacheUpdate;
 
+        Stats mStats;
+
         struct PreloadEntry
         {
-            PreloadEntry(double timestamp, osg::ref_ptr<SceneUtil::WorkItem> workItem)
+            PreloadEntry(double timestamp, float score, osg::ref_ptr<SceneUtil::WorkItem> workItem)
                 : mTimeStamp(timestamp)
+                , mScore(score)
                 , mWorkItem(workItem)
             {
             }
             PreloadEntry()
                 : mTimeStamp(0.0)
+                , mScore(0.f)
             {
             }
 
             double mTimeStamp;
+            float mScore;
             osg::ref_ptr<SceneUtil::WorkItem> mWorkItem;
         };
+
+        /// The score of the last request for the cell, but at least a fifth, less the fraction of the expiry delay
+        /// since then. Below 0 once the cell is no longer likely to be needed.
+        float getPredictedReuse(const PreloadEntry& entry, double timestamp) const;
         typedef std::map<const MWWorld::CellStore*, PreloadEntry> PreloadMap;
 
         // Cells that are currently being preloaded, or have already finished preloading
@@ -61,7 +61,12 @@ namespace MWWorld
         End of tes3mp addition
     */
 
-    std::string CellRef::getRefId() const
+    const std::string& CellRef::getRefId() const
+    {
+        return mCellRef.mRefID.getSpelling();
+    }
+
+    const ESM::RefId& CellRef::getInternedRefId() const
     {
         return mCellRef.mRefID;
     }
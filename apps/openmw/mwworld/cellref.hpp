@@ -64,7 +64,10 @@ namespace MWWorld
         bool hasContentFile() const;
 
         // Id of object being referenced
-        std::string getRefId() const;
+        const std::string& getRefId() const;
+
+        // Id of object being referenced, for comparisons and lookups
+        const ESM::RefId& getInternedRefId() const;
 
         // For doors - true if this door teleports to somewhere else, false
         // if it should open through animation.
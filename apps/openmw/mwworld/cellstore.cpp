@@ -137,7 +137,7 @@ namespace
         if (!MWWorld::LiveCellRef<T>::checkState (state))
             return; // not valid anymore with current content files -> skip
 
-        const T *record = esmStore.get<T>().search (state.mRef.mRefID);
+        const T *record = esmStore.get<T>().search (state.mRef.mRefID.toString());
 
         if (!record)
             return;
@@ -194,7 +194,7 @@ namespace MWWorld
     {
         const MWWorld::Store<X> &store = esmStore.get<X>();
 
-        if (const X *ptr = store.search (ref.mRefID))
+        if (const X *ptr = store.search (ref.mRefID.toString()))
         {
             typename std::list<LiveRef>::iterator iter =
                 std::find(mList.begin(), mList.end(), ref.mRefNum);
@@ -445,10 +445,10 @@ namespace MWWorld
     struct SearchVisitor
     {
         PtrType mFound;
-        std::string mIdToFind;
+        ESM::RefId mIdToFind;
         bool operator()(const PtrType& ptr)
         {
-            if (ptr.getCellRef().getRefId() == mIdToFind)
+            if (ptr.getCellRef().getInternedRefId() == mIdToFind)
             {
                 mFound = ptr;
                 return false;
@@ -460,7 +460,9 @@ namespace MWWorld
     Ptr CellStore::search (const std::string& id)
     {
         SearchVisitor<MWWorld::Ptr> searchVisitor;
-        searchVisitor.mIdToFind = id;
+        searchVisitor.mIdToFind = ESM::RefId::search(id);
+        if (searchVisitor.mIdToFind.empty())
+            return Ptr(); // no reference has ever used this ID
         forEach(searchVisitor);
         return searchVisitor.mFound;
     }
@@ -468,7 +470,9 @@ namespace MWWorld
     ConstPtr CellStore::searchConst (const std::string& id) const
     {
         SearchVisitor<MWWorld::ConstPtr> searchVisitor;
-        searchVisitor.mIdToFind = id;
+        searchVisitor.mIdToFind = ESM::RefId::search(id);
+        if (searchVisitor.mIdToFind.empty())
+            return ConstPtr(); // no reference has ever used this ID
         forEachConst(searchVisitor);
         return searchVisitor.mFound;
     }
@@ -680,7 +684,7 @@ namespace MWWorld
                         continue;
                     }
 
-                    mIds.push_back (Misc::StringUtils::lowerCase (ref.mRefID));
+                    mIds.push_back (ref.mRefID.toString());
                 }
             }
             catch (std::exception& e)
@@ -696,7 +700,7 @@ namespace MWWorld
             bool deleted = it->second;
 
             if (!deleted)
-                mIds.push_back(Misc::StringUtils::lowerCase(ref.mRefID));
+                mIds.push_back(ref.mRefID.toString());
         }
 
         std::sort (mIds.begin(), mIds.end());
@@ -711,7 +715,7 @@ namespace MWWorld
         if (mCell->mContextList.empty())
             return; // this is a dynamically generated cell -> skipping.
 
-        std::map<ESM::RefNum, std::string> refNumToID; // used to detect refID modifications
+        std::map<ESM::RefNum, ESM::RefId> refNumToID; // used to detect refID modifications
 
         // Load references from all plugins that do something with this cell.
         for (size_t i = 0; i < mCell->mContextList.size(); i++)
@@ -782,13 +786,15 @@ namespace MWWorld
         return Ptr();
     }
 
-    void CellStore::loadRef (ESM::CellRef& ref, bool deleted, std::map<ESM::RefNum, std::string>& refNumToID)
+    void CellStore::loadRef (ESM::CellRef& ref, bool deleted, std::map<ESM::RefNum, ESM::RefId>& refNumToID)
     {
-        Misc::StringUtils::lowerCaseInPlace (ref.mRefID);
+        // IDs of references from content files have always been spelled in lower case
+        if (ref.mRefID.getSpelling() != ref.mRefID.toString())
+            ref.mRefID = ESM::RefId(ref.mRefID.toString());
 
         const MWWorld::ESMStore& store = mStore;
 
-        std::map<ESM::RefNum, std::string>::iterator it = refNumToID.find(ref.mRefNum);
+        std::map<ESM::RefNum, ESM::RefId>::iterator it = refNumToID.find(ref.mRefNum);
         if (it != refNumToID.end())
         {
             if (it->second != ref.mRefID)
@@ -847,7 +853,7 @@ namespace MWWorld
             case ESM::REC_WEAP: mWeapons.load(ref, deleted, store); break;
             case ESM::REC_BODY: mBodyParts.load(ref, deleted, store); break;
 
-            case 0: std::cerr << "Cell reference '" + ref.mRefID + "' not found!\n"; return;
+            case 0: std::cerr << "Cell reference '" << ref.mRefID << "' not found!\n"; return;
 
             default:
                 std::cerr
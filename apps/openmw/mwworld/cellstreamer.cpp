@@ -0,0 +1,173 @@
+#include "cellstreamer.hpp"
+
+#include <algorithm>
+
+#include <osg/Timer>
+
+namespace
+{
+    // Objects this far from the camera are half as urgent as the nearest ones
+    const float sHalfPriorityDistance = 2048.f;
+
+    // Objects behind the camera are this much less urgent than those as far in front of it
+    const float sBehindFactor = 0.5f;
+
+    struct ComparePriority
+    {
+        template <class T>
+        bool operator() (const T& left, const T& right) const
+        {
+            return left.mPriority < right.mPriority;
+        }
+    };
+}
+
+namespace MWWorld
+{
+
+    CellStreamer::Stats::Stats()
+        : mObjects(0)
+        , mCells(0)
+        , mTime(0)
+        , mPendingObjects(0)
+        , mPendingCells(0)
+    {
+    }
+
+    CellStreamer::CellStreamer(float budget)
+        : mBudget(budget)
+        , mNextCell(0)
+    {
+    }
+
+    float CellStreamer::getBudget() const
+    {
+        return mBudget;
+    }
+
+    float CellStreamer::getPriority(const osg::Vec3f& eye, const osg::Vec3f& direction, const osg::Vec3f& position)
+    {
+        const osg::Vec3f offset = position - eye;
+        const float priority = sHalfPriorityDistance / (sHalfPriorityDistance + offset.length());
+        return offset * direction < 0 ? priority * sBehindFactor : priority;
+    }
+
+    unsigned int CellStreamer::addCell(const Callback& finish)
+    {
+        Cell cell;
+        cell.mFinish = finish;
+        cell.mPendingObjects = 0;
+        mCells[mNextCell] = cell;
+        mStats.mPendingCells = mCells.size();
+        return mNextCell++;
+    }
+
+    void CellStreamer::addObject(unsigned int cell, const osg::Vec3f& position, const Callback& insert)
+    {
+        std::map<unsigned int, Cell>::iterator found = mCells.find(cell);
+        if (found == mCells.end())
+            return;
+        ++found->second.mPendingObjects;
+
+        Object object;
+        object.mCell = cell;
+        object.mPosition = position;
+        object.mInsert = insert;
+        object.mPriority = 0;
+        mObjects.push_back(object);
+        mStats.mPendingObjects = mObjects.size();
+    }
+
+    void CellStreamer::removeCell(unsigned int cell)
+    {
+        if (!mCells.erase(cell))
+            return;
+
+        std::vector<Object>::iterator end = mObjects.begin();
+        for (std::vector<Object>::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            if (it->mCell != cell)
+                *end++ = *it;
+        }
+        mObjects.erase(end, mObjects.end());
+
+        mStats.mPendingObjects = mObjects.size();
+        mStats.mPendingCells = mCells.size();
+    }
+
+    bool CellStreamer::isEmpty() const
+    {
+        return mCells.empty();
+    }
+
+    bool CellStreamer::step()
+    {
+        // Cells go live as soon as they can
+        for (std::map<unsigned int, Cell>::iterator it = mCells.begin(); it != mCells.end(); ++it)
+        {
+            if (it->second.mPendingObjects == 0)
+            {
+                // Taken out before it is called, in case it queues or removes cells
+                Callback finish = it->second.mFinish;
+                mCells.erase(it);
+                ++mStats.mCells;
+                finish();
+                return true;
+            }
+        }
+
+        if (mObjects.empty())
+            return false;
+
+        Object object = mObjects.back();
+        mObjects.pop_back();
+        ++mStats.mObjects;
+        object.mInsert();
+
+        std::map<unsigned int, Cell>::iterator cell = mCells.find(object.mCell);
+        if (cell != mCells.end())
+            --cell->second.mPendingObjects;
+        return true;
+    }
+
+    void CellStreamer::update(const osg::Vec3f& eye, const osg::Vec3f& direction)
+    {
+        mStats.mObjects = 0;
+        mStats.mCells = 0;
+        mStats.mTime = 0;
+
+        if (mCells.empty())
+            return;
+
+        const osg::Timer_t start = osg::Timer::instance()->tick();
+
+        for (std::vector<Object>::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+            it->mPriority = getPriority(eye, direction, it->mPosition);
+        std::sort(mObjects.begin(), mObjects.end(), ComparePriority());
+
+        while (step())
+        {
+            mStats.mTime = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+            if (mBudget > 0 && mStats.mTime >= mBudget)
+                break;
+        }
+
+        mStats.mPendingObjects = mObjects.size();
+        mStats.mPendingCells = mCells.size();
+    }
+
+    void CellStreamer::finishAll()
+    {
+        while (step())
+            ;
+
+        mStats.mPendingObjects = mObjects.size();
+        mStats.mPendingCells = mCells.size();
+    }
+
+    const CellStreamer::Stats& CellStreamer::getStats() const
+    {
+        return mStats;
+    }
+
+}
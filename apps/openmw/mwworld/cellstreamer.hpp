@@ -0,0 +1,95 @@
+#ifndef GAME_MWWORLD_CELLSTREAMER_H
+#define GAME_MWWORLD_CELLSTREAMER_H
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include <osg/Vec3f>
+
+namespace MWWorld
+{
+    /// @brief Spreads inserting the objects of newly loaded cells over several frames, so that it takes about
+    /// a given time each frame.
+    /// @par Objects near the camera go first, those in front of it before those behind it. Each cell is finished
+    /// in one go right after its last object, which is where Scene hands the cell to scripts and physics.
+    class CellStreamer
+    {
+    public:
+        typedef std::function<void()> Callback;
+
+        struct Stats
+        {
+            Stats();
+
+            // This frame
+            unsigned int mObjects;
+            unsigned int mCells;
+            float mTime; // milliseconds
+
+            // Still to do
+            unsigned int mPendingObjects;
+            unsigned int mPendingCells;
+        };
+
+        /// @param budget Milliseconds per frame, 0 for no limit.
+        explicit CellStreamer(float budget);
+
+        float getBudget() const;
+
+        /// How soon to insert an object at \a position, higher for objects near \a eye and in front of it.
+        static float getPriority(const osg::Vec3f& eye, const osg::Vec3f& direction, const osg::Vec3f& position);
+
+        /// Queue a cell, to be finished by \a finish once all objects added to it are in.
+        /// @return Identifies the cell to addObject and removeCell.
+        unsigned int addCell(const Callback& finish);
+
+        /// Queue an object of \a cell, to be inserted by \a insert.
+        void addObject(unsigned int cell, const osg::Vec3f& position, const Callback& insert);
+
+        /// Drop a cell with its objects that are not in yet, without finishing it.
+        void removeCell(unsigned int cell);
+
+        bool isEmpty() const;
+
+        /// Insert objects and finish cells until the budget for this frame is spent, at least one of either.
+        /// @param eye Where the camera is.
+        /// @param direction Where the camera looks.
+        void update(const osg::Vec3f& eye, const osg::Vec3f& direction);
+
+        /// Insert all objects and finish all cells now.
+        void finishAll();
+
+        const Stats& getStats() const;
+
+    private:
+        struct Object
+        {
+            unsigned int mCell;
+            osg::Vec3f mPosition;
+            Callback mInsert;
+            float mPriority;
+        };
+
+        struct Cell
+        {
+            Callback mFinish;
+            unsigned int mPendingObjects;
+        };
+
+        /// Insert one object, or finish a cell that has none left. @return Whether there was anything to do.
+        bool step();
+
+        float mBudget;
+        unsigned int mNextCell;
+
+        std::map<unsigned int, Cell> mCells;
+
+        // Sorted by priority in update, the next object to insert is the last one
+        std::vector<Object> mObjects;
+
+        Stats mStats;
+    };
+}
+
+#endif
@@ -33,6 +33,8 @@
 
 namespace
 {
+    unsigned int sLastRevision = 0;
+
     template<typename T>
     float getTotalWeight (const MWWorld::CellRefList<T>& cellRefList)
     {
@@ -79,7 +81,7 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::getState (CellRefList<T
         return ContainerStoreIterator (this); // not valid anymore with current content files -> skip
 
     const T *record = MWBase::Environment::get().getWorld()->getStore().
-        get<T>().search (state.mRef.mRefID);
+        get<T>().search (state.mRef.mRefID.toString());
 
     if (!record)
         return ContainerStoreIterator (this);
@@ -125,7 +127,7 @@ void MWWorld::ContainerStore::storeStates (const CellRefList<T>& collection,
 
 const std::string MWWorld::ContainerStore::sGoldId = "gold_001";
 
-MWWorld::ContainerStore::ContainerStore() : mListener(NULL), mCachedWeight (0), mWeightUpToDate (false) {}
+MWWorld::ContainerStore::ContainerStore() : mListener(NULL), mCachedWeight (0), mWeightUpToDate (false), mRevision (++sLastRevision) {}
 
 MWWorld::ContainerStore::~ContainerStore() {}
 
@@ -161,18 +163,20 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::end()
 
 int MWWorld::ContainerStore::count(const std::string &id)
 {
+    const ESM::RefId refId = ESM::RefId::search(id);
     int total=0;
     for (MWWorld::ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
+        if (iter->getCellRef().getInternedRefId() == refId)
             total += iter->getRefData().getCount();
     return total;
 }
 
 int MWWorld::ContainerStore::restockCount(const std::string &id)
 {
+    const ESM::RefId refId = ESM::RefId::search(id);
     int total=0;
     for (MWWorld::ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
+        if (iter->getCellRef().getInternedRefId() == refId)
             if (iter->getCellRef().getSoul().empty())
                 total += iter->getRefData().getCount();
     return total;
@@ -255,7 +259,7 @@ bool MWWorld::ContainerStore::stacks(const ConstPtr& ptr1, const ConstPtr& ptr2)
     const MWWorld::Class& cls1 = ptr1.getClass();
     const MWWorld::Class& cls2 = ptr2.getClass();
 
-    if (!Misc::StringUtils::ciEqual(ptr1.getCellRef().getRefId(), ptr2.getCellRef().getRefId()))
+    if (ptr1.getCellRef().getInternedRefId() != ptr2.getCellRef().getInternedRefId())
         return false;
 
     // If it has an enchantment, don't stack when some of the charge is already used
@@ -413,10 +417,11 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addImp (const Ptr& ptr,
     if(ptr.getClass().isGold(ptr))
     {
         int realCount = count * ptr.getClass().getValue(ptr);
+        static const ESM::RefId goldId(MWWorld::ContainerStore::sGoldId);
 
         for (MWWorld::ContainerStoreIterator iter (begin(type)); iter!=end(); ++iter)
         {
-            if (Misc::StringUtils::ciEqual((*iter).getCellRef().getRefId(), MWWorld::ContainerStore::sGoldId))
+            if ((*iter).getCellRef().getInternedRefId() == goldId)
             {
                 iter->getRefData().setCount(iter->getRefData().getCount() + realCount);
                 flagAsModified();
@@ -473,9 +478,10 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addNewStack (const Cons
 int MWWorld::ContainerStore::remove(const std::string& itemId, int count, const Ptr& actor)
 {
     int toRemove = count;
+    const ESM::RefId refId = ESM::RefId::search(itemId);
 
     for (ContainerStoreIterator iter(begin()); iter != end() && toRemove > 0; ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), itemId))
+        if (iter->getCellRef().getInternedRefId() == refId)
             toRemove -= remove(*iter, toRemove, actor);
 
     flagAsModified();
@@ -697,6 +703,7 @@ void MWWorld::ContainerStore::clear()
 void MWWorld::ContainerStore::flagAsModified()
 {
     mWeightUpToDate = false;
+    mRevision = ++sLastRevision;
 }
 
 float MWWorld::ContainerStore::getWeight() const
@@ -724,6 +731,11 @@ float MWWorld::ContainerStore::getWeight() const
     return mCachedWeight;
 }
 
+unsigned int MWWorld::ContainerStore::getRevision() const
+{
+    return mRevision;
+}
+
 int MWWorld::ContainerStore::getType (const ConstPtr& ptr)
 {
     if (ptr.isEmpty())
@@ -773,10 +785,11 @@ MWWorld::Ptr MWWorld::ContainerStore::findReplacement(const std::string& id)
 {
     MWWorld::Ptr item;
     int itemHealth = 1;
+    const ESM::RefId refId = ESM::RefId::search(id);
     for (MWWorld::ContainerStoreIterator iter = begin(); iter != end(); ++iter)
     {
         int iterHealth = iter->getClass().hasItemHealth(*iter) ? iter->getClass().getItemHealth(*iter) : 1;
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
+        if (iter->getCellRef().getInternedRefId() == refId)
         {
             // Prefer the stack with the lowest remaining uses
             // Try to get item with zero durability only if there are no other items found
@@ -91,6 +91,7 @@ namespace MWWorld
 
             mutable float mCachedWeight;
             mutable bool mWeightUpToDate;
+            unsigned int mRevision;
             ContainerStoreIterator addImp (const Ptr& ptr, int count);
             void addInitialItem (const std::string& id, const std::string& owner, int count, bool topLevel=true, const std::string& levItem = "");
 
@@ -194,6 +195,10 @@ namespace MWWorld
             float getWeight() const;
             ///< Return total weight of the items contained in *this.
 
+            unsigned int getRevision() const;
+            ///< Changes whenever items are added, removed or restacked. Revisions are never reused, so a store
+            /// that was modified after being copied can be told apart from the copy.
+
             static int getType (const ConstPtr& ptr);
             ///< This function throws an exception, if ptr does not point to an object, that can be
             /// put into a container.
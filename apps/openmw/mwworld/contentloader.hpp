@@ -22,6 +22,11 @@ struct ContentLoader
     {
     }
 
+    /// Called for every content file in load order, before the first one is loaded
+    virtual void prepare(const boost::filesystem::path& filepath, int index)
+    {
+    }
+
     virtual void load(const boost::filesystem::path& filepath, int& index)
     {
       std::cout << "Loading content file " << filepath.string() << std::endl;
@@ -1,31 +1,154 @@
 #include "esmloader.hpp"
 #include "esmstore.hpp"
+#include "loadordercache.hpp"
+
+#include <algorithm>
+#include <memory>
 
 #include <components/esm/esmreader.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/to_utf8/to_utf8.hpp>
 
 namespace MWWorld
 {
 
+/// Parses the records of one content file on a worker thread, see ESMStore::decode()
+class DecodeRecordsWorkItem : public SceneUtil::WorkItem
+{
+public:
+    DecodeRecordsWorkItem(const ESMStore& store, const boost::filesystem::path& filepath, const ToUTF8::Utf8Encoder* encoder)
+        : mStore(store)
+        , mPath(filepath)
+        // Encoders keep an output buffer, so each file gets its own copy
+        , mEncoder(encoder ? new ToUTF8::Utf8Encoder(*encoder) : NULL)
+    {
+    }
+
+    virtual void doWork()
+    {
+        try
+        {
+            ESM::ESMReader reader;
+            reader.setEncoder(mEncoder.get());
+            reader.setLazyLoading(true);
+            reader.open(mPath.string());
+            mStore.decode(reader, mRecords);
+        }
+        catch (std::exception&)
+        {
+            // Leave it to EsmLoader::load() to report the error
+        }
+    }
+
+    DecodedRecords& getRecords()
+    {
+        return mRecords;
+    }
+
+private:
+    const ESMStore& mStore;
+    boost::filesystem::path mPath;
+    std::unique_ptr<ToUTF8::Utf8Encoder> mEncoder;
+    DecodedRecords mRecords;
+};
+
 EsmLoader::EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener)
+  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, int numThreads)
   : ContentLoader(listener)
   , mEsm(readers)
   , mStore(store)
   , mEncoder(encoder)
+  , mNumThreads(numThreads)
+  , mNumDecoding(0)
+  , mCache(NULL)
+  , mCacheLoaded(false)
+{
+    if (mNumThreads > 0)
+        mWorkQueue = new SceneUtil::WorkQueue(mNumThreads);
+}
+
+EsmLoader::~EsmLoader()
+{
+}
+
+void EsmLoader::setCache(LoadOrderCache* cache)
 {
+    mCache = cache;
+}
+
+void EsmLoader::prepare(const boost::filesystem::path& filepath, int index)
+{
+    if (index >= static_cast<int>(mPaths.size()))
+    {
+        mPaths.resize(index+1);
+        mDecoding.resize(index+1);
+    }
+    mPaths[index] = filepath;
+}
+
+void EsmLoader::decodeUntil(int index)
+{
+    index = std::min(index, static_cast<int>(mPaths.size()) - 1);
+    for (; mNumDecoding <= index; ++mNumDecoding)
+    {
+        if (mPaths[mNumDecoding].empty())
+            continue;
+
+        mDecoding[mNumDecoding] = new DecodeRecordsWorkItem(mStore, mPaths[mNumDecoding], mEncoder);
+        mWorkQueue->addWorkItem(mDecoding[mNumDecoding]);
+    }
 }
 
 void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
 {
+  if (index == 0)
+  {
+      mStartTime = std::chrono::steady_clock::now();
+      if (mCache)
+      {
+          mCache->setContentFiles(mPaths);
+          mCacheLoaded = mCache->load(mStore);
+      }
+  }
+
   ContentLoader::load(filepath.filename(), index);
 
+  // Keep a few files parsed ahead, but not the whole load order, since the parsed records are held twice until applied.
+  // Not needed when the load order cache already provided those records.
+  osg::ref_ptr<DecodeRecordsWorkItem> decoding;
+  if (mWorkQueue && !mCacheLoaded)
+  {
+      decodeUntil(index + mNumThreads * 2);
+      if (index < static_cast<int>(mDecoding.size()))
+          decoding.swap(mDecoding[index]);
+  }
+
   ESM::ESMReader lEsm;
   lEsm.setEncoder(mEncoder);
+  // Content files do not change while the game runs, so long texts can be read when they are needed
+  lEsm.setLazyLoading(true);
   lEsm.setIndex(index);
   lEsm.setGlobalReaderList(&mEsm);
   lEsm.open(filepath.string());
   mEsm[index] = lEsm;
-  mStore.load(mEsm[index], &mListener);
+
+  if (decoding)
+  {
+      decoding->waitTillDone();
+      mStore.load(mEsm[index], &mListener, &decoding->getRecords());
+  }
+  else
+      mStore.load(mEsm[index], &mListener);
+
+  if (index + 1 == static_cast<int>(mPaths.size()))
+  {
+      if (mCache && !mCacheLoaded)
+          mCache->save(mStore);
+
+      std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - mStartTime;
+      std::cout << "Loaded " << mPaths.size() << " content files in " << static_cast<int>(duration.count()) << " ms ("
+                << (mCacheLoaded ? "warm start from load order cache" : "cold start") << ")" << std::endl;
+  }
 }
 
 } /* namespace MWWorld */
@@ -1,8 +1,11 @@
 #ifndef ESMLOADER_HPP
 #define ESMLOADER_HPP
 
+#include <chrono>
 #include <vector>
 
+#include <osg/ref_ptr>
+
 #include "contentloader.hpp"
 
 namespace ToUTF8
@@ -15,22 +18,51 @@ namespace ESM
     class ESMReader;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWWorld
 {
 
 class ESMStore;
+class LoadOrderCache;
+class DecodeRecordsWorkItem;
 
 struct EsmLoader : public ContentLoader
 {
+    /// @param numThreads Number of threads parsing upcoming content files while earlier ones are being loaded,
+    /// 0 to parse every file on the calling thread.
     EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener);
+      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, int numThreads = 0);
+    ~EsmLoader();
+
+    /// Restore records from \a cache if it matches the load order, and write it after loading otherwise.
+    void setCache(LoadOrderCache* cache);
+
+    void prepare(const boost::filesystem::path& filepath, int index);
 
     void load(const boost::filesystem::path& filepath, int& index);
 
     private:
+      /// Start parsing the files up to \a index on the worker threads
+      void decodeUntil(int index);
+
       std::vector<ESM::ESMReader>& mEsm;
       MWWorld::ESMStore& mStore;
       ToUTF8::Utf8Encoder* mEncoder;
+
+      osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+      int mNumThreads;
+
+      std::vector<boost::filesystem::path> mPaths;
+      std::vector<osg::ref_ptr<DecodeRecordsWorkItem> > mDecoding;
+      int mNumDecoding;
+
+      LoadOrderCache* mCache;
+      bool mCacheLoaded;
+      std::chrono::steady_clock::time_point mStartTime;
 };
 
 } /* namespace MWWorld */
@@ -27,7 +27,7 @@ static bool isCacheableRecord(int id)
     return false;
 }
 
-void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener, DecodedRecords* decoded)
 {
     listener->setProgressRange(1000);
 
@@ -68,11 +68,18 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
     }
 
     // Loop through all records
-    while(esm.hasMoreRecs())
+    for (size_t recordIndex = 0; esm.hasMoreRecs(); ++recordIndex)
     {
         ESM::NAME n = esm.getRecName();
         esm.getRecHeader();
 
+        if (mCachedRecordTypes.find(n.intval) != mCachedRecordTypes.end())
+        {
+            esm.skipRecord();
+            dialogue = 0;
+            continue;
+        }
+
         // Look up the record type.
         std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
 
@@ -103,7 +110,16 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
                 throw std::runtime_error(error.str());
             }
         } else {
-            RecordId id = it->second->load(esm);
+            RecordId id;
+            if (decoded && recordIndex < decoded->size() && (*decoded)[recordIndex])
+            {
+                id = it->second->insertDecoded(*(*decoded)[recordIndex]);
+                (*decoded)[recordIndex].reset();
+                esm.skipRecord();
+            }
+            else
+                id = it->second->load(esm);
+
             if (id.mIsDeleted)
             {
                 it->second->eraseStatic(id.mId);
@@ -120,6 +136,37 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
     }
 }
 
+void ESMStore::decode(ESM::ESMReader &esm, DecodedRecords &records) const
+{
+    // Stop at the first record that does not parse cleanly. load() will parse it and everything
+    // after it itself, so that it fails or recovers exactly as it would have without decoding.
+    try
+    {
+        while(esm.hasMoreRecs())
+        {
+            ESM::NAME n = esm.getRecName();
+            esm.getRecHeader();
+
+            std::unique_ptr<DecodedRecord> record;
+
+            std::map<int, StoreBase *>::const_iterator it = mStores.find(n.intval);
+            if (it != mStores.end())
+                record.reset(it->second->decode(esm));
+
+            if (!record)
+                // Leave a gap for records that load() has to parse itself
+                esm.skipRecord();
+            else if (esm.hasMoreSubs())
+                return;
+
+            records.push_back(std::move(record));
+        }
+    }
+    catch (std::exception&)
+    {
+    }
+}
+
 void ESMStore::setUp(bool validateRecords)
 {
     mIds.clear();
@@ -1,10 +1,13 @@
 #ifndef OPENMW_MWWORLD_ESMSTORE_H
 #define OPENMW_MWWORLD_ESMSTORE_H
 
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 
 #include <components/esm/records.hpp>
+#include <components/esm/refid.hpp>
 #include "store.hpp"
 
 namespace Loading
@@ -67,9 +70,12 @@ namespace MWWorld
 
         // Lookup of all IDs. Makes looking up references faster. Just
         // maps the id name to the record type.
-        std::map<std::string, int> mIds;
+        std::unordered_map<ESM::RefId, int> mIds;
         std::map<int, StoreBase *> mStores;
 
+        // Record types restored from a LoadOrderCache, skipped when loading content files
+        std::set<int> mCachedRecordTypes;
+
         ESM::NPC mPlayerTemplate;
 
         unsigned int mDynamicCount;
@@ -90,16 +96,21 @@ namespace MWWorld
         }
 
         /// Look up the given ID in 'all'. Returns 0 if not found.
-        /// \note id must be in lower case.
-        int find(const std::string &id) const
+        int find(const ESM::RefId &id) const
         {
-            std::map<std::string, int>::const_iterator it = mIds.find(id);
+            std::unordered_map<ESM::RefId, int>::const_iterator it = mIds.find(id);
             if (it == mIds.end()) {
                 return 0;
             }
             return it->second;
         }
 
+        /// Look up the given ID in 'all'. Returns 0 if not found.
+        int find(const std::string &id) const
+        {
+            return find(ESM::RefId::search(id));
+        }
+
         ESMStore()
           : mDynamicCount(0)
         {
@@ -161,7 +172,18 @@ namespace MWWorld
             mNpcs.insert(mPlayerTemplate);
         }
 
-        void load(ESM::ESMReader &esm, Loading::Listener* listener);
+        /// @param decoded Records of this file returned by decode(), taken instead of parsing them again. Optional.
+        void load(ESM::ESMReader &esm, Loading::Listener* listener, DecodedRecords* decoded = NULL);
+
+        /// Skip records of these types in load(), because they have already been restored from a LoadOrderCache.
+        void setCachedRecordTypes(const std::set<int>& types)
+        {
+            mCachedRecordTypes = types;
+        }
+
+        /// Parse the records of a content file that do not depend on previously loaded files, for a later load().
+        /// @note Does not modify the store, so it may run on a worker thread while other files are being loaded.
+        void decode(ESM::ESMReader &esm, DecodedRecords &records) const;
 
         template <class T>
         const Store<T> &get() const {
@@ -130,6 +130,7 @@ MWWorld::InventoryStore::InventoryStore (const InventoryStore& store)
  , mRechargingItemsUpToDate(false)
 {
     copySlots (store);
+    flagAsModified();
 }
 
 MWWorld::InventoryStore& MWWorld::InventoryStore::operator= (const InventoryStore& store)
@@ -142,6 +143,7 @@ MWWorld::InventoryStore& MWWorld::InventoryStore::operator= (const InventoryStor
     ContainerStore::operator= (store);
     mSlots.clear();
     copySlots (store);
+    flagAsModified();
     return *this;
 }
 
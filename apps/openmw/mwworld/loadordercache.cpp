@@ -0,0 +1,259 @@
+#include "loadordercache.hpp"
+
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/files/mappedfilestream.hpp>
+
+#include "esmstore.hpp"
+
+namespace
+{
+    // Increase when the layout of the cache or of any cached record changes
+    const int sFormatVersion = 2;
+
+    uint64_t hashData(uint64_t hash, const char* data, size_t size)
+    {
+        // FNV-1a over 64 bit words, plenty to notice a changed content file
+        const uint64_t prime = 1099511628211ULL;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(uint64_t));
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; ++i)
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+
+        return hash;
+    }
+
+    uint64_t hashFile(const boost::filesystem::path& path)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+
+        Files::MappedFilePtr file = Files::openMappedFile(path.string().c_str());
+        if (file)
+            return hashData(hash, file->data(), file->size());
+
+        // The chunk size is a multiple of the word size, so this gives the same result as hashing the mapping
+        boost::filesystem::ifstream stream(path, std::ios::binary);
+        std::vector<char> buffer(64*1024);
+        while (stream)
+        {
+            stream.read(&buffer[0], buffer.size());
+            hash = hashData(hash, &buffer[0], static_cast<size_t>(stream.gcount()));
+        }
+        return hash;
+    }
+}
+
+namespace MWWorld
+{
+    LoadOrderCache::LoadOrderCache(const boost::filesystem::path& file, int encoding)
+        : mFile(file)
+        , mEncoding(encoding)
+    {
+    }
+
+    void LoadOrderCache::setContentFiles(const std::vector<boost::filesystem::path>& files)
+    {
+        mContentFiles.clear();
+        for (std::vector<boost::filesystem::path>::const_iterator it = files.begin(); it != files.end(); ++it)
+        {
+            if (it->empty())
+                continue;
+
+            ContentFile file;
+            file.mName = it->filename().string();
+            file.mSize = boost::filesystem::file_size(*it);
+            file.mTime = boost::filesystem::last_write_time(*it);
+            file.mHash = hashFile(*it);
+            mContentFiles.push_back(file);
+        }
+    }
+
+    bool LoadOrderCache::load(ESMStore& store)
+    {
+        if (mContentFiles.empty() || !boost::filesystem::exists(mFile))
+            return false;
+
+        std::vector<std::pair<StoreBase*, std::unique_ptr<DecodedRecord> > > records;
+        std::set<int> types;
+
+        try
+        {
+            // Strings are read eagerly, as lazy ones would point into the cache file, which save() replaces
+            ESM::ESMReader reader;
+            reader.open(Files::openMappedFileStream(mFile.string().c_str()), mFile.string());
+
+            if (reader.getRecName() != "CKEY")
+                return false;
+            reader.getRecHeader();
+
+            int format = 0;
+            reader.getHNT(format, "FORM");
+            int encoding = 0;
+            reader.getHNT(encoding, "ENCD");
+            if (format != sFormatVersion || encoding != mEncoding)
+            {
+                std::cout << "Load order cache is outdated" << std::endl;
+                return false;
+            }
+
+            size_t index = 0;
+            while (reader.isNextSub("FNAM"))
+            {
+                ContentFile file;
+                file.mName = reader.getHString();
+                reader.getHNT(file.mSize, "FSIZ");
+                reader.getHNT(file.mTime, "MTIM");
+                reader.getHNT(file.mHash, "HASH");
+
+                if (index >= mContentFiles.size() || file.mName != mContentFiles[index].mName
+                        || file.mSize != mContentFiles[index].mSize || file.mTime != mContentFiles[index].mTime
+                        || file.mHash != mContentFiles[index].mHash)
+                {
+                    std::cout << "Load order cache is outdated" << std::endl;
+                    return false;
+                }
+                ++index;
+            }
+            if (index != mContentFiles.size())
+            {
+                std::cout << "Load order cache is outdated" << std::endl;
+                return false;
+            }
+
+            // Decode everything before touching the store, a damaged cache must not leave half of it behind
+            bool complete = false;
+            while (reader.hasMoreRecs())
+            {
+                ESM::NAME name = reader.getRecName();
+                reader.getRecHeader();
+
+                if (name == "CEND")
+                {
+                    while (reader.isNextSub("TYPE"))
+                    {
+                        int type = 0;
+                        reader.getHT(type);
+                        types.insert(type);
+                    }
+                    int count = 0;
+                    reader.getHNT(count, "NREC");
+                    complete = (count == static_cast<int>(records.size()));
+                    break;
+                }
+
+                StoreBase* recordStore = NULL;
+                for (ESMStore::iterator it = store.begin(); it != store.end(); ++it)
+                {
+                    if (it->first == name.intval)
+                    {
+                        recordStore = it->second;
+                        break;
+                    }
+                }
+
+                std::unique_ptr<DecodedRecord> record;
+                if (recordStore)
+                    record.reset(recordStore->decode(reader));
+                if (!record || reader.hasMoreSubs())
+                    reader.fail("Unexpected record");
+
+                records.push_back(std::make_pair(recordStore, std::move(record)));
+            }
+
+            if (!complete)
+                reader.fail("Cache is incomplete");
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read load order cache " << mFile << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        for (size_t i = 0; i < records.size(); ++i)
+            records[i].first->insertDecoded(*records[i].second);
+
+        store.setCachedRecordTypes(types);
+        return true;
+    }
+
+    void LoadOrderCache::save(const ESMStore& store)
+    {
+        if (mContentFiles.empty())
+            return;
+
+        // Write to a temporary file first, so an interrupted write never leaves a cache that looks complete
+        boost::filesystem::path tempFile = mFile;
+        tempFile += ".tmp";
+
+        try
+        {
+            boost::filesystem::create_directories(mFile.parent_path());
+
+            boost::filesystem::ofstream stream(tempFile, std::ios::binary);
+
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.setVersion();
+            writer.setAuthor("OpenMW");
+            writer.setDescription("Load order cache");
+            writer.save(stream);
+
+            writer.startRecord("CKEY");
+            writer.writeHNT("FORM", sFormatVersion);
+            writer.writeHNT("ENCD", mEncoding);
+            for (std::vector<ContentFile>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+            {
+                writer.writeHNString("FNAM", it->mName);
+                writer.writeHNT("FSIZ", it->mSize);
+                writer.writeHNT("MTIM", it->mTime);
+                writer.writeHNT("HASH", it->mHash);
+            }
+            writer.endRecord("CKEY");
+
+            std::vector<int> types;
+            int count = 0;
+            for (ESMStore::iterator it = store.begin(); it != store.end(); ++it)
+            {
+                if (it->second->writeStatic(writer))
+                {
+                    types.push_back(it->first);
+                    count += static_cast<int>(it->second->getSize());
+                }
+            }
+
+            writer.startRecord("CEND");
+            for (std::vector<int>::const_iterator it = types.begin(); it != types.end(); ++it)
+                writer.writeHNT("TYPE", *it);
+            writer.writeHNT("NREC", count);
+            writer.endRecord("CEND");
+
+            writer.close();
+            stream.close();
+            if (stream.fail())
+                throw std::runtime_error("Write error");
+
+            boost::filesystem::rename(tempFile, mFile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write load order cache " << mFile << ": " << e.what() << std::endl;
+
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempFile, ec);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef OPENMW_MWWORLD_LOADORDERCACHE_H
+#define OPENMW_MWWORLD_LOADORDERCACHE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+
+namespace MWWorld
+{
+    class ESMStore;
+
+    /// @brief Keeps the records of a load order on disk, so that the next start with unchanged content files
+    /// does not need to parse them again.
+    ///
+    /// Only the stores that support StoreBase::decode() are cached, since their records do not depend on the
+    /// order of loading. Cells, land, pathgrids and dialogue are still loaded from the content files, which
+    /// keeps the file contexts they refer to valid.
+    class LoadOrderCache
+    {
+    public:
+        /// @param encoding Encoding of the content files, see ToUTF8::FromType. Strings are cached after conversion.
+        LoadOrderCache(const boost::filesystem::path& file, int encoding);
+
+        /// Set the content files in load order. Their names, sizes, modification times and hashes are the key
+        /// that the cache is valid for.
+        void setContentFiles(const std::vector<boost::filesystem::path>& files);
+
+        /// Insert the cached records into \a store and have it skip them while loading content files.
+        /// @return false if there is no cache for this load order, or it is outdated or damaged.
+        /// The store is not touched in that case.
+        bool load(ESMStore& store);
+
+        /// Write the cache from \a store. To be called after loading all content files, but before ESMStore::setUp().
+        void save(const ESMStore& store);
+
+    private:
+        struct ContentFile
+        {
+            std::string mName;
+            uint64_t mSize;
+            int64_t mTime;
+            uint64_t mHash;
+        };
+
+        boost::filesystem::path mFile;
+        int mEncoding;
+        std::vector<ContentFile> mContentFiles;
+    };
+}
+
+#endif
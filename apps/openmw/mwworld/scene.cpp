@@ -1,8 +1,12 @@
 #include "scene.hpp"
 
+#include <functional>
 #include <limits>
 #include <iostream>
 
+#include <osg/Stats>
+#include <osg/Timer>
+
 /*
     Start of tes3mp addition
 
@@ -10,6 +14,7 @@
 */
 #include "../mwmp/Main.hpp"
 #include "../mwmp/LocalPlayer.hpp"
+#include "../mwmp/Networking.hpp"
 /*
     End of tes3mp addition
 */
@@ -19,6 +24,9 @@
 #include <components/settings/settings.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/scenemanager.hpp>
+#include <components/resource/loadqueue.hpp>
+#include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/terrain/world.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -38,9 +46,16 @@
 #include "cellvisitors.hpp"
 #include "cellstore.hpp"
 #include "cellpreloader.hpp"
+#include "cellprediction.hpp"
+#include "cellstreamer.hpp"
 
 namespace
 {
+    // The number of teleports to predict the next one from
+    const unsigned int sTeleportHistorySize = 32;
+
+    // The number of cells that the teleport history can have preloaded
+    const size_t sTeleportHistoryDestinations = 3;
 
     void setNodeRotation(const MWWorld::Ptr& ptr, MWRender::RenderingManager& rendering, bool inverseRotationOrder)
     {
@@ -62,30 +77,32 @@ namespace
         rendering.rotateObject(ptr, worldRotQuat);
     }
 
-    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
-                   MWRender::RenderingManager& rendering)
+    std::string getModel(const MWWorld::Ptr& ptr, const VFS::Manager* vfs)
     {
-        if (ptr.getRefData().getBaseNode() || physics.getActor(ptr))
-        {
-            std::cerr << "Warning: Tried to add " << ptr.getCellRef().getRefId() << " to the scene twice" << std::endl;
-            return;
-        }
-
-        bool useAnim = ptr.getClass().useAnim();
         std::string model = ptr.getClass().getModel(ptr);
-        if (useAnim)
-            model = Misc::ResourceHelpers::correctActorModelPath(model, rendering.getResourceSystem()->getVFS());
+        if (ptr.getClass().useAnim())
+            model = Misc::ResourceHelpers::correctActorModelPath(model, vfs);
 
         std::string id = ptr.getCellRef().getRefId();
         if (id == "prisonmarker" || id == "divinemarker" || id == "templemarker" || id == "northmarker")
             model = ""; // marker objects that have a hardcoded function in the game logic, should be hidden from the player
 
+        return model;
+    }
+
+    void addObjectRendering(const MWWorld::Ptr& ptr, const std::string& model, MWRender::RenderingManager& rendering)
+    {
         ptr.getClass().insertObjectRendering(ptr, model, rendering);
         setNodeRotation(ptr, rendering, false);
+    }
 
+    // Everything but the rendering
+    void activateObject(const MWWorld::Ptr& ptr, const std::string& model, MWPhysics::PhysicsSystem& physics,
+                        MWRender::RenderingManager& rendering)
+    {
         ptr.getClass().insertObject (ptr, model, physics);
 
-        if (useAnim)
+        if (ptr.getClass().useAnim())
             MWBase::Environment::get().getMechanicsManager()->add(ptr);
 
         if (ptr.getClass().isActor())
@@ -95,6 +112,33 @@ namespace
         MWBase::Environment::get().getWorld()->applyLoopingParticles(ptr);
     }
 
+    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
+                   MWRender::RenderingManager& rendering)
+    {
+        if (ptr.getRefData().getBaseNode() || physics.getActor(ptr))
+        {
+            std::cerr << "Warning: Tried to add " << ptr.getCellRef().getRefId() << " to the scene twice" << std::endl;
+            return;
+        }
+
+        const std::string model = getModel(ptr, rendering.getResourceSystem()->getVFS());
+        addObjectRendering(ptr, model, rendering);
+        activateObject(ptr, model, physics, rendering);
+    }
+
+    // Objects that are rendered before their cell is active, when the cell is streamed in
+    bool isStreamable(const MWWorld::Ptr& ptr)
+    {
+        return !ptr.getRefData().isDeleted() && ptr.getRefData().isEnabled();
+    }
+
+    // Actors and animated objects rendered before their cell is active are hidden until it is, they would stand
+    // still until the mechanics take them on
+    bool isHiddenWhileStreamed(const MWWorld::Ptr& ptr)
+    {
+        return ptr.getClass().isActor() || ptr.getClass().useAnim();
+    }
+
     void updateObjectRotation (const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
                                     MWRender::RenderingManager& rendering, bool inverseRotationOrder)
     {
@@ -166,7 +210,16 @@ namespace
             {
                 try
                 {
-                    addObject(ptr, mPhysics, mRendering);
+                    // Objects with a base node were rendered while the cell was streamed in, see Scene::streamCell.
+                    // They may have been moved since, as their cell was not active.
+                    if (ptr.getRefData().getBaseNode())
+                    {
+                        mRendering.moveObject(ptr, ptr.getRefData().getPosition().asVec3());
+                        setNodeRotation(ptr, mRendering, false);
+                        activateObject(ptr, getModel(ptr, mRendering.getResourceSystem()->getVFS()), mPhysics, mRendering);
+                    }
+                    else
+                        addObject(ptr, mPhysics, mRendering);
                 }
                 catch (const std::exception& e)
                 {
@@ -174,11 +227,24 @@ namespace
                     std::cerr << error + e.what() << std::endl;
                 }
             }
+            else if (ptr.getRefData().getBaseNode())
+                mRendering.removeObject(ptr); // disabled or deleted while the cell was streamed in
 
             mLoadingListener.increaseProgress (1);
         }
     }
 
+    struct ListObjectsVisitor
+    {
+        std::vector<MWWorld::Ptr> mObjects;
+
+        bool operator() (const MWWorld::Ptr& ptr)
+        {
+            mObjects.push_back(ptr);
+            return true;
+        }
+    };
+
     struct AdjustPositionVisitor
     {
         bool operator() (const MWWorld::Ptr& ptr)
@@ -223,6 +289,16 @@ namespace MWWorld
             minY = std::min(y, minY);
             ++iter;
         }
+        // Cells that are still being streamed in belong to the grid as well
+        for (std::map<CellStore*, unsigned int>::const_iterator it = mStreamedCells.begin(); it != mStreamedCells.end(); ++it)
+        {
+            int x = it->first->getCell()->getGridX();
+            int y = it->first->getCell()->getGridY();
+            maxX = std::max(x, maxX);
+            maxY = std::max(y, maxY);
+            minX = std::min(x, minX);
+            minY = std::min(y, minY);
+        }
         cellX = (minX + maxX) / 2;
         cellY = (minY + maxY) / 2;
     }
@@ -236,6 +312,13 @@ namespace MWWorld
             mPreloadTimer = 0.f;
         }
 
+        if (!mStreamer->isEmpty())
+        {
+            const ESM::Position& pos = MWBase::Environment::get().getWorld()->getPlayerPtr().getRefData().getPosition();
+            const osg::Vec3f direction = osg::Quat(pos.rot[2], osg::Vec3f(0, 0, -1)) * osg::Vec3f(0, 1, 0);
+            mStreamer->update(pos.asVec3(), direction);
+        }
+
         mRendering.update (duration, paused);
 
         mPreloader->updateCache(mRendering.getReferenceTime());
@@ -257,6 +340,8 @@ namespace MWWorld
             End of tes3mp addition
         */
 
+        mPhysics->removeNavigationCell(*iter);
+
         (*iter)->forEach<ListAndResetObjectsVisitor>(visitor);
         for (std::vector<MWWorld::Ptr>::const_iterator iter2 (visitor.mObjects.begin());
             iter2!=visitor.mObjects.end(); ++iter2)
@@ -288,9 +373,11 @@ namespace MWWorld
         /*
             Start of tes3mp addition
 
-            Store a cell unload for the LocalPlayer
+            Store a cell unload for the LocalPlayer, and forget what the server knows of the
+            script variables in the cell, which it may change while the cell is unloaded
         */
         mwmp::Main::get().getLocalPlayer()->storeCellState(*cell, mwmp::CellState::UNLOAD);
+        mwmp::Main::get().getNetworking()->getScriptStateSync()->clearCell(*cell);
         /*
             End of tes3mp addition
         */
@@ -302,6 +389,8 @@ namespace MWWorld
 
         if(result.second)
         {
+            const osg::Timer_t start = osg::Timer::instance()->tick();
+
             std::cout << "Loading cell " << cell->getCell()->getDescription() << std::endl;
 
             float verts = ESM::Land::LAND_SIZE;
@@ -333,6 +422,9 @@ namespace MWWorld
             if (respawn)
                 cell->respawn();
 
+            // Have the models loaded by all worker threads rather than one by one while inserting the objects
+            mPreloader->loadModels(cell);
+
             // ... then references. This is important for adjustPosition to work correctly.
             /// \todo rescale depending on the state of a new GMST
 
@@ -346,6 +438,8 @@ namespace MWWorld
             /*
                 End of tes3mp change (major)
             */
+
+            mPhysics->addNavigationCell(cell);
             
 
             mRendering.addCell(cell);
@@ -372,6 +466,8 @@ namespace MWWorld
             /*
                 End of tes3mp addition
             */
+
+            mLastCellLoadTime = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
         }
 
         mPreloader->notifyLoaded(cell);
@@ -379,6 +475,9 @@ namespace MWWorld
 
     void Scene::clear()
     {
+        while (!mStreamedCells.empty())
+            cancelStreamedCell(mStreamedCells.begin());
+
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active!=mActiveCells.end())
             unloadCell (active++);
@@ -386,6 +485,17 @@ namespace MWWorld
         mCurrentCell = NULL;
 
         mPreloader->clear();
+        mPrediction->clear();
+
+        /*
+            Start of tes3mp addition
+
+            Forget what the server knows of our script variables when starting over or loading
+        */
+        mwmp::Main::get().getNetworking()->getScriptStateSync()->clear();
+        /*
+            End of tes3mp addition
+        */
     }
 
     void Scene::playerMoved(const osg::Vec3f &pos)
@@ -404,18 +514,33 @@ namespace MWWorld
         {
             int newX, newY;
             MWBase::Environment::get().getWorld()->positionToIndex(pos.x(), pos.y(), newX, newY);
-            changeCellGrid(newX, newY);
+            changeCellGrid(newX, newY, true, mStreamer->getBudget() > 0);
         }
     }
 
-    void Scene::changeCellGrid (int X, int Y, bool changeEvent)
+    void Scene::changeCellGrid (int X, int Y, bool changeEvent, bool stream)
     {
-        Loading::Listener* loadingListener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
+        // Streaming goes on while the game does, without a loading screen
+        Loading::Listener streamingListener;
+        Loading::Listener* loadingListener = stream ? &streamingListener : MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         Loading::ScopedLoad load(loadingListener);
 
         std::string loadingExteriorText = "#{sLoadingMessage3}";
         loadingListener->setLabel(loadingExteriorText);
 
+        std::map<CellStore*, unsigned int>::iterator streamed = mStreamedCells.begin();
+        while (streamed != mStreamedCells.end())
+        {
+            if (std::abs (X-streamed->first->getCell()->getGridX())<=mHalfGridSize &&
+                std::abs (Y-streamed->first->getCell()->getGridY())<=mHalfGridSize)
+                ++streamed;
+            else
+                cancelStreamedCell (streamed++);
+        }
+
+        if (!stream)
+            finishStreaming();
+
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active!=mActiveCells.end())
         {
@@ -451,7 +576,7 @@ namespace MWWorld
                     ++iter;
                 }
 
-                if (iter==mActiveCells.end())
+                if (iter==mActiveCells.end() && !stream)
                     refsToLoad += MWBase::Environment::get().getWorld()->getExterior(x, y)->count();
             }
         }
@@ -480,7 +605,10 @@ namespace MWWorld
                 {
                     CellStore *cell = MWBase::Environment::get().getWorld()->getExterior(x, y);
 
-                    loadCell (cell, loadingListener, changeEvent);
+                    if (stream)
+                        streamCell (cell, changeEvent);
+                    else
+                        loadCell (cell, loadingListener, changeEvent);
                 }
             }
         }
@@ -507,6 +635,113 @@ namespace MWWorld
             mCellChanged = true;
     }
 
+    void Scene::streamCell(CellStore *cell, bool respawn)
+    {
+        if (mActiveCells.count(cell) || mStreamedCells.count(cell))
+            return;
+
+        std::cout << "Streaming cell " << cell->getCell()->getDescription() << std::endl;
+
+        if (respawn)
+            cell->respawn();
+
+        mPreloader->requestModels(cell);
+
+        if (cell->getCell()->isExterior())
+            mRendering.getTerrain()->loadCell(cell->getCell()->getGridX(), cell->getCell()->getGridY());
+
+        const unsigned int id = mStreamer->addCell(std::bind(&Scene::finishStreamedCell, this, cell));
+        mStreamedCells[cell] = id;
+
+        ListObjectsVisitor visitor;
+        cell->forEach(visitor);
+        for (std::vector<Ptr>::const_iterator it = visitor.mObjects.begin(); it != visitor.mObjects.end(); ++it)
+        {
+            if (isStreamable(*it))
+                mStreamer->addObject(id, it->getRefData().getPosition().asVec3(), std::bind(&Scene::insertStreamedObject, this, cell, *it));
+        }
+    }
+
+    void Scene::insertStreamedObject(CellStore* cell, const Ptr& ptr)
+    {
+        // Scripts may have disabled or deleted the object since it was queued
+        if (!isStreamable(ptr) || ptr.getRefData().getBaseNode())
+            return;
+
+        try
+        {
+            addObjectRendering(ptr, getModel(ptr, mRendering.getResourceSystem()->getVFS()), mRendering);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "failed to render '" << ptr.getCellRef().getRefId() << "': " << e.what() << std::endl;
+        }
+
+        SceneUtil::PositionAttitudeTransform* node = ptr.getRefData().getBaseNode();
+        if (node && isHiddenWhileStreamed(ptr))
+        {
+            mHiddenObjects[cell].push_back(std::make_pair(ptr, node->getNodeMask()));
+            node->setNodeMask(0);
+        }
+    }
+
+    void Scene::finishStreamedCell(CellStore *cell)
+    {
+        mStreamedCells.erase(cell);
+
+        std::map<CellStore*, HiddenObjects>::iterator hidden = mHiddenObjects.find(cell);
+        if (hidden != mHiddenObjects.end())
+        {
+            for (HiddenObjects::const_iterator it = hidden->second.begin(); it != hidden->second.end(); ++it)
+            {
+                // Not rendered anymore if scripts disabled or deleted it since
+                if (SceneUtil::PositionAttitudeTransform* node = it->first.getRefData().getBaseNode())
+                    node->setNodeMask(it->second);
+            }
+            mHiddenObjects.erase(hidden);
+        }
+
+        // Scripts, physics and the mechanics get the whole cell at once, the objects rendered so far are picked up
+        // by insertCell
+        Loading::Listener streamingListener;
+        loadCell(cell, &streamingListener, false);
+
+        /*
+            Start of tes3mp addition
+
+            Send the cell state stored by loadCell, as changeCellGrid does
+        */
+        if (mwmp::Main::get().getLocalPlayer()->isLoggedIn())
+        {
+            mwmp::Main::get().getLocalPlayer()->sendCellStates();
+            mwmp::Main::get().getLocalPlayer()->clearCellStates();
+        }
+        /*
+            End of tes3mp addition
+        */
+
+        mCellChanged = true;
+    }
+
+    void Scene::cancelStreamedCell(std::map<CellStore*, unsigned int>::iterator iter)
+    {
+        CellStore* cell = iter->first;
+        std::cout << "Cancelling cell " << cell->getCell()->getDescription() << std::endl;
+
+        mStreamer->removeCell(iter->second);
+        mStreamedCells.erase(iter);
+        mHiddenObjects.erase(cell);
+
+        ListAndResetObjectsVisitor visitor;
+        cell->forEach(visitor);
+        mRendering.removeCell(cell);
+    }
+
+    void Scene::finishStreaming()
+    {
+        mStreamer->finishAll();
+    }
+
     void Scene::changePlayerCell(CellStore *cell, const ESM::Position &pos, bool adjustPlayerPos)
     {
         mCurrentCell = cell;
@@ -554,10 +789,15 @@ namespace MWWorld
     , mPreloadExteriorGrid(Settings::Manager::getBool("preload exterior grid", "Cells"))
     , mPreloadDoors(Settings::Manager::getBool("preload doors", "Cells"))
     , mPreloadFastTravel(Settings::Manager::getBool("preload fast travel", "Cells"))
+    , mPreloadTeleportHistory(Settings::Manager::getBool("preload teleport history", "Cells"))
     , mPredictionTime(Settings::Manager::getFloat("prediction time", "Cells"))
+    , mPrediction(new CellPrediction(sTeleportHistorySize))
+    , mLastCellLoadTime(0.f)
+    , mStreamer(new CellStreamer(Settings::Manager::getFloat("cell streaming budget", "Cells")))
     {
         mPreloader.reset(new CellPreloader(rendering.getResourceSystem(), physics->getShapeManager(), rendering.getTerrain(), rendering.getLandManager()));
         mPreloader->setWorkQueue(mRendering.getWorkQueue());
+        mPreloader->setLoadQueue(mRendering.getLoadQueue());
 
         mPreloader->setUnrefQueue(rendering.getUnrefQueue());
         mPhysics->setUnrefQueue(rendering.getUnrefQueue());
@@ -617,6 +857,9 @@ namespace MWWorld
         std::cout << "Changing to interior\n";
 
         // unload
+        while (!mStreamedCells.empty())
+            cancelStreamedCell(mStreamedCells.begin());
+
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active!=mActiveCells.end())
             unloadCell (active++);
@@ -627,6 +870,8 @@ namespace MWWorld
         // Load cell.
         loadCell (cell, loadingListener, changeEvent);
 
+        mPrediction->recordTeleport(mCurrentCell, cell, position.asVec3());
+
         /*
             Start of tes3mp addition
 
@@ -671,6 +916,7 @@ namespace MWWorld
         changeCellGrid(x, y, changeEvent);
 
         CellStore* current = MWBase::Environment::get().getWorld()->getExterior(x, y);
+        mPrediction->recordTeleport(mCurrentCell, current, position.asVec3());
         changePlayerCell(current, position, adjustPlayerPos);
 
         if (changeEvent)
@@ -743,29 +989,6 @@ namespace MWWorld
         return Ptr();
     }
 
-    class PreloadMeshItem : public SceneUtil::WorkItem
-    {
-    public:
-        PreloadMeshItem(const std::string& mesh, Resource::SceneManager* sceneManager)
-            : mMesh(mesh), mSceneManager(sceneManager)
-        {
-        }
-
-        virtual void doWork()
-        {
-            try
-            {
-                mSceneManager->getTemplate(mMesh);
-            }
-            catch (std::exception& e)
-            {
-            }
-        }
-    private:
-        std::string mMesh;
-        Resource::SceneManager* mSceneManager;
-    };
-
     void Scene::preload(const std::string &mesh, bool useAnim)
     {
         std::string mesh_ = mesh;
@@ -773,7 +996,26 @@ namespace MWWorld
             mesh_ = Misc::ResourceHelpers::correctActorModelPath(mesh_, mRendering.getResourceSystem()->getVFS());
 
         if (!mRendering.getResourceSystem()->getSceneManager()->checkLoaded(mesh_, mRendering.getReferenceTime()))
-            mRendering.getWorkQueue()->addWorkItem(new PreloadMeshItem(mesh_, mRendering.getResourceSystem()->getSceneManager()));
+            mRendering.getLoadQueue()->requestTemplate(mesh_, Resource::Priority_Speculative);
+    }
+
+    void Scene::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        const CellStreamer::Stats& streamerStats = mStreamer->getStats();
+        stats->setAttribute(frameNumber, "Stream Object", streamerStats.mObjects);
+        stats->setAttribute(frameNumber, "Stream Cell", streamerStats.mCells);
+        stats->setAttribute(frameNumber, "Stream ms", streamerStats.mTime);
+        stats->setAttribute(frameNumber, "Stream Pending", streamerStats.mPendingObjects);
+
+        const CellPreloader::Stats& preloaderStats = mPreloader->getStats();
+        stats->setAttribute(frameNumber, "Preload Cells", preloaderStats.mCells);
+        const unsigned int loads = preloaderStats.mHits + preloaderStats.mLate + preloaderStats.mMisses;
+        if (loads > 0)
+        {
+            stats->setAttribute(frameNumber, "Preload Hit %", 100.0 * preloaderStats.mHits / loads);
+            stats->setAttribute(frameNumber, "Preload Late %", 100.0 * preloaderStats.mLate / loads);
+            stats->setAttribute(frameNumber, "Cell Load ms", mLastCellLoadTime);
+        }
     }
 
     void Scene::preloadCells(float dt)
@@ -783,7 +1025,8 @@ namespace MWWorld
         const MWWorld::ConstPtr player = MWBase::Environment::get().getWorld()->getPlayerPtr();
         osg::Vec3f playerPos = player.getRefData().getPosition().asVec3();
         osg::Vec3f moved = playerPos - mLastPlayerPos;
-        osg::Vec3f predictedPos = playerPos + moved / dt * mPredictionTime;
+        osg::Vec3f velocity = moved / dt;
+        osg::Vec3f predictedPos = playerPos + velocity * mPredictionTime;
 
         if (mCurrentCell->isExterior())
             exteriorPositions.push_back(predictedPos);
@@ -793,17 +1036,19 @@ namespace MWWorld
         if (mPreloadEnabled)
         {
             if (mPreloadDoors)
-                preloadTeleportDoorDestinations(playerPos, predictedPos, exteriorPositions);
+                preloadTeleportDoorDestinations(playerPos, velocity, exteriorPositions);
             if (mPreloadExteriorGrid)
-                preloadExteriorGrid(playerPos, predictedPos);
+                preloadExteriorGrid(playerPos, predictedPos, velocity);
             if (mPreloadFastTravel)
                 preloadFastTravelDestinations(playerPos, predictedPos, exteriorPositions);
+            if (mPreloadTeleportHistory)
+                preloadTeleportHistory(exteriorPositions);
         }
 
         mPreloader->setTerrainPreloadPositions(exteriorPositions);
     }
 
-    void Scene::preloadTeleportDoorDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, std::vector<osg::Vec3f>& exteriorPositions)
+    void Scene::preloadTeleportDoorDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& velocity, std::vector<osg::Vec3f>& exteriorPositions)
     {
         std::vector<MWWorld::ConstPtr> teleportDoors;
         for (CellStoreCollection::const_iterator iter (mActiveCells.begin());
@@ -824,21 +1069,20 @@ namespace MWWorld
         for (std::vector<MWWorld::ConstPtr>::iterator it = teleportDoors.begin(); it != teleportDoors.end(); ++it)
         {
             const MWWorld::ConstPtr& door = *it;
-            float sqrDistToPlayer = (playerPos - door.getRefData().getPosition().asVec3()).length2();
-            sqrDistToPlayer = std::min(sqrDistToPlayer, (predictedPos - door.getRefData().getPosition().asVec3()).length2());
+            float score = CellPrediction::getApproachScore(playerPos, velocity, mPredictionTime, door.getRefData().getPosition().asVec3(), mPreloadDistance);
 
-            if (sqrDistToPlayer < mPreloadDistance*mPreloadDistance)
+            if (score > 0)
             {
                 try
                 {
                     if (!door.getCellRef().getDestCell().empty())
-                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()));
+                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()), false, score);
                     else
                     {
                         osg::Vec3f pos = door.getCellRef().getDoorDest().asVec3();
                         int x,y;
                         MWBase::Environment::get().getWorld()->positionToIndex (pos.x(), pos.y(), x, y);
-                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true, score);
                         exteriorPositions.push_back(pos);
                     }
                 }
@@ -850,7 +1094,7 @@ namespace MWWorld
         }
     }
 
-    void Scene::preloadExteriorGrid(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos)
+    void Scene::preloadExteriorGrid(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, const osg::Vec3f& velocity)
     {
         if (!MWBase::Environment::get().getWorld()->isCellExterior())
             return;
@@ -879,12 +1123,17 @@ namespace MWWorld
                 float loadDist = 8192/2 + 8192 - mCellLoadingThreshold + mPreloadDistance;
 
                 if (dist < loadDist)
-                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy));
+                {
+                    // Scored by the distance to the cell center, which is up to sqrt(2) times the one checked above
+                    const osg::Vec3f thisCellCenter (thisCellCenterX, thisCellCenterY, playerPos.z());
+                    float score = CellPrediction::getApproachScore(playerPos, velocity, mPredictionTime, thisCellCenter, loadDist * std::sqrt(2.f));
+                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy), false, score);
+                }
             }
         }
     }
 
-    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding)
+    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding, float score)
     {
         if (preloadSurrounding && cell->isExterior())
         {
@@ -895,14 +1144,14 @@ namespace MWWorld
             {
                 for (int dy = -mHalfGridSize; dy <= mHalfGridSize; ++dy)
                 {
-                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime());
+                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime(), score);
                     if (++numpreloaded >= mPreloader->getMaxCacheSize())
                         break;
                 }
             }
         }
         else
-            mPreloader->preload(cell, mRendering.getReferenceTime());
+            mPreloader->preload(cell, mRendering.getReferenceTime(), score);
     }
 
     void Scene::preloadTerrain(const osg::Vec3f &pos)
@@ -922,24 +1171,22 @@ namespace MWWorld
 
         bool operator()(const MWWorld::Ptr& ptr)
         {
-            if ((ptr.getRefData().getPosition().asVec3() - mPlayerPos).length2() > mPreloadDist * mPreloadDist)
+            float score = CellPrediction::getApproachScore(mPlayerPos, osg::Vec3f(), 0.f, ptr.getRefData().getPosition().asVec3(), mPreloadDist);
+            if (score <= 0)
                 return true;
 
-            if (ptr.getClass().isNpc())
-            {
-                const std::vector<ESM::Transport::Dest>& transport = ptr.get<ESM::NPC>()->mBase->mTransport.mList;
-                mList.insert(mList.begin(), transport.begin(), transport.end());
-            }
-            else
-            {
-                const std::vector<ESM::Transport::Dest>& transport = ptr.get<ESM::Creature>()->mBase->mTransport.mList;
-                mList.insert(mList.begin(), transport.begin(), transport.end());
-            }
+            const std::vector<ESM::Transport::Dest>& transport = ptr.getClass().isNpc()
+                    ? ptr.get<ESM::NPC>()->mBase->mTransport.mList
+                    : ptr.get<ESM::Creature>()->mBase->mTransport.mList;
+
+            // The player picks one destination of the service at most
+            for (std::vector<ESM::Transport::Dest>::const_iterator it = transport.begin(); it != transport.end(); ++it)
+                mList.push_back(std::make_pair(*it, score / transport.size()));
             return true;
         }
         float mPreloadDist;
         osg::Vec3f mPlayerPos;
-        std::vector<ESM::Transport::Dest> mList;
+        std::vector<std::pair<ESM::Transport::Dest, float> > mList;
     };
 
     void Scene::preloadFastTravelDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& /*predictedPos*/, std::vector<osg::Vec3f>& exteriorPositions) // ignore predictedPos here since opening dialogue with travel service takes extra time
@@ -954,18 +1201,41 @@ namespace MWWorld
             cellStore->forEachType<ESM::Creature>(listVisitor);
         }
 
-        for (std::vector<ESM::Transport::Dest>::const_iterator it = listVisitor.mList.begin(); it != listVisitor.mList.end(); ++it)
+        for (std::vector<std::pair<ESM::Transport::Dest, float> >::const_iterator it = listVisitor.mList.begin(); it != listVisitor.mList.end(); ++it)
         {
-            if (!it->mCellName.empty())
-                preloadCell(MWBase::Environment::get().getWorld()->getInterior(it->mCellName));
+            const ESM::Transport::Dest& dest = it->first;
+            if (!dest.mCellName.empty())
+                preloadCell(MWBase::Environment::get().getWorld()->getInterior(dest.mCellName), false, it->second);
             else
             {
-                osg::Vec3f pos = it->mPos.asVec3();
+                osg::Vec3f pos = dest.mPos.asVec3();
                 int x,y;
                 MWBase::Environment::get().getWorld()->positionToIndex( pos.x(), pos.y(), x, y);
-                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true, it->second);
                 exteriorPositions.push_back(pos);
             }
         }
     }
+
+    void Scene::preloadTeleportHistory(std::vector<osg::Vec3f>& exteriorPositions)
+    {
+        // Teleports without a door or travel service in reach, e.g. Recall or a server moving the player
+        std::vector<CellPrediction::Destination> destinations;
+        mPrediction->getLikelyDestinations(mCurrentCell, destinations);
+
+        for (size_t i = 0; i < destinations.size() && i < sTeleportHistoryDestinations; ++i)
+        {
+            const CellPrediction::Destination& destination = destinations[i];
+            if (destination.mCell->getState() == CellStore::State_Unloaded)
+                continue;
+
+            if (destination.mCell->isExterior())
+            {
+                preloadCell(destination.mCell, true, destination.mScore);
+                exteriorPositions.push_back(destination.mPosition);
+            }
+            else
+                preloadCell(destination.mCell, false, destination.mScore);
+        }
+    }
 }
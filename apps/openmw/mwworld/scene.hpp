@@ -4,11 +4,14 @@
 #include "ptr.hpp"
 #include "globals.hpp"
 
+#include <map>
 #include <set>
 #include <memory>
+#include <vector>
 
 namespace osg
 {
+    class Stats;
     class Vec3f;
 }
 
@@ -43,6 +46,8 @@ namespace MWWorld
     class Player;
     class CellStore;
     class CellPreloader;
+    class CellPrediction;
+    class CellStreamer;
 
     class Scene
     {
@@ -67,21 +72,48 @@ namespace MWWorld
             bool mPreloadExteriorGrid;
             bool mPreloadDoors;
             bool mPreloadFastTravel;
+            bool mPreloadTeleportHistory;
             float mPredictionTime;
 
             osg::Vec3f mLastPlayerPos;
 
+            std::unique_ptr<CellPrediction> mPrediction;
+
+            // Milliseconds that loading the last cell took
+            float mLastCellLoadTime;
+
+            // Cells whose objects are being inserted over several frames, with their handle in mStreamer.
+            // They become active once all objects are in.
+            std::unique_ptr<CellStreamer> mStreamer;
+            std::map<CellStore*, unsigned int> mStreamedCells;
+
+            // Actors and animated objects of the streamed cells that are rendered but hidden until their cell is
+            // active, with the node mask to restore then
+            typedef std::vector<std::pair<Ptr, unsigned int> > HiddenObjects;
+            std::map<CellStore*, HiddenObjects> mHiddenObjects;
+
             void insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener);
 
             // Load and unload cells as necessary to create a cell grid with "X" and "Y" in the center
-            void changeCellGrid (int X, int Y, bool changeEvent = true);
+            // @param stream Insert the objects of new cells over the next frames, rather than right away
+            void changeCellGrid (int X, int Y, bool changeEvent = true, bool stream = false);
+
+            void streamCell (CellStore* cell, bool respawn);
+            void insertStreamedObject (CellStore* cell, const Ptr& ptr);
+            void finishStreamedCell (CellStore* cell);
+            void cancelStreamedCell (std::map<CellStore*, unsigned int>::iterator iter);
+
+            // Insert the objects of all cells that are being streamed, making them active
+            void finishStreaming();
 
             void getGridCenter(int& cellX, int& cellY);
 
+            // Preload the cells the player may enter soon, each with a score of how likely that is
             void preloadCells(float dt);
-            void preloadTeleportDoorDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, std::vector<osg::Vec3f>& exteriorPositions);
-            void preloadExteriorGrid(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos);
+            void preloadTeleportDoorDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& velocity, std::vector<osg::Vec3f>& exteriorPositions);
+            void preloadExteriorGrid(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, const osg::Vec3f& velocity);
             void preloadFastTravelDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, std::vector<osg::Vec3f>& exteriorPositions);
+            void preloadTeleportHistory(std::vector<osg::Vec3f>& exteriorPositions);
 
         public:
 
@@ -89,7 +121,8 @@ namespace MWWorld
 
             ~Scene();
 
-            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false);
+            /// @param score How likely the player is to enter the cell soon, see CellPrediction.
+            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false, float score=1.f);
             void preloadTerrain(const osg::Vec3f& pos);
 
             void unloadCell (CellStoreCollection::iterator iter);
@@ -136,6 +169,8 @@ namespace MWWorld
             Ptr searchPtrViaActorId (int actorId);
 
             void preload(const std::string& mesh, bool useAnim=false);
+
+            void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
     };
 }
 
@@ -6,12 +6,21 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/rng.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
 
 namespace
 {
+    struct DialogueIdLess
+    {
+        bool operator()(const ESM::Dialogue* left, const ESM::Dialogue* right) const
+        {
+            return Misc::StringUtils::CiLessTransparent()(left->mId, right->mId);
+        }
+    };
+
     template<typename T>
     class GetRecords
     {
@@ -30,6 +39,16 @@ namespace
         }
     };
 
+    template<typename T>
+    struct Decoded : public MWWorld::DecodedRecord
+    {
+        T mRecord;
+        bool mIsDeleted;
+        uint32_t mFlags;
+
+        Decoded() : mIsDeleted(false), mFlags(0) {}
+    };
+
     struct Compare
     {
         bool operator()(const ESM::Land *x, const ESM::Land *y) {
@@ -121,6 +140,7 @@ namespace MWWorld
     template<typename T>
     Store<T>::Store(const Store<T>& orig)
         : mStatic(orig.mStatic)
+        , mStaticFlags(orig.mStaticFlags)
     {
     }
 
@@ -136,14 +156,12 @@ namespace MWWorld
     template<typename T>
     const T *Store<T>::search(const std::string &id) const
     {
-        std::string idLower = Misc::StringUtils::lowerCase(id);
-
-        typename Dynamic::const_iterator dit = mDynamic.find(idLower);
+        typename Dynamic::const_iterator dit = mDynamic.find(id);
         if (dit != mDynamic.end()) {
             return &dit->second;
         }
 
-        typename std::map<std::string, T>::const_iterator it = mStatic.find(idLower);
+        typename Static::const_iterator it = mStatic.find(id);
 
         if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
             return &(it->second);
@@ -198,12 +216,39 @@ namespace MWWorld
         record.load(esm, isDeleted);
         Misc::StringUtils::lowerCaseInPlace(record.mId);
 
+        return insertLoaded(record, isDeleted, esm.getRecordFlags());
+    }
+    template<typename T>
+    DecodedRecord *Store<T>::decode(ESM::ESMReader &esm) const
+    {
+        std::unique_ptr<Decoded<T> > decoded(new Decoded<T>);
+
+        decoded->mRecord.load(esm, decoded->mIsDeleted);
+        decoded->mFlags = esm.getRecordFlags();
+        Misc::StringUtils::lowerCaseInPlace(decoded->mRecord.mId);
+
+        return decoded.release();
+    }
+    template<typename T>
+    RecordId Store<T>::insertDecoded(DecodedRecord &record)
+    {
+        Decoded<T> &decoded = static_cast<Decoded<T>&>(record);
+        return insertLoaded(decoded.mRecord, decoded.mIsDeleted, decoded.mFlags);
+    }
+    template<typename T>
+    RecordId Store<T>::insertLoaded(const T &record, bool isDeleted, uint32_t flags)
+    {
         std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(record.mId, record));
         if (inserted.second)
             mShared.push_back(&inserted.first->second);
         else
             inserted.first->second = record;
 
+        if (flags != 0)
+            mStaticFlags[record.mId] = flags;
+        else
+            mStaticFlags.erase(record.mId);
+
         return RecordId(record.mId, isDeleted);
     }
     template<typename T>
@@ -273,9 +318,7 @@ namespace MWWorld
     template<typename T>
     bool Store<T>::eraseStatic(const std::string &id)
     {
-        std::string idLower = Misc::StringUtils::lowerCase(id);
-
-        typename std::map<std::string, T>::iterator it = mStatic.find(idLower);
+        typename Static::iterator it = mStatic.find(id);
 
         if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
             // delete from the static part of mShared
@@ -283,12 +326,13 @@ namespace MWWorld
             typename std::vector<T *>::iterator end = sharedIter + mStatic.size();
 
             while (sharedIter != mShared.end() && sharedIter != end) {
-                if((*sharedIter)->mId == idLower) {
+                if(*sharedIter == &it->second) {
                     mShared.erase(sharedIter);
                     break;
                 }
                 ++sharedIter;
             }
+            mStaticFlags.erase(it->first);
             mStatic.erase(it);
         }
 
@@ -298,8 +342,7 @@ namespace MWWorld
     template<typename T>
     bool Store<T>::erase(const std::string &id)
     {
-        std::string key = Misc::StringUtils::lowerCase(id);
-        typename Dynamic::iterator it = mDynamic.find(key);
+        typename Dynamic::iterator it = mDynamic.find(id);
         if (it == mDynamic.end()) {
             return false;
         }
@@ -330,6 +373,19 @@ namespace MWWorld
         }
     }
     template<typename T>
+    bool Store<T>::writeStatic (ESM::ESMWriter& writer) const
+    {
+        // The static records come first in mShared, in the order they were loaded
+        for (size_t i = 0; i < mStatic.size(); ++i)
+        {
+            typename StaticFlags::const_iterator flags = mStaticFlags.find(mShared[i]->mId);
+            writer.startRecord (T::sRecordId, flags != mStaticFlags.end() ? flags->second : 0);
+            mShared[i]->save (writer);
+            writer.endRecord (T::sRecordId);
+        }
+        return true;
+    }
+    template<typename T>
     RecordId Store<T>::read(ESM::ESMReader& reader)
     {
         T record;
@@ -530,16 +586,13 @@ namespace MWWorld
     }
     const ESM::Cell *Store<ESM::Cell>::search(const std::string &id) const
     {
-        ESM::Cell cell;
-        cell.mName = Misc::StringUtils::lowerCase(id);
-
-        std::map<std::string, ESM::Cell>::const_iterator it = mInt.find(cell.mName);
+        DynamicInt::const_iterator it = mInt.find(id);
 
         if (it != mInt.end() && Misc::StringUtils::ciEqual(it->second.mName, id)) {
             return &(it->second);
         }
 
-        DynamicInt::const_iterator dit = mDynamicInt.find(cell.mName);
+        DynamicInt::const_iterator dit = mDynamicInt.find(id);
         if (dit != mDynamicInt.end()) {
             return &dit->second;
         }
@@ -615,7 +668,7 @@ namespace MWWorld
     void Store<ESM::Cell>::setUp()
     {
         typedef DynamicExt::iterator ExtIterator;
-        typedef std::map<std::string, ESM::Cell>::iterator IntIterator;
+        typedef DynamicInt::iterator IntIterator;
 
         mSharedInt.clear();
         mSharedInt.reserve(mInt.size());
@@ -1047,10 +1100,13 @@ namespace MWWorld
 
         mShared.clear();
         mShared.reserve(mStatic.size());
-        std::map<std::string, ESM::Dialogue>::iterator it = mStatic.begin();
+        Static::iterator it = mStatic.begin();
         for (; it != mStatic.end(); ++it) {
             mShared.push_back(&(it->second));
         }
+
+        // mStatic is not ordered, but topic lists expect the dialogues sorted by ID
+        std::sort(mShared.begin(), mShared.end(), DialogueIdLess());
     }
 
     template<>
@@ -1079,6 +1135,19 @@ namespace MWWorld
         }
     }
 
+    template <>
+    DecodedRecord *Store<ESM::Dialogue>::decode(ESM::ESMReader &esm) const
+    {
+        // Dialogues are merged into the existing record and are followed by their INFOs, so they have to be loaded in order
+        return NULL;
+    }
+
+    template <>
+    bool Store<ESM::Dialogue>::writeStatic(ESM::ESMWriter &writer) const
+    {
+        return false;
+    }
+
     template <>
     inline RecordId Store<ESM::Dialogue>::load(ESM::ESMReader &esm) {
         // The original letter case of a dialogue ID is saved, because it's printed
@@ -1088,7 +1157,7 @@ namespace MWWorld
         dialogue.loadId(esm);
 
         std::string idLower = Misc::StringUtils::lowerCase(dialogue.mId);
-        std::map<std::string, ESM::Dialogue>::iterator found = mStatic.find(idLower);
+        Static::iterator found = mStatic.find(idLower);
         if (found == mStatic.end())
         {
             dialogue.loadData(esm, isDeleted);
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
+
+#include <components/misc/stringops.hpp>
 
 #include "recordcmp.hpp"
 
@@ -27,6 +31,14 @@ namespace MWWorld
         RecordId(const std::string &id = "", bool isDeleted = false);
     };
 
+    /// A record parsed ahead of time by StoreBase::decode(), waiting to be inserted in load order.
+    struct DecodedRecord
+    {
+        virtual ~DecodedRecord() {}
+    };
+
+    typedef std::vector<std::unique_ptr<DecodedRecord> > DecodedRecords;
+
     class StoreBase
     {
     public:
@@ -41,6 +53,17 @@ namespace MWWorld
         virtual int getDynamicSize() const { return 0; }
         virtual RecordId load(ESM::ESMReader &esm) = 0;
 
+        /// Parse the current record without touching the store, so that it can be done on a worker thread.
+        /// @return NULL if this store has to parse its records in load order, in which case nothing was read.
+        virtual DecodedRecord* decode(ESM::ESMReader &esm) const { return NULL; }
+
+        /// Insert a record returned by decode(), with the same result as load() would have had.
+        virtual RecordId insertDecoded(DecodedRecord &record) { return RecordId(); }
+
+        /// Write the records loaded from content files, for stores that support decode().
+        /// @return false if this store does not support it, in which case nothing was written.
+        virtual bool writeStatic(ESM::ESMWriter& writer) const { return false; }
+
         virtual bool eraseStatic(const std::string &id) {return false;}
         virtual void clearDynamic() {}
 
@@ -138,17 +161,25 @@ namespace MWWorld
     template <class T>
     class Store : public StoreBase
     {
-        std::map<std::string, T>      mStatic;
+        // Keys are lower case, but can be looked up in any case without allocating. The static records
+        // are hashed, the dynamic ones stay ordered to keep savegames and mShared deterministic.
+        typedef std::map<std::string, T, Misc::StringUtils::CiLessTransparent> Dynamic;
+        typedef std::unordered_map<std::string, T, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> Static;
+
+        Static              mStatic;
         std::vector<T *>    mShared; // Preserves the record order as it came from the content files (this
                                      // is relevant for the spell autocalc code and selection order
                                      // for heads/hairs in the character creation)
-        std::map<std::string, T> mDynamic;
+        Dynamic             mDynamic;
 
-        typedef std::map<std::string, T> Dynamic;
-        typedef std::map<std::string, T> Static;
+        // Record header flags of the static records that had any, so that writeStatic() keeps them
+        typedef std::unordered_map<std::string, uint32_t, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> StaticFlags;
+        StaticFlags         mStaticFlags;
 
         friend class ESMStore;
 
+        RecordId insertLoaded(const T &record, bool isDeleted, uint32_t flags);
+
     public:
         Store();
         Store(const Store<T> &orig);
@@ -192,6 +223,9 @@ namespace MWWorld
         bool erase(const T &item);
 
         RecordId load(ESM::ESMReader &esm);
+        DecodedRecord* decode(ESM::ESMReader &esm) const;
+        RecordId insertDecoded(DecodedRecord &record);
+        bool writeStatic(ESM::ESMWriter& writer) const;
         void write(ESM::ESMWriter& writer, Loading::Listener& progress) const;
         RecordId read(ESM::ESMReader& reader);
     };
@@ -268,7 +302,7 @@ namespace MWWorld
             }
         };
 
-        typedef std::map<std::string, ESM::Cell>                           DynamicInt;
+        typedef std::map<std::string, ESM::Cell, Misc::StringUtils::CiLessTransparent> DynamicInt;
         typedef std::map<std::pair<int, int>, ESM::Cell, DynamicExtCmp>    DynamicExt;
 
         DynamicInt      mInt;
@@ -77,6 +77,7 @@
 
 #include "contentloader.hpp"
 #include "esmloader.hpp"
+#include "loadordercache.hpp"
 
 namespace
 {
@@ -107,6 +108,13 @@ namespace MWWorld
             return mLoaders.insert(std::make_pair(extension, loader)).second;
         }
 
+        void prepare(const boost::filesystem::path& filepath, int index)
+        {
+            LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(filepath.extension().string())));
+            if (it != mLoaders.end())
+                it->second->prepare(filepath, index);
+        }
+
         void load(const boost::filesystem::path& filepath, int& index)
         {
             LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(filepath.extension().string())));
@@ -168,7 +176,7 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
         int activationDistanceOverride, const std::string& startCell, const std::string& startupScript,
-            const std::string& resourcePath, const std::string& userDataPath)
+            const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath)
     : mResourceSystem(resourceSystem), mFallback(fallbackMap), mLocalScripts (mStore),
       mSky (true), mCells (mStore, mEsm),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles), mUserDataPath(userDataPath),
@@ -177,6 +185,11 @@ namespace MWWorld
       mLevitationEnabled(true), mGoToJail(false), mDaysInPrison(0), mSpellPreloadTimer(0.f)
     {
         mPhysics.reset(new MWPhysics::PhysicsSystem(resourceSystem, rootNode));
+        if (Settings::Manager::getBool("enable", "Navigator"))
+        {
+            const bool cache = Settings::Manager::getBool("cache", "Navigator");
+            mPhysics->enableNavigation(cache ? (boost::filesystem::path(cachePath) / "navigation").string() : std::string());
+        }
         mRendering.reset(new MWRender::RenderingManager(viewer, rootNode, resourceSystem, workQueue, &mFallback, resourcePath));
         mProjectileManager.reset(new ProjectileManager(mRendering->getLightRoot(), resourceSystem, mRendering.get(), mPhysics.get()));
 
@@ -187,7 +200,7 @@ namespace MWWorld
         listener->loadingOn();
 
         GameContentLoader gameContentLoader(*listener);
-        EsmLoader esmLoader(mStore, mEsm, encoder, *listener);
+        EsmLoader esmLoader(mStore, mEsm, encoder, *listener, Settings::Manager::getInt("content loader threads", "General"));
 
         gameContentLoader.addLoader(".esm", &esmLoader);
         gameContentLoader.addLoader(".esp", &esmLoader);
@@ -195,6 +208,13 @@ namespace MWWorld
         gameContentLoader.addLoader(".omwaddon", &esmLoader);
         gameContentLoader.addLoader(".project", &esmLoader);
 
+        std::unique_ptr<LoadOrderCache> loadOrderCache;
+        if (Settings::Manager::getBool("load order cache", "General"))
+        {
+            loadOrderCache.reset(new LoadOrderCache(boost::filesystem::path(cachePath) / "loadorder.cache", encoder->getEncoding()));
+            esmLoader.setCache(loadOrderCache.get());
+        }
+
         loadContentFiles(fileCollections, contentFiles, gameContentLoader);
 
         listener->loadingOff();
@@ -1437,6 +1457,7 @@ namespace MWWorld
             mRendering->moveObject(newPtr, vec);
             if (movePhysics)
                 mPhysics->updatePosition(newPtr);
+            MWBase::Environment::get().getMechanicsManager()->updatePosition(newPtr);
         }
         if (isPlayer)
         {
@@ -2009,6 +2030,12 @@ namespace MWWorld
         MWBase::Environment::get().getSoundManager()->setListenerPosDir(listenerPos, forward, up, underwater);
     }
 
+    void World::reportStats (unsigned int frameNumber, osg::Stats* stats) const
+    {
+        mPhysics->reportStats(frameNumber, stats);
+        mWorldScene->reportStats(frameNumber, stats);
+    }
+
     void World::updateWindowManager ()
     {
         try
@@ -2908,6 +2935,26 @@ namespace MWWorld
         return mPhysics->getLineOfSight(actor, targetActor);
     }
 
+    void World::prefetchLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& pairs)
+    {
+        // Same as getLOS(), which does not ask the physics about these
+        std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> > active;
+        for (std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+        {
+            if (it->first.getRefData().isEnabled() && it->second.getRefData().isEnabled()
+                    && it->first.getRefData().getBaseNode() && it->second.getRefData().getBaseNode())
+                active.push_back(*it);
+        }
+
+        mPhysics->prefetchLineOfSight(active);
+    }
+
+    bool World::findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                   std::vector<osg::Vec3f>& path) const
+    {
+        return mPhysics->findNavigationPath(cell, start, end, path);
+    }
+
     float World::getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater)
     {
         osg::Vec3f to (dir);
@@ -3079,15 +3126,16 @@ namespace MWWorld
     void World::loadContentFiles(const Files::Collections& fileCollections,
         const std::vector<std::string>& content, ContentLoader& contentLoader)
     {
+        std::vector<boost::filesystem::path> paths;
         std::vector<std::string>::const_iterator it(content.begin());
         std::vector<std::string>::const_iterator end(content.end());
-        for (int idx = 0; it != end; ++it, ++idx)
+        for (; it != end; ++it)
         {
             boost::filesystem::path filename(*it);
             const Files::MultiDirCollection& col = fileCollections.getCollection(filename.extension().string());
             if (col.doesExist(*it))
             {
-                contentLoader.load(col.getPath(*it), idx);
+                paths.push_back(col.getPath(*it));
             }
             else
             {
@@ -3096,6 +3144,12 @@ namespace MWWorld
                 throw std::runtime_error(msg.str());
             }
         }
+
+        for (int idx = 0; idx < static_cast<int>(paths.size()); ++idx)
+            contentLoader.prepare(paths[idx], idx);
+
+        for (int idx = 0; idx < static_cast<int>(paths.size()); ++idx)
+            contentLoader.load(paths[idx], idx);
     }
 
     bool World::startSpellCast(const Ptr &actor)
@@ -20,6 +20,7 @@
 namespace osg
 {
     class Group;
+    class Stats;
 }
 
 namespace osgViewer
@@ -196,7 +197,8 @@ namespace MWWorld
                 const Files::Collections& fileCollections,
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
-                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath);
+                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath, const std::string& userDataPath,
+                const std::string& cachePath);
 
             virtual ~World();
 
@@ -603,6 +605,8 @@ namespace MWWorld
 
             void updateWindowManager () override;
 
+            void reportStats (unsigned int frameNumber, osg::Stats* stats) const override;
+
             MWWorld::Ptr placeObject (const MWWorld::ConstPtr& object, float cursorX, float cursorY, int amount) override;
             ///< copy and place an object into the gameworld at the specified cursor position
             /// @param object
@@ -703,6 +707,14 @@ namespace MWWorld
             bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) override;
             ///< get Line of Sight (morrowind stupid implementation)
 
+            void prefetchLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& pairs) override;
+            ///< Work out the Line of Sight for all of these pairs at once, for the getLOS() calls that follow in this frame.
+
+            bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                    std::vector<osg::Vec3f>& path) const override;
+            ///< Find a path from \a start to \a end over the collision geometry of \a cell, if its navigation grid is built.
+            /// \a path receives the points to walk through after \a start, excluding \a end.
+
             float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false) override;
 
             void enableActorCollision(const MWWorld::Ptr& actor, bool enable) override;
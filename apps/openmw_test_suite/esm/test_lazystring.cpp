@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "components/esm/esmreader.hpp"
+#include "components/esm/esmwriter.hpp"
+#include "components/esm/loadscpt.hpp"
+#include "components/to_utf8/to_utf8.hpp"
+
+namespace
+{
+    struct EsmLazyStringTest : public ::testing::Test
+    {
+        std::string mFile;
+
+        EsmLazyStringTest()
+            : mFile((boost::filesystem::temp_directory_path()
+                     / boost::filesystem::unique_path("openmw_test_lazystring_%%%%%%%%.esp")).string())
+        {
+        }
+
+        ~EsmLazyStringTest()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(mFile, ec);
+        }
+
+        void writeScript(const std::string& text)
+        {
+            ESM::Script script;
+            script.mId = "lazy_script";
+            script.blank();
+            script.mScriptText = text;
+
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.setVersion();
+            writer.setRecordCount(1);
+
+            std::ofstream stream(mFile.c_str(), std::ios::binary);
+            writer.save(stream);
+            writer.startRecord(ESM::Script::sRecordId);
+            script.save(writer);
+            writer.endRecord(ESM::Script::sRecordId);
+            writer.close();
+        }
+
+        ESM::Script readScript(bool lazy, ToUTF8::Utf8Encoder* encoder = NULL)
+        {
+            ESM::ESMReader reader;
+            reader.setEncoder(encoder);
+            reader.setLazyLoading(lazy);
+            reader.open(mFile);
+
+            reader.getRecName();
+            reader.getRecHeader();
+
+            ESM::Script script;
+            bool isDeleted = false;
+            script.load(reader, isDeleted);
+            return script;
+        }
+    };
+}
+
+TEST_F(EsmLazyStringTest, eager_by_default)
+{
+    writeScript("Begin lazy_script\nEnd\n");
+
+    ESM::Script script = readScript(false);
+    EXPECT_FALSE(script.mScriptText.isDeferred());
+    EXPECT_EQ(script.mScriptText.get(), "Begin lazy_script\nEnd\n");
+}
+
+TEST_F(EsmLazyStringTest, read_on_first_access)
+{
+    writeScript("Begin lazy_script\nEnd\n");
+
+    ESM::Script script = readScript(true);
+    EXPECT_TRUE(script.mScriptText.isDeferred());
+
+    // The reader is closed by now, the text comes from the file
+    ESM::Script copy = script;
+    EXPECT_EQ(script.mScriptText.get(), "Begin lazy_script\nEnd\n");
+    EXPECT_FALSE(script.mScriptText.isDeferred());
+    EXPECT_EQ(copy.mScriptText.get(), "Begin lazy_script\nEnd\n");
+}
+
+TEST_F(EsmLazyStringTest, converted_on_first_access)
+{
+    // "ä" in Windows-1252
+    writeScript("Begin lazy_script\n\xe4\nEnd\n");
+
+    ToUTF8::Utf8Encoder encoder(ToUTF8::WINDOWS_1252);
+    ESM::Script script = readScript(true, &encoder);
+    EXPECT_EQ(script.mScriptText.get(), "Begin lazy_script\n\xc3\xa4\nEnd\n");
+}
+
+TEST_F(EsmLazyStringTest, converted_eagerly)
+{
+    // The text fills its subrecord without a zero terminator, which a memory mapped file does not add either
+    writeScript("Begin lazy_script\n\xe4\nEnd\n");
+
+    ToUTF8::Utf8Encoder encoder(ToUTF8::WINDOWS_1252);
+    ESM::Script script = readScript(false, &encoder);
+    EXPECT_EQ(script.mScriptText.get(), "Begin lazy_script\n\xc3\xa4\nEnd\n");
+}
+
+TEST_F(EsmLazyStringTest, assignment_replaces_deferred_text)
+{
+    writeScript("Begin lazy_script\nEnd\n");
+
+    ESM::Script script = readScript(true);
+    script.mScriptText = "replaced";
+    EXPECT_FALSE(script.mScriptText.isDeferred());
+    EXPECT_EQ(script.mScriptText.get(), "replaced");
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "components/esm/refid.hpp"
+
+TEST(EsmRefId, empty)
+{
+    ESM::RefId id;
+    EXPECT_TRUE(id.empty());
+    EXPECT_EQ(id, ESM::RefId(""));
+    EXPECT_EQ(id.toString(), "");
+    EXPECT_EQ(id.getSpelling(), "");
+}
+
+TEST(EsmRefId, case_insensitive)
+{
+    ESM::RefId mixed("Gold_001");
+    ESM::RefId lower("gold_001");
+
+    EXPECT_EQ(mixed, lower);
+    EXPECT_EQ(mixed.hash(), lower.hash());
+    EXPECT_EQ(mixed.toString(), "gold_001");
+    EXPECT_NE(mixed, ESM::RefId("gold_005"));
+}
+
+TEST(EsmRefId, keeps_spelling)
+{
+    ESM::RefId mixed("Misc_Com_Bucket_01");
+    ESM::RefId upper("MISC_COM_BUCKET_01");
+    ESM::RefId lower("misc_com_bucket_01");
+
+    EXPECT_EQ(mixed, upper);
+    EXPECT_EQ(mixed.getSpelling(), "Misc_Com_Bucket_01");
+    EXPECT_EQ(upper.getSpelling(), "MISC_COM_BUCKET_01");
+    EXPECT_EQ(lower.getSpelling(), "misc_com_bucket_01");
+    EXPECT_EQ(ESM::RefId("Misc_Com_Bucket_01").getSpelling(), "Misc_Com_Bucket_01");
+}
+
+TEST(EsmRefId, search)
+{
+    EXPECT_TRUE(ESM::RefId::search("refid_search_never_interned").empty());
+
+    ESM::RefId id("RefId_Search_Interned");
+    EXPECT_EQ(ESM::RefId::search("refid_search_interned"), id);
+    EXPECT_TRUE(ESM::RefId::search("").empty());
+}
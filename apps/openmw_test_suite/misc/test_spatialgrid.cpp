@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "components/misc/spatialgrid.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::vector<int> getInRange(const Misc::SpatialGrid<int>& grid, const osg::Vec3f& position, float radius)
+    {
+        std::vector<int> result;
+        grid.getInRange(position, radius, result);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(MiscSpatialGrid, empty)
+{
+    Misc::SpatialGrid<int> grid(1024);
+    EXPECT_EQ(grid.size(), 0u);
+    EXPECT_TRUE(getInRange(grid, osg::Vec3f(0, 0, 0), 10000).empty());
+}
+
+TEST(MiscSpatialGrid, range_is_inclusive_and_three_dimensional)
+{
+    Misc::SpatialGrid<int> grid(1024);
+    grid.add(1, osg::Vec3f(100, 0, 0));
+    grid.add(2, osg::Vec3f(0, 0, 101));
+    grid.add(3, osg::Vec3f(-1500, -1500, 0));
+
+    EXPECT_EQ(getInRange(grid, osg::Vec3f(0, 0, 0), 100), std::vector<int>({1}));
+    EXPECT_EQ(getInRange(grid, osg::Vec3f(0, 0, 0), 101), std::vector<int>({1, 2}));
+    EXPECT_EQ(getInRange(grid, osg::Vec3f(-1400, -1400, 0), 200), std::vector<int>({3}));
+}
+
+TEST(MiscSpatialGrid, any_in_range)
+{
+    Misc::SpatialGrid<int> grid(1024);
+    EXPECT_FALSE(grid.isAnyInRange(osg::Vec3f(0, 0, 0), 100000));
+
+    grid.add(1, osg::Vec3f(100, 0, 0));
+    grid.add(2, osg::Vec3f(110, 0, 0));
+    grid.add(3, osg::Vec3f(-1500, -1500, 0));
+
+    EXPECT_TRUE(grid.isAnyInRange(osg::Vec3f(0, 0, 0), 100));
+    EXPECT_FALSE(grid.isAnyInRange(osg::Vec3f(0, 0, 0), 99));
+    EXPECT_TRUE(grid.isAnyInRange(osg::Vec3f(-1400, -1400, 0), 200));
+    EXPECT_TRUE(grid.isAnyInRange(osg::Vec3f(0, 0, 0), 100000));
+}
+
+TEST(MiscSpatialGrid, clear)
+{
+    Misc::SpatialGrid<int> grid(1024);
+    grid.add(1, osg::Vec3f(0, 0, 0));
+    grid.clear();
+    EXPECT_EQ(grid.size(), 0u);
+    EXPECT_TRUE(getInRange(grid, osg::Vec3f(0, 0, 0), 100).empty());
+}
+
+TEST(MiscSpatialGrid, same_as_scanning_all_values)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> coordinate(-20000, 20000);
+
+    Misc::SpatialGrid<int> grid(1024);
+    std::vector<osg::Vec3f> positions;
+    for (int i = 0; i < 500; ++i)
+    {
+        positions.push_back(osg::Vec3f(coordinate(generator), coordinate(generator), coordinate(generator) / 10));
+        grid.add(i, positions.back());
+    }
+    EXPECT_EQ(grid.size(), 500u);
+
+    const float radii[] = {0, 500, 3000, 7168, 100000};
+    for (float radius : radii)
+    {
+        for (int i = 0; i < 50; ++i)
+        {
+            osg::Vec3f position (coordinate(generator), coordinate(generator), 0);
+            std::vector<int> expected;
+            for (size_t j = 0; j < positions.size(); ++j)
+                if ((positions[j] - position).length2() <= radius * radius)
+                    expected.push_back(j);
+
+            EXPECT_EQ(getInRange(grid, position, radius), expected) << "radius " << radius;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "apps/openmw/mwmechanics/aischeduler.hpp"
+
+#include <vector>
+
+namespace
+{
+    const float sFrameDuration = 1.f / 60;
+    const float sDecisionCost = 1.f;
+    const float sSteeringCost = 0.1f;
+
+    /// Run a frame in which every actor that may decide takes sDecisionCost milliseconds, and the others sSteeringCost.
+    /// @return The actors that decided.
+    std::vector<size_t> runFrame(MWMechanics::AiScheduler& scheduler, std::vector<MWMechanics::AiSchedule>& schedules,
+                                 const std::vector<float>& priorities)
+    {
+        scheduler.beginFrame(sFrameDuration);
+        for (size_t i = 0; i < schedules.size(); ++i)
+            scheduler.addActor(schedules[i], priorities[i]);
+        scheduler.schedule();
+
+        std::vector<size_t> decided;
+        for (size_t i = 0; i < schedules.size(); ++i)
+        {
+            if (schedules[i].mMayDecide)
+                decided.push_back(i);
+            scheduler.reportTime(schedules[i], schedules[i].mMayDecide ? sDecisionCost : sSteeringCost, schedules[i].mMayDecide);
+        }
+        scheduler.endFrame();
+        return decided;
+    }
+}
+
+TEST(MWMechanicsAiScheduler, without_budget_every_actor_decides)
+{
+    MWMechanics::AiScheduler scheduler(0);
+    std::vector<MWMechanics::AiSchedule> schedules(10);
+    const std::vector<float> priorities(10, 1.f);
+
+    for (int frame = 0; frame < 10; ++frame)
+        EXPECT_EQ(runFrame(scheduler, schedules, priorities).size(), 10u);
+    EXPECT_EQ(scheduler.getStats().mOverrunFrames, 0u);
+}
+
+TEST(MWMechanicsAiScheduler, budget_limits_decisions_per_frame)
+{
+    MWMechanics::AiScheduler scheduler(3);
+    std::vector<MWMechanics::AiSchedule> schedules(10);
+    const std::vector<float> priorities(10, 1.f);
+
+    // New actors decide at once, which goes over the budget while the costs are not known yet
+    EXPECT_EQ(runFrame(scheduler, schedules, priorities).size(), 10u);
+    EXPECT_EQ(scheduler.getStats().mOverrunFrames, 1u);
+    EXPECT_FLOAT_EQ(scheduler.getStats().mOverrun, 10 * sDecisionCost - 3);
+
+    std::vector<int> decisions(10, 0);
+    for (int frame = 0; frame < 300; ++frame)
+    {
+        const std::vector<size_t> decided = runFrame(scheduler, schedules, priorities);
+        EXPECT_LE(decided.size(), 3u);
+        for (size_t i : decided)
+            ++decisions[i];
+    }
+
+    // Actors of the same priority take turns
+    for (int count : decisions)
+    {
+        EXPECT_GE(count, 30);
+        EXPECT_LE(count, 90);
+    }
+    EXPECT_LT(scheduler.getStats().mOverrunFrames, 50u);
+}
+
+TEST(MWMechanicsAiScheduler, priority_decides_more_often)
+{
+    MWMechanics::AiScheduler scheduler(2);
+    std::vector<MWMechanics::AiSchedule> schedules(4);
+    std::vector<float> priorities;
+    priorities.push_back(MWMechanics::AiScheduler::getPriority(100, true));
+    priorities.push_back(MWMechanics::AiScheduler::getPriority(100, false));
+    priorities.push_back(MWMechanics::AiScheduler::getPriority(4000, false));
+    priorities.push_back(MWMechanics::AiScheduler::getPriority(4000, false));
+
+    std::vector<int> decisions(4, 0);
+    for (int frame = 0; frame < 300; ++frame)
+        for (size_t i : runFrame(scheduler, schedules, priorities))
+            ++decisions[i];
+
+    EXPECT_GT(decisions[0], decisions[1]);
+    EXPECT_GT(decisions[1], decisions[2]);
+}
+
+TEST(MWMechanicsAiScheduler, no_actor_waits_longer_than_a_second)
+{
+    // Far too little for anyone
+    MWMechanics::AiScheduler scheduler(0.01f);
+    std::vector<MWMechanics::AiSchedule> schedules(20);
+    std::vector<float> priorities(20, 1.f);
+    priorities[0] = 100.f;
+
+    std::vector<int> lastDecision(20, 0);
+    for (int frame = 1; frame <= 300; ++frame)
+    {
+        for (size_t i : runFrame(scheduler, schedules, priorities))
+            lastDecision[i] = frame;
+        for (int last : lastDecision)
+            EXPECT_LE((frame - last) * sFrameDuration, 1.f + sFrameDuration);
+    }
+}
+
+TEST(MWMechanicsAiScheduler, only_actual_decisions_count)
+{
+    MWMechanics::AiScheduler scheduler(3);
+    std::vector<MWMechanics::AiSchedule> schedules(2);
+
+    scheduler.beginFrame(sFrameDuration);
+    for (MWMechanics::AiSchedule& schedule : schedules)
+        scheduler.addActor(schedule, 1.f);
+    scheduler.schedule();
+    ASSERT_TRUE(schedules[0].mMayDecide);
+    ASSERT_TRUE(schedules[1].mMayDecide);
+
+    // The AI of the second actor was not due to react, so it only steered
+    scheduler.reportTime(schedules[0], sDecisionCost, true);
+    scheduler.reportTime(schedules[1], sSteeringCost, false);
+    scheduler.endFrame();
+
+    EXPECT_EQ(scheduler.getStats().mDecisions, 1u);
+    EXPECT_FLOAT_EQ(schedules[0].mWaited, 0.f);
+    EXPECT_FLOAT_EQ(schedules[0].mDecisionCost, sDecisionCost);
+    EXPECT_GT(schedules[1].mWaited, 0.f);
+    EXPECT_LT(schedules[1].mDecisionCost, 0.f);
+    EXPECT_FLOAT_EQ(schedules[1].mSteeringCost, sSteeringCost);
+}
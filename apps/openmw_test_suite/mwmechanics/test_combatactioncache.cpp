@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <new>
+
+#include <components/esm/loadspel.hpp>
+
+#include "apps/openmw/mwmechanics/revisioncheck.hpp"
+#include "apps/openmw/mwmechanics/spells.hpp"
+
+namespace
+{
+    /// Stands in for MWWorld::ContainerStore, which cannot be set up without the rest of the engine.
+    /// Like it, every change takes a revision from a counter that all stores share.
+    class TestInventory
+    {
+    public:
+        TestInventory() : mRevision(++sLastRevision) {}
+
+        void add() { flagAsModified(); }
+        void remove() { flagAsModified(); }
+        void equip() { flagAsModified(); }
+
+        unsigned int getRevision() const { return mRevision; }
+
+    private:
+        void flagAsModified() { mRevision = ++sLastRevision; }
+
+        static unsigned int sLastRevision;
+        unsigned int mRevision;
+    };
+
+    unsigned int TestInventory::sLastRevision = 0;
+
+    ESM::Spell makeSpell(const std::string& id, int type)
+    {
+        ESM::Spell spell;
+        spell.blank();
+        spell.mId = id;
+        spell.mData.mType = type;
+        return spell;
+    }
+}
+
+TEST(MWMechanicsCombatActionCache, inventory_changes_invalidate)
+{
+    TestInventory inventory;
+    MWMechanics::RevisionCheck<TestInventory> check;
+
+    EXPECT_TRUE(check.update(inventory));
+    EXPECT_FALSE(check.update(inventory));
+
+    inventory.add();
+    EXPECT_TRUE(check.update(inventory));
+    EXPECT_FALSE(check.update(inventory));
+
+    inventory.remove();
+    EXPECT_TRUE(check.update(inventory));
+    EXPECT_FALSE(check.update(inventory));
+
+    inventory.equip();
+    EXPECT_TRUE(check.update(inventory));
+    EXPECT_FALSE(check.update(inventory));
+}
+
+TEST(MWMechanicsCombatActionCache, another_inventory_invalidates)
+{
+    std::unique_ptr<TestInventory> inventory(new TestInventory);
+    MWMechanics::RevisionCheck<TestInventory> check;
+    EXPECT_TRUE(check.update(*inventory));
+
+    TestInventory other;
+    EXPECT_TRUE(check.update(other));
+    EXPECT_TRUE(check.update(*inventory));
+
+    // A new inventory in the place of the old one, as an actor that was removed and added again would have
+    inventory->~TestInventory();
+    new (inventory.get()) TestInventory;
+    EXPECT_TRUE(check.update(*inventory));
+}
+
+TEST(MWMechanicsCombatActionCache, spell_changes_invalidate)
+{
+    const ESM::Spell fireball = makeSpell("fireball", ESM::Spell::ST_Spell);
+    const ESM::Spell frostbite = makeSpell("frostbite", ESM::Spell::ST_Spell);
+
+    MWMechanics::Spells spells;
+    MWMechanics::RevisionCheck<MWMechanics::Spells> check;
+    EXPECT_TRUE(check.update(spells));
+    EXPECT_FALSE(check.update(spells));
+
+    spells.add(&fireball);
+    EXPECT_TRUE(check.update(spells));
+    EXPECT_FALSE(check.update(spells));
+
+    // already known
+    spells.add(&fireball);
+    EXPECT_FALSE(check.update(spells));
+
+    spells.add(&frostbite);
+    EXPECT_TRUE(check.update(spells));
+
+    spells.remove(&fireball);
+    EXPECT_TRUE(check.update(spells));
+    EXPECT_FALSE(check.update(spells));
+
+    // not known
+    spells.remove(&fireball);
+    EXPECT_FALSE(check.update(spells));
+
+    spells.clear();
+    EXPECT_TRUE(check.update(spells));
+}
+
+TEST(MWMechanicsCombatActionCache, another_spell_list_invalidates)
+{
+    MWMechanics::Spells spells;
+    MWMechanics::Spells other;
+    MWMechanics::RevisionCheck<MWMechanics::Spells> check;
+
+    // Both at the same revision
+    EXPECT_TRUE(check.update(spells));
+    EXPECT_TRUE(check.update(other));
+    EXPECT_FALSE(check.update(other));
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "apps/openmw/mwmechanics/pathgrid.hpp"
+
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+    const long long sUnreachable = -1;
+
+    void addEdge(ESM::Pathgrid& pathgrid, int from, int to)
+    {
+        ESM::Pathgrid::Edge edge;
+        edge.mV0 = from;
+        edge.mV1 = to;
+        pathgrid.mEdges.push_back(edge);
+    }
+
+    /// A square of side by side points linked to their neighbours both ways, with some links missing like walls,
+    /// and one more point off on its own.
+    ESM::Pathgrid makePathgrid(int side, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<int> jitter(-40, 40);
+        std::uniform_int_distribution<int> percent(0, 99);
+
+        ESM::Pathgrid pathgrid;
+        for (int y = 0; y < side; ++y)
+            for (int x = 0; x < side; ++x)
+                pathgrid.mPoints.push_back(ESM::Pathgrid::Point(x * 200 + jitter(generator), y * 200 + jitter(generator),
+                                                                jitter(generator)));
+        pathgrid.mPoints.push_back(ESM::Pathgrid::Point(-1000, -1000, 0));
+
+        for (int y = 0; y < side; ++y)
+        {
+            for (int x = 0; x < side; ++x)
+            {
+                const int index = y * side + x;
+                if (x + 1 < side && percent(generator) < 75)
+                {
+                    addEdge(pathgrid, index, index + 1);
+                    addEdge(pathgrid, index + 1, index);
+                }
+                if (y + 1 < side && percent(generator) < 75)
+                {
+                    addEdge(pathgrid, index, index + side);
+                    addEdge(pathgrid, index + side, index);
+                }
+            }
+        }
+        return pathgrid;
+    }
+
+    long long getCost(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        return std::abs(a.mX - b.mX) + std::abs(a.mY - b.mY) + std::abs(a.mZ - b.mZ);
+    }
+
+    /// Cost of the cheapest path between every pair of points, by Floyd-Warshall.
+    std::vector<std::vector<long long> > getShortestCosts(const ESM::Pathgrid& pathgrid)
+    {
+        const size_t size = pathgrid.mPoints.size();
+        std::vector<std::vector<long long> > costs (size, std::vector<long long>(size, sUnreachable));
+        for (size_t i = 0; i < size; ++i)
+            costs[i][i] = 0;
+        for (const ESM::Pathgrid::Edge& edge : pathgrid.mEdges)
+            costs[edge.mV0][edge.mV1] = getCost(pathgrid.mPoints[edge.mV0], pathgrid.mPoints[edge.mV1]);
+
+        for (size_t k = 0; k < size; ++k)
+            for (size_t i = 0; i < size; ++i)
+                for (size_t j = 0; j < size; ++j)
+                    if (costs[i][k] != sUnreachable && costs[k][j] != sUnreachable
+                            && (costs[i][j] == sUnreachable || costs[i][k] + costs[k][j] < costs[i][j]))
+                        costs[i][j] = costs[i][k] + costs[k][j];
+        return costs;
+    }
+
+    bool isSamePoint(const ESM::Pathgrid::Point& a, const ESM::Pathgrid::Point& b)
+    {
+        return a.mX == b.mX && a.mY == b.mY && a.mZ == b.mZ;
+    }
+
+    bool hasEdge(const ESM::Pathgrid& pathgrid, const ESM::Pathgrid::Point& from, const ESM::Pathgrid::Point& to)
+    {
+        for (const ESM::Pathgrid::Edge& edge : pathgrid.mEdges)
+            if (isSamePoint(pathgrid.mPoints[edge.mV0], from) && isSamePoint(pathgrid.mPoints[edge.mV1], to))
+                return true;
+        return false;
+    }
+
+    /// Every path has to go along edges from start to end and cost as little as possible.
+    void checkAllPaths(const ESM::Pathgrid& pathgrid)
+    {
+        const MWMechanics::PathgridGraph graph (&pathgrid);
+        const std::vector<std::vector<long long> > costs = getShortestCosts(pathgrid);
+        const int size = static_cast<int>(pathgrid.mPoints.size());
+
+        for (int start = 0; start < size; ++start)
+        {
+            for (int end = 0; end < size; ++end)
+            {
+                const std::list<ESM::Pathgrid::Point> path = graph.aStarSearch(start, end);
+                ASSERT_EQ(graph.isPointConnected(start, end), costs[start][end] != sUnreachable);
+                if (costs[start][end] == sUnreachable)
+                {
+                    EXPECT_TRUE(path.empty());
+                    continue;
+                }
+
+                ASSERT_FALSE(path.empty());
+                EXPECT_TRUE(isSamePoint(path.front(), pathgrid.mPoints[start]));
+                EXPECT_TRUE(isSamePoint(path.back(), pathgrid.mPoints[end]));
+
+                long long cost = 0;
+                for (std::list<ESM::Pathgrid::Point>::const_iterator it = path.begin(), next = ++path.begin();
+                     next != path.end(); ++it, ++next)
+                {
+                    ASSERT_TRUE(hasEdge(pathgrid, *it, *next));
+                    cost += getCost(*it, *next);
+                }
+                EXPECT_EQ(cost, costs[start][end]) << start << " to " << end;
+            }
+        }
+    }
+}
+
+TEST(MWMechanicsPathgridGraph, no_pathgrid)
+{
+    const MWMechanics::PathgridGraph graph (NULL);
+    EXPECT_EQ(graph.getPathgrid(), nullptr);
+}
+
+TEST(MWMechanicsPathgridGraph, path_to_start_is_start)
+{
+    const ESM::Pathgrid pathgrid = makePathgrid(2, 1);
+    const MWMechanics::PathgridGraph graph (&pathgrid);
+    const std::list<ESM::Pathgrid::Point> path = graph.aStarSearch(1, 1);
+    ASSERT_EQ(path.size(), 1u);
+    EXPECT_TRUE(isSamePoint(path.front(), pathgrid.mPoints[1]));
+}
+
+TEST(MWMechanicsPathgridGraph, one_way_edges)
+{
+    ESM::Pathgrid pathgrid;
+    pathgrid.mPoints.push_back(ESM::Pathgrid::Point(0, 0, 0));
+    pathgrid.mPoints.push_back(ESM::Pathgrid::Point(100, 0, 0));
+    pathgrid.mPoints.push_back(ESM::Pathgrid::Point(200, 0, 0));
+    addEdge(pathgrid, 0, 1);
+    addEdge(pathgrid, 1, 0);
+    addEdge(pathgrid, 1, 2);
+
+    const MWMechanics::PathgridGraph graph (&pathgrid);
+    EXPECT_TRUE(graph.isPointConnected(0, 1));
+    EXPECT_FALSE(graph.isPointConnected(1, 2));
+    EXPECT_TRUE(graph.aStarSearch(0, 2).empty());
+    EXPECT_EQ(graph.aStarSearch(1, 0).size(), 2u);
+}
+
+TEST(MWMechanicsPathgridGraph, small_pathgrids_find_shortest_paths)
+{
+    // small enough for the table of next points
+    checkAllPaths(makePathgrid(8, 2));
+    checkAllPaths(makePathgrid(11, 3));
+}
+
+TEST(MWMechanicsPathgridGraph, large_pathgrids_find_shortest_paths)
+{
+    // just past the table of next points
+    checkAllPaths(makePathgrid(12, 4));
+}
+
+TEST(MWMechanicsPathgridGraph, large_pathgrids_return_cached_paths_unchanged)
+{
+    const ESM::Pathgrid pathgrid = makePathgrid(16, 5);
+    const MWMechanics::PathgridGraph graph (&pathgrid);
+    const int last = 16 * 16 - 1;
+
+    // more paths than are cached, then the first ones again
+    std::vector<std::list<ESM::Pathgrid::Point> > paths;
+    for (int start = 0; start < 40; ++start)
+        paths.push_back(graph.aStarSearch(start, last - start));
+    for (int start = 0; start < 40; ++start)
+    {
+        const std::list<ESM::Pathgrid::Point> path = graph.aStarSearch(start, last - start);
+        ASSERT_EQ(path.size(), paths[start].size());
+        EXPECT_TRUE(std::equal(path.begin(), path.end(), paths[start].begin(), isSamePoint));
+    }
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "apps/openmw/mwworld/cellprediction.hpp"
+
+#include <vector>
+
+namespace
+{
+    // Only compared, never dereferenced
+    char sCells[4] = {};
+    MWWorld::CellStore* const sBalmora = reinterpret_cast<MWWorld::CellStore*>(&sCells[0]);
+    MWWorld::CellStore* const sCaldera = reinterpret_cast<MWWorld::CellStore*>(&sCells[1]);
+    MWWorld::CellStore* const sMark = reinterpret_cast<MWWorld::CellStore*>(&sCells[2]);
+    MWWorld::CellStore* const sVivec = reinterpret_cast<MWWorld::CellStore*>(&sCells[3]);
+
+    const osg::Vec3f sOrigin (0, 0, 0);
+    const osg::Vec3f sNorth (0, 100, 0);
+}
+
+TEST(MWWorldCellPrediction, approach_score_is_one_at_the_target_and_zero_out_of_reach)
+{
+    EXPECT_FLOAT_EQ(1.f, MWWorld::CellPrediction::getApproachScore(sOrigin, osg::Vec3f(), 1, sOrigin, 1000));
+    EXPECT_FLOAT_EQ(0.5f, MWWorld::CellPrediction::getApproachScore(sOrigin, osg::Vec3f(), 1, osg::Vec3f(500, 0, 0), 1000));
+    EXPECT_FLOAT_EQ(0.f, MWWorld::CellPrediction::getApproachScore(sOrigin, osg::Vec3f(), 1, osg::Vec3f(2000, 0, 0), 1000));
+}
+
+TEST(MWWorldCellPrediction, approach_score_follows_the_path_of_the_player)
+{
+    const osg::Vec3f ahead (0, 500, 0);
+    const osg::Vec3f behind (0, -500, 0);
+
+    EXPECT_FLOAT_EQ(1.f, MWWorld::CellPrediction::getApproachScore(sOrigin, sNorth, 5, ahead, 1000));
+    EXPECT_FLOAT_EQ(0.5f, MWWorld::CellPrediction::getApproachScore(sOrigin, sNorth, 5, behind, 1000));
+
+    // Passed halfway along the path
+    EXPECT_FLOAT_EQ(0.9f, MWWorld::CellPrediction::getApproachScore(sOrigin, sNorth, 10, osg::Vec3f(100, 500, 0), 1000));
+
+    // Beyond the end of the path
+    EXPECT_FLOAT_EQ(0.5f, MWWorld::CellPrediction::getApproachScore(sOrigin, sNorth, 1, osg::Vec3f(0, 600, 0), 1000));
+}
+
+TEST(MWWorldCellPrediction, no_destinations_without_teleports)
+{
+    MWWorld::CellPrediction prediction(8);
+    prediction.recordTeleport(NULL, sBalmora, sOrigin);
+
+    std::vector<MWWorld::CellPrediction::Destination> destinations;
+    prediction.getLikelyDestinations(sBalmora, destinations);
+
+    EXPECT_TRUE(destinations.empty());
+}
+
+TEST(MWWorldCellPrediction, recall_from_anywhere_goes_to_the_mark)
+{
+    MWWorld::CellPrediction prediction(8);
+    const osg::Vec3f markPosition (10, 20, 30);
+    prediction.recordTeleport(sBalmora, sMark, markPosition);
+    prediction.recordTeleport(sCaldera, sMark, markPosition);
+
+    std::vector<MWWorld::CellPrediction::Destination> destinations;
+    prediction.getLikelyDestinations(sVivec, destinations);
+
+    ASSERT_EQ(1u, destinations.size());
+    EXPECT_EQ(sMark, destinations[0].mCell);
+    EXPECT_EQ(markPosition, destinations[0].mPosition);
+    EXPECT_FLOAT_EQ(1.f, destinations[0].mScore);
+}
+
+TEST(MWWorldCellPrediction, teleports_out_of_the_current_cell_count_the_most)
+{
+    MWWorld::CellPrediction prediction(8);
+    prediction.recordTeleport(sBalmora, sCaldera, sOrigin);
+    prediction.recordTeleport(sVivec, sMark, sOrigin);
+
+    std::vector<MWWorld::CellPrediction::Destination> destinations;
+    prediction.getLikelyDestinations(sBalmora, destinations);
+
+    ASSERT_EQ(2u, destinations.size());
+    EXPECT_EQ(sCaldera, destinations[0].mCell);
+    EXPECT_FLOAT_EQ(2.f / 3, destinations[0].mScore);
+    EXPECT_EQ(sMark, destinations[1].mCell);
+    EXPECT_FLOAT_EQ(1.f / 3, destinations[1].mScore);
+
+    destinations.clear();
+    prediction.getLikelyDestinations(sVivec, destinations);
+
+    ASSERT_EQ(2u, destinations.size());
+    EXPECT_EQ(sMark, destinations[0].mCell);
+    EXPECT_EQ(sCaldera, destinations[1].mCell);
+}
+
+TEST(MWWorldCellPrediction, the_current_cell_is_not_a_destination)
+{
+    MWWorld::CellPrediction prediction(8);
+    prediction.recordTeleport(sBalmora, sCaldera, sOrigin);
+    prediction.recordTeleport(sCaldera, sBalmora, sOrigin);
+
+    std::vector<MWWorld::CellPrediction::Destination> destinations;
+    prediction.getLikelyDestinations(sCaldera, destinations);
+
+    ASSERT_EQ(1u, destinations.size());
+    EXPECT_EQ(sBalmora, destinations[0].mCell);
+}
+
+TEST(MWWorldCellPrediction, old_teleports_are_forgotten)
+{
+    MWWorld::CellPrediction prediction(2);
+    prediction.recordTeleport(sBalmora, sMark, sOrigin);
+    prediction.recordTeleport(sBalmora, sCaldera, sOrigin);
+    prediction.recordTeleport(sBalmora, sVivec, sOrigin);
+
+    std::vector<MWWorld::CellPrediction::Destination> destinations;
+    prediction.getLikelyDestinations(sBalmora, destinations);
+
+    ASSERT_EQ(2u, destinations.size());
+    EXPECT_EQ(sVivec, destinations[0].mCell);
+    EXPECT_EQ(sCaldera, destinations[1].mCell);
+
+    prediction.clear();
+    destinations.clear();
+    prediction.getLikelyDestinations(sBalmora, destinations);
+    EXPECT_TRUE(destinations.empty());
+}
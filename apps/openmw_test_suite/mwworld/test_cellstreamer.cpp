@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "apps/openmw/mwworld/cellstreamer.hpp"
+
+#include <string>
+#include <vector>
+
+#include <osg/Timer>
+
+namespace
+{
+    // Each insert takes longer than this budget, so that updates do one step each
+    const float sTinyBudget = 0.001f;
+
+    const osg::Vec3f sEye (0, 0, 0);
+    const osg::Vec3f sForward (0, 1, 0);
+
+    /// Records what the streamer does, in order.
+    struct Log
+    {
+        std::vector<std::string> mEvents;
+
+        MWWorld::CellStreamer::Callback record(const std::string& event)
+        {
+            return [this, event] ()
+            {
+                const osg::Timer_t start = osg::Timer::instance()->tick();
+                while (osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()) < sTinyBudget * 10)
+                    ;
+                mEvents.push_back(event);
+            };
+        }
+    };
+}
+
+TEST(MWWorldCellStreamer, without_budget_everything_is_done_in_one_update)
+{
+    MWWorld::CellStreamer streamer(0);
+    Log log;
+    const unsigned int cell = streamer.addCell(log.record("cell"));
+    for (int i = 0; i < 10; ++i)
+        streamer.addObject(cell, osg::Vec3f(0, i * 100.f, 0), log.record("object"));
+
+    streamer.update(sEye, sForward);
+
+    EXPECT_EQ(11u, log.mEvents.size());
+    EXPECT_EQ("cell", log.mEvents.back());
+    EXPECT_TRUE(streamer.isEmpty());
+    EXPECT_EQ(10u, streamer.getStats().mObjects);
+    EXPECT_EQ(1u, streamer.getStats().mCells);
+}
+
+TEST(MWWorldCellStreamer, budget_spreads_objects_over_updates)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int cell = streamer.addCell(log.record("cell"));
+    for (int i = 0; i < 3; ++i)
+        streamer.addObject(cell, osg::Vec3f(0, i * 100.f, 0), log.record("object"));
+
+    for (unsigned int i = 1; i <= 3; ++i)
+    {
+        streamer.update(sEye, sForward);
+        EXPECT_EQ(i, log.mEvents.size());
+        EXPECT_EQ(3u - i, streamer.getStats().mPendingObjects);
+    }
+    EXPECT_FALSE(streamer.isEmpty());
+
+    streamer.update(sEye, sForward);
+    EXPECT_EQ("cell", log.mEvents.back());
+    EXPECT_TRUE(streamer.isEmpty());
+}
+
+TEST(MWWorldCellStreamer, nearest_objects_in_front_of_the_camera_go_first)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int cell = streamer.addCell(log.record("cell"));
+    streamer.addObject(cell, osg::Vec3f(0, 4000, 0), log.record("far"));
+    streamer.addObject(cell, osg::Vec3f(0, -500, 0), log.record("behind"));
+    streamer.addObject(cell, osg::Vec3f(0, 500, 0), log.record("near"));
+
+    for (int i = 0; i < 4; ++i)
+        streamer.update(sEye, sForward);
+
+    const std::vector<std::string> expected = {"near", "behind", "far", "cell"};
+    EXPECT_EQ(expected, log.mEvents);
+}
+
+TEST(MWWorldCellStreamer, priorities_follow_the_camera)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int cell = streamer.addCell(log.record("cell"));
+    streamer.addObject(cell, osg::Vec3f(0, 500, 0), log.record("north"));
+    streamer.addObject(cell, osg::Vec3f(0, -500, 0), log.record("south"));
+
+    streamer.update(sEye, -sForward);
+
+    EXPECT_EQ(std::vector<std::string>(1, "south"), log.mEvents);
+}
+
+TEST(MWWorldCellStreamer, each_cell_is_finished_right_after_its_last_object)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int near = streamer.addCell(log.record("near cell"));
+    const unsigned int far = streamer.addCell(log.record("far cell"));
+    streamer.addObject(far, osg::Vec3f(0, 3000, 0), log.record("far object"));
+    streamer.addObject(near, osg::Vec3f(0, 100, 0), log.record("near object"));
+
+    while (!streamer.isEmpty())
+        streamer.update(sEye, sForward);
+
+    const std::vector<std::string> expected = {"near object", "near cell", "far object", "far cell"};
+    EXPECT_EQ(expected, log.mEvents);
+}
+
+TEST(MWWorldCellStreamer, cells_without_objects_are_finished_first)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int full = streamer.addCell(log.record("full cell"));
+    streamer.addObject(full, osg::Vec3f(0, 100, 0), log.record("object"));
+    streamer.addCell(log.record("empty cell"));
+
+    streamer.update(sEye, sForward);
+
+    EXPECT_EQ(std::vector<std::string>(1, "empty cell"), log.mEvents);
+}
+
+TEST(MWWorldCellStreamer, removed_cells_are_never_finished)
+{
+    MWWorld::CellStreamer streamer(sTinyBudget);
+    Log log;
+    const unsigned int removed = streamer.addCell(log.record("removed cell"));
+    const unsigned int kept = streamer.addCell(log.record("kept cell"));
+    streamer.addObject(removed, osg::Vec3f(0, 100, 0), log.record("removed object"));
+    streamer.addObject(removed, osg::Vec3f(0, 200, 0), log.record("removed object"));
+    streamer.addObject(kept, osg::Vec3f(0, 300, 0), log.record("kept object"));
+
+    streamer.update(sEye, sForward);
+    streamer.removeCell(removed);
+    EXPECT_EQ(1u, streamer.getStats().mPendingObjects);
+    EXPECT_EQ(1u, streamer.getStats().mPendingCells);
+
+    streamer.finishAll();
+
+    const std::vector<std::string> expected = {"removed object", "kept object", "kept cell"};
+    EXPECT_EQ(expected, log.mEvents);
+    EXPECT_TRUE(streamer.isEmpty());
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include <components/files/configurationmanager.hpp>
 #include <components/esm/esmreader.hpp>
@@ -8,6 +11,7 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 
 #include "apps/openmw/mwworld/esmstore.hpp"
+#include "apps/openmw/mwworld/loadordercache.hpp"
 
 static Loading::Listener dummyListener;
 
@@ -313,3 +317,274 @@ TEST_F(StoreTest, overwrite_test)
 
     ASSERT_TRUE (overwrittenRec && overwrittenRec->mModel == "the_new_model");
 }
+
+/// Create an ESM file in-memory that overrides, deletes and reinserts records of the previous plugins.
+Files::IStreamPtr getPluginFile(int plugin)
+{
+    ESM::ESMWriter writer;
+    std::stringstream* stream = new std::stringstream;
+    writer.setFormat(0);
+    writer.save(*stream);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        std::ostringstream id;
+        id << "Apparatus" << i;
+
+        ESM::Apparatus apparatus;
+        apparatus.blank();
+        apparatus.mId = id.str();
+        apparatus.mModel = "plugin" + std::to_string(plugin);
+
+        writer.startRecord(ESM::Apparatus::sRecordId);
+        apparatus.save(writer, (i + plugin) % 7 == 0);
+        writer.endRecord(ESM::Apparatus::sRecordId);
+
+        // Dialogues are not decoded in advance, mix them in to check that the order is kept
+        if (i % 10 == 0)
+        {
+            ESM::Dialogue dialogue;
+            dialogue.blank();
+            dialogue.mId = "Topic" + std::to_string(plugin * 10 + i);
+            dialogue.mType = ESM::Dialogue::Topic;
+
+            writer.startRecord(ESM::Dialogue::sRecordId);
+            dialogue.save(writer);
+            writer.endRecord(ESM::Dialogue::sRecordId);
+        }
+
+        ESM::Static stat;
+        stat.mId = "static" + std::to_string((i * (plugin + 1)) % 20);
+        stat.mModel = id.str() + ".nif";
+
+        writer.startRecord(ESM::Static::sRecordId);
+        stat.save(writer);
+        writer.endRecord(ESM::Static::sRecordId);
+    }
+
+    return Files::IStreamPtr(stream);
+}
+
+template <typename T>
+std::string serializeRecord(const T& record)
+{
+    ESM::ESMWriter writer;
+    std::stringstream stream;
+    writer.setFormat(0);
+    writer.save(stream);
+    writer.startRecord(T::sRecordId);
+    record.save(writer);
+    writer.endRecord(T::sRecordId);
+    return stream.str();
+}
+
+template <typename T>
+void compareStores(const MWWorld::ESMStore& expected, const MWWorld::ESMStore& actual)
+{
+    const MWWorld::Store<T>& expectedStore = expected.get<T>();
+    const MWWorld::Store<T>& actualStore = actual.get<T>();
+
+    ASSERT_EQ(expectedStore.getSize(), actualStore.getSize());
+
+    typename MWWorld::Store<T>::iterator expectedIt = expectedStore.begin();
+    typename MWWorld::Store<T>::iterator actualIt = actualStore.begin();
+    for (; expectedIt != expectedStore.end(); ++expectedIt, ++actualIt)
+        ASSERT_EQ(serializeRecord(*expectedIt), serializeRecord(*actualIt));
+}
+
+/// Tests that records decoded on worker threads end up exactly as if every file was loaded serially.
+TEST_F(StoreTest, decode_test)
+{
+    const int numPlugins = 4;
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    for (int i = 0; i < numPlugins; ++i)
+    {
+        reader.open(getPluginFile(i), "filename");
+        mEsmStore.load(reader, &dummyListener);
+    }
+    mEsmStore.setUp();
+
+    MWWorld::ESMStore decodedStore;
+    std::vector<MWWorld::DecodedRecords> decoded(numPlugins);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numPlugins; ++i)
+    {
+        threads.push_back(std::thread([&decodedStore, &decoded, i] ()
+        {
+            ESM::ESMReader decodeReader;
+            decodeReader.open(getPluginFile(i), "filename");
+            decodedStore.decode(decodeReader, decoded[i]);
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (int i = 0; i < numPlugins; ++i)
+    {
+        ASSERT_FALSE (decoded[i].empty());
+
+        reader.open(getPluginFile(i), "filename");
+        decodedStore.load(reader, &dummyListener, &decoded[i]);
+    }
+    decodedStore.setUp();
+
+    compareStores<ESM::Apparatus>(mEsmStore, decodedStore);
+    compareStores<ESM::Dialogue>(mEsmStore, decodedStore);
+    compareStores<ESM::Static>(mEsmStore, decodedStore);
+}
+
+/// Loads the given content files through the load order cache, and writes it if it did not match.
+/// @return Were the cached records used?
+bool loadWithCache(MWWorld::ESMStore& store, MWWorld::LoadOrderCache& cache, const std::vector<boost::filesystem::path>& files)
+{
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    cache.setContentFiles(files);
+    bool cached = cache.load(store);
+
+    for (std::vector<boost::filesystem::path>::const_iterator it = files.begin(); it != files.end(); ++it)
+    {
+        reader.open(it->string());
+        store.load(reader, &dummyListener);
+    }
+
+    if (!cached)
+        cache.save(store);
+    store.setUp();
+    return cached;
+}
+
+/// Tests that a warm start from the load order cache gives the same records as a cold start, and that
+/// changing a content file invalidates the cache.
+TEST_F(StoreTest, load_order_cache_test)
+{
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory);
+
+    std::vector<boost::filesystem::path> files;
+    for (int i = 0; i < 3; ++i)
+    {
+        files.push_back(directory / ("plugin" + std::to_string(i) + ".esp"));
+        boost::filesystem::ofstream stream(files.back(), std::ios::binary);
+        stream << getPluginFile(i)->rdbuf();
+    }
+
+    MWWorld::LoadOrderCache cache(directory / "loadorder.cache", 0);
+
+    EXPECT_FALSE (loadWithCache(mEsmStore, cache, files));
+
+    MWWorld::ESMStore warmStore;
+    EXPECT_TRUE (loadWithCache(warmStore, cache, files));
+
+    compareStores<ESM::Apparatus>(mEsmStore, warmStore);
+    compareStores<ESM::Dialogue>(mEsmStore, warmStore);
+    compareStores<ESM::Static>(mEsmStore, warmStore);
+
+    // replace one of the plugins
+    {
+        boost::filesystem::ofstream stream(files[1], std::ios::binary);
+        stream << getPluginFile(3)->rdbuf();
+    }
+
+    MWWorld::ESMStore changedStore;
+    EXPECT_FALSE (loadWithCache(changedStore, cache, files));
+
+    boost::filesystem::remove_all(directory);
+}
+
+/// Tests that the load order cache keeps the record flags, which some records are loaded from.
+TEST_F(StoreTest, load_order_cache_record_flags_test)
+{
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory);
+
+    std::vector<boost::filesystem::path> files;
+    files.push_back(directory / "npcs.esp");
+    {
+        boost::filesystem::ofstream stream(files.back(), std::ios::binary);
+
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            ESM::NPC npc;
+            npc.blank();
+            npc.mId = "npc" + std::to_string(i);
+
+            writer.startRecord(ESM::NPC::sRecordId, i % 2 == 0 ? 0x0400 : 0);
+            npc.save(writer);
+            writer.endRecord(ESM::NPC::sRecordId);
+        }
+        writer.close();
+    }
+
+    MWWorld::LoadOrderCache cache(directory / "loadorder.cache", 0);
+
+    EXPECT_FALSE (loadWithCache(mEsmStore, cache, files));
+
+    MWWorld::ESMStore warmStore;
+    EXPECT_TRUE (loadWithCache(warmStore, cache, files));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const std::string id = "npc" + std::to_string(i);
+        EXPECT_EQ (i % 2 == 0, mEsmStore.get<ESM::NPC>().find(id)->mPersistent);
+        EXPECT_EQ (i % 2 == 0, warmStore.get<ESM::NPC>().find(id)->mPersistent);
+    }
+
+    boost::filesystem::remove_all(directory);
+}
+
+/// Tests that records loaded from the load order cache keep their text when the cache file is written again.
+TEST_F(StoreTest, load_order_cache_rewrite_test)
+{
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory);
+
+    const std::string text = "Begin cached_script\nEnd\n";
+
+    std::vector<boost::filesystem::path> files;
+    files.push_back(directory / "scripts.esp");
+    {
+        boost::filesystem::ofstream stream(files.back(), std::ios::binary);
+
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+
+        ESM::Script script;
+        script.blank();
+        script.mId = "cached_script";
+        script.mScriptText = text;
+
+        writer.startRecord(ESM::Script::sRecordId);
+        script.save(writer);
+        writer.endRecord(ESM::Script::sRecordId);
+        writer.close();
+    }
+
+    MWWorld::LoadOrderCache cache(directory / "loadorder.cache", 0);
+
+    EXPECT_FALSE (loadWithCache(mEsmStore, cache, files));
+
+    MWWorld::ESMStore warmStore;
+    EXPECT_TRUE (loadWithCache(warmStore, cache, files));
+
+    // replace the cache file with one of a different size
+    MWWorld::ESMStore emptyStore;
+    cache.save(emptyStore);
+
+    EXPECT_EQ (text, warmStore.get<ESM::Script>().find("cached_script")->mScriptText.get());
+
+    boost::filesystem::remove_all(directory);
+}
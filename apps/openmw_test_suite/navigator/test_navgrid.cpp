@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include "components/navigator/navgrid.hpp"
+#include "components/navigator/navgridbuilder.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+    struct Box
+    {
+        osg::Vec3f mMin;
+        osg::Vec3f mMax;
+    };
+
+    /// Flat ground at z = 0 with solid boxes on it, standing in for the collision geometry of a cell.
+    class BoxGeometry : public Navigator::Geometry
+    {
+    public:
+        void addBox(const osg::Vec3f& min, const osg::Vec3f& max)
+        {
+            Box box = {min, max};
+            mBoxes.push_back(box);
+        }
+
+        virtual void castDown(float x, float y, float fromZ, float toZ, std::vector<Hit>& hits) const
+        {
+            std::vector<float> tops;
+            for (const Box& box : mBoxes)
+            {
+                if (x >= box.mMin.x() && x <= box.mMax.x() && y >= box.mMin.y() && y <= box.mMax.y())
+                    tops.push_back(box.mMax.z());
+            }
+            tops.push_back(0);
+            std::sort(tops.rbegin(), tops.rend());
+
+            for (float z : tops)
+            {
+                if (z <= fromZ && z >= toZ)
+                {
+                    Hit hit = {z, 1.f};
+                    hits.push_back(hit);
+                }
+            }
+        }
+
+        virtual bool isBlocked(const osg::Vec3f& from, const osg::Vec3f& to) const
+        {
+            for (const Box& box : mBoxes)
+            {
+                // Clip the segment against the slabs of the box
+                float enter = 0;
+                float leave = 1;
+                for (int axis = 0; axis < 3 && enter <= leave; ++axis)
+                {
+                    const float delta = to[axis] - from[axis];
+                    if (delta == 0)
+                    {
+                        if (from[axis] < box.mMin[axis] || from[axis] > box.mMax[axis])
+                            leave = -1;
+                        continue;
+                    }
+                    float near = (box.mMin[axis] - from[axis]) / delta;
+                    float far = (box.mMax[axis] - from[axis]) / delta;
+                    if (near > far)
+                        std::swap(near, far);
+                    enter = std::max(enter, near);
+                    leave = std::min(leave, far);
+                }
+                if (enter <= leave)
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        std::vector<Box> mBoxes;
+    };
+
+    const float sMaxZDistance = 50;
+
+    osg::ref_ptr<Navigator::NavGrid> build(const BoxGeometry& geometry)
+    {
+        return Navigator::buildNavGrid(geometry, osg::Vec3f(0, 0, -100), osg::Vec3f(1024, 1024, 500), Navigator::BuildSettings());
+    }
+
+    /// @return whether every leg of the path from \a start to \a end stays clear of \a geometry.
+    bool isClear(const BoxGeometry& geometry, const osg::Vec3f& start, const std::vector<osg::Vec3f>& path, const osg::Vec3f& end)
+    {
+        const osg::Vec3f offset (0, 0, 34);
+        osg::Vec3f from = start;
+        for (const osg::Vec3f& point : path)
+        {
+            if (geometry.isBlocked(from + offset, point + offset))
+                return false;
+            from = point;
+        }
+        return !geometry.isBlocked(from + offset, end + offset);
+    }
+}
+
+TEST(NavigatorNavGrid, straight_line_on_open_ground)
+{
+    BoxGeometry geometry;
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+    EXPECT_EQ(grid->getWidth(), 32);
+    EXPECT_EQ(grid->getHeight(), 32);
+    EXPECT_EQ(grid->getNumNodes(), 32u * 32u);
+
+    std::vector<osg::Vec3f> path;
+    EXPECT_TRUE(grid->findPath(osg::Vec3f(100, 100, 0), osg::Vec3f(900, 700, 0), sMaxZDistance, path));
+    EXPECT_TRUE(path.empty());
+}
+
+TEST(NavigatorNavGrid, goes_around_a_wall_through_its_gap)
+{
+    BoxGeometry geometry;
+    geometry.addBox(osg::Vec3f(-10, 480, 0), osg::Vec3f(800, 520, 200));
+    geometry.addBox(osg::Vec3f(950, 480, 0), osg::Vec3f(1034, 520, 200));
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+
+    const osg::Vec3f start (200, 200, 0);
+    const osg::Vec3f end (200, 800, 0);
+    std::vector<osg::Vec3f> path;
+    ASSERT_TRUE(grid->findPath(start, end, sMaxZDistance, path));
+    ASSERT_FALSE(path.empty());
+    EXPECT_TRUE(isClear(geometry, start, path, end));
+
+    bool throughGap = false;
+    for (const osg::Vec3f& point : path)
+        throughGap = throughGap || (point.x() > 800 && point.x() < 950);
+    EXPECT_TRUE(throughGap);
+}
+
+TEST(NavigatorNavGrid, no_path_through_a_closed_wall)
+{
+    BoxGeometry geometry;
+    geometry.addBox(osg::Vec3f(-10, 480, 0), osg::Vec3f(1034, 520, 200));
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+
+    std::vector<osg::Vec3f> path;
+    EXPECT_FALSE(grid->findPath(osg::Vec3f(200, 200, 0), osg::Vec3f(200, 800, 0), sMaxZDistance, path));
+    EXPECT_TRUE(grid->findPath(osg::Vec3f(200, 200, 0), osg::Vec3f(800, 300, 0), sMaxZDistance, path));
+}
+
+TEST(NavigatorNavGrid, climbs_steps_but_not_walls)
+{
+    BoxGeometry geometry;
+    geometry.addBox(osg::Vec3f(600, 100, 0), osg::Vec3f(900, 400, 30));
+    geometry.addBox(osg::Vec3f(600, 600, 0), osg::Vec3f(900, 900, 100));
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+
+    std::vector<osg::Vec3f> path;
+    EXPECT_TRUE(grid->findPath(osg::Vec3f(200, 200, 0), osg::Vec3f(750, 250, 30), sMaxZDistance, path));
+    EXPECT_FALSE(grid->findPath(osg::Vec3f(200, 200, 0), osg::Vec3f(750, 750, 100), sMaxZDistance, path));
+}
+
+TEST(NavigatorNavGrid, walks_under_a_bridge)
+{
+    BoxGeometry geometry;
+    geometry.addBox(osg::Vec3f(-10, 400, 300), osg::Vec3f(1034, 600, 320));
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+    EXPECT_GT(grid->getNumNodes(), 32u * 32u);
+
+    std::vector<osg::Vec3f> path;
+    EXPECT_TRUE(grid->findPath(osg::Vec3f(500, 200, 0), osg::Vec3f(500, 800, 0), sMaxZDistance, path));
+    EXPECT_TRUE(path.empty());
+    EXPECT_FALSE(grid->findPath(osg::Vec3f(500, 200, 0), osg::Vec3f(500, 500, 320), sMaxZDistance, path));
+}
+
+TEST(NavigatorNavGrid, points_off_the_grid)
+{
+    BoxGeometry geometry;
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+
+    std::vector<osg::Vec3f> path;
+    EXPECT_FALSE(grid->contains(osg::Vec3f(2000, 100, 0)));
+    EXPECT_FALSE(grid->findPath(osg::Vec3f(100, 100, 0), osg::Vec3f(2000, 100, 0), sMaxZDistance, path));
+    EXPECT_FALSE(grid->findPath(osg::Vec3f(100, 100, 0), osg::Vec3f(500, 100, 300), sMaxZDistance, path));
+}
+
+TEST(NavigatorNavGrid, write_and_read)
+{
+    BoxGeometry geometry;
+    geometry.addBox(osg::Vec3f(-10, 480, 0), osg::Vec3f(800, 520, 200));
+    osg::ref_ptr<Navigator::NavGrid> grid = build(geometry);
+
+    std::stringstream stream;
+    grid->write(stream, 42);
+    const std::string data = stream.str();
+
+    std::istringstream input (data);
+    osg::ref_ptr<Navigator::NavGrid> copy = Navigator::NavGrid::read(input, 42);
+    ASSERT_TRUE(copy.get());
+    EXPECT_EQ(copy->getNumNodes(), grid->getNumNodes());
+
+    const osg::Vec3f start (200, 200, 0);
+    const osg::Vec3f end (200, 800, 0);
+    std::vector<osg::Vec3f> path;
+    std::vector<osg::Vec3f> copyPath;
+    EXPECT_TRUE(grid->findPath(start, end, sMaxZDistance, path));
+    EXPECT_TRUE(copy->findPath(start, end, sMaxZDistance, copyPath));
+    EXPECT_EQ(path, copyPath);
+
+    std::istringstream otherKey (data);
+    EXPECT_FALSE(Navigator::NavGrid::read(otherKey, 43).get());
+
+    std::istringstream truncated (data.substr(0, data.size() - 1));
+    EXPECT_FALSE(Navigator::NavGrid::read(truncated, 42).get());
+}
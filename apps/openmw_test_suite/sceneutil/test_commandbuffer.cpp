@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "components/sceneutil/commandbuffer.hpp"
+#include "components/sceneutil/workqueue.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// Stands in for the per-NPC update of MWMechanics::Actors: own stats are changed in the job,
+    /// what other NPCs or the sound and GUI would see goes through the commands.
+    struct Npc
+    {
+        float mBreath;
+        float mHealth;
+        int mPackages;
+    };
+
+    struct World
+    {
+        std::vector<Npc> mNpcs;
+        std::vector<std::string> mLog;
+    };
+
+    World makeWorld()
+    {
+        World world;
+        for (int i = 0; i < 200; ++i)
+        {
+            Npc npc;
+            npc.mBreath = (i % 7) * 0.5f;
+            npc.mHealth = 100.f - i % 13;
+            npc.mPackages = 0;
+            world.mNpcs.push_back(npc);
+        }
+        return world;
+    }
+
+    const float sDuration = 0.25f;
+
+    void updateNpc(World& world, unsigned int index, SceneUtil::CommandBuffer& commands)
+    {
+        Npc& npc = world.mNpcs[index];
+        npc.mBreath = std::max(0.f, npc.mBreath - sDuration);
+        if (npc.mBreath == 0.f)
+        {
+            // Dying would reach the world, so the health is changed on the main thread
+            const float damage = 3.f * sDuration;
+            commands.push([&world, index, damage]
+            {
+                world.mNpcs[index].mHealth -= damage;
+                world.mLog.push_back("drown " + std::to_string(index));
+            });
+
+            // Reaches another NPC, so it has to wait for the main thread
+            unsigned int other = (index + 1) % world.mNpcs.size();
+            commands.push([&world, other] { ++world.mNpcs[other].mPackages; });
+        }
+    }
+
+    void update(World& world, SceneUtil::WorkQueue* workQueue, int frames)
+    {
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            SceneUtil::runJobs(workQueue, world.mNpcs.size(), [&] (unsigned int index, SceneUtil::CommandBuffer& commands)
+            {
+                updateNpc(world, index, commands);
+            });
+        }
+    }
+
+    /// Like the actor update without worker threads, which updates every NPC right after its AI
+    /// instead of all of them at the end.
+    void updateInline(World& world, int frames)
+    {
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            for (unsigned int index = 0; index < world.mNpcs.size(); ++index)
+            {
+                SceneUtil::CommandBuffer commands;
+                updateNpc(world, index, commands);
+                commands.commit();
+            }
+        }
+    }
+
+    void expectSame(const World& expected, const World& actual)
+    {
+        ASSERT_EQ(expected.mNpcs.size(), actual.mNpcs.size());
+        for (size_t i = 0; i < expected.mNpcs.size(); ++i)
+        {
+            EXPECT_EQ(expected.mNpcs[i].mBreath, actual.mNpcs[i].mBreath) << i;
+            EXPECT_EQ(expected.mNpcs[i].mHealth, actual.mNpcs[i].mHealth) << i;
+            EXPECT_EQ(expected.mNpcs[i].mPackages, actual.mNpcs[i].mPackages) << i;
+        }
+        EXPECT_EQ(expected.mLog, actual.mLog);
+        EXPECT_FALSE(expected.mLog.empty());
+    }
+}
+
+TEST(SceneUtilCommandBuffer, commit_runs_in_push_order_once)
+{
+    std::vector<int> order;
+    SceneUtil::CommandBuffer commands;
+    EXPECT_TRUE(commands.empty());
+    commands.push([&order] { order.push_back(1); });
+    commands.push([&order] { order.push_back(2); });
+    EXPECT_FALSE(commands.empty());
+
+    commands.commit();
+    EXPECT_EQ(order, std::vector<int>({1, 2}));
+    EXPECT_TRUE(commands.empty());
+
+    commands.commit();
+    EXPECT_EQ(order.size(), 2u);
+}
+
+TEST(SceneUtilCommandBuffer, parallel_jobs_match_serial_path)
+{
+    World serial = makeWorld();
+    update(serial, NULL, 20);
+
+    osg::ref_ptr<SceneUtil::WorkQueue> workQueue = new SceneUtil::WorkQueue(4);
+    World parallel = makeWorld();
+    update(parallel, workQueue.get(), 20);
+
+    expectSame(serial, parallel);
+}
+
+TEST(SceneUtilCommandBuffer, no_worker_threads_match_parallel_path)
+{
+    World noThreads = makeWorld();
+    updateInline(noThreads, 20);
+
+    osg::ref_ptr<SceneUtil::WorkQueue> workQueue = new SceneUtil::WorkQueue(4);
+    World parallel = makeWorld();
+    update(parallel, workQueue.get(), 20);
+
+    expectSame(noThreads, parallel);
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "components/sceneutil/skinning.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <osg/ref_ptr>
+
+namespace
+{
+    /// A mesh with its bone weights, as RigGeometry gets them from the influence map
+    struct Rig
+    {
+        std::vector<osg::Vec3f> mPositions;
+        std::vector<osg::Vec3f> mNormals;
+        std::vector<osg::Vec4f> mTangents;
+        std::vector<SceneUtil::Skinning::BoneWeights> mWeights;
+        std::vector<osg::Matrixf> mInvBindMatrices;
+        std::vector<osg::Matrixf> mBoneMatrices;
+    };
+
+    osg::Matrixf makeAffineMatrix(std::mt19937& generator)
+    {
+        std::uniform_real_distribution<float> angle(-3.f, 3.f);
+        std::uniform_real_distribution<float> translation(-100.f, 100.f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.f);
+        const float a = angle(generator);
+        const float b = angle(generator);
+        const float s = scale(generator);
+        return osg::Matrixf(s * std::cos(a), s * std::sin(a), 0, 0,
+                            -s * std::sin(a) * std::cos(b), s * std::cos(a) * std::cos(b), s * std::sin(b), 0,
+                            s * std::sin(a) * std::sin(b), -s * std::cos(a) * std::sin(b), s * std::cos(b), 0,
+                            translation(generator), translation(generator), translation(generator), 1);
+    }
+
+    /// Some vertices follow one bone only, so that runs of all lengths come up, the others blend up to four bones.
+    Rig makeRig(unsigned int numVertices, unsigned int numBones)
+    {
+        std::mt19937 generator(numVertices);
+        std::uniform_real_distribution<float> coordinate(-50.f, 50.f);
+        std::uniform_int_distribution<unsigned int> bone(0, numBones - 1);
+        std::uniform_int_distribution<unsigned int> numWeights(1, 4);
+
+        Rig rig;
+        for (unsigned int i = 0; i < numBones; ++i)
+        {
+            rig.mInvBindMatrices.push_back(makeAffineMatrix(generator));
+            rig.mBoneMatrices.push_back(makeAffineMatrix(generator));
+        }
+
+        for (unsigned int i = 0; i < numVertices; ++i)
+        {
+            rig.mPositions.push_back(osg::Vec3f(coordinate(generator), coordinate(generator), coordinate(generator)));
+            rig.mNormals.push_back(osg::Vec3f(coordinate(generator), coordinate(generator), coordinate(generator)));
+            rig.mTangents.push_back(osg::Vec4f(coordinate(generator), coordinate(generator), coordinate(generator), i % 2 ? 1.f : -1.f));
+
+            SceneUtil::Skinning::BoneWeights weights;
+            if (i % 3 == 0)
+                weights.push_back(std::make_pair(bone(generator) % 3, 1.f));
+            else
+            {
+                const unsigned int count = numWeights(generator);
+                for (unsigned int j = 0; j < count; ++j)
+                    weights.push_back(std::make_pair(bone(generator), 1.f / count));
+            }
+            rig.mWeights.push_back(weights);
+        }
+        return rig;
+    }
+
+    typedef std::map<SceneUtil::Skinning::BoneWeights, std::vector<unsigned short> > Runs;
+
+    Runs getRuns(const Rig& rig)
+    {
+        Runs runs;
+        for (unsigned int i = 0; i < rig.mWeights.size(); ++i)
+            runs[rig.mWeights[i]].push_back(i);
+        return runs;
+    }
+
+    osg::ref_ptr<SceneUtil::Skinning> makeSkinning(const Rig& rig, bool normals, bool tangents)
+    {
+        osg::ref_ptr<SceneUtil::Skinning> skinning (new SceneUtil::Skinning(normals, tangents));
+        Runs runs = getRuns(rig);
+        for (Runs::const_iterator it = runs.begin(); it != runs.end(); ++it)
+            skinning->addRun(it->first, it->second, &rig.mPositions[0], normals ? &rig.mNormals[0] : NULL,
+                             tangents ? &rig.mTangents[0] : NULL);
+        return skinning;
+    }
+
+    std::vector<osg::Matrixf> getBoneMatrices(const Rig& rig)
+    {
+        std::vector<osg::Matrixf> matrices;
+        for (unsigned int i = 0; i < rig.mBoneMatrices.size(); ++i)
+            matrices.push_back(rig.mInvBindMatrices[i] * rig.mBoneMatrices[i]);
+        return matrices;
+    }
+
+    /// How RigGeometry::cull used to skin each vertex, matrix by matrix
+    void skinReference(const Rig& rig, const osg::Matrixf* geomToSkelMatrix, std::vector<osg::Vec3f>& positions,
+                       std::vector<osg::Vec3f>& normals, std::vector<osg::Vec4f>& tangents)
+    {
+        Runs runs = getRuns(rig);
+        for (Runs::const_iterator it = runs.begin(); it != runs.end(); ++it)
+        {
+            osg::Matrixf resultMat (0, 0, 0, 0,
+                                    0, 0, 0, 0,
+                                    0, 0, 0, 0,
+                                    0, 0, 0, 1);
+            for (SceneUtil::Skinning::BoneWeights::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
+            {
+                osg::Matrixf m = rig.mInvBindMatrices[weightIt->first] * rig.mBoneMatrices[weightIt->first];
+                for (int row = 0; row < 4; ++row)
+                    for (int column = 0; column < 3; ++column)
+                        resultMat(row, column) += m(row, column) * weightIt->second;
+            }
+            if (geomToSkelMatrix)
+                resultMat *= *geomToSkelMatrix;
+
+            for (std::vector<unsigned short>::const_iterator vertexIt = it->second.begin(); vertexIt != it->second.end(); ++vertexIt)
+            {
+                const unsigned short vertex = *vertexIt;
+                positions[vertex] = resultMat.preMult(rig.mPositions[vertex]);
+                normals[vertex] = osg::Matrix::transform3x3(rig.mNormals[vertex], resultMat);
+                const osg::Vec4f& srcTangent = rig.mTangents[vertex];
+                osg::Vec3f transformedTangent = osg::Matrix::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
+                tangents[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+            }
+        }
+    }
+
+    void expectNear(const float* expected, const float* actual, int size, unsigned int vertex)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            const float tolerance = 1e-5f * std::max(1.f, std::abs(expected[i]));
+            EXPECT_NEAR(expected[i], actual[i], tolerance) << "vertex " << vertex << " component " << i;
+        }
+    }
+
+    void testAgainstReference(unsigned int numVertices, unsigned int numBones, const osg::Matrixf* geomToSkelMatrix)
+    {
+        const Rig rig = makeRig(numVertices, numBones);
+
+        std::vector<osg::Vec3f> expectedPositions (numVertices);
+        std::vector<osg::Vec3f> expectedNormals (numVertices);
+        std::vector<osg::Vec4f> expectedTangents (numVertices);
+        skinReference(rig, geomToSkelMatrix, expectedPositions, expectedNormals, expectedTangents);
+
+        std::vector<osg::Vec3f> positions (numVertices);
+        std::vector<osg::Vec3f> normals (numVertices);
+        std::vector<osg::Vec4f> tangents (rig.mTangents);
+        const std::vector<osg::Matrixf> boneMatrices = getBoneMatrices(rig);
+        makeSkinning(rig, true, true)->skin(&boneMatrices[0], geomToSkelMatrix, &positions[0], &normals[0], &tangents[0]);
+
+        for (unsigned int i = 0; i < numVertices; ++i)
+        {
+            expectNear(expectedPositions[i].ptr(), positions[i].ptr(), 3, i);
+            expectNear(expectedNormals[i].ptr(), normals[i].ptr(), 3, i);
+            expectNear(expectedTangents[i].ptr(), tangents[i].ptr(), 4, i);
+        }
+    }
+
+    TEST(SkinningTest, matches_per_vertex_skinning)
+    {
+        testAgainstReference(1000, 20, NULL);
+    }
+
+    TEST(SkinningTest, matches_per_vertex_skinning_below_the_skeleton)
+    {
+        std::mt19937 generator(7);
+        const osg::Matrixf geomToSkelMatrix = makeAffineMatrix(generator);
+        testAgainstReference(1000, 20, &geomToSkelMatrix);
+    }
+
+    TEST(SkinningTest, skins_runs_shorter_than_the_lanes)
+    {
+        // With a single bone, every third vertex is in the one run, the others in runs of a few vertices
+        for (unsigned int numVertices = 1; numVertices < 20; ++numVertices)
+            testAgainstReference(numVertices, 1, NULL);
+    }
+
+    TEST(SkinningTest, leaves_arrays_it_does_not_skin_alone)
+    {
+        const Rig rig = makeRig(100, 5);
+        osg::ref_ptr<SceneUtil::Skinning> skinning = makeSkinning(rig, false, false);
+        EXPECT_EQ(100u, skinning->getNumVertices());
+
+        std::vector<osg::Vec3f> positions (rig.mPositions.size());
+        std::vector<osg::Vec3f> normals (rig.mNormals);
+        const std::vector<osg::Matrixf> boneMatrices = getBoneMatrices(rig);
+        skinning->skin(&boneMatrices[0], NULL, &positions[0], &normals[0], NULL);
+
+        for (unsigned int i = 0; i < rig.mNormals.size(); ++i)
+            EXPECT_EQ(rig.mNormals[i], normals[i]);
+        EXPECT_FALSE(positions[0] == osg::Vec3f());
+    }
+}
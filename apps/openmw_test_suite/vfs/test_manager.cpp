@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "components/vfs/archive.hpp"
+#include "components/vfs/manager.hpp"
+
+namespace
+{
+    class TestFile : public VFS::File
+    {
+    public:
+        TestFile(const std::string& content) : mContent(content) {}
+
+        virtual Files::IStreamPtr open()
+        {
+            return Files::IStreamPtr(new std::istringstream(mContent));
+        }
+
+    private:
+        std::string mContent;
+    };
+
+    /// Lists files under the names given, with each file containing its own name
+    class TestArchive : public VFS::Archive
+    {
+    public:
+        TestArchive(const std::vector<std::string>& names)
+        {
+            for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+                mFiles.push_back(std::make_pair(*it, TestFile(*it)));
+        }
+
+        virtual void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char))
+        {
+            for (std::vector<std::pair<std::string, TestFile> >::iterator it = mFiles.begin(); it != mFiles.end(); ++it)
+            {
+                std::string name = it->first;
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &it->second;
+            }
+        }
+
+    private:
+        std::vector<std::pair<std::string, TestFile> > mFiles;
+    };
+
+    std::string read(Files::IStreamPtr stream)
+    {
+        std::ostringstream content;
+        content << stream->rdbuf();
+        return content.str();
+    }
+}
+
+struct VfsManagerTest : public ::testing::Test
+{
+    VFS::Manager mManager;
+
+    VfsManagerTest()
+        : mManager(false)
+    {
+        std::vector<std::string> names;
+        names.push_back("Meshes\\Base_Anim.nif");
+        names.push_back("music/explore/track1.mp3");
+        names.push_back("music/explore/track2.mp3");
+        names.push_back("music/battle/track1.mp3");
+        names.push_back("music/explore2/track1.mp3");
+        names.push_back("textures/tx_sky.dds");
+        mManager.addArchive(new TestArchive(names));
+        mManager.buildIndex();
+    }
+};
+
+TEST_F(VfsManagerTest, get_normalizes_names)
+{
+    EXPECT_TRUE(mManager.exists("meshes/base_anim.nif"));
+    EXPECT_TRUE(mManager.exists("MESHES\\BASE_ANIM.NIF"));
+    EXPECT_FALSE(mManager.exists("meshes/base_anim.kf"));
+    EXPECT_FALSE(mManager.exists("meshes/base_anim.ni"));
+    EXPECT_FALSE(mManager.exists(""));
+
+    EXPECT_EQ(read(mManager.get("Textures\\TX_Sky.dds")), "textures/tx_sky.dds");
+    EXPECT_THROW(mManager.get("textures/tx_sky.tga"), std::runtime_error);
+}
+
+TEST_F(VfsManagerTest, get_normalized_does_not_normalize)
+{
+    EXPECT_EQ(read(mManager.getNormalized("meshes/base_anim.nif")), "Meshes\\Base_Anim.nif");
+    EXPECT_THROW(mManager.getNormalized("Meshes\\Base_Anim.nif"), std::runtime_error);
+}
+
+TEST_F(VfsManagerTest, later_archives_take_priority)
+{
+    mManager.addArchive(new TestArchive(std::vector<std::string>(1, "TEXTURES/tx_sky.dds")));
+    mManager.buildIndex();
+
+    EXPECT_EQ(read(mManager.get("textures/tx_sky.dds")), "TEXTURES/tx_sky.dds");
+    EXPECT_EQ(mManager.getIndex().size(), 6u);
+}
+
+TEST_F(VfsManagerTest, recursive_directory_range)
+{
+    std::vector<std::string> files;
+    VFS::RecursiveDirectoryRange range = mManager.getRecursiveDirectoryIterator("Music\\Explore/");
+    for (VFS::RecursiveDirectoryRange::const_iterator it = range.begin(); it != range.end(); ++it)
+        files.push_back(it->first);
+
+    ASSERT_EQ(files.size(), 2u);
+    EXPECT_EQ(files[0], "music/explore/track1.mp3");
+    EXPECT_EQ(files[1], "music/explore/track2.mp3");
+
+    range = mManager.getRecursiveDirectoryIterator("music/explore");
+    EXPECT_EQ(std::distance(range.begin(), range.end()), 3);
+
+    range = mManager.getRecursiveDirectoryIterator("");
+    EXPECT_EQ(std::distance(range.begin(), range.end()), 6);
+
+    range = mManager.getRecursiveDirectoryIterator("sound/");
+    EXPECT_TRUE(range.begin() == range.end());
+}
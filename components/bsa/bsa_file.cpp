@@ -130,6 +130,8 @@ void BSAFile::readHeader()
 
     // Set up the the FileStruct table
     files.resize(filenum);
+    lookup.clear();
+    lookup.reserve(filenum);
     for(size_t i=0;i<filenum;i++)
     {
         FileStruct &fs = files[i];
@@ -164,6 +166,7 @@ void BSAFile::open(const string &file)
 {
     filename = file;
     readHeader();
+    mapping = Files::openMappedFile(filename.c_str());
 }
 
 Files::IStreamPtr BSAFile::getFile(const char *file)
@@ -175,10 +178,12 @@ Files::IStreamPtr BSAFile::getFile(const char *file)
 
     const FileStruct &fs = files[i];
 
-    return Files::openConstrainedFileStream (filename.c_str (), fs.offset, fs.fileSize);
+    return getFile(&fs);
 }
 
 Files::IStreamPtr BSAFile::getFile(const FileStruct *file)
 {
+    if (mapping)
+        return Files::openMappedFileStream (mapping, file->offset, file->fileSize);
     return Files::openConstrainedFileStream (filename.c_str (), file->offset, file->fileSize);
 }
@@ -27,11 +27,12 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 
 #include <components/misc/stringops.hpp>
 
 #include <components/files/constrainedfilestream.hpp>
+#include <components/files/mappedfilestream.hpp>
 
 
 namespace Bsa
@@ -69,18 +70,14 @@ private:
     /// Used for error messages
     std::string filename;
 
-    /// Case insensitive string comparison
-    struct iltstr
-    {
-        bool operator()(const char *s1, const char *s2) const
-        { return Misc::StringUtils::ciLess(s1, s2); }
-    };
+    /// Mapping of the whole archive shared by all opened files, empty if the archive could not be mapped
+    Files::MappedFilePtr mapping;
 
     /** A map used for fast file name lookup. The value is the index into
-        the files[] vector above. The iltstr ensures that file name
+        the files[] vector above. CiHash and CiEqual ensure that file name
         checks are case insensitive.
     */
-    typedef std::map<const char*, int, iltstr> Lookup;
+    typedef std::unordered_map<const char*, int, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> Lookup;
     Lookup lookup;
 
     /// Error handling
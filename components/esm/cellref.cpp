@@ -135,7 +135,7 @@ void ESM::CellRef::save (ESMWriter &esm, bool wideRefNum, bool inInventory, bool
 {
     mRefNum.save (esm, wideRefNum);
 
-    esm.writeHNCString("NAME", mRefID);
+    esm.writeHNCString("NAME", mRefID.getSpelling());
 
     if (isDeleted) {
         esm.writeHNCString("DELE", "");
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "defs.hpp"
+#include "refid.hpp"
 
 namespace ESM
 {
@@ -50,7 +51,7 @@ namespace ESM
                 End of tes3mp addition
             */
 
-            std::string mRefID;    // ID of object being referenced
+            RefId mRefID;          // ID of object being referenced
 
             float mScale;          // Scale applied to mesh
 
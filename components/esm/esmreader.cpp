@@ -21,10 +21,12 @@ ESM_Context ESMReader::getContext()
 
 ESMReader::ESMReader()
     : mIdx(0)
+    , mMapped(NULL)
     , mRecordFlags(0)
     , mBuffer(50*1024)
     , mGlobalReaderList(NULL)
     , mEncoder(NULL)
+    , mLazyLoading(false)
     , mFileSize(0)
 {
 }
@@ -50,6 +52,8 @@ void ESMReader::restoreContext(const ESM_Context &rc)
 void ESMReader::close()
 {
     mEsm.reset();
+    mMapped = NULL;
+    mLazySource.reset();
     mCtx.filename.clear();
     mCtx.leftFile = 0;
     mCtx.leftRec = 0;
@@ -64,6 +68,7 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 {
     close();
     mEsm = _esm;
+    mMapped = dynamic_cast<Files::MappedFileStream*>(mEsm.get());
     mCtx.filename = name;
     mEsm->seekg(0, mEsm->end);
     mCtx.leftFile = mFileSize = mEsm->tellg();
@@ -72,7 +77,7 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 
 void ESMReader::openRaw(const std::string& filename)
 {
-    openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+    openRaw(Files::openMappedFileStream(filename.c_str()), filename);
 }
 
 void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
@@ -89,7 +94,7 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 
 void ESMReader::open(const std::string &file)
 {
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
+    open (Files::openMappedFileStream (file.c_str ()), file);
 }
 
 int64_t ESMReader::getHNLong(const char *name)
@@ -133,6 +138,33 @@ std::string ESMReader::getHString()
     return getString(mCtx.leftSub);
 }
 
+void ESMReader::getHLazyString(LazyString& str)
+{
+    if (!mLazyLoading || !mMapped)
+    {
+        str = getHString();
+        return;
+    }
+
+    getSubHeader();
+
+    // Same as in getHString()
+    if (mCtx.leftSub == 0)
+    {
+        mCtx.leftRec--;
+        char c;
+        getExact(&c, 1);
+        str = std::string();
+        return;
+    }
+
+    if (!mLazySource)
+        mLazySource.reset(new LazyStringSource(mCtx.filename, mFileSize, mEncoder ? mEncoder->getEncoding() : -1));
+
+    str.setLocation(mLazySource, getFileOffset(), mCtx.leftSub);
+    skip(mCtx.leftSub);
+}
+
 void ESMReader::getHExact(void*p, int size)
 {
     getSubHeader();
@@ -316,6 +348,16 @@ void ESMReader::getRecHeader(uint32_t &flags)
 
 void ESMReader::getExact(void*x, int size)
 {
+    if (mMapped)
+    {
+        const char* span = mMapped->readSpan(size);
+        if (span)
+        {
+            memcpy(x, span, size);
+            return;
+        }
+    }
+
     try
     {
         mEsm->read((char*)x, size);
@@ -326,28 +368,44 @@ void ESMReader::getExact(void*x, int size)
     }
 }
 
-std::string ESMReader::getString(int size)
+const char* ESMReader::getSpan(int size)
 {
+    if (mMapped)
+    {
+        const char* span = mMapped->readSpan(size);
+        if (span)
+            return span;
+    }
+
     size_t s = size;
     if (mBuffer.size() <= s)
         // Add some extra padding to reduce the chance of having to resize
         // again later.
         mBuffer.resize(3*s);
 
-    // And make sure the string is zero terminated
+    // And make sure the data is zero terminated
     mBuffer[s] = 0;
 
     // read ESM data
     char *ptr = &mBuffer[0];
     getExact(ptr, size);
+    return ptr;
+}
 
-    size = strnlen(ptr, size);
+std::string ESMReader::getString(int size)
+{
+    const char *ptr = getSpan(size);
 
     // Convert to UTF8 and return
     if (mEncoder)
-        return mEncoder->getUtf8(ptr, size);
+    {
+        // Bounded by size, so spans of a memory mapping are converted in place
+        std::string result;
+        mEncoder->getUtf8(ptr, size, result);
+        return result;
+    }
 
-    return std::string (ptr, size);
+    return std::string (ptr, strnlen(ptr, size));
 }
 
 void ESMReader::fail(const std::string &msg)
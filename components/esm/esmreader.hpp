@@ -8,12 +8,14 @@
 #include <sstream>
 
 #include <components/files/constrainedfilestream.hpp>
+#include <components/files/mappedfilestream.hpp>
 
 #include <components/misc/stringops.hpp>
 
 #include <components/to_utf8/to_utf8.hpp>
 
 #include "esmcommon.hpp"
+#include "lazystring.hpp"
 #include "loadtes3.hpp"
 
 namespace ESM {
@@ -161,6 +163,9 @@ public:
   // Read a string, including the sub-record header (but not the name)
   std::string getHString();
 
+  /// Like getHString(), but with lazy loading enabled only the location of the string is kept
+  void getHLazyString(LazyString& str);
+
   // Read the given number of bytes from a subrecord
   void getHExact(void*p, int size);
 
@@ -248,6 +253,12 @@ public:
   void getT(X &x) { getExact(&x, sizeof(X)); }
 
   void getExact(void*x, int size);
+
+  /// Get a pointer to the next 'size' bytes and skip past them. If the file is memory mapped this points
+  /// straight into the mapping, otherwise the data is copied into an internal buffer. Either way the
+  /// pointer is only valid until the next read.
+  const char* getSpan(int size);
+
   void getName(NAME &name) { getT(name); }
   void getUint(uint32_t &u) { getT(u); }
 
@@ -263,6 +274,10 @@ public:
   /// Sets font encoder for ESM strings
   void setEncoder(ToUTF8::Utf8Encoder* encoder);
 
+  /// Defer reading long texts (see LazyString) of the following records until they are used. Only takes
+  /// effect for memory mapped files, which have to stay unchanged for as long as the records exist.
+  void setLazyLoading(bool lazy) { mLazyLoading = lazy; }
+
   /// Get record flags of last record
   unsigned int getRecordFlags() { return mRecordFlags; }
 
@@ -271,6 +286,9 @@ public:
 private:
   Files::IStreamPtr mEsm;
 
+  // Same stream as mEsm if it is memory mapped, NULL otherwise
+  Files::MappedFileStream* mMapped;
+
   ESM_Context mCtx;
 
   unsigned int mRecordFlags;
@@ -285,6 +303,10 @@ private:
   std::vector<ESMReader> *mGlobalReaderList;
   ToUTF8::Utf8Encoder* mEncoder;
 
+  bool mLazyLoading;
+  // Shared by all lazy strings of the open file
+  LazyStringSourcePtr mLazySource;
+
   size_t mFileSize;
 
 };
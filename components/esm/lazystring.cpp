@@ -0,0 +1,120 @@
+#include "lazystring.hpp"
+
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+namespace
+{
+    // One lock for all lazy strings. Reading a text takes a few microseconds and is rare, so there is
+    // nothing to gain from finer locking.
+    std::mutex sMutex;
+}
+
+namespace ESM
+{
+    LazyStringSource::LazyStringSource(const std::string& file, size_t size, int encoding)
+        : mFile(file)
+        , mSize(size)
+        , mEncoding(encoding)
+    {
+    }
+
+    std::string LazyStringSource::read(size_t offset, size_t size)
+    {
+        if (!mMapping)
+            mMapping = Files::openMappedFile(mFile.c_str());
+
+        if (!mMapping || mMapping->size() != mSize || offset + size > mSize)
+        {
+            std::ostringstream error;
+            error << "Failed to read text at offset 0x" << std::hex << offset << " of " << mFile
+                  << ", it was changed or removed after loading";
+            throw std::runtime_error(error.str());
+        }
+
+        const char* data = mMapping->data() + offset;
+        std::string text(data, strnlen(data, size));
+
+        if (mEncoding < 0)
+            return text;
+
+        if (!mEncoder)
+            mEncoder.reset(new ToUTF8::Utf8Encoder(static_cast<ToUTF8::FromType>(mEncoding)));
+        // Unlike the mapping, the copy is zero terminated, which the encoder relies on
+        return mEncoder->getUtf8(text);
+    }
+
+    LazyString::LazyString(const LazyString& other)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        mValue = other.mValue;
+        mSource = other.mSource;
+        mOffset = other.mOffset;
+        mSize = other.mSize;
+    }
+
+    LazyString& LazyString::operator=(const LazyString& other)
+    {
+        if (this != &other)
+        {
+            std::lock_guard<std::mutex> lock(sMutex);
+            mValue = other.mValue;
+            mSource = other.mSource;
+            mOffset = other.mOffset;
+            mSize = other.mSize;
+        }
+        return *this;
+    }
+
+    LazyString& LazyString::operator=(const std::string& value)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        mValue = value;
+        mSource.reset();
+        mOffset = 0;
+        mSize = 0;
+        return *this;
+    }
+
+    void LazyString::setLocation(const LazyStringSourcePtr& source, size_t offset, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        mValue.clear();
+        mSource = source;
+        mOffset = offset;
+        mSize = size;
+    }
+
+    bool LazyString::isDeferred() const
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return mSource != NULL;
+    }
+
+    const std::string& LazyString::get() const
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (mSource)
+        {
+            try
+            {
+                mValue = mSource->read(mOffset, mSize);
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "Error: " << e.what() << std::endl;
+                mValue.clear();
+            }
+            mSource.reset();
+        }
+        return mValue;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const LazyString& string)
+    {
+        return stream << string.get();
+    }
+}
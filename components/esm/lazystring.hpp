@@ -0,0 +1,81 @@
+#ifndef OPENMW_ESM_LAZYSTRING_H
+#define OPENMW_ESM_LAZYSTRING_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include <components/files/mappedfilestream.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace ESM
+{
+    /// Content file that LazyStrings read their text from. Mapped on the first read only, so files whose
+    /// texts are never used cost no memory after loading.
+    class LazyStringSource
+    {
+    public:
+        /// @param size Size of \a file when it was loaded, to notice if it was replaced since.
+        /// @param encoding Encoding of the texts in \a file, see ToUTF8::FromType. -1 to keep them as they are.
+        LazyStringSource(const std::string& file, size_t size, int encoding);
+
+        /// Read and convert \a size bytes at \a offset. Not thread safe, LazyString serializes the calls.
+        std::string read(size_t offset, size_t size);
+
+    private:
+        std::string mFile;
+        size_t mSize;
+        int mEncoding;
+        Files::MappedFilePtr mMapping;
+        std::unique_ptr<ToUTF8::Utf8Encoder> mEncoder;
+    };
+
+    typedef std::shared_ptr<LazyStringSource> LazyStringSourcePtr;
+
+    /// @brief A string subrecord that is read from its content file when it is first used.
+    ///
+    /// For long texts that most sessions never look at, like script sources and dialogue responses.
+    /// ESMReader only defers reading them when lazy loading is enabled, otherwise this is a plain string.
+    /// Accessing the text is thread safe.
+    class LazyString
+    {
+    public:
+        LazyString() : mOffset(0), mSize(0) {}
+
+        LazyString(const std::string& value) : mValue(value), mOffset(0), mSize(0) {}
+
+        LazyString(const LazyString& other);
+
+        LazyString& operator=(const LazyString& other);
+
+        LazyString& operator=(const std::string& value);
+
+        LazyString& operator=(const char* value) { return *this = std::string(value); }
+
+        /// Defer reading the text until it is used. Called by ESMReader::getHLazyString().
+        void setLocation(const LazyStringSourcePtr& source, size_t offset, size_t size);
+
+        /// Has the text not been read yet?
+        bool isDeferred() const;
+
+        const std::string& get() const;
+
+        operator const std::string&() const { return get(); }
+
+        const char* c_str() const { return get().c_str(); }
+
+        bool empty() const { return get().empty(); }
+
+        void clear() { *this = std::string(); }
+
+    private:
+        mutable std::string mValue;
+        mutable LazyStringSourcePtr mSource;
+        size_t mOffset;
+        size_t mSize;
+    };
+
+    std::ostream& operator<<(std::ostream& stream, const LazyString& string);
+}
+
+#endif
@@ -56,7 +56,7 @@ namespace ESM
                     mSound = esm.getHString();
                     break;
                 case ESM::SREC_NAME:
-                    mResponse = esm.getHString();
+                    esm.getHLazyString(mResponse);
                     break;
                 case ESM::FourCC<'S','C','V','R'>::value:
                 {
@@ -67,7 +67,7 @@ namespace ESM
                     break;
                 }
                 case ESM::FourCC<'B','N','A','M'>::value:
-                    mResultScript = esm.getHString();
+                    esm.getHLazyString(mResultScript);
                     break;
                 case ESM::FourCC<'Q','S','T','N'>::value:
                     mQuestStatus = QS_Name;
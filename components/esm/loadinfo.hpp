@@ -6,6 +6,7 @@
 
 #include "defs.hpp"
 #include "variant.hpp"
+#include "lazystring.hpp"
 
 namespace ESM
 {
@@ -73,11 +74,12 @@ struct DialInfo
     std::string mActor, mRace, mClass, mFaction, mPcFaction, mCell;
 
     // Sound and text associated with this item
-    std::string mSound, mResponse;
+    std::string mSound;
+    LazyString mResponse;
 
     // Result script (uncompiled) to run whenever this dialog item is
     // selected
-    std::string mResultScript;
+    LazyString mResultScript;
 
     // ONLY include this item the NPC is not part of any faction.
     bool mFactionLess;
@@ -102,7 +102,7 @@ namespace ESM
                     break;
                 }
                 case ESM::FourCC<'S','C','T','X'>::value:
-                    mScriptText = esm.getHString();
+                    esm.getHLazyString(mScriptText);
                     break;
                 case ESM::SREC_DELE:
                     esm.skipHSub();
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "esmcommon.hpp"
+#include "lazystring.hpp"
 
 namespace ESM
 {
@@ -48,7 +49,7 @@ public:
     std::vector<unsigned char> mScriptData;
 
     /// Script source code
-    std::string mScriptText;
+    LazyString mScriptText;
 
     void load(ESMReader &esm, bool &isDeleted);
     void save(ESMWriter &esm, bool isDeleted = false) const;
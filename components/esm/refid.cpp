@@ -0,0 +1,124 @@
+#include "refid.hpp"
+
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include <components/misc/stringops.hpp>
+
+namespace
+{
+    class RefIdPool
+    {
+        typedef std::unordered_set<std::string, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> Ids;
+        typedef std::unordered_set<std::string> Spellings;
+
+        // Node based, so the addresses of the strings never change
+        Ids mIds;
+        // Spellings other than the lower case one, shared by every RefId spelled the same way
+        Spellings mSpellings;
+        // RefIds can be created from any thread, but after loading nearly all of them already exist
+        std::shared_timed_mutex mMutex;
+
+        const std::string* find(const std::string& id, const std::string*& spelling) const
+        {
+            Ids::const_iterator it = mIds.find(id);
+            if (it == mIds.end())
+                return NULL;
+
+            if (*it == id)
+                spelling = &*it;
+            else
+            {
+                Spellings::const_iterator found = mSpellings.find(id);
+                spelling = found != mSpellings.end() ? &*found : NULL;
+            }
+            return &*it;
+        }
+
+    public:
+        const std::string* intern(const std::string& id, const std::string*& spelling)
+        {
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+                const std::string* found = find(id, spelling);
+                if (found && spelling)
+                    return found;
+            }
+
+            std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+            Ids::const_iterator it = mIds.find(id);
+            if (it == mIds.end())
+                it = mIds.insert(Misc::StringUtils::lowerCase(id)).first;
+
+            if (*it == id)
+                spelling = &*it;
+            else
+                spelling = &*mSpellings.insert(id).first;
+            return &*it;
+        }
+
+        const std::string* search(const std::string& id, const std::string*& spelling)
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+            const std::string* found = find(id, spelling);
+            // Spelled differently from any RefId, but still equal to them
+            if (found && !spelling)
+                spelling = found;
+            return found;
+        }
+    };
+
+    RefIdPool& getPool()
+    {
+        static RefIdPool pool;
+        return pool;
+    }
+
+    const std::string sEmpty;
+}
+
+namespace ESM
+{
+    RefId::RefId(const std::string& id)
+        : mId(NULL)
+        , mSpelling(NULL)
+    {
+        if (!id.empty())
+            mId = getPool().intern(id, mSpelling);
+    }
+
+    RefId::RefId(const char* id)
+        : mId(NULL)
+        , mSpelling(NULL)
+    {
+        if (*id != '\0')
+            mId = getPool().intern(id, mSpelling);
+    }
+
+    RefId RefId::search(const std::string& id)
+    {
+        if (id.empty())
+            return RefId();
+
+        const std::string* spelling = NULL;
+        const std::string* found = getPool().search(id, spelling);
+        return RefId(found, spelling);
+    }
+
+    const std::string& RefId::toString() const
+    {
+        return mId ? *mId : sEmpty;
+    }
+
+    const std::string& RefId::getSpelling() const
+    {
+        return mSpelling ? *mSpelling : sEmpty;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const RefId& id)
+    {
+        return stream << id.toString();
+    }
+}
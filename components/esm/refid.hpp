@@ -0,0 +1,72 @@
+#ifndef OPENMW_ESM_REFID_H
+#define OPENMW_ESM_REFID_H
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace ESM
+{
+    /// @brief Interned record ID, e.g. the ID of the object a CellRef refers to.
+    ///
+    /// Every distinct ID is stored once, in lower case, for the lifetime of the process. IDs that only differ
+    /// in case share one entry, so comparing and hashing RefIds is an integer operation. The spelling the ID
+    /// was created with is kept as well, for the editor and for writing content files.
+    ///
+    /// Construct RefIds where IDs enter the engine (loading records, script arguments, network packets) and
+    /// use toString() where they leave it again. Interning takes a lock, so construct RefIds for constant IDs
+    /// once rather than in every call.
+    class RefId
+    {
+    public:
+        RefId() : mId(NULL), mSpelling(NULL) {}
+
+        RefId(const std::string& id);
+
+        RefId(const char* id);
+
+        /// Look up an ID without interning it.
+        /// @return an empty RefId if \a id was never interned, in which case no RefId can be equal to it.
+        static RefId search(const std::string& id);
+
+        /// @return the ID in lower case.
+        const std::string& toString() const;
+
+        /// @return the ID as it was spelled when this RefId was created.
+        const std::string& getSpelling() const;
+
+        bool empty() const { return mId == NULL; }
+
+        void clear() { mId = NULL; mSpelling = NULL; }
+
+        bool operator==(const RefId& other) const { return mId == other.mId; }
+        bool operator!=(const RefId& other) const { return mId != other.mId; }
+
+        /// Orders by address, not alphabetically. Use toString() where the order matters.
+        bool operator<(const RefId& other) const { return std::less<const std::string*>()(mId, other.mId); }
+
+        size_t hash() const { return std::hash<const std::string*>()(mId); }
+
+    private:
+        RefId(const std::string* id, const std::string* spelling) : mId(id), mSpelling(spelling) {}
+
+        const std::string* mId;
+        const std::string* mSpelling;
+    };
+
+    std::ostream& operator<<(std::ostream& stream, const RefId& id);
+}
+
+namespace std
+{
+    template <>
+    struct hash<ESM::RefId>
+    {
+        size_t operator()(const ESM::RefId& id) const
+        {
+            return id.hash();
+        }
+    };
+}
+
+#endif
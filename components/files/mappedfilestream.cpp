@@ -0,0 +1,263 @@
+#include "mappedfilestream.hpp"
+
+#include <streambuf>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+
+#include "lowlevelfile.hpp"
+
+#if FILE_API == FILE_API_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace Files
+{
+
+#if FILE_API == FILE_API_POSIX
+    MappedFile::MappedFile(const char *filename)
+        : mData(NULL), mSize(0)
+    {
+        int fd = ::open(filename, O_RDONLY);
+        if (fd == -1)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading: " << strerror(errno);
+            throw std::runtime_error(os.str());
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+        {
+            std::ostringstream os;
+            os << "Failed to query size of '" << filename << "': " << strerror(errno);
+            ::close(fd);
+            throw std::runtime_error(os.str());
+        }
+
+        mSize = st.st_size;
+
+        // mmap() refuses empty mappings, an empty file simply has no data
+        if (mSize > 0)
+        {
+            void* data = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "': " << strerror(errno);
+                ::close(fd);
+                throw std::runtime_error(os.str());
+            }
+
+            // Content files are mostly read front to back
+            madvise(data, mSize, MADV_SEQUENTIAL);
+            mData = static_cast<const char*>(data);
+        }
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mData != NULL)
+            munmap(const_cast<char*>(mData), mSize);
+    }
+
+#elif FILE_API == FILE_API_WIN32
+    MappedFile::MappedFile(const char *filename)
+        : mData(NULL), mSize(0), mFileHandle(INVALID_HANDLE_VALUE), mMappingHandle(NULL)
+    {
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::ostringstream os;
+            os << "Failed to open '" << filename << "' for reading.";
+            throw std::runtime_error(os.str());
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            std::ostringstream os;
+            os << "Failed to query size of '" << filename << "'.";
+            throw std::runtime_error(os.str());
+        }
+
+        mSize = static_cast<size_t>(size.QuadPart);
+        mFileHandle = file;
+
+        // CreateFileMapping() refuses empty files, an empty file simply has no data
+        if (mSize > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+            if (mapping == NULL)
+            {
+                CloseHandle(file);
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "'.";
+                throw std::runtime_error(os.str());
+            }
+
+            void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data == NULL)
+            {
+                CloseHandle(mapping);
+                CloseHandle(file);
+                std::ostringstream os;
+                os << "Failed to map '" << filename << "'.";
+                throw std::runtime_error(os.str());
+            }
+
+            mMappingHandle = mapping;
+            mData = static_cast<const char*>(data);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mData != NULL)
+            UnmapViewOfFile(mData);
+        if (mMappingHandle != NULL)
+            CloseHandle(mMappingHandle);
+        if (mFileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(mFileHandle);
+    }
+
+#else
+    MappedFile::MappedFile(const char *filename)
+        : mData(NULL), mSize(0)
+    {
+        std::ostringstream os;
+        os << "Failed to map '" << filename << "': memory mapping is not supported on this platform.";
+        throw std::runtime_error(os.str());
+    }
+
+    MappedFile::~MappedFile()
+    {
+    }
+#endif
+
+    class MappedFileStreamBuf : public std::streambuf
+    {
+        MappedFilePtr mFile;
+
+    public:
+        MappedFileStreamBuf(MappedFilePtr file, size_t start, size_t length)
+            : mFile(file)
+        {
+            start = std::min(start, mFile->size());
+            length = std::min(length, mFile->size() - start);
+
+            // The get area covers the whole region, so the stream never has to refill it
+            char* begin = const_cast<char*>(mFile->data()) + start;
+            setg(begin, begin, begin + length);
+        }
+
+        const char* readSpan(size_t size)
+        {
+            if (static_cast<size_t>(egptr() - gptr()) < size)
+                return NULL;
+
+            const char* span = gptr();
+            gbump(static_cast<int>(size));
+            return span;
+        }
+
+        virtual int_type underflow()
+        {
+            if(gptr() == egptr())
+                return traits_type::eof();
+
+            return traits_type::to_int_type(*gptr());
+        }
+
+        virtual std::streamsize showmanyc()
+        {
+            return egptr() - gptr();
+        }
+
+        virtual pos_type seekoff(off_type offset, std::ios_base::seekdir whence, std::ios_base::openmode mode)
+        {
+            if((mode&std::ios_base::out) || !(mode&std::ios_base::in))
+                return traits_type::eof();
+
+            // new position, relative to the start of the region
+            off_type newPos;
+            switch (whence)
+            {
+                case std::ios_base::beg:
+                    newPos = offset;
+                    break;
+                case std::ios_base::cur:
+                    newPos = (gptr() - eback()) + offset;
+                    break;
+                case std::ios_base::end:
+                    newPos = (egptr() - eback()) + offset;
+                    break;
+                default:
+                    return traits_type::eof();
+            }
+
+            if (newPos < 0 || newPos > egptr() - eback())
+                return traits_type::eof();
+
+            setg(eback(), eback() + newPos, egptr());
+            return newPos;
+        }
+
+        virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode)
+        {
+            return seekoff(off_type(pos), std::ios_base::beg, mode);
+        }
+    };
+
+    MappedFileStream::MappedFileStream(MappedFilePtr file, size_t start, size_t length)
+        : std::istream(new MappedFileStreamBuf(file, start, length))
+    {
+
+    }
+
+    MappedFileStream::~MappedFileStream()
+    {
+        delete rdbuf();
+    }
+
+    const char* MappedFileStream::readSpan(size_t size)
+    {
+        return static_cast<MappedFileStreamBuf*>(rdbuf())->readSpan(size);
+    }
+
+    MappedFilePtr openMappedFile(const char *filename)
+    {
+        try
+        {
+            return MappedFilePtr(new MappedFile(filename));
+        }
+        catch (std::exception&)
+        {
+            return MappedFilePtr();
+        }
+    }
+
+    IStreamPtr openMappedFileStream(MappedFilePtr file, size_t start, size_t length)
+    {
+        return IStreamPtr(new MappedFileStream(file, start, length));
+    }
+
+    IStreamPtr openMappedFileStream(const char *filename, size_t start, size_t length)
+    {
+        MappedFilePtr file = openMappedFile(filename);
+        if (!file)
+            return openConstrainedFileStream(filename, start, length);
+
+        return openMappedFileStream(file, start, length);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef OPENMW_MAPPEDFILESTREAM_H
+#define OPENMW_MAPPEDFILESTREAM_H
+
+#include <istream>
+#include <memory>
+
+#include "constrainedfilestream.hpp"
+
+namespace Files
+{
+
+/// A read-only memory mapping of a whole file. Throws std::runtime_error if the file can not be opened or mapped.
+class MappedFile
+{
+public:
+    MappedFile(const char *filename);
+    ~MappedFile();
+
+    const char* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* mData;
+    size_t mSize;
+
+#if defined(_WIN32)
+    void* mFileHandle;
+    void* mMappingHandle;
+#endif
+};
+
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+/// A stream over a region of a memory mapped file, specified by the 'start' and 'length' parameters.
+/// Unlike ConstrainedFileStream there is no intermediate buffer, and readSpan() gives direct access to the mapping.
+class MappedFileStream : public std::istream
+{
+public:
+    MappedFileStream(MappedFilePtr file, size_t start=0, size_t length=0xFFFFFFFF);
+    virtual ~MappedFileStream();
+
+    /// Return a pointer to the next \a size bytes and advance the read position past them.
+    /// The pointer stays valid for the lifetime of the stream.
+    /// @return NULL if less than \a size bytes are left, in which case the read position is unchanged.
+    const char* readSpan(size_t size);
+};
+
+/// Map the given file, or return an empty pointer if that is not possible on this platform.
+MappedFilePtr openMappedFile(const char *filename);
+
+/// Open a stream over a region of an already mapped file.
+IStreamPtr openMappedFileStream(MappedFilePtr file, size_t start=0, size_t length=0xFFFFFFFF);
+
+/// Open a stream over a region of the given file. Falls back to a ConstrainedFileStream if the file can not be mapped.
+IStreamPtr openMappedFileStream(const char *filename, size_t start=0, size_t length=0xFFFFFFFF);
+
+}
+
+#endif
@@ -165,24 +165,12 @@ namespace Gui
 
     void FontLoader::loadAllFonts(bool exportToFile)
     {
-        const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-
-        std::string pattern = "Fonts/";
-        mVFS->normalizeFilename(pattern);
-
-        std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(pattern);
-        while (found != index.end())
+        for (const auto& file : mVFS->getRecursiveDirectoryIterator("Fonts/"))
         {
-            const std::string& name = found->first;
-            if (name.size() >= pattern.size() && name.substr(0, pattern.size()) == pattern)
-            {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".fnt") == 0)
-                    loadFont(name, exportToFile);
-            }
-            else
-                break;
-            ++found;
+            const std::string& name = file.first;
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".fnt") == 0)
+                loadFont(name, exportToFile);
         }
     }
 
@@ -0,0 +1,148 @@
+#ifndef OPENMW_COMPONENTS_MISC_SPATIALGRID_H
+#define OPENMW_COMPONENTS_MISC_SPATIALGRID_H
+
+#include <cmath>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include <osg/Vec3f>
+
+namespace Misc
+{
+
+/// @brief Sorts values into the square columns of a uniform grid on the XY plane by their position,
+/// so that a range query only looks at the columns that the range overlaps.
+/// @par Meant to be rebuilt whenever the positions change, e.g. once per frame. Removing a single value is not supported.
+template <class T>
+class SpatialGrid
+{
+public:
+    /// @param cellSize Width of a column. Around the radius of the common queries works best.
+    explicit SpatialGrid(float cellSize)
+        : mCellSize(cellSize)
+        , mSize(0)
+    {
+    }
+
+    void clear()
+    {
+        mCells.clear();
+        mSize = 0;
+    }
+
+    void add(const T& value, const osg::Vec3f& position)
+    {
+        mCells[getKey(getIndex(position.x()), getIndex(position.y()))].push_back(Entry(value, position));
+        ++mSize;
+    }
+
+    size_t size() const { return mSize; }
+
+    /// @return whether a query for this range looks at fewer columns than there are filled ones. Otherwise, a query
+    /// visits every value anyway and going through the values one by one is just as fast.
+    bool isNarrow(const osg::Vec3f& position, float radius) const
+    {
+        return getNumColumns(position, radius) <= mCells.size();
+    }
+
+    /// Call @a function(value, position) for every value that was added within @a radius of @a position,
+    /// measured in three dimensions.
+    template <class Function>
+    void forEachInRange(const osg::Vec3f& position, float radius, Function function) const
+    {
+        visitInRange(position, radius, [&function] (const T& value, const osg::Vec3f& valuePosition)
+        {
+            function(value, valuePosition);
+            return true;
+        });
+    }
+
+    /// @return whether any value was added within @a radius of @a position. Stops looking at the first one.
+    bool isAnyInRange(const osg::Vec3f& position, float radius) const
+    {
+        return !visitInRange(position, radius, [] (const T&, const osg::Vec3f&) { return false; });
+    }
+
+    /// Add every value within @a radius of @a position to @a out, in no particular order.
+    void getInRange(const osg::Vec3f& position, float radius, std::vector<T>& out) const
+    {
+        forEachInRange(position, radius, [&out] (const T& value, const osg::Vec3f&) { out.push_back(value); });
+    }
+
+private:
+    struct Entry
+    {
+        Entry(const T& value, const osg::Vec3f& position) : mValue(value), mPosition(position) {}
+
+        T mValue;
+        osg::Vec3f mPosition;
+    };
+
+    typedef std::unordered_map<int64_t, std::vector<Entry> > Cells;
+
+    int getIndex(float coordinate) const
+    {
+        return static_cast<int>(std::floor(coordinate / mCellSize));
+    }
+
+    double getNumColumns(const osg::Vec3f& position, float radius) const
+    {
+        return (static_cast<double>(getIndex(position.x() + radius)) - getIndex(position.x() - radius) + 1)
+                * (static_cast<double>(getIndex(position.y() + radius)) - getIndex(position.y() - radius) + 1);
+    }
+
+    static int64_t getKey(int x, int y)
+    {
+        return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+    }
+
+    /// Call @a function(value, position) for the values in range until it returns false.
+    /// @return false if @a function stopped the visit
+    template <class Function>
+    bool visitInRange(const osg::Vec3f& position, float radius, Function function) const
+    {
+        const float sqrRadius = radius * radius;
+        if (!isNarrow(position, radius))
+        {
+            for (typename Cells::const_iterator it = mCells.begin(); it != mCells.end(); ++it)
+                if (!visit(it->second, position, sqrRadius, function))
+                    return false;
+            return true;
+        }
+
+        const int minX = getIndex(position.x() - radius);
+        const int maxX = getIndex(position.x() + radius);
+        const int minY = getIndex(position.y() - radius);
+        const int maxY = getIndex(position.y() + radius);
+        for (int x = minX; x <= maxX; ++x)
+        {
+            for (int y = minY; y <= maxY; ++y)
+            {
+                typename Cells::const_iterator found = mCells.find(getKey(x, y));
+                if (found != mCells.end() && !visit(found->second, position, sqrRadius, function))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template <class Function>
+    static bool visit(const std::vector<Entry>& entries, const osg::Vec3f& position, float sqrRadius, Function& function)
+    {
+        for (typename std::vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            if ((it->mPosition - position).length2() <= sqrRadius && !function(it->mValue, it->mPosition))
+                return false;
+        }
+        return true;
+    }
+
+    float mCellSize;
+    size_t mSize;
+    Cells mCells;
+};
+
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include <string>
 #include <algorithm>
 
+#include <boost/utility/string_ref.hpp>
+
 #include "utf8stream.hpp"
 
 namespace Misc
@@ -189,6 +191,60 @@ public:
         }
     };
 
+    /// Case insensitive less-than for containers keyed by lower case strings. It is transparent, so lookups
+    /// can use keys in any case without making a lower case copy first.
+    /// @note Orders lower case strings the same way as std::less<std::string>.
+    struct CiLessTransparent
+    {
+        typedef void is_transparent;
+
+        bool operator()(boost::string_ref left, boost::string_ref right) const
+        {
+            const size_t size = std::min(left.size(), right.size());
+            for (size_t i = 0; i < size; ++i)
+            {
+                // Most IDs share their prefix with their neighbours, so skip the conversion for equal bytes
+                if (left[i] == right[i])
+                    continue;
+
+                const unsigned char l = toLower(left[i]);
+                const unsigned char r = toLower(right[i]);
+                if (l != r)
+                    return l < r;
+            }
+            return left.size() < right.size();
+        }
+    };
+
+    /// Case insensitive hash, to be used together with CiEqual in unordered containers.
+    /// Looking up a key hashes it once and compares it once, with no lower case copy of it.
+    struct CiHash
+    {
+        size_t operator()(boost::string_ref key) const
+        {
+            // FNV-1a
+            size_t hash = static_cast<size_t>(2166136261u);
+            for (size_t i = 0; i < key.size(); ++i)
+                hash = (hash ^ static_cast<unsigned char>(toLower(key[i]))) * static_cast<size_t>(16777619u);
+            return hash;
+        }
+    };
+
+    struct CiEqual
+    {
+        bool operator()(boost::string_ref left, boost::string_ref right) const
+        {
+            if (left.size() != right.size())
+                return false;
+            for (size_t i = 0; i < left.size(); ++i)
+            {
+                if (left[i] != right[i] && toLower(left[i]) != toLower(right[i]))
+                    return false;
+            }
+            return true;
+        }
+    };
+
 
     /// Performs a binary search on a sorted container for a string that 'key' starts with
     template<typename Iterator, typename T>
@@ -0,0 +1,260 @@
+#include "bulletgeometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include <osg/Object>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionShapes/btCompoundShape.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btStridingMeshInterface.h>
+
+#include <components/resource/bulletshape.hpp>
+
+#include "hash.hpp"
+
+namespace
+{
+    typedef std::map<const btStridingMeshInterface*, uint64_t> MeshHashes;
+
+    uint64_t hashVector(uint64_t hash, const btVector3& vector)
+    {
+        hash = Navigator::hashValue(hash, static_cast<float>(vector.x()));
+        hash = Navigator::hashValue(hash, static_cast<float>(vector.y()));
+        return Navigator::hashValue(hash, static_cast<float>(vector.z()));
+    }
+
+    uint64_t hashTransform(uint64_t hash, const btTransform& transform)
+    {
+        for (int i = 0; i < 3; ++i)
+            hash = hashVector(hash, transform.getBasis().getRow(i));
+        return hashVector(hash, transform.getOrigin());
+    }
+
+    /// Meshes are often shared by many objects of a cell, so each is only read once.
+    uint64_t hashMesh(const btStridingMeshInterface* mesh, MeshHashes& meshHashes)
+    {
+        MeshHashes::const_iterator found = meshHashes.find(mesh);
+        if (found != meshHashes.end())
+            return found->second;
+
+        uint64_t hash = Navigator::sHashBasis;
+        for (int part = 0; part < mesh->getNumSubParts(); ++part)
+        {
+            const unsigned char* vertices = NULL;
+            const unsigned char* indices = NULL;
+            int numVertices = 0;
+            int vertexStride = 0;
+            int indexStride = 0;
+            int numFaces = 0;
+            PHY_ScalarType vertexType;
+            PHY_ScalarType indexType;
+            mesh->getLockedReadOnlyVertexIndexBase(&vertices, numVertices, vertexType, vertexStride,
+                                                   &indices, indexStride, numFaces, indexType, part);
+            hash = Navigator::hashData(hash, vertices, static_cast<size_t>(numVertices) * vertexStride);
+            hash = Navigator::hashData(hash, indices, static_cast<size_t>(numFaces) * indexStride);
+            mesh->unLockReadOnlyVertexBase(part);
+        }
+
+        meshHashes[mesh] = hash;
+        return hash;
+    }
+
+    uint64_t hashShape(uint64_t hash, const btCollisionShape* shape, MeshHashes& meshHashes)
+    {
+        hash = Navigator::hashValue(hash, shape->getShapeType());
+        hash = hashVector(hash, shape->getLocalScaling());
+
+        if (shape->isCompound())
+        {
+            const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+            for (int i = 0; i < compound->getNumChildShapes(); ++i)
+            {
+                hash = hashTransform(hash, compound->getChildTransform(i));
+                hash = hashShape(hash, compound->getChildShape(i), meshHashes);
+            }
+        }
+        else if (shape->getShapeType() == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE)
+        {
+            const btBvhTriangleMeshShape* mesh = static_cast<const btScaledBvhTriangleMeshShape*>(shape)->getChildShape();
+            hash = Navigator::hashValue(hash, hashMesh(mesh->getMeshInterface(), meshHashes));
+        }
+        else if (shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
+        {
+            const btBvhTriangleMeshShape* mesh = static_cast<const btBvhTriangleMeshShape*>(shape);
+            hash = Navigator::hashValue(hash, hashMesh(mesh->getMeshInterface(), meshHashes));
+        }
+        else
+        {
+            // Boxes and other primitives are told apart by their extents
+            btVector3 min, max;
+            shape->getAabb(btTransform::getIdentity(), min, max);
+            hash = hashVector(hashVector(hash, min), max);
+        }
+        return hash;
+    }
+
+    btVector3 toBullet(const osg::Vec3f& vector)
+    {
+        return btVector3(vector.x(), vector.y(), vector.z());
+    }
+
+    bool compareHits(const Navigator::Geometry::Hit& left, const Navigator::Geometry::Hit& right)
+    {
+        return left.mZ > right.mZ;
+    }
+}
+
+namespace Navigator
+{
+
+    BulletGeometry::BulletGeometry()
+        : mCollisionConfiguration(new btDefaultCollisionConfiguration)
+        , mDispatcher(new btCollisionDispatcher(mCollisionConfiguration.get()))
+        , mBroadphase(new btDbvtBroadphase)
+        , mCollisionWorld(new btCollisionWorld(mDispatcher.get(), mBroadphase.get(), mCollisionConfiguration.get()))
+    {
+        mCollisionWorld->setForceUpdateAllAabbs(false);
+    }
+
+    BulletGeometry::~BulletGeometry()
+    {
+        // The world refers to the objects until they are removed from it
+        for (std::vector<std::unique_ptr<btCollisionObject> >::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+            mCollisionWorld->removeCollisionObject(it->get());
+        mCollisionWorld.reset();
+    }
+
+    void BulletGeometry::addShape(const Resource::BulletShapeInstance& shape, const btTransform& transform)
+    {
+        if (!shape.mCollisionShape)
+            return;
+
+        // Instances only know how to duplicate the shapes of their source
+        osg::ref_ptr<Resource::BulletShapeInstance> copy = shape.getSource()->makeInstance();
+        copy->getCollisionShape()->setLocalScaling(shape.mCollisionShape->getLocalScaling());
+        mShapes.push_back(copy);
+
+        addObject(copy->getCollisionShape(), transform);
+    }
+
+    void BulletGeometry::addHeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH,
+                                        const osg::Object* holdObject)
+    {
+        std::unique_ptr<HeightField> heightField (new HeightField);
+        heightField->mHeights = heights;
+        heightField->mX = x;
+        heightField->mY = y;
+        heightField->mTriSize = triSize;
+        heightField->mSqrtVerts = sqrtVerts;
+        heightField->mMinH = minH;
+        heightField->mMaxH = maxH;
+        heightField->mHoldObject = holdObject;
+
+        // Same as the terrain of MWPhysics
+        heightField->mShape.reset(new btHeightfieldTerrainShape(sqrtVerts, sqrtVerts, heights, 1, minH, maxH, 2, PHY_FLOAT, false));
+        heightField->mShape->setUseDiamondSubdivision(true);
+        heightField->mShape->setLocalScaling(btVector3(triSize, triSize, 1));
+
+        const btTransform transform (btQuaternion::getIdentity(),
+                                     btVector3((x + 0.5f) * triSize * (sqrtVerts - 1),
+                                               (y + 0.5f) * triSize * (sqrtVerts - 1),
+                                               (maxH + minH) * 0.5f));
+        addObject(heightField->mShape.get(), transform);
+
+        mHeightFields.push_back(std::move(heightField));
+    }
+
+    void BulletGeometry::addObject(btCollisionShape* shape, const btTransform& transform)
+    {
+        std::unique_ptr<btCollisionObject> object (new btCollisionObject);
+        object->setCollisionShape(shape);
+        object->setWorldTransform(transform);
+        mCollisionWorld->addCollisionObject(object.get());
+        mObjects.push_back(std::move(object));
+    }
+
+    bool BulletGeometry::isEmpty() const
+    {
+        return mObjects.empty();
+    }
+
+    void BulletGeometry::getBounds(osg::Vec3f& min, osg::Vec3f& max) const
+    {
+        btVector3 boundsMin (BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+        btVector3 boundsMax (-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+        for (std::vector<std::unique_ptr<btCollisionObject> >::const_iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            btVector3 objectMin, objectMax;
+            (*it)->getCollisionShape()->getAabb((*it)->getWorldTransform(), objectMin, objectMax);
+            boundsMin.setMin(objectMin);
+            boundsMax.setMax(objectMax);
+        }
+        min = osg::Vec3f(boundsMin.x(), boundsMin.y(), boundsMin.z());
+        max = osg::Vec3f(boundsMax.x(), boundsMax.y(), boundsMax.z());
+    }
+
+    uint64_t BulletGeometry::getHash() const
+    {
+        MeshHashes meshHashes;
+        std::vector<uint64_t> hashes;
+        for (std::vector<std::unique_ptr<btCollisionObject> >::const_iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            const btCollisionShape* shape = (*it)->getCollisionShape();
+            if (shape->getShapeType() == TERRAIN_SHAPE_PROXYTYPE)
+                continue;
+            hashes.push_back(hashShape(hashTransform(sHashBasis, (*it)->getWorldTransform()), shape, meshHashes));
+        }
+
+        for (std::vector<std::unique_ptr<HeightField> >::const_iterator it = mHeightFields.begin(); it != mHeightFields.end(); ++it)
+        {
+            const HeightField& heightField = **it;
+            uint64_t hash = sHashBasis;
+            hash = hashValue(hash, heightField.mX);
+            hash = hashValue(hash, heightField.mY);
+            hash = hashValue(hash, heightField.mTriSize);
+            hash = hashValue(hash, heightField.mSqrtVerts);
+            const size_t numHeights = static_cast<size_t>(heightField.mSqrtVerts) * static_cast<size_t>(heightField.mSqrtVerts);
+            hash = hashData(hash, heightField.mHeights, numHeights * sizeof(float));
+            hashes.push_back(hash);
+        }
+
+        // The order objects were added in depends on where they are in memory
+        std::sort(hashes.begin(), hashes.end());
+        return hashes.empty() ? sHashBasis : hashData(sHashBasis, &hashes[0], hashes.size() * sizeof(uint64_t));
+    }
+
+    void BulletGeometry::castDown(float x, float y, float fromZ, float toZ, std::vector<Hit>& hits) const
+    {
+        const btVector3 from (x, y, fromZ);
+        const btVector3 to (x, y, toZ);
+        btCollisionWorld::AllHitsRayResultCallback callback (from, to);
+        mCollisionWorld->rayTest(from, to, callback);
+
+        const size_t first = hits.size();
+        for (int i = 0; i < callback.m_hitPointWorld.size(); ++i)
+        {
+            Hit hit;
+            hit.mZ = callback.m_hitPointWorld[i].z();
+            hit.mNormalZ = std::abs(callback.m_hitNormalWorld[i].z());
+            hits.push_back(hit);
+        }
+        std::sort(hits.begin() + first, hits.end(), compareHits);
+    }
+
+    bool BulletGeometry::isBlocked(const osg::Vec3f& from, const osg::Vec3f& to) const
+    {
+        const btVector3 btFrom = toBullet(from);
+        const btVector3 btTo = toBullet(to);
+        btCollisionWorld::ClosestRayResultCallback callback (btFrom, btTo);
+        mCollisionWorld->rayTest(btFrom, btTo, callback);
+        return callback.hasHit();
+    }
+
+}
@@ -0,0 +1,94 @@
+#ifndef OPENMW_COMPONENTS_NAVIGATOR_BULLETGEOMETRY_H
+#define OPENMW_COMPONENTS_NAVIGATOR_BULLETGEOMETRY_H
+
+#include <memory>
+#include <vector>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include "navgridbuilder.hpp"
+
+class btCollisionWorld;
+class btCollisionConfiguration;
+class btCollisionDispatcher;
+class btBroadphaseInterface;
+class btCollisionObject;
+class btCollisionShape;
+class btHeightfieldTerrainShape;
+class btTransform;
+
+namespace osg
+{
+    class Object;
+}
+
+namespace Resource
+{
+    class BulletShapeInstance;
+}
+
+namespace Navigator
+{
+
+    /// @brief A copy of the static collision geometry of a cell, to build a NavGrid from on a worker thread
+    /// while the physics world goes on changing.
+    /// @par Triangle meshes and height data are shared with the physics world and only read, everything else
+    /// is copied, so that the physics world may move or remove its objects in the meantime.
+    /// @note Fill on the main thread, then use from a single thread at a time.
+    class BulletGeometry : public Geometry, public osg::Referenced
+    {
+    public:
+        BulletGeometry();
+        ~BulletGeometry();
+
+        /// Add a copy of \a shape with the scale it has in the physics world, placed at \a transform.
+        void addShape(const Resource::BulletShapeInstance& shape, const btTransform& transform);
+
+        /// Add a heightfield with the parameters MWPhysics uses for terrain.
+        /// @param holdObject Kept alive for as long as this geometry is, since it owns \a heights.
+        void addHeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH,
+                            const osg::Object* holdObject);
+
+        bool isEmpty() const;
+
+        /// Get the box around everything added.
+        void getBounds(osg::Vec3f& min, osg::Vec3f& max) const;
+
+        /// Hash of the shapes, their placement and the height data, whatever order they were added in.
+        /// @note Reads all vertices, so call it on the worker thread too.
+        uint64_t getHash() const;
+
+        virtual void castDown(float x, float y, float fromZ, float toZ, std::vector<Hit>& hits) const;
+
+        virtual bool isBlocked(const osg::Vec3f& from, const osg::Vec3f& to) const;
+
+    private:
+        struct HeightField
+        {
+            const float* mHeights;
+            int mX;
+            int mY;
+            float mTriSize;
+            float mSqrtVerts;
+            float mMinH;
+            float mMaxH;
+            osg::ref_ptr<const osg::Object> mHoldObject;
+            std::unique_ptr<btHeightfieldTerrainShape> mShape;
+        };
+
+        void addObject(btCollisionShape* shape, const btTransform& transform);
+
+        std::unique_ptr<btCollisionConfiguration> mCollisionConfiguration;
+        std::unique_ptr<btCollisionDispatcher> mDispatcher;
+        std::unique_ptr<btBroadphaseInterface> mBroadphase;
+        std::unique_ptr<btCollisionWorld> mCollisionWorld;
+
+        std::vector<osg::ref_ptr<Resource::BulletShapeInstance> > mShapes;
+        std::vector<std::unique_ptr<HeightField> > mHeightFields;
+        std::vector<std::unique_ptr<btCollisionObject> > mObjects;
+    };
+
+}
+
+#endif
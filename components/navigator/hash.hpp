@@ -0,0 +1,40 @@
+#ifndef OPENMW_COMPONENTS_NAVIGATOR_HASH_H
+#define OPENMW_COMPONENTS_NAVIGATOR_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace Navigator
+{
+
+    const uint64_t sHashBasis = 14695981039346656037ULL;
+
+    /// FNV-1a over 64 bit words, for telling the inputs of a NavGrid apart.
+    inline uint64_t hashData(uint64_t hash, const void* data, size_t size)
+    {
+        const uint64_t prime = 1099511628211ULL;
+        const char* bytes = static_cast<const char*>(data);
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(uint64_t));
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; ++i)
+            hash = (hash ^ static_cast<unsigned char>(bytes[i])) * prime;
+
+        return hash;
+    }
+
+    template <class T>
+    uint64_t hashValue(uint64_t hash, const T& value)
+    {
+        return hashData(hash, &value, sizeof(T));
+    }
+
+}
+
+#endif
@@ -0,0 +1,400 @@
+#include "navgrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <queue>
+#include <string.h>
+
+namespace
+{
+    const char sMagic[8] = {'O', 'M', 'W', 'N', 'A', 'V', 'G', 0};
+
+    // Increase when the layout of the stored grid changes
+    const uint32_t sFormatVersion = 1;
+
+    const int sDirectionX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    const int sDirectionY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    // Direction for an offset of (dx + 1) + (dy + 1) * 3, or -1 for no offset
+    const int sOffsetDirection[9] = {5, 6, 7, 4, -1, 0, 3, 2, 1};
+
+    // How much more it costs to walk through a node at an edge, to keep paths off walls and ledges
+    const float sEdgeCost = 4.f;
+
+    // How many columns around a point to look at for its closest node
+    const int sFindNodeRadius = 2;
+
+    template <class T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <class T>
+    bool readValue(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template <class T>
+    void writeVector(std::ostream& stream, const std::vector<T>& values)
+    {
+        if (!values.empty())
+            stream.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+    }
+
+    template <class T>
+    bool readVector(std::istream& stream, std::vector<T>& values, size_t size)
+    {
+        values.resize(size);
+        return size == 0 || static_cast<bool>(stream.read(reinterpret_cast<char*>(&values[0]), size * sizeof(T)));
+    }
+}
+
+namespace Navigator
+{
+
+    NavGrid::NavGrid()
+        : mOriginX(0)
+        , mOriginY(0)
+        , mSpacing(1)
+        , mWidth(0)
+        , mHeight(0)
+    {
+    }
+
+    NavGrid::NavGrid(float originX, float originY, float spacing, int width, int height)
+        : mOriginX(originX)
+        , mOriginY(originY)
+        , mSpacing(spacing)
+        , mWidth(width)
+        , mHeight(height)
+    {
+        mColumns.reserve(width * height + 1);
+        mColumns.push_back(0);
+    }
+
+    void NavGrid::addColumn(const std::vector<float>& heights)
+    {
+        const size_t numLayers = std::min<size_t>(heights.size(), sMaxLayers);
+        const uint32_t column = mColumns.size() - 1;
+        for (size_t i = 0; i < numLayers; ++i)
+        {
+            Node node;
+            node.mZ = heights[i];
+            memset(node.mLinks, sNoLink, sizeof(node.mLinks));
+            mNodes.push_back(node);
+            mNodeColumns.push_back(column);
+        }
+        mColumns.push_back(mNodes.size());
+    }
+
+    void NavGrid::finish()
+    {
+        const uint32_t noRegion = std::numeric_limits<uint32_t>::max();
+        mRegions.assign(mNodes.size(), noRegion);
+
+        uint32_t region = 0;
+        std::vector<unsigned int> open;
+        for (unsigned int first = 0; first < mNodes.size(); ++first)
+        {
+            if (mRegions[first] != noRegion)
+                continue;
+
+            mRegions[first] = region;
+            open.push_back(first);
+            while (!open.empty())
+            {
+                const unsigned int index = open.back();
+                open.pop_back();
+                for (int direction = 0; direction < 8; ++direction)
+                {
+                    const int neighbour = getNeighbour(index, direction);
+                    if (neighbour >= 0 && mRegions[neighbour] == noRegion)
+                    {
+                        mRegions[neighbour] = region;
+                        open.push_back(neighbour);
+                    }
+                }
+            }
+            ++region;
+        }
+    }
+
+    osg::Vec3f NavGrid::getPosition(unsigned int index) const
+    {
+        return osg::Vec3f(mOriginX + getColumnX(index) * mSpacing, mOriginY + getColumnY(index) * mSpacing, mNodes[index].mZ);
+    }
+
+    int NavGrid::getNeighbour(unsigned int index, int direction) const
+    {
+        const unsigned char link = mNodes[index].mLinks[direction];
+        if (link == sNoLink)
+            return -1;
+        return getFirstNode(getColumnX(index) + sDirectionX[direction], getColumnY(index) + sDirectionY[direction]) + link;
+    }
+
+    void NavGrid::getNeighbourColumn(int direction, int& dx, int& dy)
+    {
+        dx = sDirectionX[direction];
+        dy = sDirectionY[direction];
+    }
+
+    bool NavGrid::contains(const osg::Vec3f& position) const
+    {
+        const float x = (position.x() - mOriginX) / mSpacing;
+        const float y = (position.y() - mOriginY) / mSpacing;
+        return x > -0.5f && y > -0.5f && x < mWidth - 0.5f && y < mHeight - 0.5f;
+    }
+
+    bool NavGrid::findPath(const osg::Vec3f& start, const osg::Vec3f& end, float maxZDistance,
+                           std::vector<osg::Vec3f>& path) const
+    {
+        path.clear();
+
+        const int startNode = findNode(start, maxZDistance);
+        const int endNode = findNode(end, maxZDistance);
+        if (startNode < 0 || endNode < 0 || mRegions[startNode] != mRegions[endNode])
+            return false;
+
+        if (startNode == endNode)
+            return true;
+
+        // A* over the nodes, with the straight distance to the end as the estimate
+        const float infinity = std::numeric_limits<float>::max();
+        std::vector<float> costs(mNodes.size(), infinity);
+        std::vector<int32_t> previous(mNodes.size(), -1);
+
+        typedef std::pair<float, unsigned int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+
+        const osg::Vec3f endPosition = getPosition(endNode);
+        costs[startNode] = 0;
+        open.push(Entry((getPosition(startNode) - endPosition).length(), startNode));
+
+        while (!open.empty())
+        {
+            const unsigned int index = open.top().second;
+            const float estimate = open.top().first;
+            open.pop();
+
+            if (index == static_cast<unsigned int>(endNode))
+                break;
+
+            const osg::Vec3f position = getPosition(index);
+            // Skip entries for nodes that were reached more cheaply since they were added
+            if (estimate > costs[index] + (position - endPosition).length() + 0.01f)
+                continue;
+
+            for (int direction = 0; direction < 8; ++direction)
+            {
+                const int neighbour = getNeighbour(index, direction);
+                if (neighbour < 0)
+                    continue;
+
+                const osg::Vec3f neighbourPosition = getPosition(neighbour);
+                float step = (neighbourPosition - position).length();
+                if (isEdge(neighbour) && neighbour != endNode)
+                    step *= sEdgeCost;
+
+                const float cost = costs[index] + step;
+                if (cost < costs[neighbour])
+                {
+                    costs[neighbour] = cost;
+                    previous[neighbour] = index;
+                    open.push(Entry(cost + (neighbourPosition - endPosition).length(), neighbour));
+                }
+            }
+        }
+
+        if (previous[endNode] < 0)
+            return false;
+
+        std::vector<unsigned int> nodes;
+        for (int index = endNode; index >= 0; index = previous[index])
+            nodes.push_back(index);
+        std::reverse(nodes.begin(), nodes.end());
+
+        // Skip the nodes that a straight line can pass by
+        size_t current = 0;
+        while (current + 1 < nodes.size())
+        {
+            size_t next = current + 1;
+            while (next + 1 < nodes.size() && isStraightPath(nodes[current], nodes[next + 1]))
+                ++next;
+
+            if (next + 1 < nodes.size())
+                path.push_back(getPosition(nodes[next]));
+            current = next;
+        }
+
+        return true;
+    }
+
+    int NavGrid::findNode(const osg::Vec3f& position, float maxZDistance) const
+    {
+        const int x = static_cast<int>(std::floor((position.x() - mOriginX) / mSpacing + 0.5f));
+        const int y = static_cast<int>(std::floor((position.y() - mOriginY) / mSpacing + 0.5f));
+
+        int closest = -1;
+        float closestDistance = std::numeric_limits<float>::max();
+        for (int columnY = std::max(0, y - sFindNodeRadius); columnY <= std::min(mHeight - 1, y + sFindNodeRadius); ++columnY)
+        {
+            for (int columnX = std::max(0, x - sFindNodeRadius); columnX <= std::min(mWidth - 1, x + sFindNodeRadius); ++columnX)
+            {
+                const unsigned int first = getFirstNode(columnX, columnY);
+                for (unsigned int index = first; index < first + getNumLayers(columnX, columnY); ++index)
+                {
+                    if (std::abs(mNodes[index].mZ - position.z()) > maxZDistance)
+                        continue;
+
+                    bool linked = false;
+                    for (int direction = 0; direction < 8 && !linked; ++direction)
+                        linked = mNodes[index].mLinks[direction] != sNoLink;
+                    if (!linked)
+                        continue;
+
+                    const float distance = (getPosition(index) - position).length2();
+                    if (distance < closestDistance)
+                    {
+                        closestDistance = distance;
+                        closest = index;
+                    }
+                }
+            }
+        }
+        return closest;
+    }
+
+    bool NavGrid::isStraightPath(unsigned int from, unsigned int to) const
+    {
+        const int fromX = getColumnX(from);
+        const int fromY = getColumnY(from);
+        const int dx = getColumnX(to) - fromX;
+        const int dy = getColumnY(to) - fromY;
+
+        // Half a column per step, so that every step moves by at most one column either way
+        const int numSteps = 2 * std::max(std::abs(dx), std::abs(dy));
+
+        unsigned int current = from;
+        int currentX = fromX;
+        int currentY = fromY;
+        for (int i = 1; i <= numSteps; ++i)
+        {
+            const float t = static_cast<float>(i) / numSteps;
+            const int x = static_cast<int>(std::floor(fromX + dx * t + 0.5f));
+            const int y = static_cast<int>(std::floor(fromY + dy * t + 0.5f));
+            if (x == currentX && y == currentY)
+                continue;
+
+            const int next = step(current, x, y);
+            if (next < 0 || (static_cast<unsigned int>(next) != to && isEdge(next)))
+                return false;
+
+            current = next;
+            currentX = x;
+            currentY = y;
+        }
+        return current == to;
+    }
+
+    bool NavGrid::isEdge(unsigned int index) const
+    {
+        for (int direction = 0; direction < 8; ++direction)
+        {
+            if (mNodes[index].mLinks[direction] == sNoLink)
+                return true;
+        }
+        return false;
+    }
+
+    int NavGrid::step(unsigned int from, int x, int y) const
+    {
+        const int direction = sOffsetDirection[(x - getColumnX(from) + 1) + (y - getColumnY(from) + 1) * 3];
+        return getNeighbour(from, direction);
+    }
+
+    int NavGrid::getColumnX(unsigned int index) const
+    {
+        return mNodeColumns[index] % mWidth;
+    }
+
+    int NavGrid::getColumnY(unsigned int index) const
+    {
+        return mNodeColumns[index] / mWidth;
+    }
+
+    void NavGrid::write(std::ostream& stream, uint64_t key) const
+    {
+        stream.write(sMagic, sizeof(sMagic));
+        writeValue(stream, sFormatVersion);
+        writeValue(stream, key);
+        writeValue(stream, mOriginX);
+        writeValue(stream, mOriginY);
+        writeValue(stream, mSpacing);
+        writeValue(stream, static_cast<int32_t>(mWidth));
+        writeValue(stream, static_cast<int32_t>(mHeight));
+        writeValue(stream, static_cast<uint32_t>(mNodes.size()));
+        writeVector(stream, mColumns);
+        writeVector(stream, mNodes);
+    }
+
+    osg::ref_ptr<NavGrid> NavGrid::read(std::istream& stream, uint64_t key)
+    {
+        char magic[sizeof(sMagic)];
+        uint32_t version = 0;
+        uint64_t storedKey = 0;
+        if (!stream.read(magic, sizeof(magic)) || memcmp(magic, sMagic, sizeof(sMagic)) != 0
+                || !readValue(stream, version) || version != sFormatVersion
+                || !readValue(stream, storedKey) || storedKey != key)
+            return NULL;
+
+        osg::ref_ptr<NavGrid> grid (new NavGrid);
+        int32_t width = 0;
+        int32_t height = 0;
+        uint32_t numNodes = 0;
+        if (!readValue(stream, grid->mOriginX) || !readValue(stream, grid->mOriginY) || !readValue(stream, grid->mSpacing)
+                || !readValue(stream, width) || !readValue(stream, height) || !readValue(stream, numNodes)
+                || width <= 0 || height <= 0 || !(grid->mSpacing > 0))
+            return NULL;
+        grid->mWidth = width;
+        grid->mHeight = height;
+
+        if (!readVector(stream, grid->mColumns, static_cast<size_t>(width) * height + 1)
+                || !readVector(stream, grid->mNodes, numNodes))
+            return NULL;
+
+        // Check everything the searches rely on, so that a damaged file can not make them read out of bounds
+        if (grid->mColumns.front() != 0 || grid->mColumns.back() != numNodes)
+            return NULL;
+        grid->mNodeColumns.reserve(numNodes);
+        for (size_t column = 0; column + 1 < grid->mColumns.size(); ++column)
+        {
+            if (grid->mColumns[column + 1] < grid->mColumns[column]
+                    || grid->mColumns[column + 1] - grid->mColumns[column] > sMaxLayers)
+                return NULL;
+            grid->mNodeColumns.resize(grid->mColumns[column + 1], column);
+        }
+        for (unsigned int index = 0; index < numNodes; ++index)
+        {
+            for (int direction = 0; direction < 8; ++direction)
+            {
+                const unsigned char link = grid->mNodes[index].mLinks[direction];
+                if (link == sNoLink)
+                    continue;
+                const int x = grid->getColumnX(index) + sDirectionX[direction];
+                const int y = grid->getColumnY(index) + sDirectionY[direction];
+                if (x < 0 || y < 0 || x >= width || y >= height || link >= grid->getNumLayers(x, y))
+                    return NULL;
+            }
+        }
+
+        grid->finish();
+        return grid;
+    }
+
+}
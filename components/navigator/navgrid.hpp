@@ -0,0 +1,123 @@
+#ifndef OPENMW_COMPONENTS_NAVIGATOR_NAVGRID_H
+#define OPENMW_COMPONENTS_NAVIGATOR_NAVGRID_H
+
+#include <iosfwd>
+#include <vector>
+#include <stdint.h>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Vec3f>
+
+namespace Navigator
+{
+
+    /// @brief Where an actor can stand within one cell, and how it gets from there to its neighbours.
+    /// @par The cell is sampled on a square grid. Every column of the grid holds a node for each walkable surface
+    /// at that spot, from the top down, e.g. a bridge and the ground below it. A node links to at most one node
+    /// in each of the eight neighbouring columns, namely the one an actor can walk to in a straight line.
+    /// @note Immutable once built, so any thread may search it.
+    class NavGrid : public osg::Referenced
+    {
+    public:
+        /// Value of Node::mLinks for a direction with no neighbour to walk to.
+        static const unsigned char sNoLink = 0xff;
+
+        /// Most nodes one column can have.
+        static const unsigned int sMaxLayers = sNoLink;
+
+        struct Node
+        {
+            float mZ;
+            /// The index of the node to walk to among the nodes of the neighbouring column in each direction,
+            /// counterclockwise starting from +X, see getNeighbourColumn().
+            unsigned char mLinks[8];
+        };
+
+        /// @param originX,originY Position of the first column.
+        /// @param spacing Distance between two neighbouring columns.
+        NavGrid(float originX, float originY, float spacing, int width, int height);
+
+        /// Add the next column, in order of X first, then Y, with nodes at the given heights from the top down.
+        /// Call for every column before linking the nodes.
+        void addColumn(const std::vector<float>& heights);
+
+        /// Call once all nodes are linked, before searching the grid. Links must go both ways.
+        void finish();
+
+        float getSpacing() const { return mSpacing; }
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+
+        unsigned int getNumNodes() const { return mNodes.size(); }
+
+        /// Index of the first node of the column at \a x, \a y. The nodes of a column are adjacent.
+        unsigned int getFirstNode(int x, int y) const { return mColumns[y * mWidth + x]; }
+        unsigned int getNumLayers(int x, int y) const { return mColumns[y * mWidth + x + 1] - mColumns[y * mWidth + x]; }
+
+        const Node& getNode(unsigned int index) const { return mNodes[index]; }
+        Node& getNode(unsigned int index) { return mNodes[index]; }
+
+        /// World position of a node.
+        osg::Vec3f getPosition(unsigned int index) const;
+
+        /// Index of the neighbouring node in \a direction, or -1 if there is no link that way.
+        int getNeighbour(unsigned int index, int direction) const;
+
+        /// Offset from a column to its neighbour in \a direction.
+        static void getNeighbourColumn(int direction, int& dx, int& dy);
+
+        /// @return whether \a position lies within the columns of the grid.
+        bool contains(const osg::Vec3f& position) const;
+
+        /// Find a path from \a start to \a end.
+        /// @param maxZDistance How far above or below the closest node each point may be.
+        /// @param path Receives the points to walk through after \a start, excluding \a end itself.
+        /// A straight line from one point to the next, as well as from the last one to \a end, stays on the grid.
+        /// @return false if no path was found, e.g. either point is off the grid or they are not connected.
+        bool findPath(const osg::Vec3f& start, const osg::Vec3f& end, float maxZDistance,
+                      std::vector<osg::Vec3f>& path) const;
+
+        /// Store the grid in a flat binary format, tagged with \a key.
+        void write(std::ostream& stream, uint64_t key) const;
+
+        /// @return NULL if the stream does not hold a grid tagged with \a key that write() stored in the same format.
+        static osg::ref_ptr<NavGrid> read(std::istream& stream, uint64_t key);
+
+    private:
+        NavGrid();
+
+        /// Index of the node closest to \a position that links to any neighbour, or -1 if there is none nearby.
+        int findNode(const osg::Vec3f& position, float maxZDistance) const;
+
+        /// @return whether the straight line between both nodes only crosses linked nodes that are not at an edge.
+        bool isStraightPath(unsigned int from, unsigned int to) const;
+
+        /// @return whether a node misses a link in any direction, i.e. an actor standing there would touch a wall
+        /// or stand at a ledge.
+        bool isEdge(unsigned int index) const;
+
+        /// Index of the node in column \a x, \a y that \a from links to, or -1.
+        int step(unsigned int from, int x, int y) const;
+
+        int getColumnX(unsigned int index) const;
+        int getColumnY(unsigned int index) const;
+
+        float mOriginX;
+        float mOriginY;
+        float mSpacing;
+        int mWidth;
+        int mHeight;
+
+        /// First node of each column, followed by the total number of nodes
+        std::vector<uint32_t> mColumns;
+        std::vector<Node> mNodes;
+        /// Column of each node, so a node knows where it is
+        std::vector<uint32_t> mNodeColumns;
+        /// Nodes with the same region are connected, so a search between different regions can give up right away
+        std::vector<uint32_t> mRegions;
+    };
+
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include "navgridbuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <osg/Math>
+
+#include "hash.hpp"
+#include "navgrid.hpp"
+
+namespace
+{
+    // Hits closer than this are the same surface, e.g. the shared edge of two triangles
+    const float sSameSurfaceDistance = 1.f;
+
+    /// Merge hits on the same surface, keeping the flattest normal.
+    void mergeHits(std::vector<Navigator::Geometry::Hit>& hits)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < hits.size(); ++i)
+        {
+            if (count > 0 && hits[count - 1].mZ - hits[i].mZ < sSameSurfaceDistance)
+                hits[count - 1].mNormalZ = std::max(hits[count - 1].mNormalZ, hits[i].mNormalZ);
+            else
+                hits[count++] = hits[i];
+        }
+        hits.resize(count);
+    }
+}
+
+namespace Navigator
+{
+
+    BuildSettings::BuildSettings()
+        : mSpacing(32.f)
+        , mAgentHeight(128.f) // about the height of an NPC
+        , mStepHeight(34.f)
+        , mMaxSlope(49.f)
+    {
+    }
+
+    uint64_t BuildSettings::getHash() const
+    {
+        uint64_t hash = sHashBasis;
+        hash = hashValue(hash, mSpacing);
+        hash = hashValue(hash, mAgentHeight);
+        hash = hashValue(hash, mStepHeight);
+        hash = hashValue(hash, mMaxSlope);
+        return hash;
+    }
+
+    osg::ref_ptr<NavGrid> buildNavGrid(const Geometry& geometry, const osg::Vec3f& min, const osg::Vec3f& max,
+                                       const BuildSettings& settings)
+    {
+        const float spacing = settings.mSpacing;
+        const int width = std::max(1, static_cast<int>(std::ceil((max.x() - min.x()) / spacing)));
+        const int height = std::max(1, static_cast<int>(std::ceil((max.y() - min.y()) / spacing)));
+        const float originX = min.x() + spacing / 2;
+        const float originY = min.y() + spacing / 2;
+
+        osg::ref_ptr<NavGrid> grid (new NavGrid(originX, originY, spacing, width, height));
+
+        // Nodes are the surfaces that are flat enough and have room for an actor above
+        const float minNormalZ = std::cos(osg::DegreesToRadians(settings.mMaxSlope));
+        std::vector<Geometry::Hit> hits;
+        std::vector<float> heights;
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                hits.clear();
+                geometry.castDown(originX + x * spacing, originY + y * spacing, max.z() + 1, min.z() - 1, hits);
+                mergeHits(hits);
+
+                heights.clear();
+                for (size_t i = 0; i < hits.size(); ++i)
+                {
+                    if (hits[i].mNormalZ < minNormalZ)
+                        continue;
+                    if (i > 0 && hits[i - 1].mZ - hits[i].mZ < settings.mAgentHeight)
+                        continue;
+                    heights.push_back(hits[i].mZ);
+                }
+                grid->addColumn(heights);
+            }
+        }
+
+        // Link every node to the node of each neighbouring column that is within a step or a walkable slope,
+        // unless something stands in between. Going through half the directions covers every pair once.
+        const float maxSlope = std::tan(osg::DegreesToRadians(settings.mMaxSlope));
+        const osg::Vec3f stepOffset (0, 0, settings.mStepHeight);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const unsigned int first = grid->getFirstNode(x, y);
+                for (unsigned int index = first; index < first + grid->getNumLayers(x, y); ++index)
+                {
+                    const osg::Vec3f position = grid->getPosition(index);
+                    for (int direction = 0; direction < 4; ++direction)
+                    {
+                        int dx, dy;
+                        NavGrid::getNeighbourColumn(direction, dx, dy);
+                        if (x + dx < 0 || x + dx >= width || y + dy >= height)
+                            continue;
+
+                        const float distance = (dx != 0 && dy != 0) ? spacing * std::sqrt(2.f) : spacing;
+                        const float maxClimb = std::max(settings.mStepHeight, distance * maxSlope);
+
+                        const unsigned int neighbourFirst = grid->getFirstNode(x + dx, y + dy);
+                        int closest = -1;
+                        float closestClimb = std::numeric_limits<float>::max();
+                        for (unsigned int layer = 0; layer < grid->getNumLayers(x + dx, y + dy); ++layer)
+                        {
+                            const float climb = std::abs(grid->getNode(neighbourFirst + layer).mZ - position.z());
+                            if (climb <= maxClimb && climb < closestClimb)
+                            {
+                                closest = layer;
+                                closestClimb = climb;
+                            }
+                        }
+
+                        const int opposite = (direction + 4) % 8;
+                        if (closest < 0 || grid->getNode(neighbourFirst + closest).mLinks[opposite] != NavGrid::sNoLink)
+                            continue;
+
+                        if (geometry.isBlocked(position + stepOffset, grid->getPosition(neighbourFirst + closest) + stepOffset))
+                            continue;
+
+                        grid->getNode(index).mLinks[direction] = static_cast<unsigned char>(closest);
+                        grid->getNode(neighbourFirst + closest).mLinks[opposite] = static_cast<unsigned char>(index - first);
+                    }
+                }
+            }
+        }
+
+        grid->finish();
+        return grid;
+    }
+
+}
@@ -0,0 +1,61 @@
+#ifndef OPENMW_COMPONENTS_NAVIGATOR_NAVGRIDBUILDER_H
+#define OPENMW_COMPONENTS_NAVIGATOR_NAVGRIDBUILDER_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <osg/ref_ptr>
+#include <osg/Vec3f>
+
+namespace Navigator
+{
+
+    class NavGrid;
+
+    /// @brief The collision geometry of a cell, as the NavGrid builder asks about it.
+    class Geometry
+    {
+    public:
+        struct Hit
+        {
+            float mZ;
+            /// Z of the surface normal, turned to face up
+            float mNormalZ;
+        };
+
+        virtual ~Geometry() {}
+
+        /// Add every surface that the vertical line at \a x, \a y crosses between \a fromZ and \a toZ to \a hits,
+        /// ordered from the top down.
+        virtual void castDown(float x, float y, float fromZ, float toZ, std::vector<Hit>& hits) const = 0;
+
+        /// @return whether anything solid lies on the straight line from \a from to \a to.
+        virtual bool isBlocked(const osg::Vec3f& from, const osg::Vec3f& to) const = 0;
+    };
+
+    struct BuildSettings
+    {
+        BuildSettings();
+
+        /// Distance between two columns of the grid
+        float mSpacing;
+        /// Free height a surface needs above it to be walkable
+        float mAgentHeight;
+        /// Height of the steps an actor walks up without a slope, see MWPhysics
+        float mStepHeight;
+        /// Steepest walkable slope in degrees, see MWPhysics
+        float mMaxSlope;
+
+        /// Hash of the settings, for telling grids built with different settings apart.
+        uint64_t getHash() const;
+    };
+
+    /// Sample \a geometry on columns that cover \a min to \a max on the XY plane, and link the nodes an actor
+    /// can walk between.
+    /// @note Casts about five rays per column, so it is meant to run on a worker thread.
+    osg::ref_ptr<NavGrid> buildNavGrid(const Geometry& geometry, const osg::Vec3f& min, const osg::Vec3f& max,
+                                       const BuildSettings& settings);
+
+}
+
+#endif
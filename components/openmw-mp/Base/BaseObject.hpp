@@ -58,6 +58,7 @@ namespace mwmp
         int shortVal;
         float floatVal;
         std::string varName;
+        unsigned char variableType; // only used by ID_SCRIPT_STATE, see BaseObjectList::SCRIPT_VARIABLE
 
         bool isDisarmed;
         bool droppedByPlayer;
@@ -99,6 +100,16 @@ namespace mwmp
             REQUEST = 3
         };
 
+        enum SCRIPT_VARIABLE
+        {
+            LOCAL_SHORT = 0,
+            LOCAL_FLOAT = 1,
+            MEMBER_SHORT = 2,
+            MEMBER_FLOAT = 3,
+            GLOBAL_SHORT = 4,
+            GLOBAL_FLOAT = 5
+        };
+
         enum CONTAINER_SUBACTION
         {
             NONE = 0,
@@ -26,6 +26,7 @@
 #include "../Packets/Object/PacketScriptMemberFloat.hpp"
 #include "../Packets/Object/PacketScriptGlobalShort.hpp"
 #include "../Packets/Object/PacketScriptGlobalFloat.hpp"
+#include "../Packets/Object/PacketScriptState.hpp"
 
 #include "ObjectPacketController.hpp"
 
@@ -67,6 +68,7 @@ mwmp::ObjectPacketController::ObjectPacketController(RakNet::RakPeerInterface *p
     AddPacket<PacketScriptMemberFloat>(&packets, peer);
     AddPacket<PacketScriptGlobalShort>(&packets, peer);
     AddPacket<PacketScriptGlobalFloat>(&packets, peer);
+    AddPacket<PacketScriptState>(&packets, peer);
 }
 
 
@@ -16,7 +16,8 @@ enum MASTER_PACKETS
 {
     ID_MASTER_QUERY = ID_USER_PACKET_ENUM,
     ID_MASTER_UPDATE,
-    ID_MASTER_ANNOUNCE
+    ID_MASTER_ANNOUNCE,
+    ID_MASTER_QUERY_DELTA
 };
 
 struct ServerRule
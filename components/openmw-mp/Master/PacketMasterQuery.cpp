@@ -26,42 +26,8 @@ void PacketMasterQuery::Packet(RakNet::BitStream *bs, bool send)
     if (send)
         bs->Write(packetID);
 
-    int32_t serversCount = servers->size();
-
-    RW(serversCount, send);
-
-    map<SystemAddress, QueryData>::iterator serverIt;
-    if (send)
-        serverIt = servers->begin();
-
-    QueryData server;
-    string addr;
-    uint16_t port;
-    while (serversCount--)
-    {
-        if (send)
-        {
-            addr = serverIt->first.ToString(false);
-            port = serverIt->first.GetPort();
-            server = serverIt->second;
-        }
-        RW(addr, send);
-        RW(port, send);
-
-        ProxyMasterPacket::addServer(this, server, send);
-
-        if(addr.empty())
-        {
-            std::cerr << "Address empty. Aborting PacketMasterQuery::Packet" << std::endl;
-            return;
-        }
-
-        if (send)
-            serverIt++;
-        else
-            servers->insert(pair<SystemAddress, QueryData>(SystemAddress(addr.c_str(), port), server));
-    }
-
+    if (!ProxyMasterPacket::addServers(this, *servers, send))
+        std::cerr << "Address empty. Aborting PacketMasterQuery::Packet" << std::endl;
 }
 
 void PacketMasterQuery::SetServers(map<SystemAddress, QueryData> *serverMap)
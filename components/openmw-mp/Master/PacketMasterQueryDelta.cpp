@@ -0,0 +1,86 @@
+#include <components/openmw-mp/NetworkMessages.hpp>
+#include <iostream>
+#include "MasterData.hpp"
+#include "PacketMasterQueryDelta.hpp"
+#include "ProxyMasterPacket.hpp"
+
+
+using namespace mwmp;
+using namespace std;
+using namespace RakNet;
+
+PacketMasterQueryDelta::PacketMasterQueryDelta(RakNet::RakPeerInterface *peer) : BasePacket(peer)
+{
+    packetID = ID_MASTER_QUERY_DELTA;
+    orderChannel = CHANNEL_MASTER;
+    reliability = RELIABLE_ORDERED_WITH_ACK_RECEIPT;
+    servers = nullptr;
+    removed = nullptr;
+    version = 0;
+    full = true;
+}
+
+void PacketMasterQueryDelta::Packet(RakNet::BitStream *bs, bool send)
+{
+    this->bs = bs;
+    if (send)
+        bs->Write(packetID);
+
+    RW(version, send);
+    RW(full, send);
+
+    if (!ProxyMasterPacket::addServers(this, *servers, send))
+    {
+        std::cerr << "Address empty. Aborting PacketMasterQueryDelta::Packet" << std::endl;
+        return;
+    }
+
+    int32_t removedCount = removed->size();
+
+    RW(removedCount, send);
+
+    if (!send)
+        removed->clear();
+
+    string addr;
+    uint16_t port;
+    for (int32_t i = 0; i < removedCount; ++i)
+    {
+        if (send)
+        {
+            addr = (*removed)[i].ToString(false);
+            port = (*removed)[i].GetPort();
+        }
+        RW(addr, send);
+        RW(port, send);
+
+        if (!send)
+            removed->emplace_back(addr.c_str(), port);
+    }
+}
+
+void PacketMasterQueryDelta::SetServers(map<SystemAddress, QueryData> *serverMap)
+{
+    servers = serverMap;
+}
+
+void PacketMasterQueryDelta::SetRemoved(vector<SystemAddress> *removedList)
+{
+    removed = removedList;
+}
+
+void PacketMasterQueryDelta::SetVersion(uint32_t version, bool full)
+{
+    this->version = version;
+    this->full = full;
+}
+
+uint32_t PacketMasterQueryDelta::GetVersion() const
+{
+    return version;
+}
+
+bool PacketMasterQueryDelta::IsFull() const
+{
+    return full;
+}
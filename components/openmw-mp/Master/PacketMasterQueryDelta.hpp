@@ -0,0 +1,39 @@
+#ifndef OPENMW_PACKETMASTERQUERYDELTA_HPP
+#define OPENMW_PACKETMASTERQUERYDELTA_HPP
+
+#include "../Packets/BasePacket.hpp"
+#include "MasterData.hpp"
+
+namespace mwmp
+{
+    class ProxyMasterPacket;
+
+    /*
+     * Answer to an ID_MASTER_QUERY_DELTA request, which carries the last list version known to the client.
+     *
+     * Contains every server changed after that version and the addresses of servers removed since then.
+     * If the master can no longer tell what was removed, "full" is set and the client must replace its list.
+     */
+    class PacketMasterQueryDelta : public BasePacket
+    {
+        friend class ProxyMasterPacket;
+    public:
+        explicit PacketMasterQueryDelta(RakNet::RakPeerInterface *peer);
+
+        void Packet(RakNet::BitStream *bs, bool send) override;
+
+        void SetServers(std::map<RakNet::SystemAddress, QueryData> *serverMap);
+        void SetRemoved(std::vector<RakNet::SystemAddress> *removedList);
+
+        void SetVersion(uint32_t version, bool full);
+        uint32_t GetVersion() const;
+        bool IsFull() const;
+    private:
+        std::map<RakNet::SystemAddress, QueryData> *servers;
+        std::vector<RakNet::SystemAddress> *removed;
+        uint32_t version;
+        bool full;
+    };
+}
+
+#endif //OPENMW_PACKETMASTERQUERYDELTA_HPP
@@ -19,6 +19,48 @@ namespace mwmp
         }
 
     public:
+        /// Write or read the address, port and data of each server in the map
+        /// @return false if the list was cut short by an empty address
+        template<class Packet>
+        static bool addServers(Packet *packet, std::map<RakNet::SystemAddress, QueryData> &servers, bool send)
+        {
+            using namespace std;
+
+            int32_t serversCount = servers.size();
+
+            packet->RW(serversCount, send);
+
+            map<RakNet::SystemAddress, QueryData>::iterator serverIt;
+            if (send)
+                serverIt = servers.begin();
+
+            QueryData server;
+            string addr;
+            uint16_t port;
+            while (serversCount--)
+            {
+                if (send)
+                {
+                    addr = serverIt->first.ToString(false);
+                    port = serverIt->first.GetPort();
+                    server = serverIt->second;
+                }
+                packet->RW(addr, send);
+                packet->RW(port, send);
+
+                addServer(packet, server, send);
+
+                if (addr.empty())
+                    return false;
+
+                if (send)
+                    serverIt++;
+                else
+                    servers[RakNet::SystemAddress(addr.c_str(), port)] = server;
+            }
+            return true;
+        }
+
         template<class Packet>
         static void addServer(Packet *packet, QueryData &server, bool send)
         {
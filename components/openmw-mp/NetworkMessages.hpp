@@ -111,7 +111,9 @@ enum GameMessages
     ID_WORLD_TIME,
     ID_WORLD_WEATHER,
 
-    ID_PLAYER_ITEM_USE
+    ID_PLAYER_ITEM_USE,
+
+    ID_SCRIPT_STATE
 };
 
 enum OrderingChannel
@@ -59,6 +59,11 @@ uint32_t BasePacket::Send(RakNet::AddressOrGUID destination)
     return peer->Send(bsSend, priority, reliability, orderChannel, destination, false);
 }
 
+uint32_t BasePacket::SendSerialized(RakNet::BitStream *serialized, RakNet::AddressOrGUID destination)
+{
+    return peer->Send(serialized, priority, reliability, orderChannel, destination, false);
+}
+
 uint32_t BasePacket::Send(bool toOther)
 {
     bsSend->ResetWritePointer();
@@ -19,6 +19,7 @@ namespace mwmp
         virtual void Packet(RakNet::BitStream *bs, bool send);
         virtual uint32_t Send(bool toOtherPlayers = true);
         virtual uint32_t Send(RakNet::AddressOrGUID destination);
+        uint32_t SendSerialized(RakNet::BitStream *serialized, RakNet::AddressOrGUID destination);
         virtual void Read();
 
         void setGUID(RakNet::RakNetGUID guid);
@@ -0,0 +1,42 @@
+#include <components/openmw-mp/NetworkMessages.hpp>
+#include "PacketScriptState.hpp"
+
+using namespace mwmp;
+
+PacketScriptState::PacketScriptState(RakNet::RakPeerInterface *peer) : ObjectPacket(peer)
+{
+    packetID = ID_SCRIPT_STATE;
+    hasCellData = true;
+}
+
+void PacketScriptState::Object(BaseObject &baseObject, bool send)
+{
+    RW(baseObject.variableType, send);
+
+    switch (baseObject.variableType)
+    {
+        case BaseObjectList::LOCAL_SHORT:
+        case BaseObjectList::LOCAL_FLOAT:
+            ObjectPacket::Object(baseObject, send);
+            RW(baseObject.index, send);
+            break;
+        case BaseObjectList::MEMBER_SHORT:
+        case BaseObjectList::MEMBER_FLOAT:
+            RW(baseObject.refId, send);
+            RW(baseObject.index, send);
+            break;
+        case BaseObjectList::GLOBAL_SHORT:
+        case BaseObjectList::GLOBAL_FLOAT:
+            RW(baseObject.varName, send);
+            break;
+        default:
+            objectList->isValid = false;
+            return;
+    }
+
+    if (baseObject.variableType == BaseObjectList::LOCAL_FLOAT || baseObject.variableType == BaseObjectList::MEMBER_FLOAT ||
+        baseObject.variableType == BaseObjectList::GLOBAL_FLOAT)
+        RW(baseObject.floatVal, send);
+    else
+        RW(baseObject.shortVal, send);
+}
@@ -0,0 +1,18 @@
+#ifndef OPENMW_PACKETSCRIPTSTATE_HPP
+#define OPENMW_PACKETSCRIPTSTATE_HPP
+
+#include <components/openmw-mp/Packets/Object/ObjectPacket.hpp>
+
+namespace mwmp
+{
+    // Any mix of local, member and global script variables, with locals belonging to the packet's cell
+    class PacketScriptState : public ObjectPacket
+    {
+    public:
+        PacketScriptState(RakNet::RakPeerInterface *peer);
+
+        virtual void Object(BaseObject &obj, bool send);
+    };
+}
+
+#endif //OPENMW_PACKETSCRIPTSTATE_HPP
@@ -57,6 +57,9 @@ namespace Resource
     public:
         BulletShapeInstance(osg::ref_ptr<const BulletShape> source);
 
+        /// The shape this is an instance of, to make further instances from.
+        const BulletShape* getSource() const { return mSource.get(); }
+
     private:
         osg::ref_ptr<const BulletShape> mSource;
     };
@@ -13,6 +13,7 @@
 #include <components/nifbullet/bulletnifloader.hpp>
 
 #include "bulletshape.hpp"
+#include "compiledcache.hpp"
 #include "scenemanager.hpp"
 #include "niffilemanager.hpp"
 #include "objectcache.hpp"
@@ -99,6 +100,7 @@ BulletShapeManager::BulletShapeManager(const VFS::Manager* vfs, SceneManager* sc
     , mInstanceCache(new MultiObjectCache)
     , mSceneManager(sceneMgr)
     , mNifFileManager(nifFileManager)
+    , mCompiledCache(NULL)
 {
 
 }
@@ -108,6 +110,11 @@ BulletShapeManager::~BulletShapeManager()
 
 }
 
+void BulletShapeManager::setCompiledCache(CompiledCache* cache)
+{
+    mCompiledCache = cache;
+}
+
 osg::ref_ptr<const BulletShape> BulletShapeManager::getShape(const std::string &name)
 {
     std::string normalized = name;
@@ -126,8 +133,20 @@ osg::ref_ptr<const BulletShape> BulletShapeManager::getShape(const std::string &
 
         if (ext == "nif")
         {
-            NifBullet::BulletNifLoader loader;
-            shape = loader.load(mNifFileManager->get(normalized));
+            uint64_t key = 0;
+            if (mCompiledCache)
+            {
+                key = mCompiledCache->getKey(normalized);
+                shape = mCompiledCache->readShape(key);
+            }
+
+            if (!shape)
+            {
+                NifBullet::BulletNifLoader loader;
+                shape = loader.load(mNifFileManager->get(normalized));
+                if (mCompiledCache)
+                    mCompiledCache->writeShape(key, *shape);
+            }
         }
         else
         {
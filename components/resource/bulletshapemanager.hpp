@@ -13,6 +13,7 @@ namespace Resource
 {
     class SceneManager;
     class NifFileManager;
+    class CompiledCache;
 
     class BulletShape;
     class BulletShapeInstance;
@@ -28,6 +29,9 @@ namespace Resource
         BulletShapeManager(const VFS::Manager* vfs, SceneManager* sceneMgr, NifFileManager* nifFileManager);
         ~BulletShapeManager();
 
+        /// Keep shapes converted from NIF files in \a cache, and take them from there when loading. Does not transfer ownership.
+        void setCompiledCache(CompiledCache* cache);
+
         /// @note May return a null pointer if the object has no shape.
         osg::ref_ptr<const BulletShape> getShape(const std::string& name);
 
@@ -52,6 +56,7 @@ namespace Resource
         osg::ref_ptr<MultiObjectCache> mInstanceCache;
         SceneManager* mSceneManager;
         NifFileManager* mNifFileManager;
+        CompiledCache* mCompiledCache;
     };
 
 }
@@ -0,0 +1,701 @@
+#include "compiledcache.hpp"
+
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+
+#include <osg/Node>
+#include <osg/StateSet>
+#include <osg/Texture>
+#include <osg/UserDataContainer>
+
+#include <osgDB/ObjectWrapper>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+#include <osgDB/Registry>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btCompoundShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleCallback.h>
+#include <BulletCollision/CollisionShapes/btTriangleMesh.h>
+
+#include <components/files/mappedfilestream.hpp>
+#include <components/nifosg/nifloader.hpp>
+#include <components/nifosg/userdata.hpp>
+#include <components/vfs/manager.hpp>
+
+#include "bulletshape.hpp"
+
+namespace
+{
+    // Increase when the conversion of NIF files or the layout of the shape format changes
+    const uint32_t sFormatVersion = 1;
+
+    const uint64_t sHashBasis = 14695981039346656037ULL;
+
+    uint64_t hashData(uint64_t hash, const char* data, size_t size)
+    {
+        // FNV-1a over 64 bit words, plenty to notice a changed NIF file
+        const uint64_t prime = 1099511628211ULL;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(uint64_t));
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; ++i)
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+
+        return hash;
+    }
+
+    template <class T>
+    uint64_t hashValue(uint64_t hash, const T& value)
+    {
+        return hashData(hash, reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    std::string toHex(uint64_t value)
+    {
+        char buffer[17];
+        for (int i = 15; i >= 0; --i, value >>= 4)
+            buffer[i] = "0123456789abcdef"[value & 0xf];
+        buffer[16] = 0;
+        return buffer;
+    }
+
+    template <class Cls>
+    osg::Object* createInstanceFunc() { return new Cls; }
+
+    bool checkNodeUserData(const NifOsg::NodeUserData&)
+    {
+        return true;
+    }
+
+    bool readNodeUserData(osgDB::InputStream& is, NifOsg::NodeUserData& data)
+    {
+        is >> data.mIndex >> data.mScale;
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<3; ++j)
+                is >> data.mRotationScale.mValues[i][j];
+        return true;
+    }
+
+    bool writeNodeUserData(osgDB::OutputStream& os, const NifOsg::NodeUserData& data)
+    {
+        os << data.mIndex << data.mScale;
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<3; ++j)
+                os << data.mRotationScale.mValues[i][j];
+        os << std::endl;
+        return true;
+    }
+
+    /// NifOsg::NodeUserData is on nearly every node the NIF loader creates, so a model can not be cached without it.
+    class NodeUserDataSerializer : public osgDB::ObjectWrapper
+    {
+    public:
+        NodeUserDataSerializer()
+            : osgDB::ObjectWrapper(createInstanceFunc<NifOsg::NodeUserData>, "NifOsg::NodeUserData", "osg::Object NifOsg::NodeUserData")
+        {
+            addSerializer(new osgDB::UserSerializer<NifOsg::NodeUserData>("Data", &checkNodeUserData, &readNodeUserData, &writeNodeUserData),
+                          osgDB::BaseSerializer::RW_USER);
+        }
+    };
+
+    osgDB::ObjectWrapper* getNodeUserDataSerializer()
+    {
+        static osg::ref_ptr<osgDB::ObjectWrapper> serializer;
+        if (!serializer)
+        {
+            serializer = new NodeUserDataSerializer;
+            osgDB::Registry::instance()->getObjectWrapperManager()->addWrapper(serializer);
+        }
+        return serializer;
+    }
+
+    /// Checks that every object in a scene graph is one the osgb format stores completely: one from the core OSG library,
+    /// or the NIF loader's user data. Objects of other libraries may be missing a serializer, or have a stub one.
+    class CanWriteSceneVisitor : public osg::NodeVisitor
+    {
+    public:
+        CanWriteSceneVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCanWrite(true)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (!mCanWrite)
+                return;
+
+            if (!check(&node) || !check(node.getStateSet()) || !checkCallbacks(node.getUpdateCallback())
+                    || !checkCallbacks(node.getEventCallback()) || !checkCallbacks(node.getCullCallback())
+                    || !check(node.getComputeBoundingSphereCallback()))
+            {
+                mCanWrite = false;
+                return;
+            }
+
+            if (osg::Drawable* drawable = node.asDrawable())
+            {
+                if (!check(drawable->getDrawCallback()) || !check(drawable->getComputeBoundingBoxCallback()))
+                {
+                    mCanWrite = false;
+                    return;
+                }
+            }
+
+            traverse(node);
+        }
+
+        bool canWrite() const
+        {
+            return mCanWrite;
+        }
+
+    private:
+        bool check(const osg::Object* object)
+        {
+            if (!object)
+                return true;
+
+            if (strcmp(object->libraryName(), "osg") != 0
+                    && !(strcmp(object->libraryName(), "NifOsg") == 0 && strcmp(object->className(), "NodeUserData") == 0))
+                return false;
+
+            if (const osg::UserDataContainer* userData = object->getUserDataContainer())
+            {
+                if (!check(userData))
+                    return false;
+                if (const osg::Referenced* data = userData->getUserData())
+                {
+                    const osg::Object* userObject = dynamic_cast<const osg::Object*>(data);
+                    if (!userObject || !check(userObject))
+                        return false;
+                }
+                for (unsigned int i=0; i<userData->getNumUserObjects(); ++i)
+                {
+                    if (!check(userData->getUserObject(i)))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        bool check(const osg::StateSet* stateset)
+        {
+            if (!stateset)
+                return true;
+
+            if (!check(static_cast<const osg::Object*>(stateset)) || !check(stateset->getUpdateCallback())
+                    || !check(stateset->getEventCallback()))
+                return false;
+
+            const osg::StateSet::AttributeList& attributes = stateset->getAttributeList();
+            for (osg::StateSet::AttributeList::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+            {
+                if (!check(it->second.first.get()))
+                    return false;
+            }
+
+            const osg::StateSet::TextureAttributeList& textureAttributes = stateset->getTextureAttributeList();
+            for (unsigned int unit=0; unit<textureAttributes.size(); ++unit)
+            {
+                for (osg::StateSet::AttributeList::const_iterator it = textureAttributes[unit].begin(); it != textureAttributes[unit].end(); ++it)
+                {
+                    const osg::StateAttribute* attribute = it->second.first.get();
+                    if (!check(attribute))
+                        return false;
+
+                    // Images are stored by name and read from the VFS again, embedded ones would be lost
+                    if (const osg::Texture* texture = attribute->asTexture())
+                    {
+                        for (unsigned int i=0; i<texture->getNumImages(); ++i)
+                        {
+                            const osg::Image* image = texture->getImage(i);
+                            if (image && image->getFileName().empty())
+                                return false;
+                        }
+                    }
+                }
+            }
+
+            const osg::StateSet::UniformList& uniforms = stateset->getUniformList();
+            for (osg::StateSet::UniformList::const_iterator it = uniforms.begin(); it != uniforms.end(); ++it)
+            {
+                if (!check(it->second.first.get()))
+                    return false;
+            }
+            return true;
+        }
+
+        bool checkCallbacks(const osg::Callback* callback)
+        {
+            for (; callback; callback = callback->getNestedCallback())
+            {
+                if (!check(callback))
+                    return false;
+            }
+            return true;
+        }
+
+        bool mCanWrite;
+    };
+
+    enum ShapeType
+    {
+        Shape_None = 0,
+        Shape_Box = 1,
+        Shape_TriangleMesh = 2,
+        Shape_Compound = 3
+    };
+
+    /// Collects the triangles of a mesh the way BulletNifLoader added them, three vertices each.
+    struct TriangleCollector : public btInternalTriangleIndexCallback
+    {
+        std::vector<float>& mVertices;
+
+        TriangleCollector(std::vector<float>& vertices)
+            : mVertices(vertices)
+        {
+        }
+
+        virtual void internalProcessTriangleIndex(btVector3* triangle, int partId, int triangleIndex)
+        {
+            for (int i=0; i<3; ++i)
+            {
+                mVertices.push_back(triangle[i].x());
+                mVertices.push_back(triangle[i].y());
+                mVertices.push_back(triangle[i].z());
+            }
+        }
+    };
+
+    class ShapeWriter
+    {
+    public:
+        ShapeWriter(std::vector<char>& data)
+            : mData(data)
+        {
+        }
+
+        template <class T>
+        void write(const T& value)
+        {
+            write(&value, 1);
+        }
+
+        template <class T>
+        void write(const T* values, size_t count)
+        {
+            const char* bytes = reinterpret_cast<const char*>(values);
+            mData.insert(mData.end(), bytes, bytes + count * sizeof(T));
+        }
+
+        void writeVector(const btVector3& vector)
+        {
+            const float values[3] = { vector.x(), vector.y(), vector.z() };
+            write(values, 3);
+        }
+
+        bool writeShape(const btCollisionShape* shape)
+        {
+            if (!shape)
+            {
+                write<uint32_t>(Shape_None);
+                return true;
+            }
+
+            switch (shape->getShapeType())
+            {
+                case BOX_SHAPE_PROXYTYPE:
+                {
+                    write<uint32_t>(Shape_Box);
+                    writeVector(static_cast<const btBoxShape*>(shape)->getHalfExtentsWithMargin());
+                    return true;
+                }
+                case TRIANGLE_MESH_SHAPE_PROXYTYPE:
+                {
+                    const Resource::TriangleMeshShape* meshShape = dynamic_cast<const Resource::TriangleMeshShape*>(shape);
+                    const btTriangleMesh* mesh = meshShape ? dynamic_cast<const btTriangleMesh*>(meshShape->getMeshInterface()) : NULL;
+                    if (!mesh)
+                        return false;
+
+                    std::vector<float> vertices;
+                    TriangleCollector collector(vertices);
+                    btVector3 aabbMax(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+                    mesh->InternalProcessAllTriangles(&collector, -aabbMax, aabbMax);
+
+                    write<uint32_t>(Shape_TriangleMesh);
+                    write<uint32_t>(mesh->getUse32bitIndices());
+                    writeVector(meshShape->getLocalScaling());
+                    write<uint32_t>(vertices.size() / 9);
+                    if (!vertices.empty())
+                        write(&vertices[0], vertices.size());
+                    return true;
+                }
+                case COMPOUND_SHAPE_PROXYTYPE:
+                {
+                    const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+                    write<uint32_t>(Shape_Compound);
+                    write<uint32_t>(compound->getNumChildShapes());
+                    for (int i=0; i<compound->getNumChildShapes(); ++i)
+                    {
+                        const btTransform& transform = compound->getChildTransform(i);
+                        btQuaternion rotation = transform.getRotation();
+                        const float values[4] = { rotation.x(), rotation.y(), rotation.z(), rotation.w() };
+                        write(values, 4);
+                        writeVector(transform.getOrigin());
+                        if (!writeShape(compound->getChildShape(i)))
+                            return false;
+                    }
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+    private:
+        std::vector<char>& mData;
+    };
+
+    class ShapeReader
+    {
+    public:
+        ShapeReader(const char* data, size_t size)
+            : mData(data)
+            , mSize(size)
+            , mPosition(0)
+        {
+        }
+
+        template <class T>
+        T read()
+        {
+            T value;
+            read(&value, 1);
+            return value;
+        }
+
+        template <class T>
+        void read(T* values, size_t count)
+        {
+            size_t size = count * sizeof(T);
+            if (size > mSize - mPosition)
+                throw std::runtime_error("unexpected end of file");
+            memcpy(values, mData + mPosition, size);
+            mPosition += size;
+        }
+
+        btVector3 readVector()
+        {
+            float values[3];
+            read(values, 3);
+            return btVector3(values[0], values[1], values[2]);
+        }
+
+        btCollisionShape* readShape()
+        {
+            uint32_t type = read<uint32_t>();
+            switch (type)
+            {
+                case Shape_None:
+                    return NULL;
+                case Shape_Box:
+                    return new btBoxShape(readVector());
+                case Shape_TriangleMesh:
+                {
+                    bool use32bitIndices = read<uint32_t>() != 0;
+                    btVector3 scaling = readVector();
+                    uint32_t numTriangles = read<uint32_t>();
+                    if (numTriangles > (mSize - mPosition) / (9 * sizeof(float)))
+                        throw std::runtime_error("unexpected end of file");
+
+                    btTriangleMesh* mesh = new btTriangleMesh(use32bitIndices);
+                    mesh->preallocateVertices(numTriangles * 3);
+                    mesh->preallocateIndices(numTriangles * 3);
+                    for (uint32_t i=0; i<numTriangles; ++i)
+                    {
+                        btVector3 v1 = readVector();
+                        btVector3 v2 = readVector();
+                        btVector3 v3 = readVector();
+                        mesh->addTriangle(v1, v2, v3);
+                    }
+
+                    Resource::TriangleMeshShape* shape = new Resource::TriangleMeshShape(mesh, true);
+                    shape->setLocalScaling(scaling);
+                    return shape;
+                }
+                case Shape_Compound:
+                {
+                    // Deletes the children read so far if the file turns out to be damaged
+                    osg::ref_ptr<Resource::BulletShape> holder (new Resource::BulletShape);
+                    btCompoundShape* compound = new btCompoundShape;
+                    holder->mCollisionShape = compound;
+
+                    uint32_t numChildren = read<uint32_t>();
+                    for (uint32_t i=0; i<numChildren; ++i)
+                    {
+                        float rotation[4];
+                        read(rotation, 4);
+                        btVector3 origin = readVector();
+                        btTransform transform(btQuaternion(rotation[0], rotation[1], rotation[2], rotation[3]), origin);
+
+                        btCollisionShape* child = readShape();
+                        if (!child)
+                            throw std::runtime_error("empty child shape");
+                        compound->addChildShape(transform, child);
+                    }
+                    holder->mCollisionShape = NULL;
+                    return compound;
+                }
+                default:
+                    throw std::runtime_error("unknown shape type");
+            }
+        }
+
+    private:
+        const char* mData;
+        size_t mSize;
+        size_t mPosition;
+    };
+}
+
+namespace Resource
+{
+
+    CompiledCache::CompiledCache(const boost::filesystem::path& directory, const VFS::Manager* vfs)
+        : mDirectory(directory)
+        , mVFS(vfs)
+        , mReaderWriter(osgDB::Registry::instance()->getReaderWriterForExtension("osgb"))
+        , mTexturesHash(sHashBasis)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(mDirectory, ec);
+        if (ec)
+            std::cerr << "Failed to create " << mDirectory.string() << ": " << ec.message() << std::endl;
+
+        getNodeUserDataSerializer();
+
+        for (const auto& file : mVFS->getRecursiveDirectoryIterator("textures/"))
+            mTexturesHash = hashData(mTexturesHash, file.first.c_str(), file.first.size() + 1);
+    }
+
+    uint64_t CompiledCache::getKey(const std::string& normalizedName)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mKeysMutex);
+            std::map<std::string, uint64_t>::const_iterator found = mKeys.find(normalizedName);
+            if (found != mKeys.end())
+                return found->second;
+        }
+
+        uint64_t hash = hashValue(sHashBasis, sFormatVersion);
+        Files::IStreamPtr stream = mVFS->get(normalizedName);
+        std::vector<char> buffer(64*1024);
+        while (*stream)
+        {
+            stream->read(&buffer[0], buffer.size());
+            hash = hashData(hash, &buffer[0], static_cast<size_t>(stream->gcount()));
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mKeysMutex);
+        mKeys[normalizedName] = hash;
+        return hash;
+    }
+
+    osg::ref_ptr<osg::Node> CompiledCache::readScene(uint64_t key, const osgDB::Options* options)
+    {
+        if (!canUseScenes())
+            return NULL;
+
+        boost::filesystem::path path = getScenePath(key);
+        if (!boost::filesystem::exists(path))
+            return NULL;
+
+        try
+        {
+            Files::IStreamPtr stream = Files::openMappedFileStream(path.string().c_str());
+            osgDB::ReaderWriter::ReadResult result = mReaderWriter->readNode(*stream, options);
+            if (result.success())
+                return result.getNode();
+            std::cerr << "Failed to read compiled model " << path.string() << ": " << result.message() << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read compiled model " << path.string() << ": " << e.what() << std::endl;
+        }
+        return NULL;
+    }
+
+    bool CompiledCache::writeScene(uint64_t key, const osg::Node& node)
+    {
+        if (!canUseScenes() || !canWriteScene(node))
+            return false;
+
+        osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+        options->setPluginStringData("fileType", "Binary");
+        // Textures are read through the ImageManager again, like the NIF loader does
+        options->setOptionString("WriteImageHint=UseExternal");
+
+        std::ostringstream stream(std::ios::binary);
+        osgDB::ReaderWriter::WriteResult result = mReaderWriter->writeNode(node, stream, options);
+        if (!result.success())
+        {
+            std::cerr << "Failed to write compiled model: " << result.message() << std::endl;
+            return false;
+        }
+
+        const std::string& data = stream.str();
+        return writeFile(getScenePath(key), std::vector<char>(data.begin(), data.end()));
+    }
+
+    osg::ref_ptr<BulletShape> CompiledCache::readShape(uint64_t key)
+    {
+        boost::filesystem::path path = getShapePath(key);
+        if (!boost::filesystem::exists(path))
+            return NULL;
+
+        try
+        {
+            std::vector<char> buffer;
+            const char* data = NULL;
+            size_t size = 0;
+
+            Files::MappedFilePtr file = Files::openMappedFile(path.string().c_str());
+            if (file)
+            {
+                data = file->data();
+                size = file->size();
+            }
+            else
+            {
+                boost::filesystem::ifstream stream(path, std::ios::binary);
+                buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+                data = buffer.data();
+                size = buffer.size();
+            }
+
+            ShapeReader reader(data, size);
+            if (reader.read<uint32_t>() != sFormatVersion)
+                return NULL;
+
+            osg::ref_ptr<BulletShape> shape (new BulletShape);
+            shape->mCollisionBoxHalfExtents.x() = reader.read<float>();
+            shape->mCollisionBoxHalfExtents.y() = reader.read<float>();
+            shape->mCollisionBoxHalfExtents.z() = reader.read<float>();
+            shape->mCollisionBoxTranslate.x() = reader.read<float>();
+            shape->mCollisionBoxTranslate.y() = reader.read<float>();
+            shape->mCollisionBoxTranslate.z() = reader.read<float>();
+
+            uint32_t numAnimatedShapes = reader.read<uint32_t>();
+            for (uint32_t i=0; i<numAnimatedShapes; ++i)
+            {
+                int32_t recIndex = reader.read<int32_t>();
+                int32_t childIndex = reader.read<int32_t>();
+                shape->mAnimatedShapes[recIndex] = childIndex;
+            }
+
+            shape->mCollisionShape = reader.readShape();
+            return shape;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read compiled collision shape " << path.string() << ": " << e.what() << std::endl;
+        }
+        return NULL;
+    }
+
+    bool CompiledCache::writeShape(uint64_t key, const BulletShape& shape)
+    {
+        std::vector<char> data;
+        ShapeWriter writer(data);
+        writer.write(sFormatVersion);
+        writer.write(shape.mCollisionBoxHalfExtents.ptr(), 3);
+        writer.write(shape.mCollisionBoxTranslate.ptr(), 3);
+
+        writer.write<uint32_t>(shape.mAnimatedShapes.size());
+        for (std::map<int, int>::const_iterator it = shape.mAnimatedShapes.begin(); it != shape.mAnimatedShapes.end(); ++it)
+        {
+            writer.write<int32_t>(it->first);
+            writer.write<int32_t>(it->second);
+        }
+
+        if (!writer.writeShape(shape.mCollisionShape))
+            return false;
+
+        return writeFile(getShapePath(key), data);
+    }
+
+    bool CompiledCache::canWriteScene(const osg::Node& node)
+    {
+        CanWriteSceneVisitor visitor;
+        const_cast<osg::Node&>(node).accept(visitor); // no const version of NodeVisitor, the visitor does not modify anything
+        return visitor.canWrite();
+    }
+
+    bool CompiledCache::canUseScenes() const
+    {
+        if (!mReaderWriter)
+            return false;
+
+        // SceneUtil::writeScene() replaces some serializers with stubs for debug output, after which the cache could
+        // neither write complete models nor read them back
+        osgDB::ObjectWrapperManager* manager = osgDB::Registry::instance()->getObjectWrapperManager();
+        if (manager->findWrapper("NifOsg::NodeUserData") != getNodeUserDataSerializer())
+            return false;
+        osgDB::ObjectWrapper* geometry = manager->findWrapper("osg::Geometry");
+        return geometry && (geometry->getSerializer("VertexArray") || geometry->getSerializer("VertexData"));
+    }
+
+    boost::filesystem::path CompiledCache::getScenePath(uint64_t key) const
+    {
+        uint64_t hash = hashValue(key, mTexturesHash);
+        hash = hashValue(hash, NifOsg::Loader::getShowMarkers());
+        return mDirectory / (toHex(hash) + ".osgb");
+    }
+
+    boost::filesystem::path CompiledCache::getShapePath(uint64_t key) const
+    {
+        return mDirectory / (toHex(key) + ".shape");
+    }
+
+    bool CompiledCache::writeFile(const boost::filesystem::path& path, const std::vector<char>& data)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::path temp = path;
+        temp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+
+        {
+            boost::filesystem::ofstream stream(temp, std::ios::binary);
+            if (!data.empty())
+                stream.write(&data[0], data.size());
+            if (!stream)
+            {
+                std::cerr << "Failed to write " << temp.string() << std::endl;
+                boost::filesystem::remove(temp, ec);
+                return false;
+            }
+        }
+
+        // Another thread may have written the same entry in the meantime, either one is fine
+        boost::filesystem::rename(temp, path, ec);
+        if (ec)
+        {
+            boost::filesystem::remove(temp, ec);
+            return boost::filesystem::exists(path);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,94 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_COMPILEDCACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_COMPILEDCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <OpenThreads/Mutex>
+
+#include <osg/ref_ptr>
+
+#include <boost/filesystem/path.hpp>
+
+namespace osg
+{
+    class Node;
+}
+
+namespace osgDB
+{
+    class Options;
+    class ReaderWriter;
+}
+
+namespace VFS
+{
+    class Manager;
+}
+
+namespace Resource
+{
+
+    class BulletShape;
+
+    /// @brief Keeps models and collision shapes converted from NIF files on disk, so that loading them again
+    /// neither parses nor converts the NIF.
+    /// @par Entries are keyed by a hash of the NIF file contents, so a changed or replaced file is converted again.
+    /// Models are stored in the osgb format, but only if they consist of plain OSG objects. That covers static
+    /// meshes, while anything with controllers, particles or skinning is still converted on every load.
+    /// Collision shapes are stored in a flat binary format that is read straight from a memory mapping.
+    /// @note Thread safe.
+    class CompiledCache
+    {
+    public:
+        /// @param directory Created if it does not exist yet.
+        CompiledCache(const boost::filesystem::path& directory, const VFS::Manager* vfs);
+
+        /// Hash of the contents of the given file. Computed once per file and then remembered.
+        /// @note Throws if the file does not exist.
+        uint64_t getKey(const std::string& normalizedName);
+
+        /// @param options Must provide a ReadFileCallback for the textures the model refers to.
+        /// @return NULL if the model is not in the cache.
+        osg::ref_ptr<osg::Node> readScene(uint64_t key, const osgDB::Options* options);
+
+        /// Store the model, unless it contains objects the cache can not store.
+        /// @return whether the model was stored.
+        bool writeScene(uint64_t key, const osg::Node& node);
+
+        /// @return NULL if the shape is not in the cache.
+        osg::ref_ptr<BulletShape> readShape(uint64_t key);
+
+        /// Store the shape, unless it contains collision shapes that a NIF file would not produce.
+        /// @return whether the shape was stored.
+        bool writeShape(uint64_t key, const BulletShape& shape);
+
+        /// @return whether \a node consists of objects that writeScene() can store.
+        static bool canWriteScene(const osg::Node& node);
+
+    private:
+        bool canUseScenes() const;
+
+        boost::filesystem::path getScenePath(uint64_t key) const;
+        boost::filesystem::path getShapePath(uint64_t key) const;
+
+        /// Write through a temporary file, so that readers never see half of an entry.
+        bool writeFile(const boost::filesystem::path& path, const std::vector<char>& data);
+
+        boost::filesystem::path mDirectory;
+        const VFS::Manager* mVFS;
+
+        osgDB::ReaderWriter* mReaderWriter;
+
+        // Models also depend on which textures exist, since NIF texture paths are corrected against the VFS
+        uint64_t mTexturesHash;
+
+        OpenThreads::Mutex mKeysMutex;
+        std::map<std::string, uint64_t> mKeys;
+    };
+
+}
+
+#endif
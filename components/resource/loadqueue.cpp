@@ -0,0 +1,287 @@
+#include "loadqueue.hpp"
+
+#include <algorithm>
+
+#include <osg/Image>
+#include <osg/Node>
+
+#include <components/sceneutil/workqueue.hpp>
+#include <components/vfs/manager.hpp>
+
+#include "resourcesystem.hpp"
+#include "scenemanager.hpp"
+#include "imagemanager.hpp"
+#include "keyframemanager.hpp"
+
+namespace
+{
+
+    /// Each request adds one of these to the WorkQueue. It loads whichever request is most important
+    /// by the time a worker thread gets to it, not necessarily the one it was added for.
+    class LoadWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        LoadWorkItem(Resource::LoadQueue* loadQueue)
+            : mLoadQueue(loadQueue)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mLoadQueue->loadNext();
+        }
+
+    private:
+        osg::ref_ptr<Resource::LoadQueue> mLoadQueue;
+    };
+
+    SceneUtil::WorkItem::Priority getWorkItemPriority(Resource::LoadPriority priority)
+    {
+        switch (priority)
+        {
+            case Resource::Priority_Visible:
+                return SceneUtil::WorkItem::Priority_High;
+            case Resource::Priority_Preload:
+                return SceneUtil::WorkItem::Priority_Normal;
+            default:
+                return SceneUtil::WorkItem::Priority_Low;
+        }
+    }
+
+}
+
+namespace Resource
+{
+
+    LoadRequest::LoadRequest(const std::string& key, const LoadFunction& load, LoadPriority priority)
+        : mKey(key)
+        , mLoad(load)
+        , mPriority(priority)
+        , mState(State_Pending)
+        , mQueued(true)
+        , mNumRequesters(1)
+    {
+    }
+
+    bool LoadRequest::isDone() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mState == State_Done;
+    }
+
+    void LoadRequest::wait()
+    {
+        run();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        while (mState != State_Done)
+            mCondition.wait(&mMutex);
+    }
+
+    void LoadRequest::abort()
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            if (mNumRequesters > 0 && --mNumRequesters > 0)
+                return;
+            if (mState != State_Pending)
+                return;
+            mState = State_Done;
+            mLoad = LoadFunction();
+        }
+        mCondition.broadcast();
+    }
+
+    osg::ref_ptr<const osg::Object> LoadRequest::getObject() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mObject;
+    }
+
+    const std::string& LoadRequest::getError() const
+    {
+        return mError;
+    }
+
+    const std::string& LoadRequest::getKey() const
+    {
+        return mKey;
+    }
+
+    LoadPriority LoadRequest::getPriority() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mPriority;
+    }
+
+    void LoadRequest::run()
+    {
+        LoadFunction load;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            if (mState != State_Pending)
+                return;
+            mState = State_Loading;
+            load.swap(mLoad);
+        }
+
+        osg::ref_ptr<const osg::Object> object;
+        std::string error;
+        try
+        {
+            object = load();
+        }
+        catch (std::exception& e)
+        {
+            error = e.what();
+        }
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mObject = object;
+            mError = error;
+            mState = State_Done;
+        }
+        mCondition.broadcast();
+    }
+
+    LoadQueue::LoadQueue(ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue)
+        : mResourceSystem(resourceSystem)
+        , mWorkQueue(workQueue)
+    {
+    }
+
+    osg::ref_ptr<LoadRequest> LoadQueue::request(const std::string& key, const LoadRequest::LoadFunction& load, LoadPriority priority)
+    {
+        osg::ref_ptr<LoadRequest> request;
+        bool addWorkItem = true;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+            std::map<std::string, osg::ref_ptr<LoadRequest> >::iterator found = key.empty() ? mRequests.end() : mRequests.find(key);
+            if (found != mRequests.end())
+            {
+                request = found->second;
+
+                OpenThreads::ScopedLock<OpenThreads::Mutex> requestLock(request->mMutex);
+                if (request->mState != LoadRequest::State_Done)
+                    ++request->mNumRequesters;
+
+                // A worker thread may have taken it off the queue already without having started it yet
+                if (request->mState == LoadRequest::State_Pending && request->mQueued && priority < request->mPriority)
+                {
+                    std::deque<osg::ref_ptr<LoadRequest> >& pending = mPending[request->mPriority];
+                    pending.erase(std::find(pending.begin(), pending.end(), request));
+                    mPending[priority].push_back(request);
+                    request->mPriority = priority;
+
+                    // The work item added for it may be far back in a lower lane of the WorkQueue, so add another one
+                    addWorkItem = (priority == Priority_Visible);
+                }
+                else if (request->mState != LoadRequest::State_Done || request->mObject)
+                    return request;
+                else
+                    request = NULL; // aborted or failed, try again
+            }
+
+            if (!request)
+            {
+                request = new LoadRequest(key, load, priority);
+                mPending[priority].push_back(request);
+                if (!key.empty())
+                    mRequests[key] = request;
+            }
+        }
+
+        if (addWorkItem)
+            mWorkQueue->addWorkItem(new LoadWorkItem(this), getWorkItemPriority(priority));
+
+        return request;
+    }
+
+    osg::ref_ptr<LoadRequest> LoadQueue::requestTemplate(const std::string& name, LoadPriority priority)
+    {
+        std::string normalized = name;
+        mResourceSystem->getVFS()->normalizeFilename(normalized);
+
+        SceneManager* sceneManager = mResourceSystem->getSceneManager();
+        return request("template:" + normalized, [sceneManager, normalized] () -> osg::ref_ptr<const osg::Object>
+        {
+            return sceneManager->getTemplate(normalized);
+        }, priority);
+    }
+
+    osg::ref_ptr<LoadRequest> LoadQueue::requestInstance(const std::string& name, LoadPriority priority)
+    {
+        SceneManager* sceneManager = mResourceSystem->getSceneManager();
+        return request(std::string(), [sceneManager, name] () -> osg::ref_ptr<const osg::Object>
+        {
+            return sceneManager->cacheInstance(name);
+        }, priority);
+    }
+
+    osg::ref_ptr<LoadRequest> LoadQueue::requestImage(const std::string& name, LoadPriority priority)
+    {
+        std::string normalized = name;
+        mResourceSystem->getVFS()->normalizeFilename(normalized);
+
+        ImageManager* imageManager = mResourceSystem->getImageManager();
+        return request("image:" + normalized, [imageManager, normalized] () -> osg::ref_ptr<const osg::Object>
+        {
+            return imageManager->getImage(normalized);
+        }, priority);
+    }
+
+    osg::ref_ptr<LoadRequest> LoadQueue::requestKeyframes(const std::string& name, LoadPriority priority)
+    {
+        std::string normalized = name;
+        mResourceSystem->getVFS()->normalizeFilename(normalized);
+
+        KeyframeManager* keyframeManager = mResourceSystem->getKeyframeManager();
+        return request("keyframes:" + normalized, [keyframeManager, normalized] () -> osg::ref_ptr<const osg::Object>
+        {
+            return keyframeManager->get(normalized);
+        }, priority);
+    }
+
+    unsigned int LoadQueue::getNumPending() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        unsigned int count = 0;
+        for (int i = 0; i < Priority_Count; ++i)
+            count += mPending[i].size();
+        return count;
+    }
+
+    void LoadQueue::loadNext()
+    {
+        osg::ref_ptr<LoadRequest> request;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            for (int i = 0; i < Priority_Count && !request; ++i)
+            {
+                if (!mPending[i].empty())
+                {
+                    request = mPending[i].front();
+                    mPending[i].pop_front();
+                    request->mQueued = false;
+                }
+            }
+        }
+
+        if (!request)
+            return;
+
+        // Does nothing if a waiting thread got to it first, or it was aborted
+        request->run();
+
+        if (!request->getKey().empty())
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            std::map<std::string, osg::ref_ptr<LoadRequest> >::iterator found = mRequests.find(request->getKey());
+            if (found != mRequests.end() && found->second == request)
+                mRequests.erase(found);
+        }
+    }
+
+}
@@ -0,0 +1,145 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_LOADQUEUE_H
+#define OPENMW_COMPONENTS_RESOURCE_LOADQUEUE_H
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Object;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace Resource
+{
+
+    class ResourceSystem;
+
+    /// Order in which queued requests are loaded. Lower values are loaded first.
+    enum LoadPriority
+    {
+        Priority_Visible = 0,       ///< Needed for the current frame, e.g. the objects of a cell being loaded
+        Priority_Preload = 1,       ///< Likely needed soon, e.g. the objects of neighbouring cells
+        Priority_Speculative = 2,   ///< May be needed, e.g. the effects of spells the player knows
+
+        Priority_Count = 3
+    };
+
+    /// @brief A resource requested from a LoadQueue. Works as a future for the loaded object.
+    /// @note Thread safe.
+    class LoadRequest : public osg::Referenced
+    {
+    public:
+        typedef std::function<osg::ref_ptr<const osg::Object> ()> LoadFunction;
+
+        LoadRequest(const std::string& key, const LoadFunction& load, LoadPriority priority);
+
+        bool isDone() const;
+
+        /// Wait until the resource is loaded. If no worker thread has started on it yet,
+        /// it is loaded on the calling thread instead, so waiting never queues behind other requests.
+        void wait();
+
+        /// Cancel the request unless it is already being loaded. A request that was merged with others
+        /// is only cancelled once every requester aborted it.
+        void abort();
+
+        /// The loaded object, or NULL if loading failed or was aborted.
+        /// @note Only valid once isDone() returns true.
+        osg::ref_ptr<const osg::Object> getObject() const;
+
+        /// Description of the error if loading failed.
+        /// @note Only valid once isDone() returns true.
+        const std::string& getError() const;
+
+        const std::string& getKey() const;
+
+        LoadPriority getPriority() const;
+
+        /// Load the resource unless it is already loading, loaded or aborted.
+        /// @par Used internally by the LoadQueue.
+        void run();
+
+    private:
+        friend class LoadQueue;
+
+        enum State
+        {
+            State_Pending,
+            State_Loading,
+            State_Done
+        };
+
+        std::string mKey;
+        LoadFunction mLoad;
+        LoadPriority mPriority;
+
+        State mState;
+        bool mQueued; // Still in a pending queue of the LoadQueue, guarded by the mutex of the LoadQueue
+        unsigned int mNumRequesters;
+        osg::ref_ptr<const osg::Object> mObject;
+        std::string mError;
+
+        mutable OpenThreads::Mutex mMutex;
+        OpenThreads::Condition mCondition;
+    };
+
+    /// @brief Loads resources on the threads of a WorkQueue, most important requests first.
+    /// @par Requests for the same resource that are still pending or loading are merged into one, which
+    /// is raised to the highest priority asked for.
+    /// @note Thread safe.
+    class LoadQueue : public osg::Referenced
+    {
+    public:
+        /// @note The work queue must outlive any calls to the request methods.
+        LoadQueue(ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue);
+
+        /// Request a load through \a load. Requests with the same non-empty \a key are merged.
+        osg::ref_ptr<LoadRequest> request(const std::string& key, const LoadRequest::LoadFunction& load, LoadPriority priority);
+
+        /// @see SceneManager::getTemplate
+        osg::ref_ptr<LoadRequest> requestTemplate(const std::string& name, LoadPriority priority);
+
+        /// @see SceneManager::cacheInstance
+        /// @note Not merged, every request caches one more instance.
+        osg::ref_ptr<LoadRequest> requestInstance(const std::string& name, LoadPriority priority);
+
+        /// @see ImageManager::getImage
+        osg::ref_ptr<LoadRequest> requestImage(const std::string& name, LoadPriority priority);
+
+        /// @see KeyframeManager::get
+        osg::ref_ptr<LoadRequest> requestKeyframes(const std::string& name, LoadPriority priority);
+
+        unsigned int getNumPending() const;
+
+        /// Load the most important pending request, if any.
+        /// @par Used internally by the work items this queue adds to the WorkQueue.
+        void loadNext();
+
+    private:
+        ResourceSystem* mResourceSystem;
+        SceneUtil::WorkQueue* mWorkQueue;
+
+        std::deque<osg::ref_ptr<LoadRequest> > mPending[Priority_Count];
+
+        /// Requests by key, until a worker thread has taken them off their pending queue and loaded them
+        std::map<std::string, osg::ref_ptr<LoadRequest> > mRequests;
+
+        mutable OpenThreads::Mutex mMutex;
+    };
+
+}
+
+#endif
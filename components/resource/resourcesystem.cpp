@@ -6,6 +6,7 @@
 #include "imagemanager.hpp"
 #include "niffilemanager.hpp"
 #include "keyframemanager.hpp"
+#include "compiledcache.hpp"
 
 namespace Resource
 {
@@ -52,6 +53,17 @@ namespace Resource
         return mKeyframeManager.get();
     }
 
+    void ResourceSystem::setCompiledCache(CompiledCache* cache)
+    {
+        mSceneManager->setCompiledCache(cache);
+        mCompiledCache.reset(cache);
+    }
+
+    CompiledCache* ResourceSystem::getCompiledCache()
+    {
+        return mCompiledCache.get();
+    }
+
     void ResourceSystem::setExpiryDelay(double expiryDelay)
     {
         for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
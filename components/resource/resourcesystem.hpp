@@ -23,6 +23,7 @@ namespace Resource
     class NifFileManager;
     class KeyframeManager;
     class ResourceManager;
+    class CompiledCache;
 
     /// @brief Wrapper class that constructs and provides access to the most commonly used resource subsystems.
     /// @par Resource subsystems can be used with multiple OpenGL contexts, just like the OSG equivalents, but
@@ -38,6 +39,12 @@ namespace Resource
         NifFileManager* getNifFileManager();
         KeyframeManager* getKeyframeManager();
 
+        /// Keep converted NIF models in \a cache between runs, see CompiledCache. Takes ownership.
+        void setCompiledCache(CompiledCache* cache);
+
+        /// @note May return a null pointer if no compiled cache is used.
+        CompiledCache* getCompiledCache();
+
         /// Indicates to each resource manager to clear the cache, i.e. to drop cached objects that are no longer referenced.
         /// @note May be called from any thread if you do not add or remove resource managers at that point.
         void updateCache(double referenceTime);
@@ -69,6 +76,7 @@ namespace Resource
         std::unique_ptr<ImageManager> mImageManager;
         std::unique_ptr<NifFileManager> mNifFileManager;
         std::unique_ptr<KeyframeManager> mKeyframeManager;
+        std::unique_ptr<CompiledCache> mCompiledCache;
 
         // Store the base classes separately to get convenient access to the common interface
         // Here users can register their own resourcemanager as well
@@ -28,6 +28,7 @@
 #include <components/shader/shadervisitor.hpp>
 #include <components/shader/shadermanager.hpp>
 
+#include "compiledcache.hpp"
 #include "imagemanager.hpp"
 #include "niffilemanager.hpp"
 #include "objectcache.hpp"
@@ -224,6 +225,7 @@ namespace Resource
         , mSharedStateManager(new SharedStateManager)
         , mImageManager(imageManager)
         , mNifFileManager(nifFileManager)
+        , mCompiledCache(NULL)
         , mMinFilter(osg::Texture::LINEAR_MIPMAP_LINEAR)
         , mMagFilter(osg::Texture::LINEAR)
         , mMaxAnisotropy(1)
@@ -350,11 +352,34 @@ namespace Resource
         return std::string();
     }
 
-    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::ImageManager* imageManager, Resource::NifFileManager* nifFileManager)
+    osg::ref_ptr<osgDB::Options> createReadOptions(Resource::ImageManager* imageManager)
+    {
+        osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+        // Set a ReadFileCallback so that image files referenced in the model are read from our virtual file system instead of the osgDB.
+        // Note, for some formats (.obj/.mtl) that reference other (non-image) files a findFileCallback would be necessary.
+        // but findFileCallback does not support virtual files, so we can't implement it.
+        options->setReadFileCallback(new ImageReadCallback(imageManager));
+        return options;
+    }
+
+    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::ImageManager* imageManager, Resource::NifFileManager* nifFileManager,
+                                  Resource::CompiledCache* compiledCache)
     {
         std::string ext = getFileExtension(normalizedFilename);
         if (ext == "nif")
-            return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+        {
+            if (!compiledCache)
+                return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+
+            uint64_t key = compiledCache->getKey(normalizedFilename);
+            osg::ref_ptr<osg::Node> loaded = compiledCache->readScene(key, createReadOptions(imageManager));
+            if (!loaded)
+            {
+                loaded = NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+                compiledCache->writeScene(key, *loaded);
+            }
+            return loaded;
+        }
         else
         {
             osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
@@ -365,11 +390,7 @@ namespace Resource
                 throw std::runtime_error(errormsg.str());
             }
 
-            osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
-            // Set a ReadFileCallback so that image files referenced in the model are read from our virtual file system instead of the osgDB.
-            // Note, for some formats (.obj/.mtl) that reference other (non-image) files a findFileCallback would be necessary.
-            // but findFileCallback does not support virtual files, so we can't implement it.
-            options->setReadFileCallback(new ImageReadCallback(imageManager));
+            osg::ref_ptr<osgDB::Options> options = createReadOptions(imageManager);
 
             osgDB::ReaderWriter::ReadResult result = reader->readNode(*file, options);
             if (!result.success())
@@ -490,7 +511,7 @@ namespace Resource
             {
                 Files::IStreamPtr file = mVFS->get(normalized);
 
-                loaded = load(file, normalized, mImageManager, mNifFileManager);
+                loaded = load(file, normalized, mImageManager, mNifFileManager, mCompiledCache);
             }
             catch (std::exception& e)
             {
@@ -503,7 +524,7 @@ namespace Resource
                     {
                         std::cerr << "Failed to load '" << name << "': " << e.what() << ", using marker_error." << sMeshTypes[i] << " instead" << std::endl;
                         Files::IStreamPtr file = mVFS->get(normalized);
-                        loaded = load(file, normalized, mImageManager, mNifFileManager);
+                        loaded = load(file, normalized, mImageManager, mNifFileManager, mCompiledCache);
                         break;
                     }
                 }
@@ -644,6 +665,11 @@ namespace Resource
         return mImageManager;
     }
 
+    void SceneManager::setCompiledCache(Resource::CompiledCache* cache)
+    {
+        mCompiledCache = cache;
+    }
+
     void SceneManager::setParticleSystemMask(unsigned int mask)
     {
         mParticleSystemMask = mask;
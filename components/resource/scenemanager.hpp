@@ -16,6 +16,7 @@ namespace Resource
     class ImageManager;
     class NifFileManager;
     class SharedStateManager;
+    class CompiledCache;
 }
 
 namespace osgUtil
@@ -126,6 +127,9 @@ namespace Resource
 
         Resource::ImageManager* getImageManager();
 
+        /// Keep converted NIF models in \a cache, and take them from there when loading. Does not transfer ownership.
+        void setCompiledCache(Resource::CompiledCache* cache);
+
         /// @param mask The node mask to apply to loaded particle system nodes.
         void setParticleSystemMask(unsigned int mask);
 
@@ -169,6 +173,7 @@ namespace Resource
 
         Resource::ImageManager* mImageManager;
         Resource::NifFileManager* mNifFileManager;
+        Resource::CompiledCache* mCompiledCache;
 
         osg::Texture::FilterMode mMinFilter;
         osg::Texture::FilterMode mMagFilter;
@@ -269,7 +269,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase *viewer)
         _resourceStatsChildNum = _switch->getNumChildren();
         _switch->addChild(group, false);
 
-        const char* statNames[] = {"Compiling", "WorkQueue", "WorkThread", "", "Texture", "StateSet", "Node", "Node Instance", "Shape", "Shape Instance", "Image", "Nif", "Keyframe", "", "Terrain Chunk", "Terrain Texture", "Land", "Composite", "", "UnrefQueue"};
+        const char* statNames[] = {"Compiling", "WorkQueue", "WorkThread", "", "Texture", "StateSet", "Node", "Node Instance", "Shape", "Shape Instance", "Image", "Nif", "Keyframe", "", "Terrain Chunk", "Terrain Texture", "Land", "Composite", "", "UnrefQueue", "", "LOS Query", "LOS Hit %", "LOS Ray", "", "AI Actor", "AI Decision", "AI ms", "AI Overrun ms", "AI Overrun", "", "Stream Object", "Stream Cell", "Stream ms", "Stream Pending", "", "Preload Cells", "Preload Hit %", "Preload Late %", "Cell Load ms"};
 
         int numLines = sizeof(statNames) / sizeof(statNames[0]);
 
@@ -0,0 +1,41 @@
+#include "commandbuffer.hpp"
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace SceneUtil
+{
+
+    void CommandBuffer::push(const Command& command)
+    {
+        mCommands.push_back(command);
+    }
+
+    void CommandBuffer::commit()
+    {
+        for (std::vector<Command>::const_iterator it = mCommands.begin(); it != mCommands.end(); ++it)
+            (*it)();
+        mCommands.clear();
+    }
+
+    bool CommandBuffer::empty() const
+    {
+        return mCommands.empty();
+    }
+
+    void runJobs(WorkQueue* workQueue, unsigned int count, const std::function<void (unsigned int, CommandBuffer&)>& job)
+    {
+        std::vector<CommandBuffer> commands(count);
+
+        if (workQueue)
+            workQueue->parallelFor(count, [&] (unsigned int index) { job(index, commands[index]); });
+        else
+        {
+            for (unsigned int i = 0; i < count; ++i)
+                job(i, commands[i]);
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+            commands[i].commit();
+    }
+
+}
@@ -0,0 +1,37 @@
+#ifndef OPENMW_COMPONENTS_COMMANDBUFFER_H
+#define OPENMW_COMPONENTS_COMMANDBUFFER_H
+
+#include <functional>
+#include <vector>
+
+namespace SceneUtil
+{
+    class WorkQueue;
+
+    /// @brief Records what a job on a worker thread has to leave to the main thread, such as playing a sound or
+    /// changing anything but the object the job is about, so that it runs later in a known order.
+    class CommandBuffer
+    {
+    public:
+        typedef std::function<void ()> Command;
+
+        void push(const Command& command);
+
+        /// Run the commands in the order they were pushed, then forget them. Call from the main thread.
+        void commit();
+
+        bool empty() const;
+
+    private:
+        std::vector<Command> mCommands;
+    };
+
+    /// Call \a job for every index in [0, count), in parallel on \a workQueue unless it is NULL, then commit the
+    /// commands that every call pushed, in the order of the indices.
+    /// @par The outcome is the same for any number of threads, including none, as long as every call only touches
+    /// what belongs to its index and pushes everything else to its CommandBuffer.
+    void runJobs(WorkQueue* workQueue, unsigned int count, const std::function<void (unsigned int, CommandBuffer&)>& job);
+
+}
+
+#endif
@@ -5,11 +5,100 @@
 #include <cstdlib>
 
 #include "skeleton.hpp"
+#include "skinning.hpp"
 #include "util.hpp"
+#include "workqueue.hpp"
+
+namespace
+{
+    osg::ref_ptr<SceneUtil::WorkQueue> sWorkQueue;
+}
 
 namespace SceneUtil
 {
 
+/// Skins one frame of a RigGeometry into one of its internal geometries, from matrices taken on the cull thread.
+class SkinningWorkItem : public WorkItem
+{
+public:
+    SkinningWorkItem(const Skinning* skinning, osg::Vec3Array* positions, osg::Vec3Array* normals, osg::Vec4Array* tangents)
+        : mSkinning(skinning)
+        , mPositions(positions)
+        , mNormals(normals)
+        , mTangents(tangents)
+        , mHasGeomToSkelMatrix(false)
+    {
+    }
+
+    virtual void doWork()
+    {
+        if (claim())
+            skin();
+    }
+
+    /// Skin on the calling thread, unless a worker thread has already started, in which case wait for it.
+    void finish()
+    {
+        if (claim())
+        {
+            skin();
+            signalDone();
+        }
+        else
+            waitTillDone();
+    }
+
+    std::vector<osg::Matrixf> mBoneMatrices;
+    osg::Matrixf mGeomToSkelMatrix;
+    bool mHasGeomToSkelMatrix;
+
+private:
+    bool claim()
+    {
+        return ++mClaims == 1;
+    }
+
+    void skin()
+    {
+        if (mBoneMatrices.empty())
+            return;
+        mSkinning->skin(&mBoneMatrices[0], mHasGeomToSkelMatrix ? &mGeomToSkelMatrix : NULL, &mPositions->front(),
+                        mNormals ? &mNormals->front() : NULL, mTangents ? &mTangents->front() : NULL);
+    }
+
+    osg::ref_ptr<const Skinning> mSkinning;
+    osg::ref_ptr<osg::Vec3Array> mPositions;
+    osg::ref_ptr<osg::Vec3Array> mNormals;
+    osg::ref_ptr<osg::Vec4Array> mTangents;
+
+    OpenThreads::Atomic mClaims;
+};
+
+/// Set on an internal geometry of a RigGeometry, finishes the skinning of the frame it holds before drawing it.
+class FinishSkinningCallback : public osg::Drawable::DrawCallback
+{
+public:
+    void setPending(SkinningWorkItem* item)
+    {
+        mPending = item;
+    }
+
+    void finish() const
+    {
+        if (mPending)
+            mPending->finish();
+    }
+
+    virtual void drawImplementation(osg::RenderInfo& renderInfo, const osg::Drawable* drawable) const
+    {
+        finish();
+        drawable->drawImplementation(renderInfo);
+    }
+
+private:
+    osg::ref_ptr<SkinningWorkItem> mPending;
+};
+
 RigGeometry::RigGeometry()
     : mSkeleton(NULL)
     , mLastFrameNumber(0)
@@ -29,6 +118,15 @@ RigGeometry::RigGeometry(const RigGeometry &copy, const osg::CopyOp &copyop)
     setSourceGeometry(copy.mSourceGeometry);
 }
 
+RigGeometry::~RigGeometry()
+{
+}
+
+void RigGeometry::setWorkQueue(WorkQueue* workQueue)
+{
+    sWorkQueue = workQueue;
+}
+
 void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
 {
     mSourceGeometry = sourceGeometry;
@@ -73,6 +171,12 @@ void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
         }
         else
             mSourceTangents = NULL;
+
+        // Worker threads write to the vertices while the cull thread goes on, so compute the bounds now rather than then
+        to.getBoundingBox();
+
+        mFinishSkinning[i] = new FinishSkinningCallback;
+        to.setDrawCallback(mFinishSkinning[i]);
     }
 }
 
@@ -106,7 +210,7 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
         return false;
     }
 
-    typedef std::map<unsigned short, std::vector<BoneWeight> > Vertex2BoneMap;
+    typedef std::map<unsigned short, Skinning::BoneWeights> Vertex2BoneMap;
     Vertex2BoneMap vertex2BoneMap;
     for (std::map<std::string, BoneInfluence>::const_iterator it = mInfluenceMap->mMap.begin(); it != mInfluenceMap->mMap.end(); ++it)
     {
@@ -119,47 +223,34 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
 
         mBoneSphereMap[bone] = it->second.mBoundSphere;
 
-        const BoneInfluence& bi = it->second;
+        const unsigned int boneIndex = mBones.size();
+        mBones.push_back(bone);
+        mInvBindMatrices.push_back(it->second.mInvBindMatrix);
 
         const std::map<unsigned short, float>& weights = it->second.mWeights;
         for (std::map<unsigned short, float>::const_iterator weightIt = weights.begin(); weightIt != weights.end(); ++weightIt)
-        {
-            std::vector<BoneWeight>& vec = vertex2BoneMap[weightIt->first];
-
-            BoneWeight b = std::make_pair(std::make_pair(bone, bi.mInvBindMatrix), weightIt->second);
-
-            vec.push_back(b);
-        }
+            vertex2BoneMap[weightIt->first].push_back(std::make_pair(boneIndex, weightIt->second));
     }
 
+    // Vertices with the same weights share their matrix
+    typedef std::map<Skinning::BoneWeights, std::vector<unsigned short> > Bone2VertexMap;
+    Bone2VertexMap bone2VertexMap;
     for (Vertex2BoneMap::iterator it = vertex2BoneMap.begin(); it != vertex2BoneMap.end(); ++it)
     {
-        mBone2VertexMap[it->second].push_back(it->first);
+        bone2VertexMap[it->second].push_back(it->first);
     }
 
-    return true;
-}
+    const osg::Vec3Array* positions = static_cast<const osg::Vec3Array*>(mSourceGeometry->getVertexArray());
+    const osg::Vec3Array* normals = static_cast<const osg::Vec3Array*>(mSourceGeometry->getNormalArray());
+    const osg::Vec4Array* tangents = mSourceTangents;
+    mSkinning = new Skinning(normals != NULL, tangents != NULL);
+    for (Bone2VertexMap::const_iterator it = bone2VertexMap.begin(); it != bone2VertexMap.end(); ++it)
+    {
+        mSkinning->addRun(it->first, it->second, &positions->front(), normals ? &normals->front() : NULL,
+                          tangents ? &tangents->front() : NULL);
+    }
 
-void accumulateMatrix(const osg::Matrixf& invBindMatrix, const osg::Matrixf& matrix, float weight, osg::Matrixf& result)
-{
-    osg::Matrixf m = invBindMatrix * matrix;
-    float* ptr = m.ptr();
-    float* ptrresult = result.ptr();
-    ptrresult[0] += ptr[0] * weight;
-    ptrresult[1] += ptr[1] * weight;
-    ptrresult[2] += ptr[2] * weight;
-
-    ptrresult[4] += ptr[4] * weight;
-    ptrresult[5] += ptr[5] * weight;
-    ptrresult[6] += ptr[6] * weight;
-
-    ptrresult[8] += ptr[8] * weight;
-    ptrresult[9] += ptr[9] * weight;
-    ptrresult[10] += ptr[10] * weight;
-
-    ptrresult[12] += ptr[12] * weight;
-    ptrresult[13] += ptr[13] * weight;
-    ptrresult[14] += ptr[14] * weight;
+    return true;
 }
 
 void RigGeometry::cull(osg::NodeVisitor* nv)
@@ -186,44 +277,40 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
     mSkeleton->updateBoneMatrices(nv->getTraversalNumber());
 
     // skinning
-    const osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
-    const osg::Vec3Array* normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
-    const osg::Vec4Array* tangentSrc = mSourceTangents;
-
     osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
     osg::Vec3Array* normalDst = static_cast<osg::Vec3Array*>(geom.getNormalArray());
     osg::Vec4Array* tangentDst = static_cast<osg::Vec4Array*>(geom.getTexCoordArray(7));
 
-    for (Bone2VertexMap::const_iterator it = mBone2VertexMap.begin(); it != mBone2VertexMap.end(); ++it)
-    {
-        osg::Matrixf resultMat  (0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 1);
+    // The frame this geometry held before must be done before it is written again
+    FinishSkinningCallback& finishSkinning = *mFinishSkinning[mLastFrameNumber%2];
+    finishSkinning.finish();
 
-        for (std::vector<BoneWeight>::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
+    if (sWorkQueue)
+    {
+        // Bones move on in the next frame while worker threads are still skinning this one, so take their matrices now
+        osg::ref_ptr<SkinningWorkItem> item (new SkinningWorkItem(mSkinning, positionDst, normalDst, tangentDst));
+        getBoneMatrices(item->mBoneMatrices);
+        if (mGeomToSkelMatrix)
         {
-            Bone* bone = weightIt->first.first;
-            const osg::Matrix& invBindMatrix = weightIt->first.second;
-            float weight = weightIt->second;
-            const osg::Matrixf& boneMatrix = bone->mMatrixInSkeletonSpace;
-            accumulateMatrix(invBindMatrix, boneMatrix, weight, resultMat);
+            item->mGeomToSkelMatrix = *mGeomToSkelMatrix;
+            item->mHasGeomToSkelMatrix = true;
         }
-        if (mGeomToSkelMatrix)
-            resultMat *= (*mGeomToSkelMatrix);
 
-        for (std::vector<unsigned short>::const_iterator vertexIt = it->second.begin(); vertexIt != it->second.end(); ++vertexIt)
+        finishSkinning.setPending(item);
+        sWorkQueue->addWorkItem(item, WorkItem::Priority_High);
+    }
+    else
+    {
+        finishSkinning.setPending(NULL);
+
+        getBoneMatrices(mBoneMatrices);
+        if (!mBoneMatrices.empty())
         {
-            unsigned short vertex = *vertexIt;
-            (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
-            if (normalDst)
-                (*normalDst)[vertex] = osg::Matrix::transform3x3((*normalSrc)[vertex], resultMat);
-            if (tangentDst)
-            {
-                osg::Vec4f srcTangent = (*tangentSrc)[vertex];
-                osg::Vec3f transformedTangent = osg::Matrix::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
-                (*tangentDst)[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
-            }
+            osg::Matrixf geomToSkelMatrix;
+            if (mGeomToSkelMatrix)
+                geomToSkelMatrix = *mGeomToSkelMatrix;
+            mSkinning->skin(&mBoneMatrices[0], mGeomToSkelMatrix ? &geomToSkelMatrix : NULL, &positionDst->front(),
+                            normalDst ? &normalDst->front() : NULL, tangentDst ? &tangentDst->front() : NULL);
         }
     }
 
@@ -238,6 +325,13 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
     nv->popFromNodePath();
 }
 
+void RigGeometry::getBoneMatrices(std::vector<osg::Matrixf>& matrices) const
+{
+    matrices.resize(mBones.size());
+    for (unsigned int i = 0; i < mBones.size(); ++i)
+        matrices[i] = mInvBindMatrices[i] * mBones[i]->mMatrixInSkeletonSpace;
+}
+
 void RigGeometry::updateBounds(osg::NodeVisitor *nv)
 {
     if (!mSkeleton)
@@ -326,6 +420,8 @@ void RigGeometry::accept(osg::NodeVisitor &nv)
 
 void RigGeometry::accept(osg::PrimitiveFunctor& func) const
 {
+    if (mFinishSkinning[mLastFrameNumber%2])
+        mFinishSkinning[mLastFrameNumber%2]->finish();
     getGeometry(mLastFrameNumber)->accept(func);
 }
 
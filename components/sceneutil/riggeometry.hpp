@@ -9,17 +9,27 @@ namespace SceneUtil
 
     class Skeleton;
     class Bone;
+    class Skinning;
+    class FinishSkinningCallback;
+    class WorkQueue;
 
     /// @brief Mesh skinning implementation.
     /// @note A RigGeometry may be attached directly to a Skeleton, or somewhere below a Skeleton.
     /// Note though that the RigGeometry ignores any transforms below the Skeleton, so the attachment point is not that important.
     /// @note The internal Geometry used for rendering is double buffered, this allows updates to be done in a thread safe way while
     /// not compromising rendering performance. This is crucial when using osg's default threading model of DrawThreadPerContext.
+    /// @note Skinning is done by a SceneUtil::Skinning, on the cull thread or, see setWorkQueue, on worker threads.
     class RigGeometry : public osg::Drawable
     {
     public:
         RigGeometry();
         RigGeometry(const RigGeometry& copy, const osg::CopyOp& copyop);
+        ~RigGeometry();
+
+        /// Skin the vertices of every RigGeometry on the threads of \a workQueue, while the cull thread goes on
+        /// through the scene. Each is finished before it is drawn or intersected with.
+        /// @param workQueue NULL to skin on the cull thread, the default.
+        static void setWorkQueue(WorkQueue* workQueue);
 
         META_Object(SceneUtil, RigGeometry)
 
@@ -66,15 +76,17 @@ namespace SceneUtil
 
         osg::ref_ptr<InfluenceMap> mInfluenceMap;
 
-        typedef std::pair<Bone*, osg::Matrixf> BoneBindMatrixPair;
-
-        typedef std::pair<BoneBindMatrixPair, float> BoneWeight;
+        // The bones of the influence map that were found in the skeleton, with their inverse bind matrices
+        std::vector<Bone*> mBones;
+        std::vector<osg::Matrixf> mInvBindMatrices;
 
-        typedef std::vector<unsigned short> VertexList;
+        osg::ref_ptr<Skinning> mSkinning;
 
-        typedef std::map<std::vector<BoneWeight>, VertexList> Bone2VertexMap;
+        // Reused to skin on the cull thread, when there are no worker threads
+        std::vector<osg::Matrixf> mBoneMatrices;
 
-        Bone2VertexMap mBone2VertexMap;
+        // Set on each of mGeometry, to finish the skinning of a frame before it is drawn
+        osg::ref_ptr<FinishSkinningCallback> mFinishSkinning[2];
 
         typedef std::map<Bone*, osg::BoundingSpheref> BoneSphereMap;
 
@@ -86,6 +98,8 @@ namespace SceneUtil
         bool initFromParentSkeleton(osg::NodeVisitor* nv);
 
         void updateGeomToSkelMatrix(const osg::NodePath& nodePath);
+
+        void getBoneMatrices(std::vector<osg::Matrixf>& matrices) const;
     };
 
 }
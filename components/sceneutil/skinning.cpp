@@ -0,0 +1,290 @@
+#include "skinning.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OPENMW_SKINNING_AVX
+#define OPENMW_SKINNING_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OPENMW_SKINNING_SSE
+#endif
+
+namespace
+{
+    /// The rows of an affine matrix, a vertex v becomes v.x * row 0 + v.y * row 1 + v.z * row 2 + row 3.
+    /// The fourth column is only kept to load the rows as a whole.
+    struct Matrix
+    {
+        float mRows[4][4];
+    };
+
+    struct ScalarLanes
+    {
+        typedef float Type;
+        static const unsigned int sSize = 1;
+
+        static Type set(float value) { return value; }
+        static Type load(const float* values) { return *values; }
+        static Type add(Type left, Type right) { return left + right; }
+        static Type mul(Type left, Type right) { return left * right; }
+
+        static void scatter(Type x, Type y, Type z, const unsigned short* indices, float* dst, unsigned int stride)
+        {
+            float* vertex = dst + indices[0] * stride;
+            vertex[0] = x;
+            vertex[1] = y;
+            vertex[2] = z;
+        }
+    };
+
+#ifdef OPENMW_SKINNING_SSE
+    struct SseLanes
+    {
+        typedef __m128 Type;
+        static const unsigned int sSize = 4;
+
+        static Type set(float value) { return _mm_set1_ps(value); }
+        static Type load(const float* values) { return _mm_loadu_ps(values); }
+        static Type add(Type left, Type right) { return _mm_add_ps(left, right); }
+        static Type mul(Type left, Type right) { return _mm_mul_ps(left, right); }
+
+        static void scatter(Type x, Type y, Type z, const unsigned short* indices, float* dst, unsigned int stride)
+        {
+            // Turn the lanes into one vertex each, and write the three floats of each without touching its neighbours
+            Type w = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            const Type vertices[4] = { x, y, z, w };
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                float* vertex = dst + indices[lane] * stride;
+                _mm_storel_pi(reinterpret_cast<__m64*>(vertex), vertices[lane]);
+                _mm_store_ss(vertex + 2, _mm_movehl_ps(vertices[lane], vertices[lane]));
+            }
+        }
+    };
+#endif
+
+#ifdef OPENMW_SKINNING_AVX
+    struct AvxLanes
+    {
+        typedef __m256 Type;
+        static const unsigned int sSize = 8;
+
+        static Type set(float value) { return _mm256_set1_ps(value); }
+        static Type load(const float* values) { return _mm256_loadu_ps(values); }
+        static Type add(Type left, Type right) { return _mm256_add_ps(left, right); }
+        static Type mul(Type left, Type right) { return _mm256_mul_ps(left, right); }
+
+        static void scatter(Type x, Type y, Type z, const unsigned short* indices, float* dst, unsigned int stride)
+        {
+            SseLanes::scatter(_mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z),
+                              indices, dst, stride);
+            SseLanes::scatter(_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1),
+                              indices + 4, dst, stride);
+        }
+    };
+#endif
+
+    /// Transform the vertices \a begin up to \a end of the source arrays by \a matrix, as many at a time as \a Lanes
+    /// holds, and scatter them to \a dst.
+    /// @return Where the vertices that are too few to fill the lanes start.
+    template <class Lanes>
+    unsigned int transform(const Matrix& matrix, bool translate, const float* x, const float* y, const float* z,
+                           const unsigned short* indices, unsigned int begin, unsigned int end, float* dst, unsigned int stride)
+    {
+        typedef typename Lanes::Type Type;
+
+        if (begin + Lanes::sSize > end)
+            return begin;
+
+        Type m[4][3];
+        for (int row = 0; row < 4; ++row)
+            for (int column = 0; column < 3; ++column)
+                m[row][column] = Lanes::set(matrix.mRows[row][column]);
+
+        for (; begin + Lanes::sSize <= end; begin += Lanes::sSize)
+        {
+            const Type vx = Lanes::load(x + begin);
+            const Type vy = Lanes::load(y + begin);
+            const Type vz = Lanes::load(z + begin);
+            Type result[3];
+            for (int column = 0; column < 3; ++column)
+            {
+                // Same order of operations as osg::Matrixf::preMult
+                result[column] = Lanes::add(Lanes::add(Lanes::mul(m[0][column], vx), Lanes::mul(m[1][column], vy)),
+                                            Lanes::mul(m[2][column], vz));
+                if (translate)
+                    result[column] = Lanes::add(result[column], m[3][column]);
+            }
+            Lanes::scatter(result[0], result[1], result[2], indices + begin, dst, stride);
+        }
+        return begin;
+    }
+
+    unsigned int transform(const Matrix& matrix, bool translate, const float* x, const float* y, const float* z,
+                           const unsigned short* indices, unsigned int begin, unsigned int end, float* dst, unsigned int stride)
+    {
+#ifdef OPENMW_SKINNING_AVX
+        begin = transform<AvxLanes>(matrix, translate, x, y, z, indices, begin, end, dst, stride);
+#endif
+#ifdef OPENMW_SKINNING_SSE
+        begin = transform<SseLanes>(matrix, translate, x, y, z, indices, begin, end, dst, stride);
+#endif
+        return transform<ScalarLanes>(matrix, translate, x, y, z, indices, begin, end, dst, stride);
+    }
+
+    /// Sum the weighted bone matrices as the rows of an affine matrix, then apply \a geomToSkelMatrix.
+    void accumulate(const unsigned int* bones, const float* weights, unsigned int numWeights, const osg::Matrixf* boneMatrices,
+                    const osg::Matrixf* geomToSkelMatrix, Matrix& result)
+    {
+#ifdef OPENMW_SKINNING_SSE
+        __m128 rows[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+        for (unsigned int i = 0; i < numWeights; ++i)
+        {
+            const __m128 weight = _mm_set1_ps(weights[i]);
+            const float* bone = boneMatrices[bones[i]].ptr();
+            for (int row = 0; row < 4; ++row)
+                rows[row] = _mm_add_ps(rows[row], _mm_mul_ps(_mm_loadu_ps(bone + row * 4), weight));
+        }
+        for (int row = 0; row < 4; ++row)
+            _mm_storeu_ps(result.mRows[row], rows[row]);
+#else
+        for (int row = 0; row < 4; ++row)
+            for (int column = 0; column < 4; ++column)
+                result.mRows[row][column] = 0.f;
+        for (unsigned int i = 0; i < numWeights; ++i)
+        {
+            const float* bone = boneMatrices[bones[i]].ptr();
+            for (int row = 0; row < 4; ++row)
+                for (int column = 0; column < 4; ++column)
+                    result.mRows[row][column] += bone[row * 4 + column] * weights[i];
+        }
+#endif
+
+        // The weights need not add up to 1, so the fourth column is set rather than summed
+        result.mRows[0][3] = result.mRows[1][3] = result.mRows[2][3] = 0.f;
+        result.mRows[3][3] = 1.f;
+
+        if (!geomToSkelMatrix)
+            return;
+
+        const float* other = geomToSkelMatrix->ptr();
+#ifdef OPENMW_SKINNING_SSE
+        const __m128 otherRows[4] = { _mm_loadu_ps(other), _mm_loadu_ps(other + 4), _mm_loadu_ps(other + 8), _mm_loadu_ps(other + 12) };
+        for (int row = 0; row < 4; ++row)
+        {
+            // Same order of operations as osg::Matrixf::postMult
+            const float* left = result.mRows[row];
+            const __m128 product = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(left[0]), otherRows[0]), _mm_mul_ps(_mm_set1_ps(left[1]), otherRows[1])),
+                    _mm_mul_ps(_mm_set1_ps(left[2]), otherRows[2])), _mm_mul_ps(_mm_set1_ps(left[3]), otherRows[3]));
+            _mm_storeu_ps(result.mRows[row], product);
+        }
+#else
+        for (int row = 0; row < 4; ++row)
+        {
+            float product[4];
+            for (int column = 0; column < 4; ++column)
+                product[column] = result.mRows[row][0] * other[column] + result.mRows[row][1] * other[4 + column]
+                        + result.mRows[row][2] * other[8 + column] + result.mRows[row][3] * other[12 + column];
+            for (int column = 0; column < 4; ++column)
+                result.mRows[row][column] = product[column];
+        }
+#endif
+    }
+}
+
+namespace SceneUtil
+{
+
+    Skinning::Skinning(bool hasNormals, bool hasTangents)
+        : mHasNormals(hasNormals)
+        , mHasTangents(hasTangents)
+    {
+    }
+
+    void Skinning::addRun(const BoneWeights& weights, const std::vector<unsigned short>& vertices,
+                          const osg::Vec3f* positions, const osg::Vec3f* normals, const osg::Vec4f* tangents)
+    {
+        Run run;
+        run.mFirstWeight = mBones.size();
+        run.mNumWeights = weights.size();
+        run.mFirstVertex = mIndices.size();
+        run.mNumVertices = vertices.size();
+        mRuns.push_back(run);
+
+        for (BoneWeights::const_iterator it = weights.begin(); it != weights.end(); ++it)
+        {
+            mBones.push_back(it->first);
+            mWeights.push_back(it->second);
+        }
+
+        for (std::vector<unsigned short>::const_iterator it = vertices.begin(); it != vertices.end(); ++it)
+        {
+            mIndices.push_back(*it);
+            mPositionX.push_back(positions[*it].x());
+            mPositionY.push_back(positions[*it].y());
+            mPositionZ.push_back(positions[*it].z());
+            if (mHasNormals)
+            {
+                mNormalX.push_back(normals[*it].x());
+                mNormalY.push_back(normals[*it].y());
+                mNormalZ.push_back(normals[*it].z());
+            }
+            if (mHasTangents)
+            {
+                mTangentX.push_back(tangents[*it].x());
+                mTangentY.push_back(tangents[*it].y());
+                mTangentZ.push_back(tangents[*it].z());
+            }
+        }
+    }
+
+    void Skinning::skin(const osg::Matrixf* boneMatrices, const osg::Matrixf* geomToSkelMatrix,
+                        osg::Vec3f* positions, osg::Vec3f* normals, osg::Vec4f* tangents) const
+    {
+        if (mRuns.empty())
+            return;
+
+        const unsigned short* indices = &mIndices[0];
+        Matrix matrix;
+        for (std::vector<Run>::const_iterator run = mRuns.begin(); run != mRuns.end(); ++run)
+        {
+            if (run->mNumVertices == 0)
+                continue;
+
+            accumulate(&mBones[run->mFirstWeight], &mWeights[run->mFirstWeight], run->mNumWeights, boneMatrices,
+                       geomToSkelMatrix, matrix);
+
+            const unsigned int begin = run->mFirstVertex;
+            const unsigned int end = begin + run->mNumVertices;
+            transform(matrix, true, &mPositionX[0], &mPositionY[0], &mPositionZ[0], indices, begin, end, positions->ptr(), 3);
+            if (mHasNormals && normals)
+                transform(matrix, false, &mNormalX[0], &mNormalY[0], &mNormalZ[0], indices, begin, end, normals->ptr(), 3);
+            if (mHasTangents && tangents)
+                transform(matrix, false, &mTangentX[0], &mTangentY[0], &mTangentZ[0], indices, begin, end, tangents->ptr(), 4);
+        }
+    }
+
+    unsigned int Skinning::getNumRuns() const
+    {
+        return mRuns.size();
+    }
+
+    unsigned int Skinning::getNumVertices() const
+    {
+        return mIndices.size();
+    }
+
+    const char* Skinning::getInstructionSet()
+    {
+#if defined(OPENMW_SKINNING_AVX)
+        return "AVX";
+#elif defined(OPENMW_SKINNING_SSE)
+        return "SSE";
+#else
+        return "scalar";
+#endif
+    }
+
+}
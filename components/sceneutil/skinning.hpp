@@ -0,0 +1,81 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_SKINNING_H
+#define OPENMW_COMPONENTS_SCENEUTIL_SKINNING_H
+
+#include <utility>
+#include <vector>
+
+#include <osg/Matrixf>
+#include <osg/Referenced>
+#include <osg/Vec3f>
+#include <osg/Vec4f>
+
+namespace SceneUtil
+{
+
+    /// @brief The source vertices of a RigGeometry, sorted into runs of vertices that share their bone weights.
+    /// @par Positions, normals and tangents are kept in structure-of-arrays layout, so that a run is transformed by its
+    /// matrix several vertices at a time with SSE or AVX, whichever the build targets, and vertex by vertex otherwise.
+    /// The results are the same as those of osg::Matrixf::preMult and osg::Matrix::transform3x3, up to rounding.
+    /// @note Immutable once built, so that skin() may be called from several threads at once.
+    class Skinning : public osg::Referenced
+    {
+    public:
+        /// <bone index, weight>
+        typedef std::vector<std::pair<unsigned int, float> > BoneWeights;
+
+        /// @param hasNormals Whether to skin normals as well as positions.
+        /// @param hasTangents Whether to skin tangents as well as positions.
+        Skinning(bool hasNormals, bool hasTangents);
+
+        /// Add a run of \a vertices that all have the given bone weights.
+        /// @param normals May be NULL if normals are not skinned.
+        /// @param tangents May be NULL if tangents are not skinned.
+        void addRun(const BoneWeights& weights, const std::vector<unsigned short>& vertices,
+                    const osg::Vec3f* positions, const osg::Vec3f* normals, const osg::Vec4f* tangents);
+
+        /// Skin every run into the destination arrays, which are indexed like the source arrays.
+        /// @param boneMatrices For each bone index, its inverse bind matrix times its current matrix.
+        /// @param geomToSkelMatrix Applied after the bones, may be NULL.
+        /// @note The w of the destination tangents is left alone.
+        void skin(const osg::Matrixf* boneMatrices, const osg::Matrixf* geomToSkelMatrix,
+                  osg::Vec3f* positions, osg::Vec3f* normals, osg::Vec4f* tangents) const;
+
+        unsigned int getNumRuns() const;
+        unsigned int getNumVertices() const;
+
+        /// "AVX", "SSE" or "scalar", depending on what the build targets.
+        static const char* getInstructionSet();
+
+    private:
+        struct Run
+        {
+            unsigned int mFirstWeight;
+            unsigned int mNumWeights;
+            unsigned int mFirstVertex;
+            unsigned int mNumVertices;
+        };
+
+        bool mHasNormals;
+        bool mHasTangents;
+
+        std::vector<Run> mRuns;
+        std::vector<unsigned int> mBones;
+        std::vector<float> mWeights;
+
+        // The index in the source and destination arrays of each vertex, in run order
+        std::vector<unsigned short> mIndices;
+
+        std::vector<float> mPositionX;
+        std::vector<float> mPositionY;
+        std::vector<float> mPositionZ;
+        std::vector<float> mNormalX;
+        std::vector<float> mNormalY;
+        std::vector<float> mNormalZ;
+        std::vector<float> mTangentX;
+        std::vector<float> mTangentY;
+        std::vector<float> mTangentZ;
+    };
+
+}
+
+#endif
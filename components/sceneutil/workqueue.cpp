@@ -1,6 +1,91 @@
 #include "workqueue.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+    /// State shared by the calling thread and the work items of one WorkQueue::parallelFor().
+    class ParallelFor : public osg::Referenced
+    {
+    public:
+        ParallelFor(unsigned int count, const std::function<void (unsigned int)>& function)
+            : mCount(count)
+            , mFunction(&function)
+        {
+        }
+
+        /// Call the function for indices that nobody has taken yet, until there are none left.
+        void run()
+        {
+            while (true)
+            {
+                // The function may be gone once all indices are taken, so only call it for one we got
+                unsigned int index = (++mNext) - 1;
+                if (index >= mCount)
+                    return;
+
+                try
+                {
+                    (*mFunction)(index);
+                }
+                catch (std::exception& e)
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+                    if (mError.empty())
+                        mError = e.what();
+                }
+
+                if (++mFinished == mCount)
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+                    mCondition.broadcast();
+                }
+            }
+        }
+
+        void wait()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            while (mFinished != mCount)
+                mCondition.wait(&mMutex);
+
+            if (!mError.empty())
+                throw std::runtime_error(mError);
+        }
+
+    private:
+        unsigned int mCount;
+        const std::function<void (unsigned int)>* mFunction;
+        OpenThreads::Atomic mNext;
+        OpenThreads::Atomic mFinished;
+
+        OpenThreads::Mutex mMutex;
+        OpenThreads::Condition mCondition;
+        std::string mError;
+    };
+
+    class ParallelForWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        ParallelForWorkItem(ParallelFor* parallelFor)
+            : mParallelFor(parallelFor)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mParallelFor->run();
+        }
+
+    private:
+        osg::ref_ptr<ParallelFor> mParallelFor;
+    };
+
+}
 
 namespace SceneUtil
 {
@@ -26,6 +111,17 @@ void WorkItem::signalDone()
     mCondition.broadcast();
 }
 
+void WorkItem::cancel()
+{
+    mCancelled.exchange(1);
+    abort();
+}
+
+bool WorkItem::isCancelled() const
+{
+    return (mCancelled > 0);
+}
+
 WorkItem::WorkItem()
 {
 }
@@ -40,11 +136,14 @@ bool WorkItem::isDone() const
 }
 
 WorkQueue::WorkQueue(int workerThreads)
-    : mIsReleased(false)
 {
+    // Even without threads, items must have somewhere to go
+    for (int i=0; i<std::max(workerThreads, 1); ++i)
+        mLanes.push_back(new Lanes);
+
     for (int i=0; i<workerThreads; ++i)
     {
-        WorkThread* thread = new WorkThread(this);
+        WorkThread* thread = new WorkThread(this, i);
         mThreads.push_back(thread);
         thread->startThread();
     }
@@ -53,10 +152,8 @@ WorkQueue::WorkQueue(int workerThreads)
 WorkQueue::~WorkQueue()
 {
     {
-        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-        while (!mQueue.empty())
-            mQueue.pop_back();
-        mIsReleased = true;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSleepMutex);
+        mIsReleased.exchange(1);
         mCondition.broadcast();
     }
 
@@ -65,9 +162,12 @@ WorkQueue::~WorkQueue()
         mThreads[i]->join();
         delete mThreads[i];
     }
+
+    for (unsigned int i=0; i<mLanes.size(); ++i)
+        delete mLanes[i];
 }
 
-void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, bool front)
+void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, WorkItem::Priority priority)
 {
     if (item->isDone())
     {
@@ -75,35 +175,139 @@ void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, bool front)
         return;
     }
 
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    if (front)
-        mQueue.push_front(item);
-    else
-        mQueue.push_back(item);
-    mCondition.signal();
+    // Spread the items over the threads, so that adding them rarely waits for a thread that is taking one
+    Lanes& lanes = *mLanes[(++mNextLanes) % mLanes.size()];
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(lanes.mMutex);
+        lanes.mItems[priority].push_back(item);
+        ++lanes.mNumItems[priority];
+        ++mNumItems;
+    }
+
+    // The counter is raised before looking for sleeping threads, and a thread goes to sleep only after
+    // checking the counter, so either the thread sees the item or we see the thread
+    if (mNumSleeping > 0)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSleepMutex);
+        mCondition.signal();
+    }
 }
 
-osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem()
+void WorkQueue::addWorkItemAfter(osg::ref_ptr<WorkItem> item, WorkItem* prerequisite, WorkItem::Priority priority)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    while (mQueue.empty() && !mIsReleased)
     {
-        mCondition.wait(&mMutex);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(prerequisite->mMutex);
+        if (prerequisite->mDone == 0)
+        {
+            WorkItem::Dependent dependent;
+            dependent.mQueue = this;
+            dependent.mItem = item;
+            dependent.mPriority = priority;
+            prerequisite->mDependents.push_back(dependent);
+            return;
+        }
     }
-    if (!mQueue.empty())
+
+    if (prerequisite->isCancelled())
+        item->cancel();
+    addWorkItem(item, priority);
+}
+
+osg::ref_ptr<WorkItem> WorkQueue::takeWorkItem(unsigned int thread)
+{
+    // Most important lane first, across all threads. Within a lane, the thread's own items
+    // from the front, other threads' items from the back, where their owners are least likely to be.
+    for (int priority=0; priority<WorkItem::Priority_Count; ++priority)
     {
-        osg::ref_ptr<WorkItem> item = mQueue.front();
-        mQueue.pop_front();
-        return item;
+        for (unsigned int i=0; i<mLanes.size(); ++i)
+        {
+            Lanes& lanes = *mLanes[(thread + i) % mLanes.size()];
+            if (lanes.mNumItems[priority] == 0)
+                continue;
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(lanes.mMutex);
+            std::deque<osg::ref_ptr<WorkItem> >& items = lanes.mItems[priority];
+            if (items.empty())
+                continue;
+
+            osg::ref_ptr<WorkItem> item;
+            if (i == 0)
+            {
+                item = items.front();
+                items.pop_front();
+            }
+            else
+            {
+                item = items.back();
+                items.pop_back();
+            }
+            --lanes.mNumItems[priority];
+            --mNumItems;
+            return item;
+        }
     }
-    else
-        return NULL;
+    return NULL;
+}
+
+osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem(unsigned int thread)
+{
+    while (mIsReleased == 0)
+    {
+        osg::ref_ptr<WorkItem> item = takeWorkItem(thread);
+        if (item)
+            return item;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSleepMutex);
+        ++mNumSleeping;
+        while (mNumItems == 0 && mIsReleased == 0)
+            mCondition.wait(&mSleepMutex);
+        --mNumSleeping;
+    }
+    return NULL;
+}
+
+void WorkQueue::completeWorkItem(WorkItem *item)
+{
+    item->signalDone();
+
+    std::vector<WorkItem::Dependent> dependents;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(item->mMutex);
+        dependents.swap(item->mDependents);
+    }
+
+    for (std::vector<WorkItem::Dependent>::iterator it = dependents.begin(); it != dependents.end(); ++it)
+    {
+        if (item->isCancelled())
+            it->mItem->cancel();
+        it->mQueue->addWorkItem(it->mItem, it->mPriority);
+    }
+}
+
+void WorkQueue::parallelFor(unsigned int count, const std::function<void (unsigned int)>& function, WorkItem::Priority priority)
+{
+    if (count == 0)
+        return;
+
+    osg::ref_ptr<ParallelFor> parallelFor = new ParallelFor(count, function);
+
+    // Items that a thread only gets to after the calling thread took the last index return right away
+    unsigned int numItems = std::min<unsigned int>(mThreads.size(), count - 1);
+    for (unsigned int i=0; i<numItems; ++i)
+        addWorkItem(new ParallelForWorkItem(parallelFor), priority);
+
+    parallelFor->run();
+    parallelFor->wait();
 }
 
 unsigned int WorkQueue::getNumItems() const
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    return mQueue.size();
+    return mNumItems;
+}
+
+unsigned int WorkQueue::getNumThreads() const
+{
+    return mThreads.size();
 }
 
 unsigned int WorkQueue::getNumActiveThreads() const
@@ -117,8 +321,9 @@ unsigned int WorkQueue::getNumActiveThreads() const
     return count;
 }
 
-WorkThread::WorkThread(WorkQueue *workQueue)
+WorkThread::WorkThread(WorkQueue *workQueue, unsigned int index)
     : mWorkQueue(workQueue)
+    , mIndex(index)
     , mActive(false)
 {
 }
@@ -127,12 +332,13 @@ void WorkThread::run()
 {
     while (true)
     {
-        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem();
+        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem(mIndex);
         if (!item)
             return;
         mActive = true;
-        item->doWork();
-        item->signalDone();
+        if (!item->isCancelled())
+            item->doWork();
+        mWorkQueue->completeWorkItem(item);
         mActive = false;
     }
 }
@@ -9,14 +9,28 @@
 #include <osg/Referenced>
 #include <osg/ref_ptr>
 
-#include <queue>
+#include <deque>
+#include <functional>
+#include <vector>
 
 namespace SceneUtil
 {
 
+    class WorkQueue;
+
     class WorkItem : public osg::Referenced
     {
     public:
+        /// The lanes of a WorkQueue. Worker threads take items from the highest priority lane that has any.
+        enum Priority
+        {
+            Priority_High = 0,      ///< Short items that others wait for, e.g. freeing memory or updating caches
+            Priority_Normal = 1,
+            Priority_Low = 2,       ///< Items nobody waits for yet, e.g. speculative preloading
+
+            Priority_Count = 3
+        };
+
         WorkItem();
         virtual ~WorkItem();
 
@@ -34,16 +48,40 @@ namespace SceneUtil
         /// Set abort flag in order to return from doWork() as soon as possible. May not be respected by all WorkItems.
         virtual void abort() {}
 
+        /// Cancel this item: abort() it, and if no worker thread has started on it yet, complete it without calling doWork().
+        /// Items that were added to run after this one are cancelled as well.
+        /// @note May be called from any thread.
+        void cancel();
+
+        bool isCancelled() const;
+
     protected:
         OpenThreads::Atomic mDone;
         OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
+
+    private:
+        friend class WorkQueue;
+
+        struct Dependent
+        {
+            WorkQueue* mQueue;
+            osg::ref_ptr<WorkItem> mItem;
+            Priority mPriority;
+        };
+
+        OpenThreads::Atomic mCancelled;
+
+        // Items to add to their queues once this one is done, protected by mMutex
+        std::vector<Dependent> mDependents;
     };
 
     class WorkThread;
 
     /// @brief A work queue that users can push work items onto, to be completed by one or more background threads.
-    /// @note Work items will be processed in the order that they were given in, however
+    /// @par Each worker thread has its own lanes of items, so adding and taking items rarely waits for a lock.
+    /// Items are spread over the threads as they are added, and a thread that runs out of items steals from the others.
+    /// @note Work items of the same priority will be started roughly in the order that they were given in, however
     /// if multiple work threads are involved then it is possible for a later item to complete before earlier items.
     class WorkQueue : public osg::Referenced
     {
@@ -51,26 +89,57 @@ namespace SceneUtil
         WorkQueue(int numWorkerThreads=1);
         ~WorkQueue();
 
-        /// Add a new work item to the back of the queue.
+        /// Add a new work item to the back of the lane for its priority.
         /// @par The work item's waitTillDone() method may be used by the caller to wait until the work is complete.
-        /// @param front If true, add item to the front of the queue. If false (default), add to the back.
-        void addWorkItem(osg::ref_ptr<WorkItem> item, bool front=false);
+        void addWorkItem(osg::ref_ptr<WorkItem> item, WorkItem::Priority priority=WorkItem::Priority_Normal);
+
+        /// Add a new work item once \a prerequisite is done. If the prerequisite gets cancelled, so does \a item.
+        /// @note The prerequisite may be in any WorkQueue, or in none yet. This queue must outlive it.
+        void addWorkItemAfter(osg::ref_ptr<WorkItem> item, WorkItem* prerequisite, WorkItem::Priority priority=WorkItem::Priority_Normal);
 
-        /// Get the next work item from the front of the queue. If the queue is empty, waits until a new item is added.
-        /// If the workqueue is in the process of being destroyed, may return NULL.
+        /// Get the next work item for the given thread, stealing it from another thread if that thread has none.
+        /// If the queue is empty, waits until a new item is added. If the workqueue is in the process of being destroyed, may return NULL.
         /// @par Used internally by the WorkThread.
-        osg::ref_ptr<WorkItem> removeWorkItem();
+        osg::ref_ptr<WorkItem> removeWorkItem(unsigned int thread);
+
+        /// Mark an item as completed and add the items that waited for it.
+        /// @par Used internally by the WorkThread.
+        void completeWorkItem(WorkItem* item);
+
+        /// Call \a function for every index in [0, count), spread over the worker threads and the calling thread,
+        /// and return once all calls have returned. Indices are handed out one at a time, so uneven calls still balance.
+        /// @note The calls must not depend on each other. If any of them throws, the first exception is rethrown
+        /// as a std::runtime_error once all calls have returned.
+        void parallelFor(unsigned int count, const std::function<void (unsigned int)>& function,
+                         WorkItem::Priority priority=WorkItem::Priority_High);
 
         unsigned int getNumItems() const;
 
+        unsigned int getNumThreads() const;
+
         unsigned int getNumActiveThreads() const;
 
     private:
-        bool mIsReleased;
-        std::deque<osg::ref_ptr<WorkItem> > mQueue;
+        /// Items queued for one worker thread
+        struct Lanes
+        {
+            OpenThreads::Mutex mMutex;
+            std::deque<osg::ref_ptr<WorkItem> > mItems[WorkItem::Priority_Count];
+            OpenThreads::Atomic mNumItems[WorkItem::Priority_Count];
+        };
+
+        osg::ref_ptr<WorkItem> takeWorkItem(unsigned int thread);
+
+        OpenThreads::Atomic mIsReleased;
+
+        std::vector<Lanes*> mLanes;
+        OpenThreads::Atomic mNextLanes;
+        OpenThreads::Atomic mNumItems;
 
-        mutable OpenThreads::Mutex mMutex;
+        // Only for putting idle threads to sleep, never held while working on the lanes
+        OpenThreads::Mutex mSleepMutex;
         OpenThreads::Condition mCondition;
+        OpenThreads::Atomic mNumSleeping;
 
         std::vector<WorkThread*> mThreads;
     };
@@ -79,7 +148,7 @@ namespace SceneUtil
     class WorkThread : public OpenThreads::Thread
     {
     public:
-        WorkThread(WorkQueue* workQueue);
+        WorkThread(WorkQueue* workQueue, unsigned int index);
 
         virtual void run();
 
@@ -87,6 +156,7 @@ namespace SceneUtil
 
     private:
         WorkQueue* mWorkQueue;
+        unsigned int mIndex;
         volatile bool mActive;
     };
 
@@ -46,6 +46,7 @@ using namespace ToUTF8;
 
 Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
     mOutput(50*1024)
+  , mEncoding(sourceEncoding)
 {
     switch (sourceEncoding)
     {
@@ -118,6 +119,40 @@ std::string Utf8Encoder::getUtf8(const char* input, size_t size)
     return std::string(&mOutput[0], outlen);
 }
 
+void Utf8Encoder::getUtf8(const char* input, size_t size, std::string& output)
+{
+    const char* end = static_cast<const char*>(std::memchr(input, 0, size));
+    if (!end)
+        end = input + size;
+
+    // Same as getLength, but bounded by 'end' instead of a terminator
+    const char* ptr = input;
+    while (ptr != end && static_cast<unsigned char>(*ptr) < 128)
+        ++ptr;
+
+    // If we're pure ascii, then don't bother converting anything.
+    if (ptr == end)
+    {
+        output.assign(input, end);
+        return;
+    }
+
+    size_t outlen = ptr - input;
+    for (const char* it = ptr; it != end; ++it)
+    {
+        unsigned char ch = *it;
+        outlen += ch < 128 ? 1 : translationArray[ch*6];
+    }
+
+    output.resize(outlen);
+    char* out = &output[0];
+    while (input != end)
+        copyFromArray(*(input++), out);
+
+    // Make sure that we wrote the correct number of bytes
+    assert((out-&output[0]) == (int)outlen);
+}
+
 std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
 {
     // Double check that the input string stops at some point (it might
@@ -27,6 +27,8 @@ namespace ToUTF8
         public:
             Utf8Encoder(FromType sourceEncoding);
 
+            FromType getEncoding() const { return mEncoding; }
+
             // Convert to UTF8 from the previously given code page.
             std::string getUtf8(const char *input, size_t size);
             inline std::string getUtf8(const std::string &str)
@@ -34,6 +36,10 @@ namespace ToUTF8
                 return getUtf8(str.c_str(), str.size());
             }
 
+            // Convert at most 'size' bytes, up to the first zero, straight into 'output'. Unlike the
+            // above the input does not need a zero terminator, so it can point into a memory mapping.
+            void getUtf8(const char *input, size_t size, std::string &output);
+
             std::string getLegacyEnc(const char *input, size_t size);
             inline std::string getLegacyEnc(const std::string &str)
             {
@@ -48,6 +54,7 @@ namespace ToUTF8
             void copyFromArray2(const char*& chp, char* &out);
 
             std::vector<char> mOutput;
+            FromType mEncoding;
             signed char* translationArray;
     };
 }
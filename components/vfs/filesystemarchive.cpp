@@ -4,6 +4,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <components/files/mappedfilestream.hpp>
+
 namespace VFS
 {
 
@@ -62,7 +64,7 @@ namespace VFS
 
     Files::IStreamPtr FileSystemArchiveFile::open()
     {
-        return Files::openConstrainedFileStream(mPath.c_str());
+        return Files::openMappedFileStream(mPath.c_str());
     }
 
 }
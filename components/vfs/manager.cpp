@@ -26,6 +26,46 @@ namespace
         std::transform(path.begin(), path.end(), path.begin(), normalize_char);
     }
 
+    // Function objects rather than pointers, so the lookups get the conversion inlined
+
+    struct NormalizedChar
+    {
+        char operator()(char ch) const { return ch; }
+    };
+
+    struct StrictNormalizeChar
+    {
+        char operator()(char ch) const { return strict_normalize_char(ch); }
+    };
+
+    struct NonstrictNormalizeChar
+    {
+        char operator()(char ch) const { return nonstrict_normalize_char(ch); }
+    };
+
+    template <class Normalize>
+    size_t hashPath(boost::string_ref path, Normalize normalize)
+    {
+        // FNV-1a
+        size_t hash = static_cast<size_t>(2166136261u);
+        for (size_t i = 0; i < path.size(); ++i)
+            hash = (hash ^ static_cast<unsigned char>(normalize(path[i]))) * static_cast<size_t>(16777619u);
+        return hash;
+    }
+
+    template <class Normalize>
+    bool equalPath(const std::string& normalized, boost::string_ref path, Normalize normalize)
+    {
+        if (normalized.size() != path.size())
+            return false;
+        for (size_t i = 0; i < path.size(); ++i)
+        {
+            if (normalized[i] != normalize(path[i]))
+                return false;
+        }
+        return true;
+    }
+
 }
 
 namespace VFS
@@ -45,6 +85,7 @@ namespace VFS
     void Manager::reset()
     {
         mIndex.clear();
+        mHashedIndex.clear();
         for (std::vector<Archive*>::iterator it = mArchives.begin(); it != mArchives.end(); ++it)
             delete *it;
         mArchives.clear();
@@ -61,30 +102,79 @@ namespace VFS
 
         for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
             (*it)->listResources(mIndex, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+
+        size_t capacity = 16;
+        while (capacity < mIndex.size() * 2)
+            capacity *= 2;
+
+        mHashedIndex.clear();
+        mHashedIndex.resize(capacity);
+        const size_t mask = capacity - 1;
+
+        for (std::map<std::string, File*>::const_iterator it = mIndex.begin(); it != mIndex.end(); ++it)
+        {
+            const size_t hash = hashPath(it->first, NormalizedChar());
+
+            size_t slot = hash & mask;
+            while (mHashedIndex[slot].mFile != NULL)
+                slot = (slot + 1) & mask;
+
+            mHashedIndex[slot].mHash = hash;
+            mHashedIndex[slot].mName = &it->first;
+            mHashedIndex[slot].mFile = it->second;
+        }
     }
 
-    Files::IStreamPtr Manager::get(const std::string &name) const
+    template <class Normalize>
+    File* Manager::lookup(boost::string_ref name) const
+    {
+        if (mHashedIndex.empty())
+            return NULL;
+
+        const size_t hash = hashPath(name, Normalize());
+        const size_t mask = mHashedIndex.size() - 1;
+
+        for (size_t slot = hash & mask; mHashedIndex[slot].mFile != NULL; slot = (slot + 1) & mask)
+        {
+            const HashedFile& entry = mHashedIndex[slot];
+            if (entry.mHash == hash && equalPath(*entry.mName, name, Normalize()))
+                return entry.mFile;
+        }
+        return NULL;
+    }
+
+    File* Manager::lookup(boost::string_ref name, bool normalize) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        if (!normalize)
+            return lookup<NormalizedChar>(name);
+        if (mStrict)
+            return lookup<StrictNormalizeChar>(name);
+        return lookup<NonstrictNormalizeChar>(name);
+    }
 
-        return getNormalized(normalized);
+    Files::IStreamPtr Manager::get(const std::string &name) const
+    {
+        File* file = lookup(name, true);
+        if (!file)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return file->open();
     }
 
-    Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName) const
+    Files::IStreamPtr Manager::getNormalized(boost::string_ref normalizedName) const
     {
-        std::map<std::string, File*>::const_iterator found = mIndex.find(normalizedName);
-        if (found == mIndex.end())
-            throw std::runtime_error("Resource '" + normalizedName + "' not found");
-        return found->second->open();
+        File* file = lookup(normalizedName, false);
+        if (!file)
+            throw std::runtime_error("Resource '" + normalizedName.to_string() + "' not found");
+        return file->open();
     }
 
     bool Manager::exists(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
-
-        return mIndex.find(normalized) != mIndex.end();
+        return lookup(name, true) != NULL;
     }
 
     const std::map<std::string, File*>& Manager::getIndex() const
@@ -92,6 +182,26 @@ namespace VFS
         return mIndex;
     }
 
+    RecursiveDirectoryRange Manager::getRecursiveDirectoryIterator(const std::string& path) const
+    {
+        std::string prefix = path;
+        normalize_path(prefix, mStrict);
+
+        // All names starting with the prefix sort before the prefix with its last character increased
+        std::string upper = prefix;
+        while (!upper.empty() && static_cast<unsigned char>(upper[upper.size() - 1]) == 0xFF)
+            upper.erase(upper.size() - 1);
+
+        std::map<std::string, File*>::const_iterator end = mIndex.end();
+        if (!upper.empty())
+        {
+            ++upper[upper.size() - 1];
+            end = mIndex.lower_bound(upper);
+        }
+
+        return RecursiveDirectoryRange(mIndex.lower_bound(prefix), end);
+    }
+
     void Manager::normalizeFilename(std::string &name) const
     {
         normalize_path(name, mStrict);
@@ -6,12 +6,33 @@
 #include <vector>
 #include <map>
 
+#include <boost/utility/string_ref.hpp>
+
 namespace VFS
 {
 
     class Archive;
     class File;
 
+    /// @brief The files of the index that are in a directory or any of its subdirectories, in sorted order.
+    class RecursiveDirectoryRange
+    {
+    public:
+        typedef std::map<std::string, File*>::const_iterator const_iterator;
+
+        RecursiveDirectoryRange(const_iterator begin, const_iterator end)
+            : mBegin(begin), mEnd(end)
+        {
+        }
+
+        const_iterator begin() const { return mBegin; }
+        const_iterator end() const { return mEnd; }
+
+    private:
+        const_iterator mBegin;
+        const_iterator mEnd;
+    };
+
     /// @brief The main class responsible for loading files from a virtual file system.
     /// @par Various archive types (e.g. directories on the filesystem, or compressed archives)
     /// can be registered, and will be merged into a single file tree. If the same filename is
@@ -44,6 +65,11 @@ namespace VFS
         /// @note May be called from any thread once the index has been built.
         const std::map<std::string, File*>& getIndex() const;
 
+        /// Get the files in the given directory and its subdirectories. The path is normalized first, and is
+        /// matched as a prefix, so "music/explore" also finds "music/explore2/track.mp3".
+        /// @note May be called from any thread once the index has been built.
+        RecursiveDirectoryRange getRecursiveDirectoryIterator(const std::string& path) const;
+
         /// Normalize the given filename, making slashes/backslashes consistent, and lower-casing if mStrict is false.
         /// @note May be called from any thread once the index has been built.
         void normalizeFilename(std::string& name) const;
@@ -56,14 +82,34 @@ namespace VFS
         /// Retrieve a file by name (name is already normalized).
         /// @note Throws an exception if the file can not be found.
         /// @note May be called from any thread once the index has been built.
-        Files::IStreamPtr getNormalized(const std::string& normalizedName) const;
+        Files::IStreamPtr getNormalized(boost::string_ref normalizedName) const;
 
     private:
+        /// An entry of the hash table over mIndex. A NULL mFile marks an empty slot.
+        struct HashedFile
+        {
+            size_t mHash;
+            const std::string* mName;
+            File* mFile;
+
+            HashedFile() : mHash(0), mName(NULL), mFile(NULL) {}
+        };
+
+        /// Find a file in the hash table, passing every character of \a name through \a Normalize.
+        /// Neither the lookup nor the normalization makes a copy of the name.
+        template <class Normalize>
+        File* lookup(boost::string_ref name) const;
+
+        File* lookup(boost::string_ref name, bool normalize) const;
+
         bool mStrict;
 
         std::vector<Archive*> mArchives;
 
         std::map<std::string, File*> mIndex;
+
+        /// Open addressing with linear probing, at most half full, so a lookup rarely looks at more than two slots
+        std::vector<HashedFile> mHashedIndex;
     };
 
 }